@@ -25,6 +25,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include "esp_http_client.h"
+#include "http_conn_pool.h"
 #include "json_utils.h"
 #include "esp_log.h"
 #include "audio_error.h"
@@ -46,8 +47,11 @@ char *baidu_get_access_token(const char *access_key, const char *access_secret)
     esp_http_client_config_t config = {
         .url = url,
     };
-    esp_http_client_handle_t http_client = esp_http_client_init(&config);
-    AUDIO_MEM_CHECK(TAG, http_client, return NULL);
+    esp_http_client_handle_t http_client = http_conn_pool_acquire(&config, NULL);
+    AUDIO_MEM_CHECK(TAG, http_client, {
+        free(url);
+        return NULL;
+    });
 
     if (esp_http_client_open(http_client, 0) != ESP_OK) {
         ESP_LOGE(TAG, "Error open http request to baidu auth server");
@@ -83,7 +87,6 @@ char *baidu_get_access_token(const char *access_key, const char *access_secret)
     }
 _exit:
     free(url);
-    esp_http_client_close(http_client);
-    esp_http_client_cleanup(http_client);
+    http_conn_pool_release(http_client, token != NULL);
     return token;
 }
@@ -0,0 +1,313 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <sys/queue.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_idf_version.h"
+#include "audio_mem.h"
+#include "audio_error.h"
+#include "http_conn_pool.h"
+
+#define HTTP_CONN_HOST_LEN  (128)
+
+static const char *TAG = "HTTP_CONN_POOL";
+
+typedef struct http_conn {
+    STAILQ_ENTRY(http_conn)     next;
+    esp_http_client_handle_t    client;
+    char                        *host;
+    int                         port;
+    bool                        is_tls;
+    http_event_handle_cb        event_handler;
+    void                        *user_data;
+    const char                  *cert_pem;
+    const char                  *user_agent;
+#if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0))
+    esp_err_t                   (*crt_bundle_attach)(void *conf);
+#endif
+    bool                        in_use;
+    TickType_t                  idle_tick;   /* Time connection was given back */
+} http_conn_t;
+
+typedef STAILQ_HEAD(http_conn_list, http_conn) http_conn_list_t;
+
+static http_conn_list_t s_conn_list = STAILQ_HEAD_INITIALIZER(s_conn_list);
+static portMUX_TYPE s_conn_lock = portMUX_INITIALIZER_UNLOCKED;
+static http_conn_pool_stats_t s_stats;
+
+static bool http_conn_parse_url(const char *url, bool *is_tls, char *host, int *port)
+{
+    if (url == NULL) {
+        return false;
+    }
+    if (strncasecmp(url, "https://", 8) == 0) {
+        *is_tls = true;
+        *port = 443;
+        url += 8;
+    } else if (strncasecmp(url, "http://", 7) == 0) {
+        *is_tls = false;
+        *port = 80;
+        url += 7;
+    } else {
+        return false;
+    }
+    const char *end = url + strcspn(url, "/?#");
+    const char *at = memchr(url, '@', end - url);
+    if (at) {
+        url = at + 1;
+    }
+    const char *host_end;
+    if (*url == '[') {
+        host_end = memchr(url, ']', end - url);
+        if (host_end == NULL) {
+            return false;
+        }
+        host_end++;
+    } else {
+        host_end = memchr(url, ':', end - url);
+        if (host_end == NULL) {
+            host_end = end;
+        }
+    }
+    if (host_end == url || host_end - url >= HTTP_CONN_HOST_LEN) {
+        return false;
+    }
+    memcpy(host, url, host_end - url);
+    host[host_end - url] = 0;
+    if (host_end < end && *host_end == ':') {
+        *port = atoi(host_end + 1);
+    }
+    return true;
+}
+
+static bool http_conn_match(http_conn_t *conn, const esp_http_client_config_t *config, bool is_tls, const char *host, int port)
+{
+    return conn->is_tls == is_tls
+           && conn->port == port
+           && conn->event_handler == config->event_handler
+           && conn->user_data == config->user_data
+           && conn->cert_pem == config->cert_pem
+           && conn->user_agent == config->user_agent
+#if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0))
+           && conn->crt_bundle_attach == config->crt_bundle_attach
+#endif
+           && strcasecmp(conn->host, host) == 0;
+}
+
+static void http_conn_destroy(http_conn_t *conn)
+{
+    esp_http_client_close(conn->client);
+    esp_http_client_cleanup(conn->client);
+    audio_free(conn->host);
+    audio_free(conn);
+}
+
+static void http_conn_destroy_list(http_conn_list_t *list)
+{
+    http_conn_t *conn, *tmp;
+    STAILQ_FOREACH_SAFE(conn, list, next, tmp) {
+        http_conn_destroy(conn);
+    }
+}
+
+/* Must be called with the pool locked, idle connections are moved to `closing` if `expired` returns true */
+static void http_conn_collect(http_conn_list_t *closing, bool (*expired)(http_conn_t *conn, void *ctx), void *ctx)
+{
+    http_conn_t *conn, *tmp;
+    STAILQ_FOREACH_SAFE(conn, &s_conn_list, next, tmp) {
+        if (conn->in_use == false && expired(conn, ctx)) {
+            STAILQ_REMOVE(&s_conn_list, conn, http_conn, next);
+            STAILQ_INSERT_TAIL(closing, conn, next);
+            s_stats.idle--;
+            s_stats.discarded++;
+        }
+    }
+}
+
+static bool http_conn_timeout(http_conn_t *conn, void *ctx)
+{
+    return (*(TickType_t *)ctx - conn->idle_tick) >= pdMS_TO_TICKS(HTTP_CONN_POOL_IDLE_TIMEOUT_MS);
+}
+
+static bool http_conn_of_user(http_conn_t *conn, void *ctx)
+{
+    return conn->user_data == ctx;
+}
+
+static bool http_conn_any(http_conn_t *conn, void *ctx)
+{
+    return true;
+}
+
+esp_http_client_handle_t http_conn_pool_acquire(const esp_http_client_config_t *config, bool *reused)
+{
+    AUDIO_NULL_CHECK(TAG, config, return NULL);
+    char host[HTTP_CONN_HOST_LEN];
+    bool is_tls = false;
+    int port = 0;
+    bool poolable = http_conn_parse_url(config->url, &is_tls, host, &port);
+    http_conn_list_t closing = STAILQ_HEAD_INITIALIZER(closing);
+    http_conn_t *conn = NULL, *found = NULL;
+    TickType_t now = xTaskGetTickCount();
+    if (reused) {
+        *reused = false;
+    }
+
+    portENTER_CRITICAL(&s_conn_lock);
+    http_conn_collect(&closing, http_conn_timeout, &now);
+    if (poolable) {
+        STAILQ_FOREACH(conn, &s_conn_list, next) {
+            if (conn->in_use == false && http_conn_match(conn, config, is_tls, host, port)) {
+                conn->in_use = true;
+                s_stats.idle--;
+                s_stats.reused++;
+                found = conn;
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&s_conn_lock);
+    http_conn_destroy_list(&closing);
+
+    if (found) {
+        ESP_LOGD(TAG, "Reuse connection to %s:%d", host, port);
+        esp_http_client_set_url(found->client, config->url);
+        if (reused) {
+            *reused = true;
+        }
+        return found->client;
+    }
+
+    esp_http_client_config_t cfg = *config;
+#if defined(CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS) && (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0))
+    // Reconnection of a pooled client resumes the TLS session instead of a full handshake
+    cfg.save_client_session = true;
+#endif
+    esp_http_client_handle_t client = esp_http_client_init(&cfg);
+    AUDIO_MEM_CHECK(TAG, client, return NULL);
+    if (poolable == false) {
+        return client;
+    }
+    conn = audio_calloc(1, sizeof(http_conn_t));
+    AUDIO_MEM_CHECK(TAG, conn, return client);
+    conn->host = audio_strdup(host);
+    AUDIO_MEM_CHECK(TAG, conn->host, {
+        audio_free(conn);
+        return client;
+    });
+    conn->client = client;
+    conn->port = port;
+    conn->is_tls = is_tls;
+    conn->event_handler = config->event_handler;
+    conn->user_data = config->user_data;
+    conn->cert_pem = config->cert_pem;
+    conn->user_agent = config->user_agent;
+#if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0))
+    conn->crt_bundle_attach = config->crt_bundle_attach;
+#endif
+    conn->in_use = true;
+    portENTER_CRITICAL(&s_conn_lock);
+    STAILQ_INSERT_TAIL(&s_conn_list, conn, next);
+    s_stats.created++;
+    portEXIT_CRITICAL(&s_conn_lock);
+    return client;
+}
+
+esp_err_t http_conn_pool_release(esp_http_client_handle_t client, bool keep_alive)
+{
+    AUDIO_NULL_CHECK(TAG, client, return ESP_ERR_INVALID_ARG);
+    http_conn_list_t closing = STAILQ_HEAD_INITIALIZER(closing);
+    http_conn_t *conn = NULL, *oldest = NULL;
+    // Unread response data would be taken as the response of next request
+    keep_alive = keep_alive && esp_http_client_is_complete_data_received(client);
+
+    portENTER_CRITICAL(&s_conn_lock);
+    STAILQ_FOREACH(conn, &s_conn_list, next) {
+        if (conn->client == client) {
+            break;
+        }
+    }
+    if (conn) {
+        STAILQ_REMOVE(&s_conn_list, conn, http_conn, next);
+        if (keep_alive) {
+            // Keep the list in release order so that the head is the least recently used
+            conn->in_use = false;
+            conn->idle_tick = xTaskGetTickCount();
+            STAILQ_INSERT_TAIL(&s_conn_list, conn, next);
+            if (++s_stats.idle > HTTP_CONN_POOL_MAX_IDLE) {
+                STAILQ_FOREACH(oldest, &s_conn_list, next) {
+                    if (oldest->in_use == false) {
+                        break;
+                    }
+                }
+                STAILQ_REMOVE(&s_conn_list, oldest, http_conn, next);
+                STAILQ_INSERT_TAIL(&closing, oldest, next);
+                s_stats.idle--;
+                s_stats.discarded++;
+            }
+        } else {
+            STAILQ_INSERT_TAIL(&closing, conn, next);
+            s_stats.discarded++;
+        }
+    }
+    portEXIT_CRITICAL(&s_conn_lock);
+
+    if (conn == NULL) {
+        esp_http_client_close(client);
+        esp_http_client_cleanup(client);
+    }
+    http_conn_destroy_list(&closing);
+    return ESP_OK;
+}
+
+void http_conn_pool_drop(void *user_data)
+{
+    http_conn_list_t closing = STAILQ_HEAD_INITIALIZER(closing);
+    portENTER_CRITICAL(&s_conn_lock);
+    http_conn_collect(&closing, http_conn_of_user, user_data);
+    portEXIT_CRITICAL(&s_conn_lock);
+    http_conn_destroy_list(&closing);
+}
+
+void http_conn_pool_clear(void)
+{
+    http_conn_list_t closing = STAILQ_HEAD_INITIALIZER(closing);
+    portENTER_CRITICAL(&s_conn_lock);
+    http_conn_collect(&closing, http_conn_any, NULL);
+    portEXIT_CRITICAL(&s_conn_lock);
+    http_conn_destroy_list(&closing);
+}
+
+esp_err_t http_conn_pool_get_stats(http_conn_pool_stats_t *stats)
+{
+    AUDIO_NULL_CHECK(TAG, stats, return ESP_ERR_INVALID_ARG);
+    portENTER_CRITICAL(&s_conn_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_conn_lock);
+    return ESP_OK;
+}
@@ -0,0 +1,115 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _HTTP_CONN_POOL_H_
+#define _HTTP_CONN_POOL_H_
+
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef HTTP_CONN_POOL_MAX_IDLE
+#define HTTP_CONN_POOL_MAX_IDLE         (4)
+#endif
+
+#ifndef HTTP_CONN_POOL_IDLE_TIMEOUT_MS
+#define HTTP_CONN_POOL_IDLE_TIMEOUT_MS  (4000)  /* Below the usual server keep-alive timeout */
+#endif
+
+/**
+ * @brief HTTP connection pool statistics
+ */
+typedef struct {
+    int created;    /*!< Connections created by the pool */
+    int reused;     /*!< Borrows served by an idle connection */
+    int discarded;  /*!< Connections closed on release or evicted from the pool */
+    int idle;       /*!< Idle connections kept in the pool */
+} http_conn_pool_stats_t;
+
+/**
+ * @brief      Borrow an HTTP client from the shared connection pool
+ *
+ *             Idle clients are matched by scheme, host and port of `config->url`, together with
+ *             the event handler, user data, certificate settings and user agent of the configuration.
+ *             A matched client keeps its connection (and TLS session), only the URL is updated.
+ *             Otherwise a new client is created with `config`.
+ *
+ * @note       A kept-alive connection can be closed by the server at any time, when the request on
+ *             a reused client fails, close the client and open it again to connect to the server.
+ *
+ * @param[in]  config  The HTTP client configuration
+ * @param[out] reused  Whether the client is served by an idle connection, can be NULL
+ *
+ * @return
+ *     - The HTTP client handle
+ *     - NULL, on failure
+ */
+esp_http_client_handle_t http_conn_pool_acquire(const esp_http_client_config_t *config, bool *reused);
+
+/**
+ * @brief      Give back an HTTP client borrowed by `http_conn_pool_acquire`
+ *
+ *             The connection is kept for reuse only if `keep_alive` is set and the response is fully received,
+ *             otherwise the client is cleaned up. Clients not created by the pool are always cleaned up.
+ *
+ * @param[in]  client      The HTTP client handle
+ * @param[in]  keep_alive  Whether the connection can be reused
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t http_conn_pool_release(esp_http_client_handle_t client, bool keep_alive);
+
+/**
+ * @brief      Close idle connections borrowed with `user_data`, call it before the user data is freed
+ *
+ * @param[in]  user_data  The user data of the HTTP client configuration
+ */
+void http_conn_pool_drop(void *user_data);
+
+/**
+ * @brief      Close all idle connections
+ */
+void http_conn_pool_clear(void);
+
+/**
+ * @brief      Get statistics of the connection pool
+ *
+ * @param[out] stats  The statistics
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t http_conn_pool_get_stats(http_conn_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -23,6 +23,7 @@
  */
 
 #include <string.h>
+#include <math.h>
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
@@ -33,8 +34,6 @@
 #include "audio_mixer.h"
 #include "audio_mem.h"
 #include "audio_error.h"
-#include "esp_downmix.h"
-#include "sys/queue.h"
 
 static const char *TAG = "AUDIO_MIXER";
 
@@ -44,35 +43,60 @@ static const char *TAG = "AUDIO_MIXER";
 #define MIXER_DESTROY_BIT              BIT(1)
 #define MIXER_DESTROYED                BIT(2)
 #define PREVIOUS_RETURN_VALID          (1)
+#define SAMPLERATE_MIN                 (4000)
+#define SAMPLERATE_MAX                 (100000)
+#define GAIN_MIN                       (-100)
+#define GAIN_MAX                       (100)
+#define SOURCE_NUM_MAX                 (8)
+
+#define SLOT_UPDATE_FORMAT             BIT(0)
+#define SLOT_UPDATE_GAIN               BIT(1)
+
+#define MIXER_GAIN_Q                   (12)
+#define MIXER_GAIN_MAX_DB              (24)
+#define MIXER_RAMP_BLOCK_FRAMES        (32)
+#define MIXER_RSP_Q                    (32)
+#define MIXER_RSP_ONE                  (1ULL << MIXER_RSP_Q)
 
 typedef struct slot_info {
-    STAILQ_ENTRY(slot_info)     next;
     uint8_t                     id;
     mixer_io_callback_t         read;
     void                        *ctx;
     int                         prv_ret;
+    /* Settings from the API, applied by the mixer task before the next read */
+    volatile uint32_t           update;
+    int                         sample_rate;
+    int                         channel;
+    float                       gain[2];
+    int                         transit_time;
+    /* Runtime state, only touched by the mixer task */
+    int                         cur_channel;
+    uint64_t                    step;        /* Input frames per output frame, Q32 */
+    uint64_t                    pos;         /* Position of the next output frame in `buf`, Q32 */
+    int                         keep;        /* Input frames kept at the head of `buf` for interpolation */
+    int16_t                    *buf;
+    int                         buf_frames;
+    float                       gain_cur;
+    float                       gain_goal;
+    float                       gain_delta;
+    int                         ramp_left;
 } slot_info_t;
 
-typedef STAILQ_HEAD(slot_list, slot_info) slot_list_t;
-
 typedef struct {
     audio_mixer_state_t state;
-    slot_list_t         slot_in;
+    slot_info_t        *slot;
     mixer_io_callback_t out;
     void               *out_ctx;
     EventGroupHandle_t  evt_sync;
     int                 evt_ticks;
     uint8_t             max_in_slot;
     int                 max_sample_num;
-    esp_downmix_info_t  downmix_info;
-    unsigned char     **inbuf;
-    unsigned char      *outbuf;
-    void               *downmix_handle;
-    bool                reopen;
+    int32_t            *outbuf;     /* Sums of all slots, packed to int16 in place before output */
     bool                process_run;
     bool                destroy;
     bool                is_open;
     int                 channel;
+    int                 sample_rate;
 } audio_mixer_t;
 
 static esp_err_t audio_mixer_close(void *handle);
@@ -80,8 +104,8 @@ static esp_err_t audio_mixer_close(void *handle);
 static esp_err_t audio_mixer_destroy(void *handle)
 {
     audio_mixer_t *mixer = (audio_mixer_t *)handle;
-    if (mixer->downmix_info.source_info) {
-        audio_free(mixer->downmix_info.source_info);
+    if (mixer->slot) {
+        audio_free(mixer->slot);
     }
     audio_free(mixer);
     return ESP_OK;
@@ -91,44 +115,23 @@ static esp_err_t audio_mixer_open(void *handle)
 {
     ESP_LOGI(TAG, "Open an audio mixer");
     audio_mixer_t *mixer = (audio_mixer_t *)handle;
-    mixer->inbuf = (unsigned char **)audio_calloc(1, mixer->max_in_slot * sizeof(unsigned char *));
-    AUDIO_MEM_CHECK(TAG, mixer->inbuf, return ESP_ERR_NO_MEM);
-    for (int i = 0; i < mixer->max_in_slot; i++) {
-        mixer->inbuf[i] = (unsigned char *)audio_calloc(1, mixer->max_sample_num * mixer->channel * sizeof(short));
-        AUDIO_MEM_CHECK(TAG, mixer->inbuf[i], goto _exit);
-    }
-    mixer->outbuf = (unsigned char *)audio_calloc(1, mixer->max_sample_num * mixer->channel * sizeof(short));
-    AUDIO_NULL_CHECK(TAG, mixer->outbuf, goto _exit);
-
-    mixer->reopen = true;
-    mixer->downmix_handle = esp_downmix_open(&mixer->downmix_info);
-    if (mixer->downmix_handle == NULL) {
-        ESP_LOGE(TAG, "Downmix open failed");
-        goto _exit;
-    }
+    mixer->outbuf = (int32_t *)audio_calloc(1, mixer->max_sample_num * mixer->channel * sizeof(int32_t));
+    AUDIO_MEM_CHECK(TAG, mixer->outbuf, return ESP_ERR_NO_MEM);
     return ESP_OK;
-_exit:
-    audio_mixer_close(handle);
-    return ESP_FAIL;
 }
 
 static esp_err_t audio_mixer_close(void *handle)
 {
     ESP_LOGD(TAG, "Close an audio mixer, h:%p", handle);
     audio_mixer_t *mixer = (audio_mixer_t *)handle;
-    if (mixer->downmix_handle != NULL) {
-        esp_downmix_close(mixer->downmix_handle);
-    }
     for (int i = 0; i < mixer->max_in_slot; i++) {
-        if (mixer->inbuf[i] != NULL) {
-            memset(mixer->inbuf[i], 0, mixer->max_sample_num * 2 * sizeof(short));
-            audio_free(mixer->inbuf[i]);
-            mixer->inbuf[i] = NULL;
+        if (mixer->slot[i].buf != NULL) {
+            audio_free(mixer->slot[i].buf);
+            mixer->slot[i].buf = NULL;
+            mixer->slot[i].buf_frames = 0;
         }
-    }
-    if (mixer->inbuf != NULL) {
-        audio_free(mixer->inbuf);
-        mixer->inbuf = NULL;
+        mixer->slot[i].cur_channel = 0;
+        __atomic_fetch_or(&mixer->slot[i].update, SLOT_UPDATE_FORMAT, __ATOMIC_SEQ_CST);
     }
     if (mixer->outbuf != NULL) {
         audio_free(mixer->outbuf);
@@ -137,64 +140,213 @@ static esp_err_t audio_mixer_close(void *handle)
     return ESP_OK;
 }
 
-static int audio_mixer_reset_downmix(void *handle)
+static float audio_mixer_db_to_gain(float db)
 {
-    audio_mixer_t *mixer = (audio_mixer_t *)handle;
-    if (mixer->downmix_handle != NULL) {
-        esp_downmix_close(mixer->downmix_handle);
+    if (db <= -96.0f) {
+        return 0.0f;
     }
-    mixer->downmix_handle = esp_downmix_open(&mixer->downmix_info);
-    if (mixer->downmix_handle == NULL) {
-        ESP_LOGE(TAG, "Downmix reset failed");
-        return ESP_FAIL;
+    if (db > MIXER_GAIN_MAX_DB) {
+        db = MIXER_GAIN_MAX_DB;
+    }
+    return powf(10.0f, db / 20.0f);
+}
+
+static esp_err_t audio_mixer_slot_apply(audio_mixer_t *mixer, slot_info_t *slot)
+{
+    // Flags raised by the API while applying stay set for the next block
+    uint32_t update = __atomic_exchange_n(&slot->update, 0, __ATOMIC_SEQ_CST);
+    if (update & SLOT_UPDATE_FORMAT) {
+        int rate = slot->sample_rate > 0 ? slot->sample_rate : mixer->sample_rate;
+        int channel = slot->channel > 0 ? slot->channel : mixer->channel;
+        uint64_t step = ((uint64_t)rate << MIXER_RSP_Q) / mixer->sample_rate;
+        // Enough input for a full output block, the position may run one step ahead after a short read
+        int frames = (int)(((mixer->max_sample_num + 1) * step) >> MIXER_RSP_Q) + 4;
+        if (frames * channel > slot->buf_frames * slot->cur_channel) {
+            int16_t *buf = audio_realloc(slot->buf, frames * channel * sizeof(int16_t));
+            AUDIO_MEM_CHECK(TAG, buf, return ESP_ERR_NO_MEM);
+            slot->buf = buf;
+        } else {
+            frames = slot->buf_frames * slot->cur_channel / channel;
+        }
+        slot->buf_frames = frames;
+        slot->cur_channel = channel;
+        slot->step = step;
+        slot->pos = 0;
+        slot->keep = 0;
+        ESP_LOGD(TAG, "Slot %d input %d Hz %d ch, output %d Hz %d ch", slot->id, rate, channel,
+                 mixer->sample_rate, mixer->channel);
+    }
+    if (update & SLOT_UPDATE_GAIN) {
+        slot->gain_cur = audio_mixer_db_to_gain(slot->gain[0]);
+        slot->gain_goal = audio_mixer_db_to_gain(slot->gain[1]);
+        slot->ramp_left = (int)((int64_t)slot->transit_time * mixer->sample_rate / 1000);
+        if (slot->ramp_left > 0) {
+            slot->gain_delta = (slot->gain_goal - slot->gain_cur) / slot->ramp_left;
+        } else {
+            slot->gain_cur = slot->gain_goal;
+        }
     }
     return ESP_OK;
 }
 
-static int audio_mixer_process(void *handle)
+/* Number of new input frames needed to produce `out_frames` output frames */
+static int audio_mixer_slot_need(slot_info_t *slot, int out_frames)
 {
-    audio_mixer_t *mixer = (audio_mixer_t *)handle;
-    int r_size = mixer->max_sample_num * sizeof(short);
-    int ret = 0;
-    if (mixer->reopen == true) {
-        ret = audio_mixer_reset_downmix(mixer);
-        if (ret != ESP_OK) {
-            return ESP_ERR_MIXER_FAIL;
+    if (slot->step == MIXER_RSP_ONE) {
+        return out_frames;
+    }
+    uint64_t last = slot->pos + (out_frames - 1) * slot->step;
+    int total = (int)(last >> MIXER_RSP_Q) + 2;
+    int next = (int)((last + slot->step) >> MIXER_RSP_Q) + 1;
+    if (next > total) {
+        total = next;
+    }
+    return total - slot->keep;
+}
+
+/* Number of output frames which can be produced from `avail` input frames */
+static int audio_mixer_slot_frames(slot_info_t *slot, int avail, int out_frames)
+{
+    if (slot->step == MIXER_RSP_ONE) {
+        return avail < out_frames ? avail : out_frames;
+    }
+    if (avail <= 1) {
+        return 0;
+    }
+    uint64_t limit = (uint64_t)(avail - 1) << MIXER_RSP_Q;
+    if (limit <= slot->pos) {
+        return 0;
+    }
+    uint64_t n = (limit - slot->pos + slot->step - 1) / slot->step;
+    return n < (uint64_t)out_frames ? (int)n : out_frames;
+}
+
+/* Drop consumed input and keep the frames which the next interpolation still needs */
+static void audio_mixer_slot_consume(slot_info_t *slot, int avail, int frames)
+{
+    if (slot->step == MIXER_RSP_ONE) {
+        slot->keep = 0;
+        return;
+    }
+    uint64_t next = slot->pos + frames * slot->step;
+    int used = (int)(next >> MIXER_RSP_Q);
+    if (used > avail) {
+        // Short read, the next output frame lies beyond the data read so far
+        used = avail;
+    }
+    slot->pos = next - ((uint64_t)used << MIXER_RSP_Q);
+    slot->keep = avail - used;
+    memmove(slot->buf, slot->buf + used * slot->cur_channel, slot->keep * slot->cur_channel * sizeof(int16_t));
+}
+
+static inline int32_t audio_mixer_slot_gain(slot_info_t *slot, int frames)
+{
+    if (slot->ramp_left > 0) {
+        int n = frames < slot->ramp_left ? frames : slot->ramp_left;
+        slot->ramp_left -= n;
+        slot->gain_cur = slot->ramp_left ? slot->gain_cur + slot->gain_delta * n : slot->gain_goal;
+    }
+    return (int32_t)(slot->gain_cur * (1 << MIXER_GAIN_Q));
+}
+
+static inline void audio_mixer_put(int32_t *out, int32_t v, bool add)
+{
+    *out = add ? *out + v : v;
+}
+
+/* Clip the sums once after the last slot, so the result does not depend on the slot order */
+static void audio_mixer_pack(int32_t *buf, int samples)
+{
+    char *out = (char *)buf;
+    for (int i = 0; i < samples; i++) {
+        int32_t v = buf[i];
+        if (v > INT16_MAX) {
+            v = INT16_MAX;
+        } else if (v < INT16_MIN) {
+            v = INT16_MIN;
         }
-        mixer->reopen = false;
-        ESP_LOGI(TAG, "Reset the audio mixer");
-        return ESP_ERR_MIXER_OK;
+        int16_t sample = (int16_t)v;
+        // Byte copy, the int16 samples overlap the int32 sums already read
+        memcpy(out + i * sizeof(int16_t), &sample, sizeof(int16_t));
     }
-    slot_info_t *ch_list, *tmp;
+}
+
+/*
+ * Read one block from the slot, convert it to the output format and mix it straight into the output buffer.
+ * Output frames below `mixed` already hold the sum of previous slots and are accumulated, the others are overwritten.
+ */
+static int audio_mixer_slot_mix(audio_mixer_t *mixer, slot_info_t *slot, int mixed)
+{
+    int in_ch = slot->cur_channel;
+    int16_t *in = slot->buf;
+    int need = audio_mixer_slot_need(slot, mixer->max_sample_num);
+    int ret = slot->read((uint8_t *)(in + slot->keep * in_ch), need * in_ch * sizeof(int16_t), slot->ctx);
+    slot->prv_ret = ret;
+    if (ret <= 0) {
+        return ret;
+    }
+    int avail = slot->keep + ret / (in_ch * sizeof(int16_t));
+    int frames = audio_mixer_slot_frames(slot, avail, mixer->max_sample_num);
+    int32_t *out = mixer->outbuf;
+    uint64_t pos = slot->pos;
     int k = 0;
-    uint8_t i = 0;
-    STAILQ_FOREACH_SAFE(ch_list, &mixer->slot_in, next, tmp) {
-        if (ch_list->read) {
-            if (ch_list->prv_ret > 0) {
-                memset(mixer->inbuf[i], 0, mixer->max_sample_num * mixer->channel * sizeof(short));
-                ret = ch_list->read((uint8_t *)mixer->inbuf[i], r_size * mixer->channel, ch_list->ctx);
-                ch_list->prv_ret = ret;
+    while (k < frames) {
+        int end = k + MIXER_RAMP_BLOCK_FRAMES < frames ? k + MIXER_RAMP_BLOCK_FRAMES : frames;
+        int32_t gain = audio_mixer_slot_gain(slot, end - k);
+        for (; k < end; k++) {
+            int32_t l, r;
+            if (slot->step == MIXER_RSP_ONE) {
+                l = in[k * in_ch];
+                r = in[k * in_ch + in_ch - 1];
+            } else {
+                const int16_t *a = in + (pos >> MIXER_RSP_Q) * in_ch;
+                int32_t f = (uint32_t)pos >> (MIXER_RSP_Q - 15);
+                l = a[0] + (((a[in_ch] - a[0]) * f) >> 15);
+                r = a[in_ch - 1] + (((a[2 * in_ch - 1] - a[in_ch - 1]) * f) >> 15);
+                pos += slot->step;
             }
-        } else {
-            ret = ESP_ERR_MIXER_FAIL;
+            if (mixer->channel == 1) {
+                audio_mixer_put(&out[k], (((l + r) >> 1) * gain) >> MIXER_GAIN_Q, k < mixed);
+            } else {
+                audio_mixer_put(&out[2 * k], (l * gain) >> MIXER_GAIN_Q, k < mixed);
+                audio_mixer_put(&out[2 * k + 1], (r * gain) >> MIXER_GAIN_Q, k < mixed);
+            }
+        }
+    }
+    audio_mixer_slot_consume(slot, avail, frames);
+    return frames;
+}
+
+static int audio_mixer_process(void *handle)
+{
+    audio_mixer_t *mixer = (audio_mixer_t *)handle;
+    int ret = 0;
+    int mixed = 0;
+    int k = 0;
+    for (int i = 0; i < mixer->max_in_slot; i++) {
+        slot_info_t *slot = &mixer->slot[i];
+        // Idle slots are neither read nor mixed
+        if (slot->read == NULL || slot->prv_ret <= 0) {
+            continue;
+        }
+        if (slot->update && audio_mixer_slot_apply(mixer, slot) != ESP_OK) {
+            return ESP_ERR_MIXER_FAIL;
         }
-        if (ret > 0) {
+        ret = audio_mixer_slot_mix(mixer, slot, mixed);
+        if (slot->prv_ret > 0) {
             k++;
         }
-        i++;
+        if (ret > mixed) {
+            mixed = ret;
+        }
     }
-    if (k == 0) { 
-        mixer->out(mixer->outbuf, 0, mixer->out_ctx);
+    if (k == 0) {
+        mixer->out((uint8_t *)mixer->outbuf, 0, mixer->out_ctx);
         return ESP_ERR_MIXER_NO_DATA;
     }
-    ESP_LOGD(TAG, "valid_cnt:%d, I:%d", k, i);
-    ret = esp_downmix_process(mixer->downmix_handle, mixer->inbuf, mixer->outbuf, mixer->max_sample_num, mixer->downmix_info.mode);
-    if (ret < 0) {
-        ESP_LOGE(TAG, "Downmix process fail");
-        ret = ESP_ERR_MIXER_FAIL;
-    }
-
-    ret = mixer->out(mixer->outbuf, ret, mixer->out_ctx);
+    ESP_LOGD(TAG, "valid_cnt:%d, frames:%d", k, mixed);
+    audio_mixer_pack(mixer->outbuf, mixed * mixer->channel);
+    ret = mixer->out((uint8_t *)mixer->outbuf, mixed * mixer->channel * sizeof(int16_t), mixer->out_ctx);
     if (ret >= 0) {
         ret = ESP_ERR_MIXER_OK;
     }
@@ -259,8 +411,9 @@ static void mixer_task(void *params)
         audio_mixer_close(mixer);
         mixer->is_open = false;
     }
+    EventGroupHandle_t evt_sync = mixer->evt_sync;
     audio_mixer_destroy(mixer);
-    xEventGroupSetBits(mixer->evt_sync, MIXER_DESTROYED);
+    xEventGroupSetBits(evt_sync, MIXER_DESTROYED);
     vTaskDelete(NULL);
 }
 
@@ -288,36 +441,27 @@ esp_err_t audio_mixer_init(audio_mixer_config_t *config, void **handle)
         config->max_sample_num = 512;
     }
 
+    if (config->bits != 16) {
+        ESP_LOGE(TAG, "The bits number of mixer stream must be 16 bits. (line %d)", __LINE__);
+        return ESP_ERR_INVALID_ARG;
+    }
+
     esp_err_t ret = ESP_OK;
     audio_mixer_t *mixer = audio_calloc(1, sizeof(audio_mixer_t));
-    AUDIO_MEM_CHECK(TAG, mixer, return ESP_ERR_INVALID_ARG);
+    AUDIO_MEM_CHECK(TAG, mixer, return ESP_ERR_NO_MEM);
     mixer->evt_sync = xEventGroupCreate();
-    AUDIO_MEM_CHECK(TAG, mixer->evt_sync, goto __mixer_init;);
-    mixer->downmix_info.source_info = audio_calloc(config->max_in_slot, sizeof(esp_downmix_input_info_t));
-    if (mixer->downmix_info.source_info == NULL) {
-        ESP_LOGE(TAG, "Allocate downmix source_info failed");
-        goto __mixer_init;
-    }
-    if (config->bits != 16) {
-        ESP_LOGE(TAG, "The bits number of downmix source stream must be 16 bits. (line %d)", __LINE__);
-        goto __mixer_init;
-    }
+    AUDIO_MEM_CHECK(TAG, mixer->evt_sync, {ret = ESP_ERR_NO_MEM; goto __mixer_init;});
+    mixer->slot = audio_calloc(config->max_in_slot, sizeof(slot_info_t));
+    AUDIO_MEM_CHECK(TAG, mixer->slot, {ret = ESP_ERR_NO_MEM; goto __mixer_init;});
     for (int i = 0; i < config->max_in_slot; ++i) {
-        mixer->downmix_info.source_info[i].samplerate = config->sample_rate;
-        mixer->downmix_info.source_info[i].channel = config->channel;
-        mixer->downmix_info.source_info[i].bits_num = config->bits;
-        if (config->channel > 0) {
-            mixer->channel = config->channel;
-        }
+        mixer->slot[i].id = i;
+        mixer->slot[i].prv_ret = PREVIOUS_RETURN_VALID;
+        mixer->slot[i].update = SLOT_UPDATE_FORMAT | SLOT_UPDATE_GAIN;
     }
-    mixer->downmix_info.out_ctx = ESP_DOWNMIX_OUT_CTX_NORMAL;
-    mixer->downmix_info.output_type = mixer->channel;
-    mixer->downmix_info.mode = ESP_DOWNMIX_WORK_MODE_SWITCH_ON;
-    mixer->downmix_info.source_num = config->max_in_slot;
-
+    mixer->channel = config->channel;
+    mixer->sample_rate = config->sample_rate;
     mixer->max_in_slot = config->max_in_slot;
     mixer->max_sample_num = config->max_sample_num;
-    STAILQ_INIT(&mixer->slot_in);
     ret = audio_thread_create(NULL, "audio_mixer", mixer_task, mixer,
                               config->task_stack, config->task_prio, true, config->task_core);
     if (ret != ESP_OK) {
@@ -332,9 +476,10 @@ __mixer_init:
     if (mixer->evt_sync) {
         vEventGroupDelete(mixer->evt_sync);
     }
-    if (mixer) {
-        audio_free(mixer);
+    if (mixer->slot) {
+        audio_free(mixer->slot);
     }
+    audio_free(mixer);
     return ret;
 }
 
@@ -342,12 +487,12 @@ esp_err_t audio_mixer_deinit(void *handle)
 {
     AUDIO_NULL_CHECK(TAG, handle, return ESP_ERR_INVALID_ARG);
     audio_mixer_t *mixer = (audio_mixer_t *)handle;
-    mixer->destroy = false;
-    xEventGroupSetBits(mixer->evt_sync, MIXER_DESTROY_BIT);
-    xEventGroupWaitBits(mixer->evt_sync, MIXER_DESTROYED, true, false, portMAX_DELAY);
-    if (mixer->evt_sync) {
-        vEventGroupDelete(mixer->evt_sync);
-    }
+    // The mixer is freed by its task, keep the event group to wait on
+    EventGroupHandle_t evt_sync = mixer->evt_sync;
+    mixer->destroy = true;
+    xEventGroupSetBits(evt_sync, MIXER_DESTROY_BIT);
+    xEventGroupWaitBits(evt_sync, MIXER_DESTROYED, true, false, portMAX_DELAY);
+    vEventGroupDelete(evt_sync);
     return ESP_OK;
 }
 
@@ -374,22 +519,28 @@ esp_err_t audio_mixer_configure_in(void *handle, audio_mixer_slot_info_t *input_
             ESP_LOGE(TAG, "The transfer time [%d] need gather than 0", input_slot[i].transfer_time_ms);
             return ESP_ERR_INVALID_ARG;
         }
+        if (input_slot[i].sample_rate && CHECK_OUT_OF_RANGE(input_slot[i].sample_rate, SAMPLERATE_MIN, SAMPLERATE_MAX)) {
+            ESP_LOGE(TAG, "Unsupported sample rate of slot %d, %d", i, input_slot[i].sample_rate);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (input_slot[i].channel && CHECK_OUT_OF_RANGE(input_slot[i].channel, 1, 2)) {
+            ESP_LOGE(TAG, "The channel number[%d] of slot %d does not support", input_slot[i].channel, i);
+            return ESP_ERR_INVALID_ARG;
+        }
     }
     float cumulative_gain = 0;
     for (int i = 0; i < num_of_slot; i++) {
-        mixer->downmix_info.source_info[i].gain[0] = input_slot[i].origin_gain_db;
-        mixer->downmix_info.source_info[i].gain[1] = input_slot[i].goal_gain_db;
-        mixer->downmix_info.source_info[i].transit_time = input_slot[i].transfer_time_ms;
-
+        slot_info_t *slot = &mixer->slot[i];
+        slot->gain[0] = input_slot[i].origin_gain_db;
+        slot->gain[1] = input_slot[i].goal_gain_db;
+        slot->transit_time = input_slot[i].transfer_time_ms;
+        slot->sample_rate = input_slot[i].sample_rate;
+        slot->channel = input_slot[i].channel;
         cumulative_gain += input_slot[i].goal_gain_db;
-        slot_info_t *item = audio_calloc(1, sizeof(slot_info_t));
-        AUDIO_MEM_CHECK(TAG, item, return ESP_ERR_NO_MEM);
-        item->read = input_slot[i].read_cb;
-
-        item->ctx = input_slot[i].cb_ctx;
-        item->id = i;
-        item->prv_ret = PREVIOUS_RETURN_VALID;
-        STAILQ_INSERT_TAIL(&mixer->slot_in, item, next);
+        slot->read = input_slot[i].read_cb;
+        slot->ctx = input_slot[i].cb_ctx;
+        slot->prv_ret = PREVIOUS_RETURN_VALID;
+        slot->update = SLOT_UPDATE_FORMAT | SLOT_UPDATE_GAIN;
     }
     if (cumulative_gain > 0) {
         ESP_LOGE(TAG, "The cumulative gain is %f, which is larger than 0", cumulative_gain);
@@ -435,15 +586,10 @@ esp_err_t audio_mixer_set_read_cb(void *handle, audio_mixer_slot_t slot, mixer_i
         ESP_LOGE(TAG, "The ID of source number is out of range, line %d", __LINE__);
         return ESP_ERR_INVALID_ARG;
     }
-    slot_info_t *ch_list, *tmp;
-    STAILQ_FOREACH_SAFE(ch_list, &mixer->slot_in, next, tmp) {
-        if (ch_list->id == slot) {
-            ch_list->read = read;
-            ch_list->ctx = ctx;
-            ch_list->prv_ret = PREVIOUS_RETURN_VALID;
-            break;
-        }
-    }
+    mixer->slot[slot].read = read;
+    mixer->slot[slot].ctx = ctx;
+    mixer->slot[slot].prv_ret = PREVIOUS_RETURN_VALID;
+    __atomic_fetch_or(&mixer->slot[slot].update, SLOT_UPDATE_FORMAT, __ATOMIC_SEQ_CST);
     return ESP_OK;
 }
 
@@ -455,13 +601,8 @@ esp_err_t audio_mixer_reset_slot(void *handle, audio_mixer_slot_t slot)
         ESP_LOGE(TAG, "The index of source slot is out of range, idx:%d, line:%d", slot, __LINE__);
         return ESP_ERR_INVALID_ARG;
     }
-    slot_info_t *ch_list, *tmp;
-    STAILQ_FOREACH_SAFE(ch_list, &mixer->slot_in, next, tmp) {
-        if (ch_list->id == slot) {
-            ch_list->prv_ret = PREVIOUS_RETURN_VALID;
-            break;
-        }
-    }
+    mixer->slot[slot].prv_ret = PREVIOUS_RETURN_VALID;
+    __atomic_fetch_or(&mixer->slot[slot].update, SLOT_UPDATE_FORMAT, __ATOMIC_SEQ_CST);
     return ESP_OK;
 }
 
@@ -473,13 +614,37 @@ esp_err_t audio_mixer_set_channel(void *handle, audio_mixer_slot_t slot, int cha
         ESP_LOGE(TAG, "The index of source slot is out of range, idx:%d, line:%d", slot, __LINE__);
         return ESP_ERR_INVALID_ARG;
     }
-    if (CHECK_OUT_OF_RANGE(mixer->downmix_info.source_info[slot].channel, 1, 2)) {
-        ESP_LOGE(TAG, "The channel number[%d] does not support", mixer->downmix_info.source_info[slot].channel);
+    if (CHECK_OUT_OF_RANGE(channel_num, 1, 2)) {
+        ESP_LOGE(TAG, "The channel number[%d] does not support", channel_num);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (mixer->slot[slot].channel != channel_num) {
+        mixer->slot[slot].channel = channel_num;
+        __atomic_fetch_or(&mixer->slot[slot].update, SLOT_UPDATE_FORMAT, __ATOMIC_SEQ_CST);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_mixer_set_slot_format(void *handle, audio_mixer_slot_t slot, int sample_rate, int channel_num)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_ERR_INVALID_ARG);
+    audio_mixer_t *mixer = (audio_mixer_t *)handle;
+    if (slot >= mixer->max_in_slot) {
+        ESP_LOGE(TAG, "The index of source slot is out of range, idx:%d, line:%d", slot, __LINE__);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (sample_rate && CHECK_OUT_OF_RANGE(sample_rate, SAMPLERATE_MIN, SAMPLERATE_MAX)) {
+        ESP_LOGE(TAG, "Unsupported sample rate, %d", sample_rate);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (channel_num && CHECK_OUT_OF_RANGE(channel_num, 1, 2)) {
+        ESP_LOGE(TAG, "The channel number[%d] does not support", channel_num);
         return ESP_ERR_INVALID_ARG;
     }
-    if (mixer->downmix_info.source_info[slot].channel != channel_num) {
-        mixer->downmix_info.source_info[slot].channel = channel_num;
-        mixer->reopen = true;
+    if (mixer->slot[slot].sample_rate != sample_rate || mixer->slot[slot].channel != channel_num) {
+        mixer->slot[slot].sample_rate = sample_rate;
+        mixer->slot[slot].channel = channel_num;
+        __atomic_fetch_or(&mixer->slot[slot].update, SLOT_UPDATE_FORMAT, __ATOMIC_SEQ_CST);
     }
     return ESP_OK;
 }
@@ -496,15 +661,13 @@ esp_err_t audio_mixer_set_gain(void *handle, audio_mixer_slot_t slot, float gain
         ESP_LOGE(TAG, "The gain is out of range [%d, %d]", GAIN_MIN, GAIN_MAX);
         return ESP_ERR_INVALID_ARG;
     }
-    if ((mixer->downmix_info.source_info[slot].gain[0] - gain0 < 0.01)
-        && (mixer->downmix_info.source_info[slot].gain[0] - gain0 > 0.01)
-        && (mixer->downmix_info.source_info[slot].gain[1] - gain1 < 0.01)
-        && (mixer->downmix_info.source_info[slot].gain[1] - gain1 > 0.01)) {
+    if (fabsf(mixer->slot[slot].gain[0] - gain0) < 0.01f
+        && fabsf(mixer->slot[slot].gain[1] - gain1) < 0.01f) {
         return ESP_OK;
     }
-    mixer->downmix_info.source_info[slot].gain[0] = gain0;
-    mixer->downmix_info.source_info[slot].gain[1] = gain1;
-    mixer->reopen = true;
+    mixer->slot[slot].gain[0] = gain0;
+    mixer->slot[slot].gain[1] = gain1;
+    __atomic_fetch_or(&mixer->slot[slot].update, SLOT_UPDATE_GAIN, __ATOMIC_SEQ_CST);
     return ESP_OK;
 }
 
@@ -520,9 +683,9 @@ esp_err_t audio_mixer_set_transit_time(void *handle, audio_mixer_slot_t slot, in
         ESP_LOGE(TAG, "The set transit_time must be greater than or equal to zero (%d)", transit_time);
         return ESP_ERR_INVALID_ARG;
     }
-    if (mixer->downmix_info.source_info[slot].transit_time != transit_time) {
-        mixer->downmix_info.source_info[slot].transit_time = transit_time;
-        mixer->reopen = true;
+    if (mixer->slot[slot].transit_time != transit_time) {
+        mixer->slot[slot].transit_time = transit_time;
+        __atomic_fetch_or(&mixer->slot[slot].update, SLOT_UPDATE_GAIN, __ATOMIC_SEQ_CST);
     }
     return ESP_OK;
 }
@@ -39,6 +39,8 @@ extern "C"
     .origin_gain_db   = origin_gain,                                                   \
     .goal_gain_db     = goal_gain,                                                     \
     .transfer_time_ms = transfer_time,                                                 \
+    .sample_rate      = 0,                                                             \
+    .channel          = 0,                                                             \
     .read_cb          = NULL,                                                          \
     .cb_ctx           = NULL,                                                          \
 }
@@ -85,9 +87,12 @@ typedef enum {
 
 /**
  * @brief  Configuration structure for the audio mixer
+ *
+ * @note  `channel` and `sample_rate` describe the mixer output. Input slots may use other formats,
+ *        see `audio_mixer_slot_info_t` and `audio_mixer_set_slot_format`.
  */
 typedef struct {
-    uint8_t channel;         /*!< Channel number of the slot */
+    uint8_t channel;         /*!< Channel number of the mixer output */
     uint8_t bits;            /*!< Number of bits in the audio data. Currently just support 16 bits */
     int     sample_rate;     /*!< Sample rate for the audio mixer */
     int     task_stack;      /*!< Task stack size for the audio mixer */
@@ -104,6 +109,8 @@ typedef struct {
     int8_t              origin_gain_db;    /*!< Original gain of the slot in decibels */
     int8_t              goal_gain_db;      /*!< Goal gain of the slot in decibels */
     int                 transfer_time_ms;  /*!< Transfer time for the slot in milliseconds */
+    int                 sample_rate;       /*!< Sample rate of the slot data, 0 means same as the mixer output */
+    int                 channel;           /*!< Channel number of the slot data, 0 means same as the mixer output */
     mixer_io_callback_t read_cb;           /*!< Read callback function for the slot */
     void               *cb_ctx;            /*!< Context to be passed to the read callback function */
 } audio_mixer_slot_info_t;
@@ -225,9 +232,30 @@ esp_err_t audio_mixer_reset_slot(void *handle, audio_mixer_slot_t slot);
  */
 esp_err_t audio_mixer_set_channel(void *handle, audio_mixer_slot_t slot, int channel_num);
 
+/**
+ * @brief  Sets the input format for a specific slot in the audio mixer
+ *
+ * @note  The slot data is converted to the mixer output format by the mixer itself, channel conversion
+ *        and linear interpolation resampling are done while mixing, no extra pipeline is needed.
+ *        The new format takes effect on the next read of the slot, and drops the resampler history of the slot.
+ *
+ * @param[in]  handle       Handle of the audio mixer
+ * @param[in]  slot         Index of the slot for which the format is set
+ * @param[in]  sample_rate  Sample rate of the slot data, 0 means same as the mixer output
+ * @param[in]  channel_num  Channel number of the slot data, 0 means same as the mixer output
+ *
+ * @return
+ *       - ESP_OK               On success
+ *       - ESP_ERR_INVALID_ARG  NULL pointer or invalid configuration
+ */
+esp_err_t audio_mixer_set_slot_format(void *handle, audio_mixer_slot_t slot, int sample_rate, int channel_num);
+
 /**
  * @brief  Sets the gain for a specific slot in the audio mixer
  *
+ * @note  The slot gain ramps from `gain0` to `gain1` within the transit time of the slot.
+ *        Gains above +24 dB are clipped to +24 dB.
+ *
  * @param[in]  handle  Handle of the audio mixer
  * @param[in]  slot    Index of the slot for which the gain is set
  * @param[in]  gain0   Gain value for the source gain
@@ -21,6 +21,7 @@
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  *
  */
+#include <string.h>
 #include "esp_log.h"
 #include "esp_err.h"
 #include "audio_mem.h"
@@ -66,8 +67,8 @@ TEST_CASE("audio-mixer", "audio-mixer")
     audio_mixer_config_t mixer_cfg = AUDIO_MIXER_DEFAULT_CONF(16000, 2, 16, 2);
 
     audio_mixer_slot_info_t in_source[2] = {
-        AUDIO_MIXER_DEFAULT_CHANNEL_INFO_CONF(1, 16, -6, -6, 0),
-        AUDIO_MIXER_DEFAULT_CHANNEL_INFO_CONF(1, 16, -6, -6, 0),
+        AUDIO_MIXER_DEFAULT_CHANNEL_INFO_CONF(-6, -6, 0),
+        AUDIO_MIXER_DEFAULT_CHANNEL_INFO_CONF(-6, -6, 0),
     };
 
     TEST_ASSERT_EQUAL(ESP_OK, audio_mixer_init(&mixer_cfg, &mixer_handle));
@@ -79,4 +80,82 @@ TEST_CASE("audio-mixer", "audio-mixer")
     TEST_ASSERT_EQUAL(ESP_OK, audio_mixer_data_is_ready(mixer_handle));
     vTaskDelay(10000 / portTICK_PERIOD_MS);
     TEST_ASSERT_EQUAL(ESP_OK, audio_mixer_deinit(mixer_handle));
-}
\ No newline at end of file
+}
+
+typedef struct {
+    int     channel;
+    int     frames;
+    int16_t value;
+} mixer_test_src_t;
+
+typedef struct {
+    int     frames;
+    int     bad;
+} mixer_test_sink_t;
+
+static esp_err_t audio_mixer_const_read(uint8_t *data, int len, void *ctx)
+{
+    mixer_test_src_t *src = (mixer_test_src_t *)ctx;
+    int16_t *pcm = (int16_t *)data;
+    int frames = len / (src->channel * sizeof(int16_t));
+    if (frames > src->frames) {
+        frames = src->frames;
+    }
+    for (int i = 0; i < frames * src->channel; i++) {
+        pcm[i] = src->value;
+    }
+    src->frames -= frames;
+    return frames * src->channel * sizeof(int16_t);
+}
+
+static esp_err_t audio_mixer_check_write(uint8_t *data, int len, void *ctx)
+{
+    mixer_test_sink_t *sink = (mixer_test_sink_t *)ctx;
+    int16_t *pcm = (int16_t *)data;
+    for (int i = 0; i < len / sizeof(int16_t); i++) {
+        // 1000 from the music slot plus 2000 from the prompt slot while both are playing
+        if (pcm[i] != 3000 && pcm[i] != 1000) {
+            sink->bad++;
+        }
+    }
+    sink->frames += len / (2 * sizeof(int16_t));
+    return len;
+}
+
+TEST_CASE("audio-mixer slots with different sample rate and channel", "[audio-mixer]")
+{
+    void *mixer_handle = NULL;
+    audio_mixer_config_t mixer_cfg = AUDIO_MIXER_DEFAULT_CONF(44100, 2, 16, 3);
+    // 1s of 44.1kHz stereo music, 0.5s of 16kHz mono prompt and one idle slot
+    mixer_test_src_t music = { .channel = 2, .frames = 44100, .value = 1000 };
+    mixer_test_src_t prompt = { .channel = 1, .frames = 8000, .value = 2000 };
+    mixer_test_sink_t sink = { 0 };
+    audio_mixer_slot_info_t in_source[3] = {
+        AUDIO_MIXER_DEFAULT_CHANNEL_INFO_CONF(0, 0, 0),
+        AUDIO_MIXER_DEFAULT_CHANNEL_INFO_CONF(0, 0, 0),
+        AUDIO_MIXER_DEFAULT_CHANNEL_INFO_CONF(0, 0, 0),
+    };
+    in_source[0].read_cb = audio_mixer_const_read;
+    in_source[0].cb_ctx = &music;
+    in_source[1].sample_rate = 16000;
+    in_source[1].channel = 1;
+    in_source[1].read_cb = audio_mixer_const_read;
+    in_source[1].cb_ctx = &prompt;
+
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mixer_init(&mixer_cfg, &mixer_handle));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mixer_configure_in(mixer_handle, in_source, 3));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mixer_configure_out(mixer_handle, audio_mixer_check_write, &sink));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, audio_mixer_set_slot_format(mixer_handle, AUDIO_MIXER_SLOT_2, 16000, 3));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, audio_mixer_set_channel(mixer_handle, AUDIO_MIXER_SLOT_2, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mixer_data_is_ready(mixer_handle));
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+
+    audio_mixer_state_t state = AUDIO_MIXER_STATE_UNKNOWN;
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mixer_get_state(mixer_handle, &state));
+    TEST_ASSERT_EQUAL(AUDIO_MIXER_STATE_IDLE, state);
+    TEST_ASSERT_EQUAL(0, music.frames);
+    TEST_ASSERT_EQUAL(0, prompt.frames);
+    TEST_ASSERT_EQUAL(44100, sink.frames);
+    TEST_ASSERT_EQUAL(0, sink.bad);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mixer_deinit(mixer_handle));
+}
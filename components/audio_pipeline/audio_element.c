@@ -30,6 +30,7 @@
 #include "freertos/event_groups.h"
 
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "audio_element.h"
 #include "audio_mem.h"
 #include "audio_mutex.h"
@@ -123,6 +124,11 @@ struct audio_element {
     volatile bool               is_running;
     volatile bool               task_run;
     volatile bool               stopping;
+    SemaphoreHandle_t           host_wakeup;
+
+    /* Statistics */
+    bool                        stats_enabled;
+    audio_element_stats_t       stats;
 };
 
 const static int STOPPED_BIT = BIT0;
@@ -150,7 +156,11 @@ static esp_err_t audio_element_cmd_send(audio_element_handle_t el, audio_element
         .cmd = cmd,
     };
     ESP_LOGV(TAG, "[%s]evt internal cmd = %d", el->tag, msg.cmd);
-    return audio_event_iface_cmd(el->iface_event, &msg);
+    esp_err_t ret = audio_event_iface_cmd(el->iface_event, &msg);
+    if (ret == ESP_OK && el->host_wakeup) {
+        xSemaphoreGive(el->host_wakeup);
+    }
+    return ret;
 }
 
 static esp_err_t audio_element_msg_sendout(audio_element_handle_t el, audio_event_iface_msg_t *msg)
@@ -331,13 +341,53 @@ static esp_err_t audio_element_on_cmd(audio_event_iface_msg_t *msg, void *contex
     return ret;
 }
 
-static esp_err_t audio_element_process_running(audio_element_handle_t el)
+static void audio_element_stats_on_process(audio_element_handle_t el, int64_t start_us)
+{
+    uint32_t used_us = (uint32_t)(esp_timer_get_time() - start_us);
+    el->stats.process_count++;
+    el->stats.process_total_us += used_us;
+    if (used_us < el->stats.process_min_us) {
+        el->stats.process_min_us = used_us;
+    }
+    if (used_us > el->stats.process_max_us) {
+        el->stats.process_max_us = used_us;
+    }
+}
+
+static void audio_element_stats_sample_fill(audio_element_handle_t el)
+{
+    if (el->read_type != IO_TYPE_RB || el->in.input_rb == NULL) {
+        return;
+    }
+    int size = rb_get_size(el->in.input_rb);
+    if (size <= 0) {
+        return;
+    }
+    int level = rb_bytes_filled(el->in.input_rb) * AEL_STATS_FILL_LEVELS / size;
+    if (level >= AEL_STATS_FILL_LEVELS) {
+        level = AEL_STATS_FILL_LEVELS - 1;
+    }
+    el->stats.fill_level[level]++;
+}
+
+static esp_err_t audio_element_process_running(audio_element_handle_t el, int *out_len)
 {
     int process_len = -1;
+    int64_t start_us = 0;
     if (el->state < AEL_STATE_RUNNING || !el->is_running) {
         return ESP_ERR_INVALID_STATE;
     }
+    if (el->stats_enabled) {
+        audio_element_stats_sample_fill(el);
+        start_us = esp_timer_get_time();
+    }
     process_len = el->process(el, el->buf, el->buf_size);
+    if (el->stats_enabled) {
+        audio_element_stats_on_process(el, start_us);
+    }
+    if (out_len) {
+        *out_len = process_len;
+    }
     if (process_len <= 0) {
         switch (process_len) {
             case AEL_IO_ABORT:
@@ -374,26 +424,8 @@ static esp_err_t audio_element_process_running(audio_element_handle_t el)
     return ESP_OK;
 }
 
-audio_element_err_t audio_element_input(audio_element_handle_t el, char *buffer, int wanted_size)
+static void audio_element_input_check(audio_element_handle_t el, int in_len)
 {
-    int in_len = 0;
-    if (el->read_type == IO_TYPE_CB) {
-        if (el->in.read_cb.cb == NULL) {
-            ESP_LOGE(TAG, "[%s] Read IO Type callback but callback not set", el->tag);
-            return ESP_FAIL;
-        }
-        in_len = el->in.read_cb.cb(el, buffer, wanted_size, el->input_wait_time,
-                                   el->in.read_cb.ctx);
-    } else if (el->read_type == IO_TYPE_RB) {
-        if (el->in.input_rb == NULL) {
-            ESP_LOGE(TAG, "[%s] Read IO type ringbuf but ringbuf not set", el->tag);
-            return ESP_FAIL;
-        }
-        in_len = rb_read(el->in.input_rb, buffer, wanted_size, el->input_wait_time);
-    } else {
-        ESP_LOGE(TAG, "[%s] Invalid read IO type", el->tag);
-        return ESP_FAIL;
-    }
     if (in_len <= 0) {
         switch (in_len) {
             case AEL_IO_ABORT:
@@ -415,25 +447,10 @@ audio_element_err_t audio_element_input(audio_element_handle_t el, char *buffer,
                 break;
         }
     }
-    return in_len;
 }
 
-audio_element_err_t audio_element_output(audio_element_handle_t el, char *buffer, int write_size)
+static void audio_element_output_check(audio_element_handle_t el, int output_len)
 {
-    int output_len = 0;
-    if (el->write_type == IO_TYPE_CB) {
-        if (el->out.write_cb.cb && write_size) {
-            output_len = el->out.write_cb.cb(el, buffer, write_size, el->output_wait_time,
-                                             el->out.write_cb.ctx);
-        }
-    } else if (el->write_type == IO_TYPE_RB) {
-        if (el->out.output_rb && write_size) {
-            output_len = rb_write(el->out.output_rb, buffer, write_size, el->output_wait_time);
-            if ((rb_bytes_filled(el->out.output_rb) > el->out_buf_size_expect) || (output_len < 0)) {
-                xEventGroupSetBits(el->state_event, BUFFER_REACH_LEVEL_BIT);
-            }
-        }
-    }
     if (output_len <= 0) {
         switch (output_len) {
             case AEL_IO_ABORT:
@@ -455,11 +472,136 @@ audio_element_err_t audio_element_output(audio_element_handle_t el, char *buffer
                 break;
         }
     }
+}
+
+audio_element_err_t audio_element_input(audio_element_handle_t el, char *buffer, int wanted_size)
+{
+    int in_len = 0;
+    int64_t start_us = el->stats_enabled ? esp_timer_get_time() : 0;
+    if (el->read_type == IO_TYPE_CB) {
+        if (el->in.read_cb.cb == NULL) {
+            ESP_LOGE(TAG, "[%s] Read IO Type callback but callback not set", el->tag);
+            return ESP_FAIL;
+        }
+        in_len = el->in.read_cb.cb(el, buffer, wanted_size, el->input_wait_time,
+                                   el->in.read_cb.ctx);
+    } else if (el->read_type == IO_TYPE_RB) {
+        if (el->in.input_rb == NULL) {
+            ESP_LOGE(TAG, "[%s] Read IO type ringbuf but ringbuf not set", el->tag);
+            return ESP_FAIL;
+        }
+        in_len = rb_read(el->in.input_rb, buffer, wanted_size, el->input_wait_time);
+    } else {
+        ESP_LOGE(TAG, "[%s] Invalid read IO type", el->tag);
+        return ESP_FAIL;
+    }
+    if (el->stats_enabled) {
+        el->stats.input_wait_us += esp_timer_get_time() - start_us;
+        if (in_len > 0) {
+            el->stats.bytes_in += in_len;
+        }
+    }
+    audio_element_input_check(el, in_len);
+    return in_len;
+}
+
+audio_element_err_t audio_element_output(audio_element_handle_t el, char *buffer, int write_size)
+{
+    int output_len = 0;
+    int64_t start_us = el->stats_enabled ? esp_timer_get_time() : 0;
+    if (el->write_type == IO_TYPE_CB) {
+        if (el->out.write_cb.cb && write_size) {
+            output_len = el->out.write_cb.cb(el, buffer, write_size, el->output_wait_time,
+                                             el->out.write_cb.ctx);
+        }
+    } else if (el->write_type == IO_TYPE_RB) {
+        if (el->out.output_rb && write_size) {
+            output_len = rb_write(el->out.output_rb, buffer, write_size, el->output_wait_time);
+            if ((rb_bytes_filled(el->out.output_rb) > el->out_buf_size_expect) || (output_len < 0)) {
+                xEventGroupSetBits(el->state_event, BUFFER_REACH_LEVEL_BIT);
+            }
+        }
+    }
+    if (el->stats_enabled) {
+        el->stats.output_wait_us += esp_timer_get_time() - start_us;
+        if (output_len > 0) {
+            el->stats.bytes_out += output_len;
+        }
+    }
+    audio_element_output_check(el, output_len);
     return output_len;
 }
-void audio_element_task(void *pv)
+
+audio_element_err_t audio_element_input_acquire(audio_element_handle_t el, char **buffer, int wanted_size)
+{
+    if (el->read_type != IO_TYPE_RB) {
+        return AEL_IO_FAIL;
+    }
+    if (el->in.input_rb == NULL) {
+        ESP_LOGE(TAG, "[%s] Read IO type ringbuf but ringbuf not set", el->tag);
+        return ESP_FAIL;
+    }
+    int64_t start_us = el->stats_enabled ? esp_timer_get_time() : 0;
+    int in_len = rb_acquire_read(el->in.input_rb, buffer, wanted_size, el->input_wait_time);
+    if (el->stats_enabled) {
+        el->stats.input_wait_us += esp_timer_get_time() - start_us;
+    }
+    audio_element_input_check(el, in_len);
+    return in_len;
+}
+
+esp_err_t audio_element_input_release(audio_element_handle_t el, int size)
+{
+    if (el->read_type != IO_TYPE_RB || el->in.input_rb == NULL) {
+        return ESP_FAIL;
+    }
+    if (rb_release_read(el->in.input_rb, size) < 0) {
+        return ESP_FAIL;
+    }
+    if (el->stats_enabled) {
+        el->stats.bytes_in += size;
+    }
+    return ESP_OK;
+}
+
+audio_element_err_t audio_element_output_acquire(audio_element_handle_t el, char **buffer, int wanted_size)
+{
+    if (el->write_type != IO_TYPE_RB) {
+        return AEL_IO_FAIL;
+    }
+    if (el->out.output_rb == NULL) {
+        ESP_LOGE(TAG, "[%s] Write IO type ringbuf but ringbuf not set", el->tag);
+        return ESP_FAIL;
+    }
+    int64_t start_us = el->stats_enabled ? esp_timer_get_time() : 0;
+    int output_len = rb_acquire_write(el->out.output_rb, buffer, wanted_size, el->output_wait_time);
+    if (el->stats_enabled) {
+        el->stats.output_wait_us += esp_timer_get_time() - start_us;
+    }
+    if (output_len < 0) {
+        xEventGroupSetBits(el->state_event, BUFFER_REACH_LEVEL_BIT);
+    }
+    audio_element_output_check(el, output_len);
+    return output_len;
+}
+
+audio_element_err_t audio_element_output_commit(audio_element_handle_t el, int size)
+{
+    if (el->write_type != IO_TYPE_RB || el->out.output_rb == NULL) {
+        return ESP_FAIL;
+    }
+    int output_len = rb_commit_write(el->out.output_rb, size);
+    if ((rb_bytes_filled(el->out.output_rb) > el->out_buf_size_expect) || (output_len < 0)) {
+        xEventGroupSetBits(el->state_event, BUFFER_REACH_LEVEL_BIT);
+    }
+    if (el->stats_enabled && output_len > 0) {
+        el->stats.bytes_out += output_len;
+    }
+    return output_len;
+}
+
+static void audio_element_task_prepare(audio_element_handle_t el)
 {
-    audio_element_handle_t el = (audio_element_handle_t)pv;
     el->task_run = true;
     xEventGroupSetBits(el->state_event, TASK_CREATED_BIT);
     audio_element_force_set_state(el, AEL_STATE_INIT);
@@ -472,6 +614,30 @@ void audio_element_task(void *pv)
         });
     }
     xEventGroupClearBits(el->state_event, STOPPED_BIT);
+}
+
+static void audio_element_task_cleanup(audio_element_handle_t el)
+{
+    if (el->is_open && el->close) {
+        ESP_LOGD(TAG, "[%s-%p] el closed", el->tag, el);
+        el->close(el);
+        audio_element_force_set_state(el, AEL_STATE_STOPPED);
+    }
+    el->is_open = false;
+    audio_free(el->buf);
+    el->buf = NULL;
+    el->stopping = false;
+    el->task_run = false;
+    el->host_wakeup = NULL;
+    xEventGroupSetBits(el->state_event, STOPPED_BIT);
+    xEventGroupSetBits(el->state_event, RESUMED_BIT);
+    xEventGroupSetBits(el->state_event, TASK_DESTROYED_BIT);
+}
+
+void audio_element_task(void *pv)
+{
+    audio_element_handle_t el = (audio_element_handle_t)pv;
+    audio_element_task_prepare(el);
     esp_err_t ret = ESP_OK;
     while (el->task_run) {
         if ((ret = audio_event_iface_waiting_cmd_msg(el->iface_event)) != ESP_OK) {
@@ -484,28 +650,68 @@ void audio_element_task(void *pv)
                 break;
             }
         }
-        if (audio_element_process_running(el) != ESP_OK) {
+        if (audio_element_process_running(el, NULL) != ESP_OK) {
             // continue;
         }
     }
-
-    if (el->is_open && el->close) {
-        ESP_LOGD(TAG, "[%s-%p] el closed", el->tag, el);
-        el->close(el);
-        audio_element_force_set_state(el, AEL_STATE_STOPPED);
-    }
-    el->is_open = false;
-    audio_free(el->buf);
-    el->buf = NULL;
-    el->stopping = false;
-    el->task_run = false;
     ESP_LOGD(TAG, "[%s-%p] el task deleted,%d", el->tag, el, uxTaskGetStackHighWaterMark(NULL));
-    xEventGroupSetBits(el->state_event, STOPPED_BIT);
-    xEventGroupSetBits(el->state_event, RESUMED_BIT);
-    xEventGroupSetBits(el->state_event, TASK_DESTROYED_BIT);
+    audio_element_task_cleanup(el);
     audio_thread_delete_task(&el->audio_thread);
 }
 
+esp_err_t audio_element_run_cooperative(audio_element_handle_t el, SemaphoreHandle_t wakeup)
+{
+    AUDIO_NULL_CHECK(TAG, el, return ESP_ERR_INVALID_ARG);
+    if (el->task_run) {
+        ESP_LOGD(TAG, "[%s-%p] Element already hosted", el->tag, el);
+        return ESP_OK;
+    }
+    audio_event_iface_discard(el->iface_event);
+    xEventGroupClearBits(el->state_event, TASK_CREATED_BIT | TASK_DESTROYED_BIT);
+    el->host_wakeup = wakeup;
+    audio_element_task_prepare(el);
+    if (el->task_run == false) {
+        el->host_wakeup = NULL;
+        audio_element_force_set_state(el, AEL_STATE_ERROR);
+        audio_element_report_status(el, AEL_STATUS_ERROR_OPEN);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "[%s-%p] Element hosted cooperatively", el->tag, el);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_cooperative_poll_cmd(audio_element_handle_t el)
+{
+    AUDIO_NULL_CHECK(TAG, el, return ESP_ERR_INVALID_ARG);
+    if (el->task_run == false) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    QueueHandle_t queue = audio_event_iface_get_msg_queue_handle(el->iface_event);
+    audio_event_iface_msg_t msg;
+    esp_err_t ret = ESP_OK;
+    while (queue && xQueueReceive(queue, &msg, 0) == pdTRUE) {
+        ret = audio_element_on_cmd(&msg, el);
+        if (ret != ESP_OK) {
+            xEventGroupSetBits(el->state_event, STOPPED_BIT);
+            if (ret == AEL_IO_ABORT) {
+                ESP_LOGD(TAG, "[%s-%p] el released by host", el->tag, el);
+                audio_element_task_cleanup(el);
+                return AEL_IO_ABORT;
+            }
+        }
+    }
+    return ret;
+}
+
+esp_err_t audio_element_cooperative_process(audio_element_handle_t el, int *process_len)
+{
+    esp_err_t ret = audio_element_cooperative_poll_cmd(el);
+    if (ret == AEL_IO_ABORT || ret == ESP_ERR_INVALID_STATE || ret == ESP_ERR_INVALID_ARG) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return audio_element_process_running(el, process_len);
+}
+
 esp_err_t audio_element_reset_state(audio_element_handle_t el)
 {
     return audio_element_force_set_state(el, AEL_STATE_INIT);
@@ -559,6 +765,31 @@ char *audio_element_get_tag(audio_element_handle_t el)
     return el->tag;
 }
 
+esp_err_t audio_element_enable_stats(audio_element_handle_t el, bool enable)
+{
+    AUDIO_NULL_CHECK(TAG, el, return ESP_ERR_INVALID_ARG);
+    if (enable) {
+        el->stats_enabled = false;
+        memset(&el->stats, 0, sizeof(el->stats));
+        el->stats.process_min_us = UINT32_MAX;
+    }
+    el->stats_enabled = enable;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_get_stats(audio_element_handle_t el, audio_element_stats_t *stats)
+{
+    AUDIO_NULL_CHECK(TAG, el, return ESP_ERR_INVALID_ARG);
+    AUDIO_NULL_CHECK(TAG, stats, return ESP_ERR_INVALID_ARG);
+    memcpy(stats, &el->stats, sizeof(audio_element_stats_t));
+    if (stats->process_count) {
+        stats->process_avg_us = (uint32_t)(stats->process_total_us / stats->process_count);
+    } else {
+        stats->process_min_us = 0;
+    }
+    return ESP_OK;
+}
+
 esp_err_t audio_element_set_uri(audio_element_handle_t el, const char *uri)
 {
     mutex_lock(el->lock);
@@ -35,6 +35,7 @@
 #include "audio_event_iface.h"
 #include "audio_mem.h"
 #include "audio_mutex.h"
+#include "audio_thread.h"
 #include "ringbuf.h"
 #include "audio_error.h"
 
@@ -62,6 +63,34 @@ typedef struct audio_element_item {
 
 typedef STAILQ_HEAD(audio_element_list, audio_element_item) audio_element_list_t;
 
+/**
+ * Direct connection between two elements of a cooperative pipeline.
+ * The writer copies straight into the reader's request buffer, only what it produces
+ * beyond the request is kept in `carry` for the next read. `carry` is allocated on the
+ * first overflow and grows to the largest one, so a reader asking for at least what
+ * the writer outputs per process never needs it.
+ * A link without `dst` belongs to an element kept by `audio_pipeline_breakup_elements`,
+ * its carried data goes to the next reader linked to it.
+ */
+typedef struct coop_link {
+    STAILQ_ENTRY(coop_link)     next;
+    audio_element_handle_t      src;
+    audio_element_handle_t      dst;
+    SemaphoreHandle_t           wakeup;
+    audio_mem_arena_handle_t    arena;
+    char                        *carry;
+    int                         carry_size;
+    int                         carry_len;
+    int                         carry_pos;
+    char                        *req_buf;
+    int                         req_len;
+    int                         req_filled;
+} coop_link_t;
+
+typedef STAILQ_HEAD(coop_link_list, coop_link) coop_link_list_t;
+
+static const int COOP_TASK_EXIT_BIT = BIT0;
+
 struct audio_pipeline {
     audio_element_list_t        el_list;
     ringbuf_list_t              rb_list;
@@ -69,8 +98,40 @@ struct audio_pipeline {
     SemaphoreHandle_t            lock;
     bool                        linked;
     audio_event_iface_handle_t  listener;
+    audio_pipeline_cfg_t        cfg;
+    coop_link_list_t            coop_list;
+    audio_element_handle_t      coop_sink;
+    audio_element_handle_t      coop_kept;
+    SemaphoreHandle_t           coop_wakeup;
+    EventGroupHandle_t          coop_state;
+    audio_thread_t              coop_thread;
+    volatile bool               coop_task_run;
+    volatile bool               coop_release;
+    audio_mem_arena_handle_t    arena;
 };
 
+static void *_pipeline_calloc(audio_pipeline_handle_t pipeline, size_t size)
+{
+    if (pipeline->arena == NULL) {
+        return audio_calloc(1, size);
+    }
+    audio_mem_arena_handle_t prev = audio_mem_arena_enter(pipeline->arena);
+    void *data = audio_calloc(1, size);
+    audio_mem_arena_exit(prev);
+    return data;
+}
+
+static ringbuf_handle_t _pipeline_rb_create(audio_pipeline_handle_t pipeline, int size)
+{
+    if (pipeline->arena == NULL) {
+        return rb_create_spsc(size, 1);
+    }
+    audio_mem_arena_handle_t prev = audio_mem_arena_enter(pipeline->arena);
+    ringbuf_handle_t rb = rb_create_spsc(size, 1);
+    audio_mem_arena_exit(prev);
+    return rb;
+}
+
 static audio_element_item_t *audio_pipeline_get_el_item_by_tag(audio_pipeline_handle_t pipeline, const char *tag)
 {
     audio_element_item_t *item;
@@ -106,7 +167,7 @@ static void audio_pipeline_register_element(audio_pipeline_handle_t pipeline, au
         ESP_LOGW(TAG, "%d, %s already exist in pipeline", __LINE__, audio_element_get_tag(el));
         return;
     }
-    audio_element_item_t *el_item = audio_calloc(1, sizeof(audio_element_item_t));
+    audio_element_item_t *el_item = _pipeline_calloc(pipeline, sizeof(audio_element_item_t));
     AUDIO_MEM_CHECK(TAG, el_item, return);
     el_item->el = el;
     el_item->linked = true;
@@ -126,7 +187,7 @@ static void audio_pipeline_unregister_element(audio_pipeline_handle_t pipeline,
 
 static void add_rb_to_audio_pipeline(audio_pipeline_handle_t pipeline, ringbuf_handle_t rb, audio_element_handle_t host_el)
 {
-    ringbuf_item_t *rb_item = (ringbuf_item_t *)audio_calloc(1, sizeof(ringbuf_item_t));
+    ringbuf_item_t *rb_item = (ringbuf_item_t *)_pipeline_calloc(pipeline, sizeof(ringbuf_item_t));
     AUDIO_MEM_CHECK(TAG, rb_item, return);
     rb_item->rb = rb;
     rb_item->linked = true;
@@ -135,6 +196,261 @@ static void add_rb_to_audio_pipeline(audio_pipeline_handle_t pipeline, ringbuf_h
     STAILQ_INSERT_TAIL(&pipeline->rb_list, rb_item, next);
 }
 
+static esp_err_t _coop_carry_grow(coop_link_t *link, int size)
+{
+    audio_mem_arena_handle_t prev = NULL;
+    if (link->arena) {
+        prev = audio_mem_arena_enter(link->arena);
+    }
+    char *carry = audio_realloc(link->carry, size);
+    if (link->arena) {
+        audio_mem_arena_exit(prev);
+    }
+    if (carry == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    link->carry = carry;
+    link->carry_size = size;
+    return ESP_OK;
+}
+
+static int _coop_write(audio_element_handle_t el, char *buf, int len, TickType_t ticks, void *ctx)
+{
+    coop_link_t *link = (coop_link_t *)ctx;
+    int copied = 0;
+    if (link->req_buf && link->req_filled < link->req_len) {
+        copied = link->req_len - link->req_filled;
+        if (copied > len) {
+            copied = len;
+        }
+        memcpy(link->req_buf + link->req_filled, buf, copied);
+        link->req_filled += copied;
+    }
+    int remain = len - copied;
+    if (remain > 0) {
+        if (link->carry_pos > 0) {
+            memmove(link->carry, link->carry + link->carry_pos, link->carry_len - link->carry_pos);
+            link->carry_len -= link->carry_pos;
+            link->carry_pos = 0;
+        }
+        if (remain > link->carry_size - link->carry_len
+            && _coop_carry_grow(link, link->carry_len + remain) != ESP_OK) {
+            ESP_LOGW(TAG, "[%s] No memory to carry data, %d of %d bytes taken", audio_element_get_tag(el),
+                     copied + link->carry_size - link->carry_len, len);
+            remain = link->carry_size - link->carry_len;
+        }
+        memcpy(link->carry + link->carry_len, buf + copied, remain);
+        link->carry_len += remain;
+    }
+    return copied + remain;
+}
+
+static int _coop_read(audio_element_handle_t el, char *buf, int len, TickType_t ticks, void *ctx)
+{
+    coop_link_t *link = (coop_link_t *)ctx;
+    if (link->carry_len > link->carry_pos) {
+        int rlen = link->carry_len - link->carry_pos;
+        if (rlen > len) {
+            rlen = len;
+        }
+        memcpy(buf, link->carry + link->carry_pos, rlen);
+        link->carry_pos += rlen;
+        if (link->carry_pos == link->carry_len) {
+            link->carry_pos = 0;
+            link->carry_len = 0;
+        }
+        return rlen;
+    }
+    int ret = 0;
+    link->req_buf = buf;
+    link->req_len = len;
+    link->req_filled = 0;
+    while (link->req_filled == 0) {
+        int process_len = 0;
+        if (audio_element_cooperative_process(link->src, &process_len) != ESP_OK) {
+            audio_element_state_t state = audio_element_get_state(link->src);
+            if (state == AEL_STATE_FINISHED) {
+                ret = AEL_IO_DONE;
+            } else if (state == AEL_STATE_STOPPED || state == AEL_STATE_ERROR) {
+                ret = AEL_IO_ABORT;
+            } else {
+                // The writer is paused or not started yet, wait for a command then let the host handle it
+                xSemaphoreTake(link->wakeup, ticks);
+                ret = AEL_IO_TIMEOUT;
+            }
+            break;
+        }
+        if (process_len == AEL_IO_TIMEOUT) {
+            ret = AEL_IO_TIMEOUT;
+            break;
+        }
+    }
+    if (link->req_filled > 0) {
+        ret = link->req_filled;
+    }
+    link->req_buf = NULL;
+    link->req_len = 0;
+    link->req_filled = 0;
+    return ret;
+}
+
+static void audio_pipeline_coop_task(void *pv)
+{
+    audio_pipeline_handle_t pipeline = (audio_pipeline_handle_t)pv;
+    audio_element_item_t *el_item;
+    ESP_LOGI(TAG, "Cooperative pipeline task started, sink:%s", audio_element_get_tag(pipeline->coop_sink));
+    while (pipeline->coop_release == false) {
+        int hosted = 0;
+        STAILQ_FOREACH(el_item, &pipeline->el_list, next) {
+            if (el_item->linked || el_item->el == pipeline->coop_kept) {
+                esp_err_t ret = audio_element_cooperative_poll_cmd(el_item->el);
+                if (ret != ESP_ERR_INVALID_STATE && ret != AEL_IO_ABORT) {
+                    hosted++;
+                }
+            }
+        }
+        if (hosted == 0) {
+            break;
+        }
+        if (pipeline->coop_sink == NULL
+            || audio_element_cooperative_process(pipeline->coop_sink, NULL) != ESP_OK) {
+            xSemaphoreTake(pipeline->coop_wakeup, portMAX_DELAY);
+        }
+    }
+    ESP_LOGD(TAG, "Cooperative pipeline task deleted,%d", uxTaskGetStackHighWaterMark(NULL));
+    audio_thread_t thread = pipeline->coop_thread;
+    pipeline->coop_task_run = false;
+    // The pipeline may be released as soon as the bit is set
+    xEventGroupSetBits(pipeline->coop_state, COOP_TASK_EXIT_BIT);
+    audio_thread_delete_task(&thread);
+}
+
+static esp_err_t audio_pipeline_coop_start_task(audio_pipeline_handle_t pipeline)
+{
+    if (pipeline->coop_task_run) {
+        return ESP_OK;
+    }
+    pipeline->coop_task_run = true;
+    xEventGroupClearBits(pipeline->coop_state, COOP_TASK_EXIT_BIT);
+    if (audio_thread_create(&pipeline->coop_thread, "pipeline", audio_pipeline_coop_task, pipeline, pipeline->cfg.task_stack,
+                            pipeline->cfg.task_prio, pipeline->cfg.stack_in_ext, pipeline->cfg.task_core) != ESP_OK) {
+        pipeline->coop_task_run = false;
+        xEventGroupSetBits(pipeline->coop_state, COOP_TASK_EXIT_BIT);
+        ESP_LOGE(TAG, "Create cooperative pipeline task failed");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t audio_pipeline_coop_run(audio_pipeline_handle_t pipeline)
+{
+    audio_element_item_t *el_item;
+    STAILQ_FOREACH(el_item, &pipeline->el_list, next) {
+        if (el_item->linked
+            && ((AEL_STATE_INIT == audio_element_get_state(el_item->el))
+                || (AEL_STATE_STOPPED == audio_element_get_state(el_item->el))
+                || (AEL_STATE_FINISHED == audio_element_get_state(el_item->el))
+                || (AEL_STATE_ERROR == audio_element_get_state(el_item->el)))) {
+            if (audio_element_run_cooperative(el_item->el, pipeline->coop_wakeup) != ESP_OK) {
+                return ESP_FAIL;
+            }
+        }
+    }
+    return audio_pipeline_coop_start_task(pipeline);
+}
+
+static void audio_pipeline_coop_wait_exit(audio_pipeline_handle_t pipeline, TickType_t ticks_to_wait)
+{
+    if (pipeline->coop_state == NULL) {
+        return;
+    }
+    EventBits_t uxBits = xEventGroupWaitBits(pipeline->coop_state, COOP_TASK_EXIT_BIT, false, true, ticks_to_wait);
+    if ((uxBits & COOP_TASK_EXIT_BIT) == 0) {
+        ESP_LOGW(TAG, "Cooperative pipeline task exit timeout[%d]", (int)ticks_to_wait);
+    }
+}
+
+static void audio_pipeline_coop_free_link(audio_pipeline_handle_t pipeline, coop_link_t *link)
+{
+    ESP_LOGD(TAG, "audio_pipeline_unlink, src:%p, dst:%p", link->src, link->dst);
+    STAILQ_REMOVE(&pipeline->coop_list, link, coop_link, next);
+    audio_element_set_write_cb(link->src, NULL, NULL);
+    if (link->dst) {
+        audio_element_set_read_cb(link->dst, NULL, NULL);
+    }
+    audio_free(link->carry);
+    audio_free(link);
+}
+
+static void audio_pipeline_coop_unlink(audio_pipeline_handle_t pipeline)
+{
+    coop_link_t *link, *tmp;
+    STAILQ_FOREACH_SAFE(link, &pipeline->coop_list, next, tmp) {
+        audio_pipeline_coop_free_link(pipeline, link);
+    }
+    STAILQ_INIT(&pipeline->coop_list);
+    pipeline->coop_sink = NULL;
+}
+
+/* The kept element stays hosted and its output link keeps the data nobody read yet, the others are released */
+static void audio_pipeline_coop_breakup(audio_pipeline_handle_t pipeline, audio_element_handle_t kept_ctx_el)
+{
+    audio_element_item_t *el_item, *kept_item = NULL;
+    coop_link_t *link, *tmp;
+    STAILQ_FOREACH(el_item, &pipeline->el_list, next) {
+        if (el_item->linked == false) {
+            continue;
+        }
+        if (el_item->el == kept_ctx_el) {
+            if ((audio_element_get_state(el_item->el) == AEL_STATE_RUNNING)
+                || (audio_element_get_state(el_item->el) == AEL_STATE_PAUSED)) {
+                kept_item = el_item;
+                ESP_LOGD(TAG, "found kept_ctx_el:%p", el_item->el);
+                continue;
+            }
+            ESP_LOGW(TAG, "found kept_ctx_el, but not set kept, el:%p", el_item->el);
+        }
+        audio_element_terminate(el_item->el);
+    }
+    // Release the pipeline task before touching the links, the next run starts a new one
+    pipeline->coop_release = true;
+    xSemaphoreGive(pipeline->coop_wakeup);
+    audio_pipeline_coop_wait_exit(pipeline, 2000 / portTICK_PERIOD_MS);
+    pipeline->coop_release = false;
+    STAILQ_FOREACH_SAFE(link, &pipeline->coop_list, next, tmp) {
+        if (kept_item && link->src == kept_item->el) {
+            audio_element_set_read_cb(link->dst, NULL, NULL);
+            link->dst = NULL;
+            continue;
+        }
+        audio_pipeline_coop_free_link(pipeline, link);
+    }
+    pipeline->coop_sink = NULL;
+    pipeline->coop_kept = kept_item ? kept_item->el : NULL;
+    STAILQ_FOREACH(el_item, &pipeline->el_list, next) {
+        if (el_item->linked) {
+            el_item->linked = false;
+            el_item->kept_ctx = (el_item == kept_item);
+            if (el_item != kept_item) {
+                audio_element_reset_state(el_item->el);
+            }
+        }
+    }
+}
+
+/* Called after relinking, a kept element linked as the last one has no reader for its carried data */
+static void audio_pipeline_coop_drop_kept(audio_pipeline_handle_t pipeline)
+{
+    coop_link_t *link, *tmp;
+    STAILQ_FOREACH_SAFE(link, &pipeline->coop_list, next, tmp) {
+        audio_element_item_t *item = audio_pipeline_get_el_item_by_handle(pipeline, link->src);
+        if (link->dst == NULL && (item == NULL || item->linked)) {
+            ESP_LOGW(TAG, "Drop %d bytes kept from [%s]", link->carry_len - link->carry_pos, audio_element_get_tag(link->src));
+            audio_pipeline_coop_free_link(pipeline, link);
+        }
+    }
+}
+
 static void debug_pipeline_lists(audio_pipeline_handle_t pipeline, int line, const char *func)
 {
     audio_element_item_t *el_item, *el_tmp;
@@ -261,10 +577,55 @@ audio_pipeline_handle_t audio_pipeline_init(audio_pipeline_cfg_t *config)
             (pipeline->lock = mutex_create())
         );
 
-    AUDIO_MEM_CHECK(TAG, _success, return NULL);
+    AUDIO_MEM_CHECK(TAG, _success, {
+        audio_free(pipeline);
+        return NULL;
+    });
     STAILQ_INIT(&pipeline->el_list);
     STAILQ_INIT(&pipeline->rb_list);
+    STAILQ_INIT(&pipeline->coop_list);
 
+    if (config) {
+        pipeline->cfg = *config;
+    }
+    if (pipeline->cfg.arena_chunk_size > 0) {
+        audio_mem_arena_cfg_t arena_cfg = {
+            .name = "pipeline",
+            .chunk_size = pipeline->cfg.arena_chunk_size,
+            .budget = pipeline->cfg.arena_budget,
+            .place = AUDIO_MEM_PLACE_DEFAULT,
+        };
+        pipeline->arena = audio_mem_arena_create(&arena_cfg);
+        AUDIO_MEM_CHECK(TAG, pipeline->arena, {
+            mutex_destroy(pipeline->lock);
+            audio_free(pipeline);
+            return NULL;
+        });
+    }
+    if (pipeline->cfg.cooperative) {
+        pipeline->coop_wakeup = xSemaphoreCreateBinary();
+        pipeline->coop_state = xEventGroupCreate();
+        AUDIO_MEM_CHECK(TAG, pipeline->coop_wakeup && pipeline->coop_state, {
+            if (pipeline->coop_wakeup) {
+                vSemaphoreDelete(pipeline->coop_wakeup);
+            }
+            if (pipeline->coop_state) {
+                vEventGroupDelete(pipeline->coop_state);
+            }
+            if (pipeline->arena) {
+                audio_mem_arena_destroy(pipeline->arena);
+            }
+            mutex_destroy(pipeline->lock);
+            audio_free(pipeline);
+            return NULL;
+        });
+        xEventGroupSetBits(pipeline->coop_state, COOP_TASK_EXIT_BIT);
+        if (pipeline->cfg.task_stack <= 0) {
+            pipeline->cfg.task_stack = DEFAULT_PIPELINE_TASK_STACK;
+        }
+        ESP_LOGI(TAG, "Cooperative pipeline, stack:%d, prio:%d, core:%d", pipeline->cfg.task_stack,
+                 pipeline->cfg.task_prio, pipeline->cfg.task_core);
+    }
     pipeline->state = AEL_STATE_INIT;
     return pipeline;
 }
@@ -273,6 +634,8 @@ esp_err_t audio_pipeline_deinit(audio_pipeline_handle_t pipeline)
 {
     audio_pipeline_terminate(pipeline);
     audio_pipeline_unlink(pipeline);
+    // Links kept by a breakup outlive the unlinked state
+    audio_pipeline_coop_unlink(pipeline);
     audio_element_item_t *el_item, *tmp;
     STAILQ_FOREACH_SAFE(el_item, &pipeline->el_list, next, tmp) {
         ESP_LOGD(TAG, "[%16s]-[%p]element instance has been deleted", audio_element_get_tag(el_item->el), el_item->el);
@@ -280,6 +643,15 @@ esp_err_t audio_pipeline_deinit(audio_pipeline_handle_t pipeline)
         audio_pipeline_unregister(pipeline, el_item->el);
     }
     mutex_destroy(pipeline->lock);
+    if (pipeline->coop_wakeup) {
+        vSemaphoreDelete(pipeline->coop_wakeup);
+    }
+    if (pipeline->coop_state) {
+        vEventGroupDelete(pipeline->coop_state);
+    }
+    if (pipeline->arena) {
+        audio_mem_arena_destroy(pipeline->arena);
+    }
     audio_free(pipeline);
     return ESP_OK;
 }
@@ -290,7 +662,7 @@ esp_err_t audio_pipeline_register(audio_pipeline_handle_t pipeline, audio_elemen
     if (name) {
         audio_element_set_tag(el, name);
     }
-    audio_element_item_t *el_item = audio_calloc(1, sizeof(audio_element_item_t));
+    audio_element_item_t *el_item = _pipeline_calloc(pipeline, sizeof(audio_element_item_t));
 
     AUDIO_MEM_CHECK(TAG, el_item, return ESP_ERR_NO_MEM);
     el_item->el = el;
@@ -355,14 +727,25 @@ esp_err_t audio_pipeline_run(audio_pipeline_handle_t pipeline)
         ESP_LOGW(TAG, "Pipeline already started, state:%d", pipeline->state);
         return ESP_OK;
     }
-    STAILQ_FOREACH(el_item, &pipeline->el_list, next) {
-        ESP_LOGD(TAG, "start el[%16s], linked:%d, state:%d,[%p], ", audio_element_get_tag(el_item->el), el_item->linked,  audio_element_get_state(el_item->el), el_item->el);
-        if (el_item->linked
-            && ((AEL_STATE_INIT == audio_element_get_state(el_item->el))
-                || (AEL_STATE_STOPPED == audio_element_get_state(el_item->el))
-                || (AEL_STATE_FINISHED == audio_element_get_state(el_item->el))
-                || (AEL_STATE_ERROR == audio_element_get_state(el_item->el)))) {
-            audio_element_run(el_item->el);
+    if (pipeline->coop_sink) {
+        if (audio_pipeline_coop_run(pipeline) != ESP_OK) {
+            audio_pipeline_change_state(pipeline, AEL_STATE_ERROR);
+            audio_pipeline_terminate(pipeline);
+            return ESP_FAIL;
+        }
+    } else {
+        if (pipeline->cfg.cooperative) {
+            ESP_LOGW(TAG, "Pipeline linked with ringbuffers, elements run in their own tasks");
+        }
+        STAILQ_FOREACH(el_item, &pipeline->el_list, next) {
+            ESP_LOGD(TAG, "start el[%16s], linked:%d, state:%d,[%p], ", audio_element_get_tag(el_item->el), el_item->linked,  audio_element_get_state(el_item->el), el_item->el);
+            if (el_item->linked
+                && ((AEL_STATE_INIT == audio_element_get_state(el_item->el))
+                    || (AEL_STATE_STOPPED == audio_element_get_state(el_item->el))
+                    || (AEL_STATE_FINISHED == audio_element_get_state(el_item->el))
+                    || (AEL_STATE_ERROR == audio_element_get_state(el_item->el)))) {
+                audio_element_run(el_item->el);
+            }
         }
     }
     AUDIO_MEM_SHOW(TAG);
@@ -380,15 +763,38 @@ esp_err_t audio_pipeline_run(audio_pipeline_handle_t pipeline)
     return ESP_OK;
 }
 
+/* The element kept by a cooperative breakup is still hosted, the pipeline task takes its commands */
+static audio_element_handle_t audio_pipeline_coop_host_kept(audio_pipeline_handle_t pipeline)
+{
+    if (pipeline->coop_kept) {
+        audio_pipeline_coop_start_task(pipeline);
+    }
+    return pipeline->coop_kept;
+}
+
+static void audio_pipeline_coop_release_kept(audio_pipeline_handle_t pipeline)
+{
+    audio_element_item_t *el_item = audio_pipeline_get_el_item_by_handle(pipeline, pipeline->coop_kept);
+    if (el_item) {
+        el_item->kept_ctx = false;
+    }
+    pipeline->coop_kept = NULL;
+}
+
 esp_err_t audio_pipeline_terminate(audio_pipeline_handle_t pipeline)
 {
     audio_element_item_t *el_item;
     ESP_LOGD(TAG, "Destroy audio_pipeline elements");
+    audio_element_handle_t kept = audio_pipeline_coop_host_kept(pipeline);
     STAILQ_FOREACH(el_item, &pipeline->el_list, next) {
-        if (el_item->linked) {
+        if (el_item->linked || el_item->el == kept) {
             audio_element_terminate(el_item->el);
         }
     }
+    audio_pipeline_coop_wait_exit(pipeline, 2000 / portTICK_PERIOD_MS);
+    if (kept) {
+        audio_pipeline_coop_release_kept(pipeline);
+    }
     return ESP_OK;
 }
 
@@ -397,11 +803,16 @@ esp_err_t audio_pipeline_terminate_with_ticks(audio_pipeline_handle_t pipeline,
     audio_element_item_t *el_item;
     esp_err_t ret = ESP_OK;
     ESP_LOGD(TAG, "Destroy audio_pipeline elements with ticks[%d]", (int)ticks_to_wait);
+    audio_element_handle_t kept = audio_pipeline_coop_host_kept(pipeline);
     STAILQ_FOREACH(el_item, &pipeline->el_list, next) {
-        if (el_item->linked) {
+        if (el_item->linked || el_item->el == kept) {
             ret |= audio_element_terminate_with_ticks(el_item->el, ticks_to_wait);
         }
     }
+    audio_pipeline_coop_wait_exit(pipeline, ticks_to_wait);
+    if (kept) {
+        audio_pipeline_coop_release_kept(pipeline);
+    }
     return ret;
 }
 
@@ -478,8 +889,8 @@ static esp_err_t _pipeline_rb_linked(audio_pipeline_handle_t pipeline, audio_ele
             audio_element_set_input_ringbuf(el, rb);
         }
         bool _success = (
-                            (rb_item = audio_calloc(1, sizeof(ringbuf_item_t))) &&
-                            (rb = rb_create(audio_element_get_output_ringbuf_size(el), 1))
+                            (rb_item = _pipeline_calloc(pipeline, sizeof(ringbuf_item_t))) &&
+                            (rb = _pipeline_rb_create(pipeline, audio_element_get_output_ringbuf_size(el)))
                         );
 
         AUDIO_MEM_CHECK(TAG, _success, {
@@ -498,10 +909,46 @@ static esp_err_t _pipeline_rb_linked(audio_pipeline_handle_t pipeline, audio_ele
     return ESP_OK;
 }
 
+static esp_err_t _pipeline_coop_linked(audio_pipeline_handle_t pipeline, audio_element_handle_t prev, audio_element_handle_t el, bool last)
+{
+    if (el == pipeline->coop_kept) {
+        // Linked again, the pipeline task hosts it from now on
+        audio_pipeline_get_el_item_by_handle(pipeline, el)->kept_ctx = false;
+        pipeline->coop_kept = NULL;
+    }
+    if (prev) {
+        coop_link_t *link = NULL;
+        STAILQ_FOREACH(link, &pipeline->coop_list, next) {
+            if (link->src == prev && link->dst == NULL) {
+                ESP_LOGD(TAG, "found kept link, src:%p, carry:%d", prev, link->carry_len - link->carry_pos);
+                break;
+            }
+        }
+        if (link == NULL) {
+            link = _pipeline_calloc(pipeline, sizeof(coop_link_t));
+            AUDIO_MEM_CHECK(TAG, link, return ESP_ERR_NO_MEM);
+            link->src = prev;
+            link->wakeup = pipeline->coop_wakeup;
+            link->arena = pipeline->arena;
+            STAILQ_INSERT_TAIL(&pipeline->coop_list, link, next);
+            audio_element_set_write_cb(prev, _coop_write, link);
+        }
+        link->dst = el;
+        audio_element_set_read_cb(el, _coop_read, link);
+        ESP_LOGI(TAG, "link el->el, src:%s, dst:%s", audio_element_get_tag(prev) == NULL ? "NULL" : audio_element_get_tag(prev),
+                 audio_element_get_tag(el) == NULL ? "NULL" : audio_element_get_tag(el));
+    }
+    if (last) {
+        pipeline->coop_sink = el;
+    }
+    return ESP_OK;
+}
+
 esp_err_t audio_pipeline_link(audio_pipeline_handle_t pipeline, const char *link_tag[], int link_num)
 {
     esp_err_t ret = ESP_OK;
     bool first = false, last = false;
+    audio_element_handle_t prev = NULL;
     if (pipeline->linked) {
         audio_pipeline_unlink(pipeline);
     }
@@ -516,10 +963,18 @@ esp_err_t audio_pipeline_link(audio_pipeline_handle_t pipeline, const char *link
         audio_element_handle_t el = item->el;
         first = (i == 0);
         last = (i == link_num - 1);
-        ret = _pipeline_rb_linked(pipeline, el, first, last);
+        if (pipeline->cfg.cooperative) {
+            ret = _pipeline_coop_linked(pipeline, prev, el, last);
+        } else {
+            ret = _pipeline_rb_linked(pipeline, el, first, last);
+        }
         if (ret != ESP_OK) {
             return ret;
         }
+        prev = el;
+    }
+    if (pipeline->cfg.cooperative) {
+        audio_pipeline_coop_drop_kept(pipeline);
     }
     pipeline->linked = true;
     PIPELINE_DEBUG(pipeline);
@@ -556,6 +1011,7 @@ esp_err_t audio_pipeline_unlink(audio_pipeline_handle_t pipeline)
         rb_item->host_el = NULL;
         audio_free(rb_item);
     }
+    audio_pipeline_coop_unlink(pipeline);
     ESP_LOGI(TAG, "audio_pipeline_unlinked");
     STAILQ_INIT(&pipeline->rb_list);
     pipeline->linked = false;
@@ -593,6 +1049,7 @@ esp_err_t audio_pipeline_link_more(audio_pipeline_handle_t pipeline, audio_eleme
     int idx = 0;
     bool first = false;
     bool last = false;
+    audio_element_handle_t prev = NULL;
     if (pipeline->linked) {
         audio_pipeline_unlink(pipeline);
     }
@@ -610,10 +1067,18 @@ esp_err_t audio_pipeline_link_more(audio_pipeline_handle_t pipeline, audio_eleme
         first = (idx == 1);
         element_1 = va_arg(args, audio_element_handle_t);
         last = (NULL == element_1) ? true : false;
-        ret = _pipeline_rb_linked(pipeline, el, first, last);
+        if (pipeline->cfg.cooperative) {
+            ret = _pipeline_coop_linked(pipeline, prev, el, last);
+        } else {
+            ret = _pipeline_rb_linked(pipeline, el, first, last);
+        }
         if (ret != ESP_OK) {
             return ret;
         }
+        prev = el;
+    }
+    if (pipeline->cfg.cooperative) {
+        audio_pipeline_coop_drop_kept(pipeline);
     }
     pipeline->linked = true;
     va_end(args);
@@ -798,6 +1263,12 @@ esp_err_t audio_pipeline_breakup_elements(audio_pipeline_handle_t pipeline, audi
     audio_element_item_t *el_item, *el_tmp;
     ringbuf_item_t *rb_item, *tmp;
     bool kept = true;
+    if (pipeline->coop_sink) {
+        audio_pipeline_coop_breakup(pipeline, kept_ctx_el);
+        pipeline->linked = false;
+        audio_pipeline_change_state(pipeline, AEL_STATE_INIT);
+        return ESP_OK;
+    }
     ESP_LOGD(TAG, "audio_pipeline_breakup_elements IN,%p,%s", kept_ctx_el, kept_ctx_el != NULL ? audio_element_get_tag(kept_ctx_el) : "NULL");
     STAILQ_FOREACH_SAFE(el_item, &pipeline->el_list, next, el_tmp) {
         ESP_LOGD(TAG, "%d, el:%08x, %s, in_rb:%08x, out_rb:%08x, linked:%d, el-kept:%d", __LINE__,
@@ -913,8 +1384,8 @@ static esp_err_t audio_pipeline_el_item_link(audio_pipeline_handle_t pipeline,
     if ((last == false) && (cur_rb_item == NULL)) {
         ringbuf_handle_t tmp_rb = NULL;
         bool _success = (
-                            (cur_rb_item = audio_calloc(1, sizeof(ringbuf_item_t))) &&
-                            (tmp_rb = rb_create(audio_element_get_output_ringbuf_size(el), 1))
+                            (cur_rb_item = _pipeline_calloc(pipeline, sizeof(ringbuf_item_t))) &&
+                            (tmp_rb = _pipeline_rb_create(pipeline, audio_element_get_output_ringbuf_size(el)))
                         );
 
         AUDIO_MEM_CHECK(TAG, _success, {
@@ -955,6 +1426,7 @@ esp_err_t audio_pipeline_relink(audio_pipeline_handle_t pipeline, const char *li
     }
     esp_err_t ret = ESP_OK;
     audio_element_item_t *el_item, *el_tmp;
+    audio_element_handle_t prev = NULL;
     bool first = false, last = false;
     for (int i = 0; i < link_num; i++) {
         audio_element_item_t *src_el_item = audio_pipeline_get_el_item_by_tag(pipeline, link_tag[i]);
@@ -980,7 +1452,18 @@ esp_err_t audio_pipeline_relink(audio_pipeline_handle_t pipeline, const char *li
         src_el_item->linked = true;
         first = (i == 0);
         last = (i == link_num - 1);
-        audio_pipeline_el_item_link(pipeline, src_el_item, el, first, last);
+        if (pipeline->cfg.cooperative) {
+            ret = _pipeline_coop_linked(pipeline, prev, el, last);
+            if (ret != ESP_OK) {
+                goto relink_err;
+            }
+        } else {
+            audio_pipeline_el_item_link(pipeline, src_el_item, el, first, last);
+        }
+        prev = el;
+    }
+    if (pipeline->cfg.cooperative) {
+        audio_pipeline_coop_drop_kept(pipeline);
     }
     pipeline->linked = true;
     PIPELINE_DEBUG(pipeline);
@@ -998,6 +1481,7 @@ esp_err_t audio_pipeline_relink_more(audio_pipeline_handle_t pipeline, audio_ele
     va_list args;
     audio_element_item_t *el_item, *el_tmp;
     va_start(args, element_1);
+    audio_element_handle_t prev = NULL;
     bool first = false, last = false;
     uint16_t idx = 0;
     while (element_1) {
@@ -1022,10 +1506,77 @@ esp_err_t audio_pipeline_relink_more(audio_pipeline_handle_t pipeline, audio_ele
         first = (idx == 1);
         element_1 = va_arg(args, audio_element_handle_t);
         last = (NULL == element_1) ? true : false;
-        audio_pipeline_el_item_link(pipeline, src_el_item, el, first, last);
+        if (pipeline->cfg.cooperative) {
+            if (_pipeline_coop_linked(pipeline, prev, el, last) != ESP_OK) {
+                va_end(args);
+                return ESP_ERR_NO_MEM;
+            }
+        } else {
+            audio_pipeline_el_item_link(pipeline, src_el_item, el, first, last);
+        }
+        prev = el;
+    }
+    if (pipeline->cfg.cooperative) {
+        audio_pipeline_coop_drop_kept(pipeline);
     }
     pipeline->linked = true;
     PIPELINE_DEBUG(pipeline);
     va_end(args);
     return ESP_OK;
 }
+
+esp_err_t audio_pipeline_enable_stats(audio_pipeline_handle_t pipeline, bool enable)
+{
+    AUDIO_NULL_CHECK(TAG, pipeline, return ESP_ERR_INVALID_ARG);
+    audio_element_item_t *el_item;
+    STAILQ_FOREACH(el_item, &pipeline->el_list, next) {
+        if (el_item->linked) {
+            audio_element_enable_stats(el_item->el, enable);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_dump_stats(audio_pipeline_handle_t pipeline)
+{
+    AUDIO_NULL_CHECK(TAG, pipeline, return ESP_ERR_INVALID_ARG);
+    audio_element_item_t *el_item;
+    audio_element_stats_t stats;
+    char fill[AEL_STATS_FILL_LEVELS * 4 + 1];
+    ESP_LOGI(TAG, "| Element          | Bytes In   | Bytes Out  | Calls    | Min/Avg/Max(us)      | InWait(ms) | OutWait(ms) | Input fill 0-100%% (%% of calls)");
+    STAILQ_FOREACH(el_item, &pipeline->el_list, next) {
+        if (el_item->linked == false || audio_element_get_stats(el_item->el, &stats) != ESP_OK) {
+            continue;
+        }
+        uint32_t samples = 0;
+        for (int i = 0; i < AEL_STATS_FILL_LEVELS; i++) {
+            samples += stats.fill_level[i];
+        }
+        int pos = 0;
+        for (int i = 0; i < AEL_STATS_FILL_LEVELS; i++) {
+            pos += snprintf(fill + pos, sizeof(fill) - pos, "%3d ", samples ? (int)(stats.fill_level[i] * 100 / samples) : 0);
+        }
+        char times[24];
+        snprintf(times, sizeof(times), "%d/%d/%d", (int)stats.process_min_us, (int)stats.process_avg_us, (int)stats.process_max_us);
+        ESP_LOGI(TAG, "| %-16s | %-10llu | %-10llu | %-8d | %-20s | %-10llu | %-11llu | %s",
+                 audio_element_get_tag(el_item->el) == NULL ? "NULL" : audio_element_get_tag(el_item->el),
+                 (unsigned long long)stats.bytes_in, (unsigned long long)stats.bytes_out, (int)stats.process_count, times,
+                 (unsigned long long)(stats.input_wait_us / 1000), (unsigned long long)(stats.output_wait_us / 1000), samples ? fill : "-");
+    }
+    audio_mem_arena_stats_t mem;
+    if (pipeline->arena && audio_mem_arena_get_stats(pipeline->arena, &mem) == ESP_OK) {
+        ESP_LOGI(TAG, "| Arena in use:%d, peak:%d, reserved:%d, peak reserved:%d, fragmentation:%d%%",
+                 (int)mem.in_use, (int)mem.peak, (int)mem.reserved, (int)mem.peak_reserved, mem.fragmentation);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_get_mem_stats(audio_pipeline_handle_t pipeline, audio_mem_arena_stats_t *stats)
+{
+    AUDIO_NULL_CHECK(TAG, pipeline, return ESP_ERR_INVALID_ARG);
+    AUDIO_NULL_CHECK(TAG, stats, return ESP_ERR_INVALID_ARG);
+    if (pipeline->arena == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return audio_mem_arena_get_stats(pipeline->arena, stats);
+}
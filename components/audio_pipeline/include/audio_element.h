@@ -140,6 +140,25 @@ typedef struct {
     .codec_fmt = ESP_CODEC_TYPE_UNKNOW    \
 }
 
+#define AEL_STATS_FILL_LEVELS           (8)
+
+/**
+ * @brief Audio Element runtime statistics, collected only after `audio_element_enable_stats`
+ */
+typedef struct {
+    uint64_t bytes_in;                              /*!< Bytes read from the input */
+    uint64_t bytes_out;                             /*!< Bytes written to the output */
+    uint32_t process_count;                         /*!< Number of `process` calls */
+    uint32_t process_min_us;                        /*!< Shortest `process` call in microseconds */
+    uint32_t process_avg_us;                        /*!< Average `process` call in microseconds */
+    uint32_t process_max_us;                        /*!< Longest `process` call in microseconds */
+    uint64_t process_total_us;                      /*!< Total time spent in `process` in microseconds */
+    uint64_t input_wait_us;                         /*!< Time spent in input ringbuffer reads or read callbacks */
+    uint64_t output_wait_us;                        /*!< Time spent in output ringbuffer writes or write callbacks */
+    uint32_t fill_level[AEL_STATS_FILL_LEVELS];     /*!< Histogram of the input ringbuffer fill level sampled before each `process` call,
+                                                         bucket i counts samples between i/AEL_STATS_FILL_LEVELS and (i+1)/AEL_STATS_FILL_LEVELS full */
+} audio_element_stats_t;
+
 typedef esp_err_t (*el_io_func)(audio_element_handle_t self);
 typedef audio_element_err_t (*process_func)(audio_element_handle_t self, char *el_buffer, int el_buf_len);
 typedef int (*stream_func)(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait,
@@ -278,6 +297,32 @@ esp_err_t audio_element_setinfo(audio_element_handle_t el, audio_element_info_t
  */
 esp_err_t audio_element_getinfo(audio_element_handle_t el, audio_element_info_t *info);
 
+/**
+ * @brief      Enable or disable runtime statistics of the element.
+ *             Enabling clears all the counters. The counters live in the element handle,
+ *             so nothing is allocated while the element is running.
+ *
+ * @param[in]  el      The audio element handle
+ * @param[in]  enable  true to start collecting, false to stop
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_element_enable_stats(audio_element_handle_t el, bool enable);
+
+/**
+ * @brief      Get a snapshot of the element runtime statistics.
+ *
+ * @param[in]  el     The audio element handle
+ * @param[out] stats  The statistics pointer
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_element_get_stats(audio_element_handle_t el, audio_element_stats_t *stats);
+
 /**
  * @brief      Set audio element URI.
  *
@@ -313,6 +358,48 @@ char *audio_element_get_uri(audio_element_handle_t el);
  */
 esp_err_t audio_element_run(audio_element_handle_t el);
 
+/**
+ * @brief      Start Audio Element without creating a task for it.
+ *             The element is prepared in the caller's context and then driven by a host task
+ *             (normally the cooperative pipeline task) through `audio_element_cooperative_process`.
+ *             Commands sent by the element control API are still queued, and `wakeup` is given
+ *             each time a command is queued so that an idle host can pick it up.
+ *
+ * @param[in]  el      The audio element handle
+ * @param[in]  wakeup  Semaphore given on every queued command, can be NULL
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t audio_element_run_cooperative(audio_element_handle_t el, SemaphoreHandle_t wakeup);
+
+/**
+ * @brief      Handle all pending commands of a cooperatively hosted element without blocking.
+ *
+ * @param[in]  el    The audio element handle
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_STATE, the element is not hosted
+ *     - AEL_IO_ABORT, the element received the destroy command and has been released
+ *     - Others, error returned by the command handler
+ */
+esp_err_t audio_element_cooperative_poll_cmd(audio_element_handle_t el);
+
+/**
+ * @brief      Handle pending commands, then call the element `process` function once
+ *             if it is running. This is what the element task loop does in one iteration.
+ *
+ * @param[in]  el           The audio element handle
+ * @param[out] process_len  The value returned by `process`, can be NULL
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_STATE, the element is not hosted or not running
+ */
+esp_err_t audio_element_cooperative_process(audio_element_handle_t el, int *process_len);
+
 /**
  * @brief      Terminate Audio Element.
  *             With this function, audio_element will exit the task function.
@@ -680,6 +767,63 @@ audio_element_err_t audio_element_input(audio_element_handle_t el, char *buffer,
  */
 audio_element_err_t audio_element_output(audio_element_handle_t el, char *buffer, int write_size);
 
+/**
+ * @brief      Get a pointer to contiguous data in the Element input ringbuffer, so `process` can decode from it in place.
+ *             The span must be returned with `audio_element_input_release`.
+ *             Fewer than `wanted_size` bytes may be returned when the data wraps around the end of the ringbuffer.
+ *
+ * @param[in]  el            The audio element handle
+ * @param[out] buffer        The pointer to the input data
+ * @param[in]  wanted_size   The wanted size
+ *
+ * @return
+ *        - > 0 number of bytes available at `buffer`
+ *        - AEL_IO_FAIL the input is not a ringbuffer, use `audio_element_input` instead
+ *        - <=0 audio_element_err_t
+ */
+audio_element_err_t audio_element_input_acquire(audio_element_handle_t el, char **buffer, int wanted_size);
+
+/**
+ * @brief      Release the bytes consumed from the span returned by `audio_element_input_acquire`
+ *
+ * @param[in]  el     The audio element handle
+ * @param[in]  size   Number of bytes consumed
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t audio_element_input_release(audio_element_handle_t el, int size);
+
+/**
+ * @brief      Get a pointer to contiguous free space in the Element output ringbuffer,
+ *             so `process` can write straight into the next Element's buffer.
+ *             The span must be published with `audio_element_output_commit`.
+ *             Fewer than `wanted_size` bytes may be returned when the space wraps around the end of the ringbuffer.
+ *
+ * @param[in]  el            The audio element handle
+ * @param[out] buffer        The pointer to the output space
+ * @param[in]  wanted_size   The wanted size
+ *
+ * @return
+ *        - > 0 number of bytes available at `buffer`
+ *        - AEL_IO_FAIL the output is not a ringbuffer, use `audio_element_output` instead
+ *        - <=0 audio_element_err_t
+ */
+audio_element_err_t audio_element_output_acquire(audio_element_handle_t el, char **buffer, int wanted_size);
+
+/**
+ * @brief      Publish the bytes written to the span returned by `audio_element_output_acquire`
+ *
+ * @param[in]  el     The audio element handle
+ * @param[in]  size   Number of bytes written, 0 to cancel
+ *
+ * @return
+ *        - >= 0 number of bytes committed
+ *        - ESP_FAIL
+ */
+audio_element_err_t audio_element_output_commit(audio_element_handle_t el, int size);
+
 /**
  * @brief     This API allows the application to set a read callback for the first audio_element in the pipeline for
  *            allowing the pipeline to interface with other systems. The callback is invoked every time the audio
@@ -26,6 +26,7 @@
 #define _AUDIO_PIPELINE_H_
 
 #include "audio_element.h"
+#include "audio_mem.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,12 +39,30 @@ typedef struct audio_pipeline *audio_pipeline_handle_t;
  */
 typedef struct audio_pipeline_cfg {
     int rb_size;        /*!< Audio Pipeline ringbuffer size */
+    bool cooperative;   /*!< Run the linked elements in one pipeline task, passing data directly instead of through ringbuffers */
+    int task_stack;     /*!< Pipeline task stack size, used in cooperative mode only */
+    int task_prio;      /*!< Pipeline task priority, used in cooperative mode only */
+    int task_core;      /*!< Pipeline task running in core (0 or 1), used in cooperative mode only */
+    bool stack_in_ext;  /*!< Try to allocate pipeline task stack in external memory */
+    int arena_chunk_size;   /*!< Take ringbuffers and lists of the pipeline from a private arena with chunks of this size, 0 to use the heap.
+                                 The arena is released in one shot by `audio_pipeline_deinit` */
+    int arena_budget;       /*!< Most bytes the arena may take from the heap, 0 for no limit */
 } audio_pipeline_cfg_t;
 
 #define DEFAULT_PIPELINE_RINGBUF_SIZE    (8*1024)
+#define DEFAULT_PIPELINE_TASK_STACK      (8*1024)
+#define DEFAULT_PIPELINE_TASK_PRIO       (5)
+#define DEFAULT_PIPELINE_TASK_CORE       (0)
 
 #define DEFAULT_AUDIO_PIPELINE_CONFIG() {\
     .rb_size            = DEFAULT_PIPELINE_RINGBUF_SIZE,\
+    .cooperative        = false,\
+    .task_stack         = DEFAULT_PIPELINE_TASK_STACK,\
+    .task_prio          = DEFAULT_PIPELINE_TASK_PRIO,\
+    .task_core          = DEFAULT_PIPELINE_TASK_CORE,\
+    .stack_in_ext       = false,\
+    .arena_chunk_size   = 0,\
+    .arena_budget       = 0,\
 }
 
 /**
@@ -52,6 +71,14 @@ typedef struct audio_pipeline_cfg {
  *             It will connect and start the audio element in order, responsible for retrieving the data from the previous element
  *             and passing it to the element after it. Also get events from each element, process events or pass it to a higher layer
  *
+ * @note       With `cooperative` set, `audio_pipeline_link` and `audio_pipeline_link_more` connect the elements
+ *             with direct read/write callbacks and `audio_pipeline_run` starts one pipeline task instead of one task
+ *             per element. The pipeline task drives the last element, and every read of a linked input calls the
+ *             `process` of the element before it. Only linear chains are supported. The relink functions link
+ *             cooperatively too, while `audio_pipeline_link_insert` always uses ringbuffers and makes
+ *             `audio_pipeline_run` fall back to element tasks. `audio_pipeline_breakup_elements` keeps only
+ *             `kept_ctx_el` hosted together with the output it has not passed on yet, and releases the others.
+ *
  * @param      config  The configuration - audio_pipeline_cfg_t
  *
  * @return
@@ -479,6 +506,44 @@ esp_err_t audio_pipeline_relink_more(audio_pipeline_handle_t pipeline, audio_ele
  */
 esp_err_t audio_pipeline_change_state(audio_pipeline_handle_t pipeline, audio_element_state_t new_state);
 
+/**
+ * @brief      Enable or disable runtime statistics of all the linked elements, see `audio_element_enable_stats`.
+ *
+ * @param[in]  pipeline     The Audio Pipeline Handle
+ * @param[in]  enable       true to clear and start the counters, false to stop them
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG    Invalid parameters.
+ */
+esp_err_t audio_pipeline_enable_stats(audio_pipeline_handle_t pipeline, bool enable);
+
+/**
+ * @brief      Print a table with the runtime statistics of all the linked elements.
+ *             Use it to find the element that limits the pipeline: a full input fill level
+ *             means the element is slower than its source, a long input wait means it is starved.
+ *
+ * @param[in]  pipeline     The Audio Pipeline Handle
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG    Invalid parameters.
+ */
+esp_err_t audio_pipeline_dump_stats(audio_pipeline_handle_t pipeline);
+
+/**
+ * @brief      Get the memory counters of the pipeline arena, see `audio_pipeline_cfg_t.arena_chunk_size`
+ *
+ * @param[in]  pipeline     The Audio Pipeline Handle
+ * @param[out] stats        The counters
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG    Invalid parameters.
+ *     - ESP_ERR_NOT_SUPPORTED  The pipeline has no arena
+ */
+esp_err_t audio_pipeline_get_mem_stats(audio_pipeline_handle_t pipeline, audio_mem_arena_stats_t *stats);
+
 
 #ifdef __cplusplus
 }
@@ -53,6 +53,19 @@ typedef struct ringbuf *ringbuf_handle_t;
  */
 ringbuf_handle_t rb_create(int block_size, int n_blocks);
 
+/**
+ * @brief      Create a single producer/single consumer ringbuffer with total size = block_size * n_blocks
+ *             `rb_read` and `rb_write` do not take the mutex and only signal the other side when it is blocked
+ *             on an empty or full buffer. Each side must be accessed by only one task at a time,
+ *             abort, done-write and unblock-reader may still be called from any task.
+ *
+ * @param[in]  block_size   Size of each block
+ * @param[in]  n_blocks     Number of blocks
+ *
+ * @return     ringbuf_handle_t
+ */
+ringbuf_handle_t rb_create_spsc(int block_size, int n_blocks);
+
 /**
  * @brief      Cleanup and free all memory created by ringbuf_handle_t
  *
@@ -151,6 +164,64 @@ int rb_read(ringbuf_handle_t rb, char *buf, int len, TickType_t ticks_to_wait);
  */
 int rb_write(ringbuf_handle_t rb, char *buf, int len, TickType_t ticks_to_wait);
 
+/**
+ * @brief      Get a pointer to contiguous free space of the Ringbuffer, waiting `ticks_to_wait` ticks until there is space.
+ *             The caller fills the span in place and publishes it with `rb_commit_write`, there is no copy.
+ *             The span stops at the end of the buffer, so fewer than `len` bytes may be returned on wraparound.
+ *             Only one write span can be outstanding at a time.
+ *
+ * @param[in]  rb             The Ringbuffer handle
+ * @param[out] buf            The pointer to the writable span
+ * @param[in]  len            The length request
+ * @param[in]  ticks_to_wait  The ticks to wait
+ *
+ * @return
+ *     - > 0 Number of bytes available at `buf`
+ *     - RB_DONE, RB_ABORT, RB_TIMEOUT, RB_FAIL
+ */
+int rb_acquire_write(ringbuf_handle_t rb, char **buf, int len, TickType_t ticks_to_wait);
+
+/**
+ * @brief      Publish `len` bytes of the span obtained by `rb_acquire_write` to the reader
+ *
+ * @param[in]  rb     The Ringbuffer handle
+ * @param[in]  len    Number of bytes written, must not exceed the acquired span, 0 to cancel
+ *
+ * @return
+ *     - >= 0 Number of bytes committed
+ *     - RB_FAIL
+ */
+int rb_commit_write(ringbuf_handle_t rb, int len);
+
+/**
+ * @brief      Get a pointer to contiguous filled data of the Ringbuffer, waiting `ticks_to_wait` ticks until there is data.
+ *             The caller consumes the span in place and returns it with `rb_release_read`, there is no copy.
+ *             The span stops at the end of the buffer, so fewer than `len` bytes may be returned on wraparound.
+ *             Only one read span can be outstanding at a time.
+ *
+ * @param[in]  rb             The Ringbuffer handle
+ * @param[out] buf            The pointer to the readable span
+ * @param[in]  len            The length request
+ * @param[in]  ticks_to_wait  The ticks to wait
+ *
+ * @return
+ *     - > 0 Number of bytes available at `buf`
+ *     - RB_DONE, RB_ABORT, RB_TIMEOUT, RB_FAIL
+ */
+int rb_acquire_read(ringbuf_handle_t rb, char **buf, int len, TickType_t ticks_to_wait);
+
+/**
+ * @brief      Release `len` bytes of the span obtained by `rb_acquire_read` back to the writer
+ *
+ * @param[in]  rb     The Ringbuffer handle
+ * @param[in]  len    Number of bytes consumed, must not exceed the acquired span
+ *
+ * @return
+ *     - >= 0 Number of bytes released
+ *     - RB_FAIL
+ */
+int rb_release_read(ringbuf_handle_t rb, int len);
+
 /**
  * @brief      Set status of writing to ringbuffer is done
  *
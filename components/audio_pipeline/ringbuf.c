@@ -47,6 +47,11 @@ struct ringbuf {
     bool abort_write;
     bool is_done_write;         /**< To signal that we are done writing */
     bool unblock_reader_flag;   /**< To unblock instantly from rb_read */
+    int acquired_read;          /**< Size of the span handed out by rb_acquire_read */
+    int acquired_write;         /**< Size of the span handed out by rb_acquire_write */
+    bool spsc;                  /**< Single producer/single consumer, no lock on read/write */
+    volatile bool reader_waiting;   /**< SPSC: reader is blocked on can_read */
+    volatile bool writer_waiting;   /**< SPSC: writer is blocked on can_write */
     void *reader_holder;
     void *writer_holder;
 };
@@ -55,7 +60,7 @@ static esp_err_t rb_abort_read(ringbuf_handle_t rb);
 static esp_err_t rb_abort_write(ringbuf_handle_t rb);
 static void rb_release(SemaphoreHandle_t handle);
 
-ringbuf_handle_t rb_create(int block_size, int n_blocks)
+static ringbuf_handle_t _rb_create(int block_size, int n_blocks, bool spsc)
 {
     if (block_size < 2) {
         ESP_LOGE(TAG, "Invalid size");
@@ -82,12 +87,23 @@ ringbuf_handle_t rb_create(int block_size, int n_blocks)
     rb->unblock_reader_flag = false;
     rb->abort_read = false;
     rb->abort_write = false;
+    rb->spsc = spsc;
     return rb;
 _rb_init_failed:
     rb_destroy(rb);
     return NULL;
 }
 
+ringbuf_handle_t rb_create(int block_size, int n_blocks)
+{
+    return _rb_create(block_size, n_blocks, false);
+}
+
+ringbuf_handle_t rb_create_spsc(int block_size, int n_blocks)
+{
+    return _rb_create(block_size, n_blocks, true);
+}
+
 esp_err_t rb_destroy(ringbuf_handle_t rb)
 {
     if (rb == NULL) {
@@ -126,6 +142,10 @@ esp_err_t rb_reset(ringbuf_handle_t rb)
     rb->unblock_reader_flag = false;
     rb->abort_read = false;
     rb->abort_write = false;
+    rb->acquired_read = 0;
+    rb->acquired_write = 0;
+    rb->reader_waiting = false;
+    rb->writer_waiting = false;
     return ESP_OK;
 }
 
@@ -158,11 +178,90 @@ static void rb_release(SemaphoreHandle_t handle)
 
 #define rb_block(handle, time) xSemaphoreTake(handle, time)
 
+static inline BaseType_t rb_lock(ringbuf_handle_t rb)
+{
+    if (rb->spsc) {
+        return pdTRUE;
+    }
+    return rb_block(rb->lock, portMAX_DELAY);
+}
+
+static inline void rb_unlock(ringbuf_handle_t rb)
+{
+    if (!rb->spsc) {
+        rb_release(rb->lock);
+    }
+}
+
+/* The reader only moves `p_r` and the writer only moves `p_w`, `fill_cnt` is the sole shared counter */
+static inline void rb_fill_add(ringbuf_handle_t rb, int size)
+{
+    __atomic_add_fetch(&rb->fill_cnt, size, __ATOMIC_SEQ_CST);
+}
+
+static inline void rb_fill_sub(ringbuf_handle_t rb, int size)
+{
+    __atomic_sub_fetch(&rb->fill_cnt, size, __ATOMIC_SEQ_CST);
+}
+
+static inline void rb_wake_reader(ringbuf_handle_t rb)
+{
+    // In SPSC mode the reader is only signalled when it is really blocked
+    if (!rb->spsc || __atomic_exchange_n(&rb->reader_waiting, false, __ATOMIC_SEQ_CST)) {
+        rb_release(rb->can_read);
+    }
+}
+
+static inline void rb_wake_writer(ringbuf_handle_t rb)
+{
+    if (!rb->spsc || __atomic_exchange_n(&rb->writer_waiting, false, __ATOMIC_SEQ_CST)) {
+        rb_release(rb->can_write);
+    }
+}
+
+static BaseType_t rb_wait_readable(ringbuf_handle_t rb, uint32_t fill_cnt, TickType_t ticks_to_wait)
+{
+    BaseType_t ret;
+    rb_wake_writer(rb);
+    if (rb->spsc) {
+        __atomic_store_n(&rb->reader_waiting, true, __ATOMIC_SEQ_CST);
+        // Re-check after publishing the flag, the writer may have committed in between
+        if (__atomic_load_n(&rb->fill_cnt, __ATOMIC_SEQ_CST) != fill_cnt) {
+            __atomic_store_n(&rb->reader_waiting, false, __ATOMIC_SEQ_CST);
+            return pdTRUE;
+        }
+    }
+    ret = rb_block(rb->can_read, ticks_to_wait);
+    if (rb->spsc) {
+        __atomic_store_n(&rb->reader_waiting, false, __ATOMIC_SEQ_CST);
+    }
+    return ret;
+}
+
+static BaseType_t rb_wait_writable(ringbuf_handle_t rb, uint32_t fill_cnt, TickType_t ticks_to_wait)
+{
+    BaseType_t ret;
+    rb_wake_reader(rb);
+    if (rb->spsc) {
+        __atomic_store_n(&rb->writer_waiting, true, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&rb->fill_cnt, __ATOMIC_SEQ_CST) != fill_cnt) {
+            __atomic_store_n(&rb->writer_waiting, false, __ATOMIC_SEQ_CST);
+            return pdTRUE;
+        }
+    }
+    ret = rb_block(rb->can_write, ticks_to_wait);
+    if (rb->spsc) {
+        __atomic_store_n(&rb->writer_waiting, false, __ATOMIC_SEQ_CST);
+    }
+    return ret;
+}
+
 int rb_read(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks_to_wait)
 {
     int read_size = 0;
     int total_read_size = 0;
     int ret_val = 0;
+    uint32_t fill_cnt;
 
     if (rb == NULL) {
         return RB_FAIL;
@@ -170,13 +269,14 @@ int rb_read(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks_to_wai
 
     while (buf_len) {
         //take buffer lock
-        if (rb_block(rb->lock, portMAX_DELAY) != pdTRUE) {
+        if (rb_lock(rb) != pdTRUE) {
             ret_val = RB_TIMEOUT;
             goto read_err;
         }
 
-        if (rb->fill_cnt < buf_len) {
-            read_size = rb->fill_cnt;
+        fill_cnt = rb->fill_cnt;
+        if (fill_cnt < buf_len) {
+            read_size = fill_cnt;
             /**
              * When non-multiple of 4(word size) bytes are written to I2S, there is noise.
              * Below is the kind of workaround to read only in multiple of 4. Avoids noise when rb is read in small chunks.
@@ -184,7 +284,7 @@ int rb_read(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks_to_wai
              */
             read_size = read_size & 0xfffffffc;
             if ((read_size == 0) && rb->is_done_write) {
-                read_size = rb->fill_cnt;
+                read_size = fill_cnt;
             }
         } else {
             read_size = buf_len;
@@ -195,25 +295,24 @@ int rb_read(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks_to_wai
 
             if (rb->is_done_write) {
                 ret_val = RB_DONE;
-                rb_release(rb->lock);
+                rb_unlock(rb);
                 goto read_err;
             }
             if (rb->abort_read) {
                 ret_val = RB_ABORT;
-                rb_release(rb->lock);
+                rb_unlock(rb);
                 goto read_err;
             }
             if (rb->unblock_reader_flag) {
                 //reader_unblock is nothing but forced timeout
                 ret_val = RB_TIMEOUT;
-                rb_release(rb->lock);
+                rb_unlock(rb);
                 goto read_err;
             }
 
-            rb_release(rb->lock);
-            rb_release(rb->can_write);
+            rb_unlock(rb);
             //wait till some data available to read
-            if (rb_block(rb->can_read, ticks_to_wait) != pdTRUE) {
+            if (rb_wait_readable(rb, fill_cnt, ticks_to_wait) != pdTRUE) {
                 ret_val = RB_TIMEOUT;
                 goto read_err;
             }
@@ -236,17 +335,17 @@ int rb_read(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks_to_wai
         }
 
         buf_len -= read_size;
-        rb->fill_cnt -= read_size;
+        rb_fill_sub(rb, read_size);
         total_read_size += read_size;
         buf += read_size;
-        rb_release(rb->lock);
+        rb_unlock(rb);
         if (buf_len == 0) {
             break;
         }
     }
 read_err:
     if (total_read_size > 0) {
-        rb_release(rb->can_write);
+        rb_wake_writer(rb);
     }
     if ((ret_val == RB_FAIL) ||
         (ret_val == RB_ABORT)) {
@@ -261,6 +360,7 @@ int rb_write(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks_to_wa
     int write_size;
     int total_write_size = 0;
     int ret_val = 0;
+    uint32_t fill_cnt;
 
     if (rb == NULL || buf == NULL) {
         return RB_FAIL;
@@ -268,11 +368,12 @@ int rb_write(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks_to_wa
 
     while (buf_len) {
         //take buffer lock
-        if (rb_block(rb->lock, portMAX_DELAY) != pdTRUE) {
+        if (rb_lock(rb) != pdTRUE) {
             ret_val =  RB_TIMEOUT;
             goto write_err;
         }
-        write_size = rb_bytes_available(rb);
+        fill_cnt = rb->fill_cnt;
+        write_size = rb->size - fill_cnt;
 
         if (buf_len < write_size) {
             write_size = buf_len;
@@ -282,19 +383,18 @@ int rb_write(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks_to_wa
             //no space to write, release thread block to allow other to read data
             if (rb->is_done_write) {
                 ret_val = RB_DONE;
-                rb_release(rb->lock);
+                rb_unlock(rb);
                 goto write_err;
             }
             if (rb->abort_write) {
                 ret_val = RB_ABORT;
-                rb_release(rb->lock);
+                rb_unlock(rb);
                 goto write_err;
             }
 
-            rb_release(rb->lock);
-            rb_release(rb->can_read);
+            rb_unlock(rb);
             //wait till we have some empty space to write
-            if (rb_block(rb->can_write, ticks_to_wait) != pdTRUE) {
+            if (rb_wait_writable(rb, fill_cnt, ticks_to_wait) != pdTRUE) {
                 ret_val = RB_TIMEOUT;
                 goto write_err;
             }
@@ -313,17 +413,17 @@ int rb_write(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks_to_wa
         }
 
         buf_len -= write_size;
-        rb->fill_cnt += write_size;
+        rb_fill_add(rb, write_size);
         total_write_size += write_size;
         buf += write_size;
-        rb_release(rb->lock);
+        rb_unlock(rb);
         if (buf_len == 0) {
             break;
         }
     }
 write_err:
     if (total_write_size > 0) {
-        rb_release(rb->can_read);
+        rb_wake_reader(rb);
     }
     if ((ret_val == RB_FAIL) ||
         (ret_val == RB_ABORT)) {
@@ -332,6 +432,179 @@ write_err:
     return total_write_size > 0 ? total_write_size : ret_val;
 }
 
+int rb_acquire_write(ringbuf_handle_t rb, char **buf, int len, TickType_t ticks_to_wait)
+{
+    int write_size = 0;
+    int ret_val = 0;
+    uint32_t fill_cnt;
+
+    if (rb == NULL || buf == NULL || len <= 0) {
+        return RB_FAIL;
+    }
+
+    while (1) {
+        if (rb_lock(rb) != pdTRUE) {
+            return RB_TIMEOUT;
+        }
+        if (rb->acquired_write) {
+            ESP_LOGE(TAG, "Previous write span not committed, %d", rb->acquired_write);
+            rb_unlock(rb);
+            return RB_FAIL;
+        }
+        fill_cnt = rb->fill_cnt;
+        write_size = rb->size - fill_cnt;
+        if (write_size > 0) {
+            break;
+        }
+        //no space to write, release thread block to allow other to read data
+        if (rb->is_done_write) {
+            ret_val = RB_DONE;
+        } else if (rb->abort_write) {
+            ret_val = RB_ABORT;
+        }
+        rb_unlock(rb);
+        if (ret_val != 0) {
+            return ret_val;
+        }
+        //wait till we have some empty space to write
+        if (rb_wait_writable(rb, fill_cnt, ticks_to_wait) != pdTRUE) {
+            return RB_TIMEOUT;
+        }
+    }
+
+    if (rb->p_w == rb->p_o + rb->size) {
+        rb->p_w = rb->p_o;
+    }
+    // Only the contiguous part up to the end of the buffer is handed out, the caller acquires again for the rest
+    if (write_size > rb->p_o + rb->size - rb->p_w) {
+        write_size = rb->p_o + rb->size - rb->p_w;
+    }
+    if (write_size > len) {
+        write_size = len;
+    }
+    *buf = rb->p_w;
+    rb->acquired_write = write_size;
+    rb_unlock(rb);
+    return write_size;
+}
+
+int rb_commit_write(ringbuf_handle_t rb, int len)
+{
+    if (rb == NULL || len < 0) {
+        return RB_FAIL;
+    }
+    rb_lock(rb);
+    if (len > rb->acquired_write) {
+        ESP_LOGE(TAG, "Commit size %d exceeds the acquired span %d", len, rb->acquired_write);
+        rb_unlock(rb);
+        return RB_FAIL;
+    }
+    rb->p_w += len;
+    if (rb->p_w == rb->p_o + rb->size) {
+        rb->p_w = rb->p_o;
+    }
+    rb_fill_add(rb, len);
+    rb->acquired_write = 0;
+    rb_unlock(rb);
+    if (len > 0) {
+        rb_wake_reader(rb);
+    }
+    return len;
+}
+
+int rb_acquire_read(ringbuf_handle_t rb, char **buf, int len, TickType_t ticks_to_wait)
+{
+    int read_size = 0;
+    int ret_val = 0;
+    uint32_t fill_cnt;
+
+    if (rb == NULL || buf == NULL || len <= 0) {
+        return RB_FAIL;
+    }
+
+    while (1) {
+        if (rb_lock(rb) != pdTRUE) {
+            ret_val = RB_TIMEOUT;
+            goto acquire_err;
+        }
+        if (rb->acquired_read) {
+            ESP_LOGE(TAG, "Previous read span not released, %d", rb->acquired_read);
+            rb_unlock(rb);
+            return RB_FAIL;
+        }
+        fill_cnt = rb->fill_cnt;
+        read_size = fill_cnt;
+        if (read_size < len) {
+            // Same word alignment workaround as rb_read
+            read_size = read_size & 0xfffffffc;
+            if ((read_size == 0) && rb->is_done_write) {
+                read_size = fill_cnt;
+            }
+        }
+        if (read_size > 0) {
+            break;
+        }
+        //no data to read, release thread block to allow other threads to write data
+        if (rb->is_done_write) {
+            ret_val = RB_DONE;
+        } else if (rb->abort_read) {
+            ret_val = RB_ABORT;
+        } else if (rb->unblock_reader_flag) {
+            ret_val = RB_TIMEOUT;
+        }
+        rb_unlock(rb);
+        if (ret_val != 0) {
+            goto acquire_err;
+        }
+        //wait till some data available to read
+        if (rb_wait_readable(rb, fill_cnt, ticks_to_wait) != pdTRUE) {
+            ret_val = RB_TIMEOUT;
+            goto acquire_err;
+        }
+    }
+
+    if (rb->p_r == rb->p_o + rb->size) {
+        rb->p_r = rb->p_o;
+    }
+    if (read_size > rb->p_o + rb->size - rb->p_r) {
+        read_size = rb->p_o + rb->size - rb->p_r;
+    }
+    if (read_size > len) {
+        read_size = len;
+    }
+    *buf = rb->p_r;
+    rb->acquired_read = read_size;
+    rb_unlock(rb);
+    ret_val = read_size;
+acquire_err:
+    rb->unblock_reader_flag = false;
+    return ret_val;
+}
+
+int rb_release_read(ringbuf_handle_t rb, int len)
+{
+    if (rb == NULL || len < 0) {
+        return RB_FAIL;
+    }
+    rb_lock(rb);
+    if (len > rb->acquired_read) {
+        ESP_LOGE(TAG, "Release size %d exceeds the acquired span %d", len, rb->acquired_read);
+        rb_unlock(rb);
+        return RB_FAIL;
+    }
+    rb->p_r += len;
+    if (rb->p_r == rb->p_o + rb->size) {
+        rb->p_r = rb->p_o;
+    }
+    rb_fill_sub(rb, len);
+    rb->acquired_read = 0;
+    rb_unlock(rb);
+    if (len > 0) {
+        rb_wake_writer(rb);
+    }
+    return len;
+}
+
 static esp_err_t rb_abort_read(ringbuf_handle_t rb)
 {
     if (rb == NULL) {
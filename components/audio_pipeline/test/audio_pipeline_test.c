@@ -117,3 +117,321 @@ TEST_CASE("audio_pipeline", "esp-adf")
     TEST_ASSERT_EQUAL(ESP_OK, audio_element_deinit(last_el));
 
 }
+
+#define COOP_TEST_TOTAL_BYTES   (200 * 1024)
+
+static int coop_produced;
+static int coop_consumed;
+static uint32_t coop_sum_in;
+static uint32_t coop_sum_out;
+
+static int _coop_src_read(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *ctx)
+{
+    if (coop_produced >= COOP_TEST_TOTAL_BYTES) {
+        return AEL_IO_DONE;
+    }
+    if (len > COOP_TEST_TOTAL_BYTES - coop_produced) {
+        len = COOP_TEST_TOTAL_BYTES - coop_produced;
+    }
+    for (int i = 0; i < len; i++) {
+        buffer[i] = (char)((coop_produced + i) * 7);
+        coop_sum_in = coop_sum_in * 31 + (uint8_t)buffer[i];
+    }
+    coop_produced += len;
+    return len;
+}
+
+static int _coop_sink_write(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *ctx)
+{
+    for (int i = 0; i < len; i++) {
+        coop_sum_out = coop_sum_out * 31 + (uint8_t)buffer[i];
+    }
+    coop_consumed += len;
+    return len;
+}
+
+static int _coop_el_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    if (r_size > 0) {
+        return audio_element_output(self, in_buffer, r_size);
+    }
+    return r_size;
+}
+
+TEST_CASE("audio_pipeline cooperative mode", "[audio_pipeline]")
+{
+    audio_element_handle_t first_el, mid_el, last_el;
+    audio_element_cfg_t el_cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    el_cfg.open = _el_open;
+    el_cfg.close = _el_close;
+    el_cfg.process = _coop_el_process;
+
+    // Different buffer sizes on each side force partial reads and carried over data
+    el_cfg.buffer_len = 1000;
+    first_el = audio_element_init(&el_cfg);
+    el_cfg.buffer_len = 4096;
+    mid_el = audio_element_init(&el_cfg);
+    el_cfg.buffer_len = 300;
+    last_el = audio_element_init(&el_cfg);
+    TEST_ASSERT_NOT_NULL(first_el);
+    TEST_ASSERT_NOT_NULL(mid_el);
+    TEST_ASSERT_NOT_NULL(last_el);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    pipeline_cfg.cooperative = true;
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    TEST_ASSERT_NOT_NULL(pipeline);
+
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, first_el, "first"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, mid_el, "mid"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, last_el, "last"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_link(pipeline, (const char *[]) {"first", "mid", "last"}, 3));
+    audio_element_set_read_cb(first_el, _coop_src_read, NULL);
+    audio_element_set_write_cb(last_el, _coop_sink_write, NULL);
+    TEST_ASSERT_NULL(audio_element_get_output_ringbuf(first_el));
+    TEST_ASSERT_NULL(audio_element_get_input_ringbuf(last_el));
+
+    coop_produced = coop_consumed = 0;
+    coop_sum_in = coop_sum_out = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_enable_stats(pipeline, true));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_run(pipeline));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_pause(pipeline));
+    int paused_at = coop_consumed;
+    vTaskDelay(50 / portTICK_RATE_MS);
+    TEST_ASSERT_EQUAL(paused_at, coop_consumed);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_resume(pipeline));
+
+    TEST_ASSERT_EQUAL(ESP_OK, audio_element_wait_for_stop(last_el));
+    TEST_ASSERT_EQUAL(AEL_STATE_FINISHED, audio_element_get_state(last_el));
+    TEST_ASSERT_EQUAL(COOP_TEST_TOTAL_BYTES, coop_consumed);
+    TEST_ASSERT_EQUAL_UINT32(coop_sum_in, coop_sum_out);
+
+    audio_element_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_OK, audio_element_get_stats(mid_el, &stats));
+    TEST_ASSERT_EQUAL(COOP_TEST_TOTAL_BYTES, (int)stats.bytes_in);
+    TEST_ASSERT_EQUAL(COOP_TEST_TOTAL_BYTES, (int)stats.bytes_out);
+    TEST_ASSERT_TRUE(stats.process_count > 0);
+    TEST_ASSERT_TRUE(stats.process_min_us <= stats.process_avg_us && stats.process_avg_us <= stats.process_max_us);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_dump_stats(pipeline));
+
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_terminate(pipeline));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_deinit(pipeline));
+}
+
+TEST_CASE("audio_pipeline cooperative breakup and relink", "[audio_pipeline]")
+{
+    audio_element_handle_t first_el, mid_el, last_el;
+    audio_element_cfg_t el_cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    el_cfg.open = _el_open;
+    el_cfg.close = _el_close;
+    el_cfg.process = _coop_el_process;
+
+    // The reader of the kept element takes less than it produces, so some output waits in the link
+    el_cfg.buffer_len = 1000;
+    first_el = audio_element_init(&el_cfg);
+    el_cfg.buffer_len = 300;
+    mid_el = audio_element_init(&el_cfg);
+    el_cfg.buffer_len = 4096;
+    last_el = audio_element_init(&el_cfg);
+    TEST_ASSERT_NOT_NULL(first_el);
+    TEST_ASSERT_NOT_NULL(mid_el);
+    TEST_ASSERT_NOT_NULL(last_el);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    pipeline_cfg.cooperative = true;
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    TEST_ASSERT_NOT_NULL(pipeline);
+
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, first_el, "first"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, mid_el, "mid"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, last_el, "last"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_link(pipeline, (const char *[]) {"first", "mid", "last"}, 3));
+    audio_element_set_read_cb(first_el, _coop_src_read, NULL);
+    audio_element_set_write_cb(last_el, _coop_sink_write, NULL);
+
+    coop_produced = coop_consumed = 0;
+    coop_sum_in = coop_sum_out = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_run(pipeline));
+    while (coop_consumed == 0) {
+        vTaskDelay(1);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_pause(pipeline));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_breakup_elements(pipeline, first_el));
+    TEST_ASSERT_EQUAL(AEL_STATE_PAUSED, audio_element_get_state(first_el));
+    TEST_ASSERT_EQUAL(AEL_STATE_INIT, audio_element_get_state(mid_el));
+    TEST_ASSERT_EQUAL(AEL_STATE_INIT, audio_element_get_state(last_el));
+    TEST_ASSERT_TRUE(coop_consumed < COOP_TEST_TOTAL_BYTES);
+
+    // The kept element carries on where it stopped, nothing it produced before the breakup is lost
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_relink(pipeline, (const char *[]) {"first", "mid", "last"}, 3));
+    audio_element_set_write_cb(last_el, _coop_sink_write, NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_run(pipeline));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_element_wait_for_stop(last_el));
+    TEST_ASSERT_EQUAL(AEL_STATE_FINISHED, audio_element_get_state(last_el));
+    TEST_ASSERT_EQUAL(COOP_TEST_TOTAL_BYTES, coop_produced);
+    TEST_ASSERT_EQUAL(COOP_TEST_TOTAL_BYTES, coop_consumed);
+    TEST_ASSERT_EQUAL_UINT32(coop_sum_in, coop_sum_out);
+
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_terminate(pipeline));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_deinit(pipeline));
+}
+
+#define ZC_TEST_TOTAL_BYTES     (10 * DEFAULT_ELEMENT_RINGBUF_SIZE + 123)
+
+static int zc_produced;
+static int zc_consumed;
+static int zc_mismatch;
+static int zc_cb_acquire;
+
+static int _zc_src_read(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *ctx)
+{
+    return AEL_IO_DONE;
+}
+
+static int _zc_sink_write(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *ctx)
+{
+    return len;
+}
+
+static int _zc_src_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    char *span = NULL;
+    if (audio_element_input_acquire(self, &span, in_len) == AEL_IO_FAIL) {
+        zc_cb_acquire++;
+    }
+    if (zc_produced >= ZC_TEST_TOTAL_BYTES) {
+        return AEL_IO_DONE;
+    }
+    // An odd size keeps moving the spans across the end of the ringbuffer
+    int ret = audio_element_output_acquire(self, &span, 1000);
+    if (ret <= 0) {
+        return ret;
+    }
+    if (ret > ZC_TEST_TOTAL_BYTES - zc_produced) {
+        ret = ZC_TEST_TOTAL_BYTES - zc_produced;
+    }
+    // Commit a bit less than acquired now and then
+    if (ret > 3 && (zc_produced & 1)) {
+        ret -= 3;
+    }
+    for (int i = 0; i < ret; i++) {
+        span[i] = (char)((zc_produced + i) * 13);
+    }
+    zc_produced += ret;
+    return audio_element_output_commit(self, ret);
+}
+
+static int _zc_sink_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    char *span = NULL;
+    if (audio_element_output_acquire(self, &span, in_len) == AEL_IO_FAIL) {
+        zc_cb_acquire++;
+    }
+    int ret = audio_element_input_acquire(self, &span, 700);
+    if (ret <= 0) {
+        return ret;
+    }
+    if (ret > 1 && (zc_consumed & 1) == 0) {
+        ret--;
+    }
+    for (int i = 0; i < ret; i++) {
+        if (span[i] != (char)((zc_consumed + i) * 13)) {
+            zc_mismatch++;
+        }
+    }
+    zc_consumed += ret;
+    if (audio_element_input_release(self, ret) != ESP_OK) {
+        return AEL_IO_FAIL;
+    }
+    return ret;
+}
+
+TEST_CASE("audio_pipeline zero-copy acquire and commit", "[audio_pipeline]")
+{
+    audio_element_cfg_t el_cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    el_cfg.open = _el_open;
+    el_cfg.close = _el_close;
+    el_cfg.process = _zc_src_process;
+    audio_element_handle_t src_el = audio_element_init(&el_cfg);
+    el_cfg.process = _zc_sink_process;
+    audio_element_handle_t sink_el = audio_element_init(&el_cfg);
+    TEST_ASSERT_NOT_NULL(src_el);
+    TEST_ASSERT_NOT_NULL(sink_el);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    TEST_ASSERT_NOT_NULL(pipeline);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, src_el, "src"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, sink_el, "sink"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_link(pipeline, (const char *[]) {"src", "sink"}, 2));
+    audio_element_set_read_cb(src_el, _zc_src_read, NULL);
+    audio_element_set_write_cb(sink_el, _zc_sink_write, NULL);
+    ringbuf_handle_t rb = audio_element_get_output_ringbuf(src_el);
+    TEST_ASSERT_NOT_NULL(rb);
+    TEST_ASSERT_TRUE(ZC_TEST_TOTAL_BYTES > 2 * rb_get_size(rb));
+
+    zc_produced = zc_consumed = 0;
+    zc_mismatch = zc_cb_acquire = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_run(pipeline));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_element_wait_for_stop(sink_el));
+    TEST_ASSERT_EQUAL(AEL_STATE_FINISHED, audio_element_get_state(sink_el));
+    TEST_ASSERT_EQUAL(ZC_TEST_TOTAL_BYTES, zc_produced);
+    TEST_ASSERT_EQUAL(ZC_TEST_TOTAL_BYTES, zc_consumed);
+    TEST_ASSERT_EQUAL(0, zc_mismatch);
+    // Callback IO has no span to hand out
+    TEST_ASSERT_TRUE(zc_cb_acquire > 0);
+
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_terminate(pipeline));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_deinit(pipeline));
+}
+
+TEST_CASE("audio_pipeline arena", "[audio_pipeline]")
+{
+    audio_element_cfg_t el_cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    el_cfg.open = _el_open;
+    el_cfg.close = _el_close;
+    el_cfg.process = _el_process;
+    audio_element_handle_t first_el = audio_element_init(&el_cfg);
+    audio_element_handle_t mid_el = audio_element_init(&el_cfg);
+    audio_element_handle_t last_el = audio_element_init(&el_cfg);
+    TEST_ASSERT_NOT_NULL(first_el);
+    TEST_ASSERT_NOT_NULL(mid_el);
+    TEST_ASSERT_NOT_NULL(last_el);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    pipeline_cfg.arena_chunk_size = 2 * DEFAULT_ELEMENT_RINGBUF_SIZE + 2048;
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    TEST_ASSERT_NOT_NULL(pipeline);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, first_el, "first"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, mid_el, "mid"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, last_el, "last"));
+
+    // Relinking many times must not grow the arena, the freed ringbuffers are reused
+    audio_mem_arena_stats_t stats;
+    size_t reserved = 0;
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_link(pipeline, (const char *[]) {"first", "mid", "last"}, 3));
+        TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_get_mem_stats(pipeline, &stats));
+        TEST_ASSERT_TRUE(stats.in_use > 2 * DEFAULT_ELEMENT_RINGBUF_SIZE);
+        if (i == 0) {
+            reserved = stats.peak_reserved;
+        }
+        TEST_ASSERT_EQUAL(reserved, stats.peak_reserved);
+        TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_unlink(pipeline));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_get_mem_stats(pipeline, &stats));
+    TEST_ASSERT_TRUE(stats.in_use < 1024);
+    // The pipeline deinitializes the elements still registered, so take them back first
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_unregister_more(pipeline, first_el, mid_el, last_el, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_deinit(pipeline));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_element_deinit(first_el));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_element_deinit(mid_el));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_element_deinit(last_el));
+}
@@ -0,0 +1,265 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_mem.h"
+#include "audio_error.h"
+#include "bench_elements.h"
+
+static const char *TAG = "BENCH_EL";
+
+#define BENCH_STAMP_MAGIC       (0x5354414d)
+#define BENCH_TONE_RATE         (48000)
+#define BENCH_TONE_FREQ         (1000)
+#define BENCH_TONE_PERIOD       (BENCH_TONE_RATE / BENCH_TONE_FREQ)
+
+typedef enum {
+    BENCH_ROLE_SOURCE,
+    BENCH_ROLE_PASS,
+    BENCH_ROLE_SINK,
+} bench_role_t;
+
+/* Written at every `stamp_stride` offset of the stream, only the next hop trusts it */
+typedef struct {
+    uint32_t    magic;
+    uint32_t    hop;
+    int64_t     time_us;
+} bench_stamp_t;
+
+typedef struct {
+    bench_role_t        role;
+    bench_element_cfg_t cfg;
+    int64_t             total_bytes;
+    int64_t             gen_pos;
+    int64_t             pos;
+    int                 phase;
+    int16_t             sine[BENCH_TONE_PERIOD];
+    char                *path;
+    FILE                *file;
+    bench_hop_stats_t   stats;
+} bench_element_t;
+
+static void bench_stamp(bench_element_t *bench, char *buf, int len)
+{
+    int stride = bench->cfg.stamp_stride;
+    int64_t now = esp_timer_get_time();
+    int64_t at = (bench->pos + stride - 1) / stride * stride;
+    for (; at < bench->pos + len; at += stride) {
+        if (at + (int64_t)sizeof(bench_stamp_t) > bench->pos + len) {
+            bench->stats.lost_stamps++;
+            break;
+        }
+        char *p = buf + (at - bench->pos);
+        bench_stamp_t stamp;
+        if (bench->role != BENCH_ROLE_SOURCE) {
+            memcpy(&stamp, p, sizeof(stamp));
+            if (stamp.magic == BENCH_STAMP_MAGIC && stamp.hop + 1 == bench->cfg.hop) {
+                int64_t latency = now - stamp.time_us;
+                bench->stats.stamps++;
+                bench->stats.latency_total_us += latency;
+                if (latency > bench->stats.latency_max_us) {
+                    bench->stats.latency_max_us = latency;
+                }
+            } else {
+                bench->stats.lost_stamps++;
+            }
+        }
+        if (bench->role != BENCH_ROLE_SINK) {
+            stamp.magic = BENCH_STAMP_MAGIC;
+            stamp.hop = bench->cfg.hop;
+            stamp.time_us = now;
+            memcpy(p, &stamp, sizeof(stamp));
+        }
+    }
+    bench->pos += len;
+    bench->stats.bytes += len;
+}
+
+static esp_err_t _bench_open(audio_element_handle_t self)
+{
+    bench_element_t *bench = (bench_element_t *)audio_element_getdata(self);
+    bench->gen_pos = 0;
+    bench->pos = 0;
+    bench->phase = 0;
+    memset(&bench->stats, 0, sizeof(bench->stats));
+    if (bench->path) {
+        bench->file = fopen(bench->path, "wb");
+        if (bench->file == NULL) {
+            ESP_LOGE(TAG, "Failed to open %s", bench->path);
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _bench_close(audio_element_handle_t self)
+{
+    bench_element_t *bench = (bench_element_t *)audio_element_getdata(self);
+    if (bench->file) {
+        fclose(bench->file);
+        bench->file = NULL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _bench_destroy(audio_element_handle_t self)
+{
+    bench_element_t *bench = (bench_element_t *)audio_element_getdata(self);
+    audio_free(bench->path);
+    audio_free(bench);
+    return ESP_OK;
+}
+
+static int _tone_read(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    bench_element_t *bench = (bench_element_t *)audio_element_getdata(self);
+    int64_t remain = bench->total_bytes - bench->gen_pos;
+    if (remain <= 0) {
+        return AEL_IO_DONE;
+    }
+    if (len > remain) {
+        len = (int)remain;
+    }
+    len &= ~3;
+    int16_t *frame = (int16_t *)buffer;
+    for (int i = 0; i < len / 4; i++) {
+        frame[2 * i] = bench->sine[bench->phase];
+        frame[2 * i + 1] = bench->sine[bench->phase];
+        if (++bench->phase == BENCH_TONE_PERIOD) {
+            bench->phase = 0;
+        }
+    }
+    bench->gen_pos += len;
+    audio_element_update_byte_pos(self, len);
+    return len;
+}
+
+static int _sink_write(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    bench_element_t *bench = (bench_element_t *)audio_element_getdata(self);
+    if (bench->file && fwrite(buffer, 1, len, bench->file) != (size_t)len) {
+        ESP_LOGE(TAG, "Failed to write %s", bench->path);
+        return AEL_IO_FAIL;
+    }
+    audio_element_update_byte_pos(self, len);
+    return len;
+}
+
+static int _bench_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    bench_element_t *bench = (bench_element_t *)audio_element_getdata(self);
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    int w_size = 0;
+    if (r_size > 0) {
+        bench_stamp(bench, in_buffer, r_size);
+        w_size = audio_element_output(self, in_buffer, r_size);
+    } else {
+        w_size = r_size;
+    }
+    return w_size;
+}
+
+static audio_element_handle_t bench_element_init(const bench_element_cfg_t *config, bench_role_t role, const char *tag)
+{
+    AUDIO_NULL_CHECK(TAG, config, return NULL);
+    AUDIO_CHECK(TAG, config->stamp_stride >= (int)sizeof(bench_stamp_t), return NULL, "Stamp stride too small");
+    bench_element_t *bench = audio_calloc(1, sizeof(bench_element_t));
+    AUDIO_MEM_CHECK(TAG, bench, return NULL);
+    bench->role = role;
+    bench->cfg = *config;
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _bench_open;
+    cfg.close = _bench_close;
+    cfg.process = _bench_process;
+    cfg.destroy = _bench_destroy;
+    cfg.buffer_len = config->buffer_len;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.tag = tag;
+    if (role == BENCH_ROLE_SOURCE) {
+        cfg.read = _tone_read;
+    } else if (role == BENCH_ROLE_SINK) {
+        cfg.write = _sink_write;
+    }
+    audio_element_handle_t el = audio_element_init(&cfg);
+    AUDIO_MEM_CHECK(TAG, el, {
+        audio_free(bench);
+        return NULL;
+    });
+    audio_element_setdata(el, bench);
+    return el;
+}
+
+audio_element_handle_t bench_tone_gen_init(const bench_element_cfg_t *config, int64_t total_bytes)
+{
+    audio_element_handle_t el = bench_element_init(config, BENCH_ROLE_SOURCE, "tone");
+    if (el) {
+        bench_element_t *bench = (bench_element_t *)audio_element_getdata(el);
+        bench->total_bytes = total_bytes;
+        for (int i = 0; i < BENCH_TONE_PERIOD; i++) {
+            bench->sine[i] = (int16_t)(16384 * sin(2 * M_PI * i / BENCH_TONE_PERIOD));
+        }
+        audio_element_set_music_info(el, BENCH_TONE_RATE, 2, 16);
+        audio_element_set_total_bytes(el, total_bytes);
+    }
+    return el;
+}
+
+audio_element_handle_t bench_pass_init(const bench_element_cfg_t *config)
+{
+    return bench_element_init(config, BENCH_ROLE_PASS, "pass");
+}
+
+audio_element_handle_t bench_null_sink_init(const bench_element_cfg_t *config)
+{
+    return bench_element_init(config, BENCH_ROLE_SINK, "null");
+}
+
+audio_element_handle_t bench_file_sink_init(const bench_element_cfg_t *config, const char *path)
+{
+    AUDIO_NULL_CHECK(TAG, path, return NULL);
+    audio_element_handle_t el = bench_element_init(config, BENCH_ROLE_SINK, "file");
+    if (el) {
+        bench_element_t *bench = (bench_element_t *)audio_element_getdata(el);
+        bench->path = audio_strdup(path);
+        AUDIO_MEM_CHECK(TAG, bench->path, {
+            audio_element_deinit(el);
+            return NULL;
+        });
+    }
+    return el;
+}
+
+esp_err_t bench_element_get_stats(audio_element_handle_t el, bench_hop_stats_t *stats)
+{
+    AUDIO_NULL_CHECK(TAG, el, return ESP_ERR_INVALID_ARG);
+    AUDIO_NULL_CHECK(TAG, stats, return ESP_ERR_INVALID_ARG);
+    bench_element_t *bench = (bench_element_t *)audio_element_getdata(el);
+    *stats = bench->stats;
+    return ESP_OK;
+}
@@ -0,0 +1,84 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _BENCH_ELEMENTS_H_
+#define _BENCH_ELEMENTS_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Latency seen by one element, measured on the time stamps the upstream element put in the stream
+ */
+typedef struct {
+    uint64_t    bytes;              /*!< Bytes that went through the element */
+    uint32_t    stamps;             /*!< Time stamps checked */
+    uint32_t    lost_stamps;        /*!< Time stamps split across two reads, not counted */
+    int64_t     latency_total_us;   /*!< Sum of the latency from the previous element */
+    int64_t     latency_max_us;     /*!< Worst latency from the previous element */
+} bench_hop_stats_t;
+
+/**
+ * @brief Synthetic element configuration
+ */
+typedef struct {
+    int         buffer_len;         /*!< Element buffer length */
+    int         out_rb_size;        /*!< Output ringbuffer size, 0 for the sink */
+    int         stamp_stride;       /*!< Distance in bytes between two time stamps, at least 16 */
+    int         hop;                /*!< Position in the chain, the source is 0 */
+} bench_element_cfg_t;
+
+/**
+ * @brief Tone generator source, produces `total_bytes` of 16 bit stereo sine then reports finished
+ */
+audio_element_handle_t bench_tone_gen_init(const bench_element_cfg_t *config, int64_t total_bytes);
+
+/**
+ * @brief Pass through element, copies its input to its output and restamps it
+ */
+audio_element_handle_t bench_pass_init(const bench_element_cfg_t *config);
+
+/**
+ * @brief Sink dropping the data
+ */
+audio_element_handle_t bench_null_sink_init(const bench_element_cfg_t *config);
+
+/**
+ * @brief Sink writing the data to a file
+ */
+audio_element_handle_t bench_file_sink_init(const bench_element_cfg_t *config, const char *path);
+
+/**
+ * @brief Get the latency counters of a synthetic element
+ */
+esp_err_t bench_element_get_stats(audio_element_handle_t el, bench_hop_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BENCH_ELEMENTS_H_ */
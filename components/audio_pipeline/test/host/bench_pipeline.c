@@ -0,0 +1,295 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Pipeline benchmark on the host port: tone generator -> N pass through elements -> null or file sink.
+ * Every combination of mode, chain length and buffer size is run once and reported on one line:
+ *
+ *   ./bench_pipeline -n 0,2,8 -b 512,4096 -m task,coop -t 16 [-r rb_size] [-o file] [-v]
+ *
+ * The hop latency is measured on time stamps carried in the stream, context switches are the times a
+ * task blocked in the FreeRTOS port plus the voluntary/involuntary switches the kernel reported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_mem.h"
+#include "audio_error.h"
+#include "audio_pipeline.h"
+#include "audio_event_iface.h"
+#include "freertos_posix.h"
+#include "bench_elements.h"
+
+static const char *TAG = "BENCH_PIPELINE";
+
+#define BENCH_MAX_LIST          (16)
+#define BENCH_MAX_HOPS          (32)
+#define BENCH_STAMP_STRIDE      (256)
+
+typedef struct {
+    bool        cooperative;
+    int         hops;
+    int         buffer_len;
+    int         rb_size;
+    int64_t     total_bytes;
+    const char  *file;
+} bench_case_t;
+
+typedef struct {
+    double      mbps;
+    double      hop_avg_us[BENCH_MAX_HOPS + 1];
+    int64_t     hop_max_us;
+    uint64_t    blocks;
+    long        nvcsw;
+    long        nivcsw;
+    uint32_t    setup_allocs;
+    uint32_t    run_allocs;
+    uint32_t    tasks;
+} bench_result_t;
+
+static int parse_list(const char *arg, int *list)
+{
+    int num = 0;
+    char *dup = strdup(arg);
+    for (char *tok = strtok(dup, ","); tok && num < BENCH_MAX_LIST; tok = strtok(NULL, ",")) {
+        list[num++] = atoi(tok);
+    }
+    free(dup);
+    return num;
+}
+
+static bool wait_finished(audio_event_iface_handle_t evt, audio_element_handle_t sink)
+{
+    audio_event_iface_msg_t msg;
+    while (audio_event_iface_listen(evt, &msg, pdMS_TO_TICKS(30000)) == ESP_OK) {
+        if (msg.source_type != AUDIO_ELEMENT_TYPE_ELEMENT || msg.cmd != AEL_MSG_CMD_REPORT_STATUS) {
+            continue;
+        }
+        int status = (int)(intptr_t)msg.data;
+        if (status >= AEL_STATUS_ERROR_OPEN && status <= AEL_STATUS_ERROR_UNKNOWN) {
+            ESP_LOGE(TAG, "[%s] reported error %d", audio_element_get_tag((audio_element_handle_t)msg.source), status);
+            return false;
+        }
+        if (msg.source == (void *)sink && status == AEL_STATUS_STATE_FINISHED) {
+            return true;
+        }
+    }
+    ESP_LOGE(TAG, "Timeout waiting for the sink");
+    return false;
+}
+
+static esp_err_t run_case(const bench_case_t *bc, bench_result_t *res)
+{
+    audio_element_handle_t els[BENCH_MAX_HOPS + 2] = { 0 };
+    char names[BENCH_MAX_HOPS + 2][16];
+    const char *tags[BENCH_MAX_HOPS + 2];
+    int num = bc->hops + 2;
+    esp_err_t ret = ESP_FAIL;
+    audio_mem_stats_t mem_start, mem_run, mem_end;
+    freertos_posix_stats_t os_start, os_end;
+    struct rusage ru_start, ru_end;
+
+    memset(res, 0, sizeof(*res));
+    audio_mem_get_stats(&mem_start);
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    pipeline_cfg.cooperative = bc->cooperative;
+    pipeline_cfg.rb_size = bc->rb_size;
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    AUDIO_NULL_CHECK(TAG, pipeline, return ESP_FAIL);
+
+    for (int i = 0; i < num; i++) {
+        bench_element_cfg_t cfg = {
+            .buffer_len = bc->buffer_len,
+            .out_rb_size = i == num - 1 ? 0 : bc->rb_size,
+            .stamp_stride = BENCH_STAMP_STRIDE,
+            .hop = i,
+        };
+        if (i == 0) {
+            els[i] = bench_tone_gen_init(&cfg, bc->total_bytes);
+        } else if (i < num - 1) {
+            els[i] = bench_pass_init(&cfg);
+        } else if (bc->file) {
+            els[i] = bench_file_sink_init(&cfg, bc->file);
+        } else {
+            els[i] = bench_null_sink_init(&cfg);
+        }
+        AUDIO_NULL_CHECK(TAG, els[i], goto _exit);
+        snprintf(names[i], sizeof(names[i]), "el%d", i);
+        tags[i] = names[i];
+        audio_pipeline_register(pipeline, els[i], names[i]);
+    }
+    AUDIO_CHECK(TAG, audio_pipeline_link(pipeline, tags, num) == ESP_OK, goto _exit, "Link failed");
+
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    audio_event_iface_handle_t evt = audio_event_iface_init(&evt_cfg);
+    AUDIO_NULL_CHECK(TAG, evt, goto _exit);
+    audio_pipeline_set_listener(pipeline, evt);
+
+    audio_mem_get_stats(&mem_run);
+    freertos_posix_get_stats(&os_start);
+    getrusage(RUSAGE_SELF, &ru_start);
+    int64_t start_us = esp_timer_get_time();
+    if (audio_pipeline_run(pipeline) == ESP_OK && wait_finished(evt, els[num - 1])) {
+        int64_t elapsed_us = esp_timer_get_time() - start_us;
+        getrusage(RUSAGE_SELF, &ru_end);
+        freertos_posix_get_stats(&os_end);
+        audio_mem_get_stats(&mem_end);
+
+        bench_hop_stats_t hop;
+        bench_element_get_stats(els[num - 1], &hop);
+        res->mbps = (double)hop.bytes / elapsed_us;
+        for (int i = 1; i < num; i++) {
+            bench_element_get_stats(els[i], &hop);
+            res->hop_avg_us[i - 1] = hop.stamps ? (double)hop.latency_total_us / hop.stamps : 0;
+            if (hop.latency_max_us > res->hop_max_us) {
+                res->hop_max_us = hop.latency_max_us;
+            }
+        }
+        res->blocks = os_end.blocks - os_start.blocks;
+        res->tasks = os_end.tasks_created - os_start.tasks_created;
+        res->nvcsw = ru_end.ru_nvcsw - ru_start.ru_nvcsw;
+        res->nivcsw = ru_end.ru_nivcsw - ru_start.ru_nivcsw;
+        res->setup_allocs = mem_run.alloc_count - mem_start.alloc_count;
+        res->run_allocs = mem_end.alloc_count - mem_run.alloc_count;
+        ret = ESP_OK;
+    }
+
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+    audio_pipeline_terminate(pipeline);
+    audio_pipeline_remove_listener(pipeline);
+    audio_event_iface_destroy(evt);
+_exit:
+    for (int i = 0; i < num; i++) {
+        if (els[i]) {
+            audio_pipeline_unregister(pipeline, els[i]);
+        }
+    }
+    audio_pipeline_deinit(pipeline);
+    for (int i = 0; i < num; i++) {
+        if (els[i]) {
+            audio_element_deinit(els[i]);
+        }
+    }
+    return ret;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [-n hops,..] [-b buffer_len,..] [-m task,coop] [-t total_MB] [-r rb_size] [-o file] [-v]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    int hops[BENCH_MAX_LIST] = { 0, 2, 8 };
+    int hop_num = 3;
+    int bufs[BENCH_MAX_LIST] = { 512, 4096 };
+    int buf_num = 2;
+    bool modes[2] = { true, true };
+    int total_mb = 16;
+    int rb_size = DEFAULT_PIPELINE_RINGBUF_SIZE;
+    const char *file = NULL;
+    bool verbose = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:b:m:t:r:o:vh")) != -1) {
+        switch (opt) {
+            case 'n':
+                hop_num = parse_list(optarg, hops);
+                break;
+            case 'b':
+                buf_num = parse_list(optarg, bufs);
+                break;
+            case 'm':
+                modes[0] = strstr(optarg, "task") != NULL;
+                modes[1] = strstr(optarg, "coop") != NULL;
+                break;
+            case 't':
+                total_mb = atoi(optarg);
+                break;
+            case 'r':
+                rb_size = atoi(optarg);
+                break;
+            case 'o':
+                file = optarg;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    esp_log_level_set("*", verbose ? ESP_LOG_INFO : ESP_LOG_ERROR);
+
+    printf("%-5s %4s %6s | %9s | %11s %11s | %9s %9s %9s | %6s %6s\n", "mode", "hops", "buf", "MB/s",
+           "hop_avg_us", "hop_max_us", "blocks", "vcsw", "ivcsw", "allocs", "in_run");
+    int failed = 0;
+    for (int m = 0; m < 2; m++) {
+        if (!modes[m]) {
+            continue;
+        }
+        for (int h = 0; h < hop_num; h++) {
+            for (int b = 0; b < buf_num; b++) {
+                bench_case_t bc = {
+                    .cooperative = m == 1,
+                    .hops = hops[h] < BENCH_MAX_HOPS ? hops[h] : BENCH_MAX_HOPS,
+                    .buffer_len = bufs[b],
+                    .rb_size = rb_size,
+                    .total_bytes = (int64_t)total_mb * 1024 * 1024,
+                    .file = file,
+                };
+                bench_result_t res;
+                if (run_case(&bc, &res) != ESP_OK) {
+                    printf("%-5s %4d %6d | failed\n", bc.cooperative ? "coop" : "task", bc.hops, bc.buffer_len);
+                    failed++;
+                    continue;
+                }
+                double avg = 0;
+                for (int i = 0; i <= bc.hops; i++) {
+                    avg += res.hop_avg_us[i];
+                }
+                avg /= bc.hops + 1;
+                printf("%-5s %4d %6d | %9.1f | %11.1f %11lld | %9llu %9ld %9ld | %6u %6u\n",
+                       bc.cooperative ? "coop" : "task", bc.hops, bc.buffer_len, res.mbps, avg, (long long)res.hop_max_us,
+                       (unsigned long long)res.blocks, res.nvcsw, res.nivcsw, (unsigned)res.setup_allocs, (unsigned)res.run_allocs);
+                if (verbose) {
+                    printf("      per hop avg us:");
+                    for (int i = 0; i <= bc.hops; i++) {
+                        printf(" %.1f", res.hop_avg_us[i]);
+                    }
+                    printf("\n");
+                }
+            }
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,19 @@
+#!/usr/bin/perl
+#
+# Build audio_sal, ringbuf and audio_pipeline for Linux on the pthread FreeRTOS port in ./port,
+# together with the pipeline benchmark. Run it as:
+#   ./build.pl && ./bench_pipeline
+#
+# Pass "asan" to build with the address and undefined behaviour sanitizers.
+#
+use strict;
+
+my $r = "../..";
+my @src = ("$r/../audio_sal/audio_mem.c", "$r/../audio_sal/audio_mutex.c", "$r/../audio_sal/audio_thread.c",
+           "$r/../audio_sal/audio_queue.c", "$r/../audio_sal/audio_sample.c", "$r/../audio_sal/audio_url.c",
+           "$r/ringbuf.c", "$r/audio_element.c", "$r/audio_pipeline.c", "$r/audio_event_iface.c",
+           "port/freertos_posix.c", "bench_elements.c");
+my $inc = "-D_GNU_SOURCE -Iport -I. -I$r/../audio_sal/include -I$r/include";
+my $opt = (grep { $_ eq "asan" } @ARGV) ? "-O1 -fsanitize=address,undefined -fno-omit-frame-pointer" : "-O2";
+
+system("gcc $opt -g @src bench_pipeline.c $inc -o ./bench_pipeline -lpthread -lm") == 0 or die "build failed";
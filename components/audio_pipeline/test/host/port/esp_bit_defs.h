@@ -0,0 +1,46 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _ESP_BIT_DEFS_H_
+#define _ESP_BIT_DEFS_H_
+
+#define BIT(nr)     (1UL << (nr))
+#define BIT0        BIT(0)
+#define BIT1        BIT(1)
+#define BIT2        BIT(2)
+#define BIT3        BIT(3)
+#define BIT4        BIT(4)
+#define BIT5        BIT(5)
+#define BIT6        BIT(6)
+#define BIT7        BIT(7)
+#define BIT8        BIT(8)
+#define BIT9        BIT(9)
+#define BIT10       BIT(10)
+#define BIT11       BIT(11)
+#define BIT12       BIT(12)
+#define BIT13       BIT(13)
+#define BIT14       BIT(14)
+#define BIT15       BIT(15)
+
+#endif /* _ESP_BIT_DEFS_H_ */
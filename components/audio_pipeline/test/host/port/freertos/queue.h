@@ -0,0 +1,70 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _FREERTOS_POSIX_QUEUE_H_
+#define _FREERTOS_POSIX_QUEUE_H_
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct rtos_queue *QueueHandle_t;
+typedef QueueHandle_t xQueueHandle;
+typedef QueueHandle_t QueueSetHandle_t;
+typedef QueueHandle_t QueueSetMemberHandle_t;
+
+#define queueSEND_TO_BACK   ((BaseType_t)0)
+#define queueSEND_TO_FRONT  ((BaseType_t)1)
+#define queueOVERWRITE      ((BaseType_t)2)
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait, BaseType_t position);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait);
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks_to_wait);
+BaseType_t xQueueSemaphoreTake(QueueHandle_t queue, TickType_t ticks_to_wait);
+BaseType_t xQueueReset(QueueHandle_t queue);
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t queue);
+
+QueueSetHandle_t xQueueCreateSet(UBaseType_t length);
+BaseType_t xQueueAddToSet(QueueSetMemberHandle_t member, QueueSetHandle_t set);
+BaseType_t xQueueRemoveFromSet(QueueSetMemberHandle_t member, QueueSetHandle_t set);
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t set, TickType_t ticks_to_wait);
+
+#define xQueueSend(q, item, ticks)              xQueueGenericSend(q, item, ticks, queueSEND_TO_BACK)
+#define xQueueSendToBack(q, item, ticks)        xQueueGenericSend(q, item, ticks, queueSEND_TO_BACK)
+#define xQueueSendToFront(q, item, ticks)       xQueueGenericSend(q, item, ticks, queueSEND_TO_FRONT)
+#define xQueueOverwrite(q, item)                xQueueGenericSend(q, item, 0, queueOVERWRITE)
+#define xQueueSendFromISR(q, item, woken)       xQueueGenericSend(q, item, 0, queueSEND_TO_BACK)
+#define xQueueSendToFrontFromISR(q, item, woken) xQueueGenericSend(q, item, 0, queueSEND_TO_FRONT)
+#define xQueueReceiveFromISR(q, item, woken)    xQueueReceive(q, item, 0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FREERTOS_POSIX_QUEUE_H_ */
@@ -0,0 +1,51 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _FREERTOS_POSIX_SEMPHR_H_
+#define _FREERTOS_POSIX_SEMPHR_H_
+
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+
+#define xSemaphoreCreateBinary()                xSemaphoreCreateCounting(1, 0)
+#define xSemaphoreCreateMutex()                 xSemaphoreCreateCounting(1, 1)
+#define xSemaphoreTake(sem, ticks)              xQueueSemaphoreTake(sem, ticks)
+#define xSemaphoreGive(sem)                     xQueueGenericSend(sem, NULL, 0, queueSEND_TO_BACK)
+#define xSemaphoreGiveFromISR(sem, woken)       xSemaphoreGive(sem)
+#define xSemaphoreTakeFromISR(sem, woken)       xSemaphoreTake(sem, 0)
+#define uxSemaphoreGetCount(sem)                uxQueueMessagesWaiting(sem)
+#define vSemaphoreDelete(sem)                   vQueueDelete(sem)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FREERTOS_POSIX_SEMPHR_H_ */
@@ -0,0 +1,495 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos_posix.h"
+
+struct rtos_task {
+    TaskFunction_t      func;
+    void                *arg;
+    uint32_t            stack_depth;
+    char                name[configMAX_TASK_NAME_LEN];
+};
+
+struct rtos_queue {
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    uint8_t             *buf;
+    UBaseType_t         length;
+    UBaseType_t         item_size;
+    UBaseType_t         head;
+    UBaseType_t         count;
+    struct rtos_queue   *set;
+};
+
+struct rtos_event_group {
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    EventBits_t         bits;
+};
+
+esp_log_level_t esp_log_default_level = ESP_LOG_INFO;
+
+static freertos_posix_stats_t s_stats;
+static __thread struct rtos_task *s_current;
+static __thread struct rtos_task s_foreign;
+
+static void _cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct timespec _deadline(TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ms = (uint64_t)ticks * portTICK_PERIOD_MS;
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+/* Sleep once on the condition, false when the deadline passed */
+static bool _wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *deadline)
+{
+    if (ticks == 0) {
+        return false;
+    }
+    __atomic_add_fetch(&s_stats.blocks, 1, __ATOMIC_RELAXED);
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+static void _wake(pthread_cond_t *cond)
+{
+    __atomic_add_fetch(&s_stats.wakeups, 1, __ATOMIC_RELAXED);
+    pthread_cond_broadcast(cond);
+}
+
+void freertos_posix_get_stats(freertos_posix_stats_t *stats)
+{
+    stats->tasks_created = __atomic_load_n(&s_stats.tasks_created, __ATOMIC_RELAXED);
+    stats->blocks = __atomic_load_n(&s_stats.blocks, __ATOMIC_RELAXED);
+    stats->wakeups = __atomic_load_n(&s_stats.wakeups, __ATOMIC_RELAXED);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    esp_log_default_level = level;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
+
+/* Tasks */
+
+static void *_task_entry(void *arg)
+{
+    s_current = (struct rtos_task *)arg;
+    s_current->func(s_current->arg);
+    /* FreeRTOS tasks must not return, treat it as a self delete */
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t func, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *created_task, BaseType_t core_id)
+{
+    struct rtos_task *task = calloc(1, sizeof(struct rtos_task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->func = func;
+    task->arg = arg;
+    task->stack_depth = stack_depth;
+    snprintf(task->name, sizeof(task->name), "%s", name ? name : "");
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    int ret = pthread_create(&thread, &attr, _task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    __atomic_add_fetch(&s_stats.tasks_created, 1, __ATOMIC_RELAXED);
+    if (created_task) {
+        *created_task = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task != NULL && task != s_current) {
+        /* Deleting another task would leave its kernel objects locked, the pipeline code never does that */
+        ESP_LOGE("FREERTOS_POSIX", "Deleting another task is not supported");
+        abort();
+    }
+    if (s_current != NULL && s_current != &s_foreign) {
+        free(s_current);
+        s_current = NULL;
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+    __atomic_add_fetch(&s_stats.blocks, 1, __ATOMIC_RELAXED);
+    uint64_t ms = (uint64_t)ticks * portTICK_PERIOD_MS;
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (s_current == NULL) {
+        /* A thread not created by xTaskCreate, such as main */
+        s_foreign.stack_depth = 0;
+        snprintf(s_foreign.name, sizeof(s_foreign.name), "main");
+        s_current = &s_foreign;
+    }
+    return s_current;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    task = task ? task : xTaskGetCurrentTaskHandle();
+    return task->stack_depth;
+}
+
+char *pcTaskGetName(TaskHandle_t task)
+{
+    task = task ? task : xTaskGetCurrentTaskHandle();
+    return task->name;
+}
+
+/* Queues, semaphores and queue sets */
+
+static QueueHandle_t _queue_create(UBaseType_t length, UBaseType_t item_size, UBaseType_t count)
+{
+    QueueHandle_t queue = calloc(1, sizeof(struct rtos_queue));
+    if (queue == NULL) {
+        return NULL;
+    }
+    if (item_size) {
+        queue->buf = calloc(length, item_size);
+        if (queue->buf == NULL) {
+            free(queue);
+            return NULL;
+        }
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    _cond_init(&queue->cond);
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->count = count;
+    return queue;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    return _queue_create(length, item_size, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    return _queue_create(max_count, 0, initial_count);
+}
+
+QueueSetHandle_t xQueueCreateSet(UBaseType_t length)
+{
+    return _queue_create(length, sizeof(QueueSetMemberHandle_t), 0);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->cond);
+    free(queue->buf);
+    free(queue);
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait, BaseType_t position)
+{
+    struct timespec deadline = _deadline(ticks_to_wait);
+    pthread_mutex_lock(&queue->lock);
+    if (position == queueOVERWRITE && queue->count == queue->length) {
+        queue->count--;
+    }
+    while (queue->count == queue->length) {
+        if (!_wait(&queue->cond, &queue->lock, ticks_to_wait, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFAIL;
+        }
+    }
+    if (queue->item_size) {
+        UBaseType_t slot;
+        if (position == queueSEND_TO_FRONT) {
+            queue->head = (queue->head + queue->length - 1) % queue->length;
+            slot = queue->head;
+        } else {
+            slot = (queue->head + queue->count) % queue->length;
+        }
+        memcpy(queue->buf + slot * queue->item_size, item, queue->item_size);
+    }
+    queue->count++;
+    QueueSetHandle_t set = queue->set;
+    _wake(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    if (set) {
+        xQueueGenericSend(set, &queue, 0, queueSEND_TO_BACK);
+    }
+    return pdPASS;
+}
+
+static BaseType_t _queue_receive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait, bool peek)
+{
+    struct timespec deadline = _deadline(ticks_to_wait);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (!_wait(&queue->cond, &queue->lock, ticks_to_wait, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFAIL;
+        }
+    }
+    if (queue->item_size && item) {
+        memcpy(item, queue->buf + queue->head * queue->item_size, queue->item_size);
+    }
+    if (!peek) {
+        if (queue->item_size) {
+            queue->head = (queue->head + 1) % queue->length;
+        }
+        queue->count--;
+        _wake(&queue->cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    return _queue_receive(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    return _queue_receive(queue, item, ticks_to_wait, true);
+}
+
+BaseType_t xQueueSemaphoreTake(QueueHandle_t queue, TickType_t ticks_to_wait)
+{
+    return _queue_receive(queue, NULL, ticks_to_wait, false);
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->head = 0;
+    queue->count = 0;
+    _wake(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t spaces = queue->length - queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return spaces;
+}
+
+BaseType_t xQueueAddToSet(QueueSetMemberHandle_t member, QueueSetHandle_t set)
+{
+    BaseType_t ret = pdFAIL;
+    pthread_mutex_lock(&member->lock);
+    /* Same rules as FreeRTOS, a queue joins one set and only while empty */
+    if (member->set == NULL && member->count == 0) {
+        member->set = set;
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&member->lock);
+    return ret;
+}
+
+BaseType_t xQueueRemoveFromSet(QueueSetMemberHandle_t member, QueueSetHandle_t set)
+{
+    BaseType_t ret = pdFAIL;
+    pthread_mutex_lock(&member->lock);
+    if (member->set == set && member->count == 0) {
+        member->set = NULL;
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&member->lock);
+    return ret;
+}
+
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t set, TickType_t ticks_to_wait)
+{
+    QueueSetMemberHandle_t member = NULL;
+    if (xQueueReceive(set, &member, ticks_to_wait) != pdPASS) {
+        return NULL;
+    }
+    return member;
+}
+
+/* Event groups */
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    EventGroupHandle_t group = calloc(1, sizeof(struct rtos_event_group));
+    if (group == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&group->lock, NULL);
+    _cond_init(&group->cond);
+    return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    if (group == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&group->lock);
+    pthread_cond_destroy(&group->cond);
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, const EventBits_t bits)
+{
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t ret = group->bits;
+    _wake(&group->cond);
+    pthread_mutex_unlock(&group->lock);
+    return ret;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, const EventBits_t bits)
+{
+    pthread_mutex_lock(&group->lock);
+    EventBits_t ret = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return ret;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, const EventBits_t bits, const BaseType_t clear_on_exit,
+                                const BaseType_t wait_for_all, TickType_t ticks_to_wait)
+{
+    struct timespec deadline = _deadline(ticks_to_wait);
+    pthread_mutex_lock(&group->lock);
+    EventBits_t ret;
+    while (1) {
+        ret = group->bits;
+        bool matched = wait_for_all ? ((ret & bits) == bits) : ((ret & bits) != 0);
+        if (matched) {
+            if (clear_on_exit) {
+                group->bits &= ~bits;
+            }
+            break;
+        }
+        if (!_wait(&group->cond, &group->lock, ticks_to_wait, &deadline)) {
+            ret = group->bits;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&group->lock);
+    return ret;
+}
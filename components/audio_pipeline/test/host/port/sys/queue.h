@@ -0,0 +1,63 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _FREERTOS_POSIX_SYS_QUEUE_H_
+#define _FREERTOS_POSIX_SYS_QUEUE_H_
+
+/* glibc lacks the _SAFE iterators that the newlib copy in ESP-IDF provides */
+#include_next <sys/queue.h>
+
+#ifndef STAILQ_FIRST
+#define STAILQ_FIRST(head)          ((head)->stqh_first)
+#endif
+
+#ifndef STAILQ_NEXT
+#define STAILQ_NEXT(elm, field)     ((elm)->field.stqe_next)
+#endif
+
+#ifndef STAILQ_FOREACH_SAFE
+#define STAILQ_FOREACH_SAFE(var, head, field, tvar)                 \
+    for ((var) = STAILQ_FIRST((head));                              \
+         (var) && ((tvar) = STAILQ_NEXT((var), field), 1);          \
+         (var) = (tvar))
+#endif
+
+#ifndef STAILQ_LAST
+#define STAILQ_LAST(head, type, field)                              \
+    (STAILQ_EMPTY((head)) ? NULL :                                  \
+     __containerof((head)->stqh_last, struct type, field.stqe_next))
+#endif
+
+#ifndef __containerof
+#define __containerof(ptr, type, field) ((type *)((char *)(ptr) - offsetof(type, field)))
+#endif
+
+#ifndef SLIST_FOREACH_SAFE
+#define SLIST_FOREACH_SAFE(var, head, field, tvar)                  \
+    for ((var) = SLIST_FIRST((head));                               \
+         (var) && ((tvar) = SLIST_NEXT((var), field), 1);           \
+         (var) = (tvar))
+#endif
+
+#endif /* _FREERTOS_POSIX_SYS_QUEUE_H_ */
@@ -0,0 +1,250 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "ringbuf.h"
+#include "esp_log.h"
+#include "esp_err.h"
+
+static const char *TAG = "RINGBUF_TEST";
+
+#define RB_TEST_SIZE        (8 * 1024)
+#define RB_TEST_CHUNK       (1024)
+#define RB_TEST_TOTAL       (4 * 1024 * 1024)
+
+typedef struct {
+    ringbuf_handle_t    rb;
+    bool                zero_copy;
+    SemaphoreHandle_t   done;
+} rb_bench_t;
+
+typedef struct {
+    ringbuf_handle_t    rb;
+    SemaphoreHandle_t   done;
+    int                 received;
+    int                 errors;
+    int                 ret;
+} rb_spsc_t;
+
+TEST_CASE("ringbuf acquire and commit with wraparound", "[ringbuf]")
+{
+    ringbuf_handle_t rb = rb_create(100, 1);
+    TEST_ASSERT_NOT_NULL(rb);
+    char data[100];
+    char *span = NULL;
+    for (int i = 0; i < sizeof(data); i++) {
+        data[i] = i;
+    }
+
+    // Move the pointers close to the end so that the next span has to wrap
+    TEST_ASSERT_EQUAL(80, rb_write(rb, data, 80, 0));
+    TEST_ASSERT_EQUAL(80, rb_read(rb, data, 80, 0));
+
+    TEST_ASSERT_EQUAL(20, rb_acquire_write(rb, &span, 60, 0));
+    memset(span, 0x5A, 20);
+    TEST_ASSERT_EQUAL(RB_FAIL, rb_acquire_write(rb, &span, 60, 0));
+    TEST_ASSERT_EQUAL(20, rb_commit_write(rb, 20));
+    TEST_ASSERT_EQUAL(40, rb_acquire_write(rb, &span, 40, 0));
+    memset(span, 0xA5, 40);
+    TEST_ASSERT_EQUAL(30, rb_commit_write(rb, 30));
+    TEST_ASSERT_EQUAL(50, rb_bytes_filled(rb));
+
+    TEST_ASSERT_EQUAL(20, rb_acquire_read(rb, &span, 50, 0));
+    TEST_ASSERT_EACH_EQUAL_HEX8(0x5A, span, 20);
+    TEST_ASSERT_EQUAL(20, rb_release_read(rb, 20));
+    TEST_ASSERT_EQUAL(28, rb_acquire_read(rb, &span, 50, 0));
+    TEST_ASSERT_EACH_EQUAL_HEX8(0xA5, span, 28);
+    TEST_ASSERT_EQUAL(RB_FAIL, rb_release_read(rb, 29));
+    TEST_ASSERT_EQUAL(28, rb_release_read(rb, 28));
+
+    rb_done_write(rb);
+    TEST_ASSERT_EQUAL(2, rb_acquire_read(rb, &span, 50, 0));
+    TEST_ASSERT_EQUAL(2, rb_release_read(rb, 2));
+    TEST_ASSERT_EQUAL(RB_DONE, rb_acquire_read(rb, &span, 50, 0));
+
+    rb_reset(rb);
+    rb_abort(rb);
+    TEST_ASSERT_EQUAL(RB_ABORT, rb_acquire_read(rb, &span, 50, portMAX_DELAY));
+    rb_destroy(rb);
+}
+
+// Byte stream pattern, the period is prime so it never lines up with the buffer size
+static char rb_spsc_pattern(int pos)
+{
+    return (char)(pos % 251);
+}
+
+static void rb_spsc_reader(void *pv)
+{
+    rb_spsc_t *spsc = (rb_spsc_t *)pv;
+    char *span = NULL;
+    int want = 1;
+    while (1) {
+        spsc->ret = rb_acquire_read(spsc->rb, &span, want, portMAX_DELAY);
+        if (spsc->ret <= 0) {
+            break;
+        }
+        for (int i = 0; i < spsc->ret; i++) {
+            if (span[i] != rb_spsc_pattern(spsc->received + i)) {
+                spsc->errors++;
+            }
+        }
+        spsc->received += spsc->ret;
+        rb_release_read(spsc->rb, spsc->ret);
+        want = want % 509 + 37;
+    }
+    xSemaphoreGive(spsc->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("ringbuf spsc acquire and commit between two tasks", "[ringbuf]")
+{
+    rb_spsc_t spsc = {
+        .rb = rb_create_spsc(1000, 1),
+        .done = xSemaphoreCreateBinary(),
+    };
+    TEST_ASSERT_NOT_NULL(spsc.rb);
+    xTaskCreatePinnedToCore(rb_spsc_reader, "rb_reader", 3 * 1024, &spsc, 5, NULL, 1);
+
+    // Odd sized spans from both sides make the pointers wrap at every offset
+    char *span = NULL;
+    int sent = 0;
+    int want = 1;
+    while (sent < RB_TEST_TOTAL / 4) {
+        int ret = rb_acquire_write(spsc.rb, &span, want, portMAX_DELAY);
+        TEST_ASSERT_GREATER_THAN(0, ret);
+        for (int i = 0; i < ret; i++) {
+            span[i] = rb_spsc_pattern(sent + i);
+        }
+        TEST_ASSERT_EQUAL(ret, rb_commit_write(spsc.rb, ret));
+        sent += ret;
+        want = want % 311 + 53;
+    }
+    rb_done_write(spsc.rb);
+    TEST_ASSERT_TRUE(xSemaphoreTake(spsc.done, 5000 / portTICK_PERIOD_MS));
+    TEST_ASSERT_EQUAL(RB_DONE, spsc.ret);
+    TEST_ASSERT_EQUAL(sent, spsc.received);
+    TEST_ASSERT_EQUAL(0, spsc.errors);
+
+    // Abort from the writer side wakes a reader blocked on the empty buffer
+    rb_reset(spsc.rb);
+    spsc.received = 0;
+    xTaskCreatePinnedToCore(rb_spsc_reader, "rb_reader", 3 * 1024, &spsc, 5, NULL, 1);
+    vTaskDelay(100 / portTICK_PERIOD_MS);
+    TEST_ASSERT_FALSE(xSemaphoreTake(spsc.done, 0));
+    rb_abort(spsc.rb);
+    TEST_ASSERT_TRUE(xSemaphoreTake(spsc.done, 1000 / portTICK_PERIOD_MS));
+    TEST_ASSERT_EQUAL(RB_ABORT, spsc.ret);
+    TEST_ASSERT_EQUAL(0, spsc.received);
+    // and a writer waiting for space on the full buffer
+    while (rb_bytes_available(spsc.rb) > 0) {
+        int ret = rb_acquire_write(spsc.rb, &span, RB_TEST_CHUNK, 0);
+        TEST_ASSERT_GREATER_THAN(0, ret);
+        rb_commit_write(spsc.rb, ret);
+    }
+    TEST_ASSERT_EQUAL(RB_ABORT, rb_acquire_write(spsc.rb, &span, 1, portMAX_DELAY));
+
+    vSemaphoreDelete(spsc.done);
+    rb_destroy(spsc.rb);
+}
+
+static void rb_bench_reader(void *pv)
+{
+    rb_bench_t *bench = (rb_bench_t *)pv;
+    char *buf = malloc(RB_TEST_CHUNK);
+    char *span = NULL;
+    int ret = 0;
+    while (1) {
+        if (bench->zero_copy) {
+            ret = rb_acquire_read(bench->rb, &span, RB_TEST_CHUNK, portMAX_DELAY);
+            if (ret > 0) {
+                rb_release_read(bench->rb, ret);
+            }
+        } else {
+            ret = rb_read(bench->rb, buf, RB_TEST_CHUNK, portMAX_DELAY);
+        }
+        if (ret <= 0) {
+            break;
+        }
+    }
+    free(buf);
+    xSemaphoreGive(bench->done);
+    vTaskDelete(NULL);
+}
+
+static void rb_bench_run(bool spsc, bool zero_copy)
+{
+    rb_bench_t bench = {
+        .rb = spsc ? rb_create_spsc(RB_TEST_SIZE, 1) : rb_create(RB_TEST_SIZE, 1),
+        .zero_copy = zero_copy,
+        .done = xSemaphoreCreateBinary(),
+    };
+    TEST_ASSERT_NOT_NULL(bench.rb);
+    char *buf = calloc(1, RB_TEST_CHUNK);
+    char *span = NULL;
+    xTaskCreatePinnedToCore(rb_bench_reader, "rb_reader", 3 * 1024, &bench, 5, NULL, 1);
+
+    int64_t start = esp_timer_get_time();
+    int total = 0;
+    while (total < RB_TEST_TOTAL) {
+        int ret = 0;
+        if (zero_copy) {
+            ret = rb_acquire_write(bench.rb, &span, RB_TEST_CHUNK, portMAX_DELAY);
+            if (ret > 0) {
+                rb_commit_write(bench.rb, ret);
+            }
+        } else {
+            ret = rb_write(bench.rb, buf, RB_TEST_CHUNK, portMAX_DELAY);
+        }
+        TEST_ASSERT_GREATER_THAN(0, ret);
+        total += ret;
+    }
+    rb_done_write(bench.rb);
+    xSemaphoreTake(bench.done, portMAX_DELAY);
+    int64_t cost_us = esp_timer_get_time() - start;
+
+    ESP_LOGI(TAG, "%s %s: %d bytes in %lld us, %lld KB/s", spsc ? "spsc" : "mutex",
+             zero_copy ? "acquire/commit" : "read/write", total, cost_us, (int64_t)total * 1000 / 1024 * 1000 / cost_us);
+    free(buf);
+    vSemaphoreDelete(bench.done);
+    rb_destroy(bench.rb);
+}
+
+TEST_CASE("ringbuf copy and zero-copy throughput", "[ringbuf]")
+{
+    rb_bench_run(false, false);
+    rb_bench_run(false, true);
+}
+
+TEST_CASE("ringbuf spsc throughput", "[ringbuf]")
+{
+    rb_bench_run(true, false);
+    rb_bench_run(true, true);
+}
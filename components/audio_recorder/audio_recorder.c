@@ -151,8 +151,18 @@ static inline esp_err_t audio_recorder_update_state_2_user(audio_recorder_t *rec
     return recorder->event_cb(&event, recorder->user_data);
 }
 
+static inline void audio_recorder_sr_output_enable(audio_recorder_t *recorder, bool enable)
+{
+    if (recorder->sr_handle && recorder->sr_iface->output_enable) {
+        recorder->sr_iface->output_enable(recorder->sr_handle, enable);
+    }
+}
+
 static inline void audio_recorder_set_state(audio_recorder_t *recorder, int state)
 {
+    if ((recorder->state == RECORDER_ST_IDLE) != (state == RECORDER_ST_IDLE)) {
+        audio_recorder_sr_output_enable(recorder, state != RECORDER_ST_IDLE);
+    }
     recorder->state = state;
 }
 
@@ -298,7 +308,7 @@ static void audio_recorder_update_state(audio_recorder_t *recorder, int event)
                     audio_recorder_update_state_2_user(recorder, AUDIO_REC_VAD_START, NULL, 0);
                 }
             } else if (event == RECORDER_EVENT_WAKEUP_TIMER_EXPIRED) {
-                recorder->state = RECORDER_ST_IDLE;
+                audio_recorder_set_state(recorder, RECORDER_ST_IDLE);
                 esp_timer_stop(recorder->vad_timer);
                 audio_recorder_update_state_2_user(recorder, AUDIO_REC_WAKEUP_END, NULL, 0);
                 audio_recorder_encoder_enable(recorder, false);
@@ -313,7 +323,7 @@ static void audio_recorder_update_state(audio_recorder_t *recorder, int event)
                 esp_timer_stop(recorder->wakeup_timer);
                 audio_recorder_update_state_2_user(recorder, AUDIO_REC_VAD_START, NULL, 0);
             } else if (event == RECORDER_EVENT_WAKEUP_TIMER_EXPIRED) {
-                recorder->state = RECORDER_ST_IDLE;
+                audio_recorder_set_state(recorder, RECORDER_ST_IDLE);
                 esp_timer_stop(recorder->vad_timer);
                 audio_recorder_update_state_2_user(recorder, AUDIO_REC_WAKEUP_END, NULL, 0);
                 audio_recorder_encoder_enable(recorder, false);
@@ -342,7 +352,7 @@ static void audio_recorder_update_state(audio_recorder_t *recorder, int event)
                     audio_recorder_set_state(recorder, RECORDER_ST_WAIT_FOR_SLEEP);
                     audio_recorder_wakeup_timer_start(recorder);
                 } else {
-                    recorder->state = RECORDER_ST_IDLE;
+                    audio_recorder_set_state(recorder, RECORDER_ST_IDLE);
                 }
                 audio_recorder_update_state_2_user(recorder, AUDIO_REC_VAD_END, NULL, 0);
             }
@@ -369,7 +379,7 @@ static void audio_recorder_reset(audio_recorder_t *recorder)
     esp_timer_stop(recorder->wakeup_timer);
     esp_timer_stop(recorder->vad_timer);
     audio_recorder_encoder_enable(recorder, false);
-    recorder->state = RECORDER_ST_IDLE;
+    audio_recorder_set_state(recorder, RECORDER_ST_IDLE);
 }
 
 static void audio_recorder_task(void *parameters)
@@ -539,6 +549,7 @@ audio_rec_handle_t audio_recorder_create(audio_rec_cfg_t *config)
         sr_iface->set_mn_monitor(recorder->sr_handle, audio_recorder_mn_monitor, recorder);
         sr_iface->base.set_read_cb(recorder->sr_handle, recorder->read, NULL);
         sr_iface->base.enable(recorder->sr_handle, true);
+        audio_recorder_sr_output_enable(recorder, false);
     }
 
     if (recorder->encoder_handle) {
@@ -27,6 +27,7 @@
 
 #include <string.h>
 #include "esp_err.h"
+#include "audio_sample.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -78,22 +79,17 @@ static __attribute__((always_inline)) inline int8_t ch_get_idx(int8_t *order, si
  * @brief Sort and copy the given data to output buffer with `src_order` for 2 channels i2s data.
  *
  * @param i_buf         input buffer
- * @param o_buf         output buffer
+ * @param o_buf         output buffer, may be `i_buf` to sort in place
  * @param len           length of `i_buf`, length of `o_buf` should not less than `i_buf`'s
  * @param src_order     order of the channels
  * @return ESP_OK
  */
 static __attribute__((always_inline)) inline esp_err_t ch_sort_16bit_2ch(int16_t *i_buf, int16_t *o_buf, size_t len, int8_t *src_order)
 {
-    if (src_order[0] == DAT_CH_0 && src_order[1] == DAT_CH_1) {
-        memcpy(o_buf, i_buf, len);
-        return ESP_OK;
-    }
-    for (int i = 0; i < (len >> 2); i++) {
-        size_t cur_idx = i << 1;
-        o_buf[cur_idx] = i_buf[cur_idx + 1];
-        o_buf[cur_idx + 1] = i_buf[cur_idx];
-    }
+    static const int8_t keep[2] = { 0, 1 };
+    static const int8_t swap[2] = { 1, 0 };
+    const int8_t *map = (src_order[0] == DAT_CH_0 && src_order[1] == DAT_CH_1) ? keep : swap;
+    audio_sample_reorder_16(i_buf, 2, o_buf, map, 2, len >> 2);
     return ESP_OK;
 }
 
@@ -103,7 +99,7 @@ static __attribute__((always_inline)) inline esp_err_t ch_sort_16bit_2ch(int16_t
  *        so this function will pick ch0, ch1 and ch2, and sort them into correct order, data of ch3 will be dropped.
  *
  * @param i_buf         input buffer
- * @param o_buf         output buffer
+ * @param o_buf         output buffer, may be `i_buf` to sort in place
  * @param len           length of `i_buf`, length of `o_buf` should not less than `i_buf`'s
  * @param src_order     order of the channels
  * @return ESP_OK
@@ -118,12 +114,8 @@ static __attribute__((always_inline)) inline esp_err_t ch_sort_16bit_4ch(int16_t
     if (ch0_idx == -1 || ch1_idx == -1 || ref_idx == -1) {
         return ESP_ERR_INVALID_ARG;
     }
-    for (int i = 0; i < (len >> 3); i++) {
-        o_buf[3 * i + 0] = i_buf[(i << 2) + ch0_idx];
-        o_buf[3 * i + 1] = i_buf[(i << 2) + ch1_idx];
-        o_buf[3 * i + 2] = i_buf[(i << 2) + ref_idx];
-    }
-    return ESP_OK;
+    int8_t map[3] = { ch0_idx, ch1_idx, ref_idx };
+    return audio_sample_reorder_16(i_buf, 4, o_buf, map, 3, len >> 3);
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,188 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __RECORDER_PREROLL_H__
+#define __RECORDER_PREROLL_H__
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief What the pre-roll buffer does when the reader falls a whole buffer behind the writer
+ */
+typedef enum {
+    RECORDER_OVERFLOW_DROP_OLDEST,  /*!< Overwrite the oldest unread data, the reader skips ahead */
+    RECORDER_OVERFLOW_DROP_NEWEST,  /*!< Keep the unread data and discard what does not fit */
+} recorder_overflow_policy_t;
+
+/**
+ * @brief Pre-roll buffer configuration
+ */
+typedef struct {
+    int                        size;     /*!< Buffer size in bytes, bounds both the history and the unread data */
+    recorder_overflow_policy_t policy;   /*!< Overflow policy while a reader is attached */
+} recorder_preroll_cfg_t;
+
+/**
+ * @brief Pre-roll buffer statistics, all counters are in bytes except `overflows`
+ */
+typedef struct {
+    uint64_t written;    /*!< Data written by the producer */
+    uint64_t read;       /*!< Data handed to the reader */
+    uint64_t dropped;    /*!< Data lost because the attached reader fell behind */
+    uint32_t overflows;  /*!< Writes that dropped data */
+    uint32_t preroll;    /*!< History handed to the reader by the last attach */
+} recorder_preroll_stats_t;
+
+/**
+ * @brief Pre-roll buffer handle
+ *
+ *        A circular buffer that keeps the latest `size` bytes whether or not anyone reads them.
+ *        While no reader is attached the data is only history and is overwritten silently.
+ *        Attaching starts the reader some history before a marked point, e.g. the wake word detection,
+ *        so the consumer gets the audio that triggered it. From then on unread data is subject to
+ *        the overflow policy and every lost byte is counted.
+ */
+typedef struct recorder_preroll *recorder_preroll_handle_t;
+
+/**
+ * @brief Create a pre-roll buffer, the reader starts attached at the write position
+ *
+ * @param cfg  Configuration
+ *
+ * @return NULL    failed
+ *         Others  Pre-roll buffer handle
+ */
+recorder_preroll_handle_t recorder_preroll_create(recorder_preroll_cfg_t *cfg);
+
+/**
+ * @brief Write data, never blocks
+ *
+ * @param handle  Pre-roll buffer handle
+ * @param data    Data to write
+ * @param len     Length of data
+ *
+ * @return Bytes accepted, less than `len` only when `RECORDER_OVERFLOW_DROP_NEWEST` discarded data
+ *         RB_FAIL     invalid argument
+ */
+int recorder_preroll_write(recorder_preroll_handle_t handle, const void *data, int len);
+
+/**
+ * @brief Read data for the attached reader, waits until `len` bytes are read or `ticks` passed
+ *
+ * @param handle  Pre-roll buffer handle
+ * @param buf     Buffer to read into
+ * @param len     Length of buffer
+ * @param ticks   Timeout
+ *
+ * @return Bytes read
+ *         RB_TIMEOUT  nothing to read before timeout
+ *         RB_DONE     `recorder_preroll_done` was called and nothing is left
+ *         RB_FAIL     invalid argument
+ */
+int recorder_preroll_read(recorder_preroll_handle_t handle, void *buf, int len, TickType_t ticks);
+
+/**
+ * @brief Mark the current write position as the start of an event, the next attach rewinds from it
+ *
+ * @param handle  Pre-roll buffer handle
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t recorder_preroll_mark(recorder_preroll_handle_t handle);
+
+/**
+ * @brief Attach the reader `history` bytes before the mark, or before the write position when nothing is marked.
+ *        The mark is consumed, the history is clamped to what the buffer still holds.
+ *
+ * @param handle   Pre-roll buffer handle
+ * @param history  Bytes of history to hand out first
+ *
+ * @return History bytes the reader gets
+ *         RB_FAIL     invalid argument
+ */
+int recorder_preroll_attach(recorder_preroll_handle_t handle, int history);
+
+/**
+ * @brief Detach the reader, unread data becomes history and nothing is counted as dropped
+ *
+ * @param handle  Pre-roll buffer handle
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t recorder_preroll_detach(recorder_preroll_handle_t handle);
+
+/**
+ * @brief Drop all data and the mark, and clear the done state. Attachment and statistics are kept.
+ *
+ * @param handle  Pre-roll buffer handle
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t recorder_preroll_reset(recorder_preroll_handle_t handle);
+
+/**
+ * @brief Tell the reader no more data is coming, a blocked read returns RB_DONE once the data is drained
+ *
+ * @param handle  Pre-roll buffer handle
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t recorder_preroll_done(recorder_preroll_handle_t handle);
+
+/**
+ * @brief Get the statistics
+ *
+ * @param handle  Pre-roll buffer handle
+ * @param stats   Statistics output
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t recorder_preroll_get_stats(recorder_preroll_handle_t handle, recorder_preroll_stats_t *stats);
+
+/**
+ * @brief Destroy the pre-roll buffer, no reader may be blocked on it
+ *
+ * @param handle  Pre-roll buffer handle
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t recorder_preroll_destroy(recorder_preroll_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RECORDER_PREROLL_H__ */
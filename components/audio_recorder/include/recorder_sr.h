@@ -28,6 +28,7 @@
 #include "esp_afe_sr_iface.h"
 #include "esp_err.h"
 #include "recorder_sr_iface.h"
+#include "recorder_preroll.h"
 #include "esp_mn_models.h"
 #include "ch_sort.h"
 
@@ -42,6 +43,8 @@ extern "C" {
 #define FEED_TASK_PINNED_CORE    (0)
 #define FETCH_TASK_PINNED_CORE   (1)
 #define SR_OUTPUT_RB_SIZE        (6 * 1024)
+#define SR_OUTPUT_PREROLL_MS     (500)
+#define SR_OUTPUT_BYTES_PER_MS   (32)   /* The afe output is 16 kHz, 16 bit, mono */
 
 /**
  * @brief SR processor handle
@@ -68,6 +71,8 @@ typedef struct {
     int          fetch_task_prio;                       /*!< Priority of fetch task */
     int          fetch_task_stack;                      /*!< Stack size of fetch task */
     int          rb_size;                               /*!< Ringbuffer size of recorder sr */
+    int          preroll_ms;                            /*!< History kept ahead of the wake word and handed out first when the output starts, the output buffer grows by this much */
+    recorder_overflow_policy_t overflow_policy;         /*!< What to drop when the output is not read fast enough, see `recorder_sr_get_output_stats` */
     char         *partition_label;                      /*!< Partition label which stored the model data */
     char         *mn_language;                          /*!< Command language for multinet to load */
     char         *wn_wakeword;                          /*!< Wake Word for WakeNet to load. This is useful when multiple Wake Words are selected in sdkconfig. Setting this to NULL will use the first found model. */
@@ -104,6 +109,8 @@ typedef struct {
     .fetch_task_prio  = FETCH_TASK_PRIO,            \
     .fetch_task_stack = FETCH_TASK_STACK_SZ,        \
     .rb_size          = SR_OUTPUT_RB_SIZE,          \
+    .preroll_ms       = SR_OUTPUT_PREROLL_MS,       \
+    .overflow_policy  = RECORDER_OVERFLOW_DROP_OLDEST, \
     .partition_label  = "model",                    \
     .mn_language      = ESP_MN_CHINESE,             \
     .wn_wakeword      = NULL,                       \
@@ -142,6 +149,17 @@ esp_err_t recorder_sr_destroy(recorder_sr_handle_t handle);
  */
 esp_err_t recorder_sr_reset_speech_cmd(recorder_sr_handle_t handle, char *command_str, char *err_phrase_id);
 
+/**
+ * @brief Get the statistics of the SR output buffer, including the data dropped by the overflow policy
+ *
+ * @param handle SR processor handle
+ * @param stats  Statistics output
+ *
+ * @return ESP_OK
+ *         ESP_FAIL
+ */
+esp_err_t recorder_sr_get_output_stats(recorder_sr_handle_t handle, recorder_preroll_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -154,6 +154,19 @@ typedef struct {
      *          ESP_ERR_INVALID_ARG
      */
     esp_err_t (*mn_enable)(void *handle, bool enable);
+
+    /**
+     * @brief Start or stop handing the afe output to `fetch`, optional.
+     *        Once started the output begins with the pre-roll history before the wake word,
+     *        or before the call when no wake word was detected. While stopped the output is only kept as history.
+     *
+     * @param handle    The handle of sr handle
+     * @param enable    true to start, false to stop
+     *
+     * @returns ESP_OK
+     *          ESP_ERR_INVALID_ARG
+     */
+    esp_err_t (*output_enable)(void *handle, bool enable);
 } recorder_sr_iface_t;
 
 #ifdef __cplusplus
@@ -0,0 +1,276 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+#include "audio_error.h"
+#include "audio_mem.h"
+#include "ringbuf.h"
+#include "recorder_preroll.h"
+
+static const char *TAG = "RECORDER_PREROLL";
+
+/*
+ * Positions are absolute byte counts since creation, so they never wrap in practice and
+ * `pos % size` is the offset in the buffer. `valid` bytes before `w` are still held,
+ * the reader owns [r, w) while attached and follows `w` while detached.
+ */
+struct recorder_preroll {
+    uint8_t                    *buf;
+    int                        size;
+    recorder_overflow_policy_t policy;
+    SemaphoreHandle_t          lock;
+    SemaphoreHandle_t          can_read;
+    uint64_t                   w;
+    uint64_t                   r;
+    uint64_t                   valid;
+    uint64_t                   mark;
+    bool                       marked;
+    bool                       attached;
+    bool                       is_done;
+    recorder_preroll_stats_t   stats;
+};
+
+static void _preroll_copy_in(struct recorder_preroll *pr, const uint8_t *data, int len)
+{
+    int offset = pr->w % pr->size;
+    int first = pr->size - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(pr->buf + offset, data, first);
+    memcpy(pr->buf, data + first, len - first);
+}
+
+static void _preroll_copy_out(struct recorder_preroll *pr, uint8_t *data, int len)
+{
+    int offset = pr->r % pr->size;
+    int first = pr->size - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(data, pr->buf + offset, first);
+    memcpy(data + first, pr->buf, len - first);
+}
+
+recorder_preroll_handle_t recorder_preroll_create(recorder_preroll_cfg_t *cfg)
+{
+    AUDIO_NULL_CHECK(TAG, cfg, return NULL);
+    AUDIO_CHECK(TAG, cfg->size > 0, return NULL, "Invalid size");
+
+    struct recorder_preroll *pr = audio_calloc(1, sizeof(struct recorder_preroll));
+    AUDIO_MEM_CHECK(TAG, pr, return NULL);
+    pr->buf = audio_malloc(cfg->size);
+    AUDIO_MEM_CHECK(TAG, pr->buf, goto _failed);
+    pr->lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, pr->lock, goto _failed);
+    pr->can_read = xSemaphoreCreateBinary();
+    AUDIO_MEM_CHECK(TAG, pr->can_read, goto _failed);
+    pr->size = cfg->size;
+    pr->policy = cfg->policy;
+    pr->attached = true;
+    return pr;
+
+_failed:
+    recorder_preroll_destroy(pr);
+    return NULL;
+}
+
+int recorder_preroll_write(recorder_preroll_handle_t handle, const void *data, int len)
+{
+    AUDIO_CHECK(TAG, handle && data && len >= 0, return RB_FAIL, "Invalid argument");
+    struct recorder_preroll *pr = handle;
+    const uint8_t *src = data;
+    int accepted = len;
+
+    xSemaphoreTake(pr->lock, portMAX_DELAY);
+    pr->stats.written += len;
+    if (pr->attached) {
+        int space = pr->size - (int)(pr->w - pr->r);
+        if (len > space) {
+            pr->stats.overflows++;
+            if (pr->policy == RECORDER_OVERFLOW_DROP_NEWEST) {
+                pr->stats.dropped += len - space;
+                accepted = len = space;
+            } else {
+                if (len > pr->size) {
+                    pr->stats.dropped += len - pr->size;
+                    src += len - pr->size;
+                    len = pr->size;
+                }
+                if (len > space) {
+                    pr->stats.dropped += len - space;
+                    pr->r += len - space;
+                }
+            }
+        }
+    } else if (len > pr->size) {
+        src += len - pr->size;
+        len = pr->size;
+    }
+    _preroll_copy_in(pr, src, len);
+    pr->w += len;
+    pr->valid += len;
+    if (pr->valid > pr->size) {
+        pr->valid = pr->size;
+    }
+    if (!pr->attached) {
+        pr->r = pr->w;
+    }
+    bool notify = pr->attached && len > 0;
+    xSemaphoreGive(pr->lock);
+
+    if (notify) {
+        xSemaphoreGive(pr->can_read);
+    }
+    return accepted;
+}
+
+int recorder_preroll_read(recorder_preroll_handle_t handle, void *buf, int len, TickType_t ticks)
+{
+    AUDIO_CHECK(TAG, handle && buf && len >= 0, return RB_FAIL, "Invalid argument");
+    struct recorder_preroll *pr = handle;
+    uint8_t *dst = buf;
+    int got = 0;
+    bool done = false;
+
+    while (got < len) {
+        xSemaphoreTake(pr->lock, portMAX_DELAY);
+        int n = pr->attached ? (int)(pr->w - pr->r) : 0;
+        if (n > len - got) {
+            n = len - got;
+        }
+        _preroll_copy_out(pr, dst + got, n);
+        pr->r += n;
+        pr->stats.read += n;
+        done = pr->is_done;
+        xSemaphoreGive(pr->lock);
+        got += n;
+        if (got == len || done) {
+            break;
+        }
+        if (xSemaphoreTake(pr->can_read, ticks) != pdTRUE) {
+            break;
+        }
+    }
+    if (got > 0) {
+        return got;
+    }
+    return done ? RB_DONE : RB_TIMEOUT;
+}
+
+esp_err_t recorder_preroll_mark(recorder_preroll_handle_t handle)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_ERR_INVALID_ARG);
+    struct recorder_preroll *pr = handle;
+    xSemaphoreTake(pr->lock, portMAX_DELAY);
+    pr->mark = pr->w;
+    pr->marked = true;
+    xSemaphoreGive(pr->lock);
+    return ESP_OK;
+}
+
+int recorder_preroll_attach(recorder_preroll_handle_t handle, int history)
+{
+    AUDIO_CHECK(TAG, handle && history >= 0, return RB_FAIL, "Invalid argument");
+    struct recorder_preroll *pr = handle;
+    xSemaphoreTake(pr->lock, portMAX_DELAY);
+    uint64_t oldest = pr->w - pr->valid;
+    uint64_t from = pr->marked ? pr->mark : pr->w;
+    uint64_t start = from > oldest + history ? from - history : oldest;
+    pr->r = start;
+    pr->attached = true;
+    pr->marked = false;
+    pr->stats.preroll = from > start ? (uint32_t)(from - start) : 0;
+    int ret = pr->stats.preroll;
+    xSemaphoreGive(pr->lock);
+
+    xSemaphoreGive(pr->can_read);
+    ESP_LOGD(TAG, "Attached with %d bytes of history, %d unread", ret, (int)(pr->w - start));
+    return ret;
+}
+
+esp_err_t recorder_preroll_detach(recorder_preroll_handle_t handle)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_ERR_INVALID_ARG);
+    struct recorder_preroll *pr = handle;
+    xSemaphoreTake(pr->lock, portMAX_DELAY);
+    pr->attached = false;
+    pr->r = pr->w;
+    xSemaphoreGive(pr->lock);
+    return ESP_OK;
+}
+
+esp_err_t recorder_preroll_reset(recorder_preroll_handle_t handle)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_ERR_INVALID_ARG);
+    struct recorder_preroll *pr = handle;
+    xSemaphoreTake(pr->lock, portMAX_DELAY);
+    pr->valid = 0;
+    pr->r = pr->w;
+    pr->marked = false;
+    pr->is_done = false;
+    xSemaphoreGive(pr->lock);
+    return ESP_OK;
+}
+
+esp_err_t recorder_preroll_done(recorder_preroll_handle_t handle)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_ERR_INVALID_ARG);
+    struct recorder_preroll *pr = handle;
+    xSemaphoreTake(pr->lock, portMAX_DELAY);
+    pr->is_done = true;
+    xSemaphoreGive(pr->lock);
+    xSemaphoreGive(pr->can_read);
+    return ESP_OK;
+}
+
+esp_err_t recorder_preroll_get_stats(recorder_preroll_handle_t handle, recorder_preroll_stats_t *stats)
+{
+    AUDIO_CHECK(TAG, handle && stats, return ESP_ERR_INVALID_ARG, "Invalid argument");
+    struct recorder_preroll *pr = handle;
+    xSemaphoreTake(pr->lock, portMAX_DELAY);
+    memcpy(stats, &pr->stats, sizeof(recorder_preroll_stats_t));
+    xSemaphoreGive(pr->lock);
+    return ESP_OK;
+}
+
+esp_err_t recorder_preroll_destroy(recorder_preroll_handle_t handle)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_ERR_INVALID_ARG);
+    struct recorder_preroll *pr = handle;
+    if (pr->lock) {
+        vSemaphoreDelete(pr->lock);
+    }
+    if (pr->can_read) {
+        vSemaphoreDelete(pr->can_read);
+    }
+    audio_free(pr->buf);
+    audio_free(pr);
+    return ESP_OK;
+}
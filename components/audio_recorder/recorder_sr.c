@@ -36,6 +36,7 @@
 #include "audio_thread.h"
 
 #include "ringbuf.h"
+#include "recorder_preroll.h"
 
 #include "esp_afe_sr_models.h"
 #include "esp_wn_iface.h"
@@ -72,8 +73,10 @@ typedef struct __recorder_sr {
     int                   fetch_task_core;
     int                   fetch_task_prio;
     int                   fetch_task_stack;
-    ringbuf_handle_t      out_rb;
+    recorder_preroll_handle_t out_rb;
     int                   rb_size;
+    int                   preroll_size;
+    recorder_overflow_policy_t overflow_policy;
     EventGroupHandle_t    events;
     bool                  feed_running;
     bool                  fetch_running;
@@ -227,8 +230,6 @@ static void feed_task(void *parameters)
     int buf_size = chunksize * sizeof(int16_t) * recorder_sr->src_ch_num;
     int16_t *i_buf = audio_calloc(1, buf_size);
     assert(i_buf);
-    int16_t *o_buf = audio_calloc(1, buf_size);;
-    assert(o_buf);
 
     int fill_cnt = 0;
 
@@ -240,18 +241,17 @@ static void feed_task(void *parameters)
         int ret = recorder_sr->read((char *)i_buf + fill_cnt, buf_size - fill_cnt, recorder_sr->read_ctx, portMAX_DELAY);
         fill_cnt += ret;
         if (fill_cnt == buf_size) {
-            if (recorder_sr->src_ch_num == 1) {
-                memcpy(o_buf, i_buf, fill_cnt);
-            } else if (recorder_sr->src_ch_num == 2) {
-                ch_sort_16bit_2ch(i_buf, o_buf, fill_cnt, recorder_sr->input_order);
+            // The afe copies what it is fed, so the channels are sorted in place and mono goes as is
+            if (recorder_sr->src_ch_num == 2) {
+                ch_sort_16bit_2ch(i_buf, i_buf, fill_cnt, recorder_sr->input_order);
             } else if (recorder_sr->src_ch_num == 4) {
-                ch_sort_16bit_4ch(i_buf, o_buf, fill_cnt, recorder_sr->input_order);
-            } else {
+                ch_sort_16bit_4ch(i_buf, i_buf, fill_cnt, recorder_sr->input_order);
+            } else if (recorder_sr->src_ch_num != 1) {
                 ESP_LOGE(TAG, "Not supported source channel number [%d], please check the configuration",
                         recorder_sr->src_ch_num);
                 goto exit;
             }
-            esp_afe->feed(recorder_sr->afe_handle, o_buf);
+            esp_afe->feed(recorder_sr->afe_handle, i_buf);
             fill_cnt -= buf_size;
         } else if (fill_cnt > buf_size) {
             ESP_LOGE(TAG, "fill cnt > buffer_size, there may be memory out of range");
@@ -260,7 +260,6 @@ static void feed_task(void *parameters)
     }
 exit:
     audio_free(i_buf);
-    audio_free(o_buf);
     xEventGroupClearBits(recorder_sr->events, FEED_TASK_RUNNING);
     xEventGroupSetBits(recorder_sr->events, FEED_TASK_DESTROY);
     vTaskDelete(NULL);
@@ -275,6 +274,9 @@ static void fetch_task(void *parameters)
         xEventGroupWaitBits(recorder_sr->events, FETCH_TASK_RUNNING, false, true, portMAX_DELAY);
 
         afe_fetch_result_t *afe_result = esp_afe->fetch(recorder_sr->afe_handle);
+        if (afe_result->wakeup_state == WAKENET_DETECTED) {
+            recorder_preroll_mark(recorder_sr->out_rb);
+        }
 #ifdef CONFIG_USE_MULTINET
         recorder_mn_detect(recorder_sr, afe_result);
 #endif
@@ -293,10 +295,7 @@ static void fetch_task(void *parameters)
 
 static esp_err_t recorder_sr_output(recorder_sr_t *recorder_sr, void *buffer, int len)
 {
-    if (rb_bytes_available(recorder_sr->out_rb) < len) {
-        rb_read(recorder_sr->out_rb, NULL, len, 0);
-    }
-    int ret = rb_write(recorder_sr->out_rb, buffer, len, 0);
+    int ret = recorder_preroll_write(recorder_sr->out_rb, buffer, len);
     return ret == len ? ESP_OK : ESP_FAIL;
 }
 
@@ -304,7 +303,24 @@ static int recorder_sr_fetch(void *handle, void *buf, int len, TickType_t ticks)
 {
     AUDIO_CHECK(TAG, handle, return ESP_ERR_INVALID_ARG, "Handle is NULL");
     recorder_sr_t *recorder_sr = (recorder_sr_t *)handle;
-    return rb_read(recorder_sr->out_rb, buf, len, ticks);
+    return recorder_preroll_read(recorder_sr->out_rb, buf, len, ticks);
+}
+
+static esp_err_t recorder_sr_output_enable(void *handle, bool enable)
+{
+    AUDIO_CHECK(TAG, handle, return ESP_ERR_INVALID_ARG, "Handle is NULL");
+    recorder_sr_t *recorder_sr = (recorder_sr_t *)handle;
+    if (enable) {
+        int preroll = recorder_preroll_attach(recorder_sr->out_rb, recorder_sr->preroll_size);
+        ESP_LOGI(TAG, "Output start with %d ms pre-roll", preroll / SR_OUTPUT_BYTES_PER_MS);
+        return ESP_OK;
+    }
+    recorder_preroll_stats_t stats = { 0 };
+    recorder_preroll_get_stats(recorder_sr->out_rb, &stats);
+    if (stats.dropped) {
+        ESP_LOGW(TAG, "Output dropped %llu bytes in %u overflows so far", stats.dropped, (unsigned)stats.overflows);
+    }
+    return recorder_preroll_detach(recorder_sr->out_rb);
 }
 
 static esp_err_t recorder_sr_suspend(void *handle, bool suspend)
@@ -316,11 +332,11 @@ static esp_err_t recorder_sr_suspend(void *handle, bool suspend)
         xEventGroupClearBits(recorder_sr->events, FEED_TASK_RUNNING);
         xEventGroupClearBits(recorder_sr->events, FETCH_TASK_RUNNING);
         if (recorder_sr->out_rb) {
-            rb_done_write(recorder_sr->out_rb);
+            recorder_preroll_done(recorder_sr->out_rb);
         }
     } else {
         if (recorder_sr->out_rb) {
-            rb_reset(recorder_sr->out_rb);
+            recorder_preroll_reset(recorder_sr->out_rb);
         }
         xEventGroupSetBits(recorder_sr->events, FEED_TASK_RUNNING);
         xEventGroupSetBits(recorder_sr->events, FETCH_TASK_RUNNING);
@@ -361,7 +377,7 @@ static esp_err_t recorder_sr_enable(void *handle, bool enable)
         recorder_sr_suspend(handle, !enable);
 
         if (recorder_sr->out_rb) {
-            rb_reset(recorder_sr->out_rb);
+            recorder_preroll_reset(recorder_sr->out_rb);
         }
     } else {
         recorder_sr_suspend(handle, false);
@@ -381,7 +397,7 @@ static esp_err_t recorder_sr_enable(void *handle, bool enable)
             }
         }
         if (recorder_sr->out_rb) {
-            rb_done_write(recorder_sr->out_rb);
+            recorder_preroll_done(recorder_sr->out_rb);
         }
     }
     return ret == ESP_OK ? ESP_OK : ESP_FAIL;
@@ -506,6 +522,7 @@ static recorder_sr_iface_t recorder_sr_iface = {
     .set_mn_monitor = recorder_sr_set_mn_monitor,
     .wwe_enable = recorder_sr_wwe_enable,
     .mn_enable = recorder_sr_mn_enable,
+    .output_enable = recorder_sr_output_enable,
 };
 
 static void recorder_sr_clear(void *handle)
@@ -528,8 +545,7 @@ static void recorder_sr_clear(void *handle)
         esp_srmodel_deinit(recorder_sr->models);
     }
     if (recorder_sr->out_rb) {
-        rb_reset(recorder_sr->out_rb);
-        rb_destroy(recorder_sr->out_rb);
+        recorder_preroll_destroy(recorder_sr->out_rb);
     }
     if (recorder_sr->events) {
         vEventGroupDelete(recorder_sr->events);
@@ -553,6 +569,8 @@ recorder_sr_handle_t recorder_sr_create(recorder_sr_cfg_t *cfg, recorder_sr_ifac
     recorder_sr->fetch_task_prio  = cfg->fetch_task_prio;
     recorder_sr->fetch_task_stack = cfg->fetch_task_stack;
     recorder_sr->rb_size          = cfg->rb_size;
+    recorder_sr->preroll_size     = cfg->preroll_ms * SR_OUTPUT_BYTES_PER_MS;
+    recorder_sr->overflow_policy  = cfg->overflow_policy;
     recorder_sr->partition_label  = cfg->partition_label;
     recorder_sr->aec_enable       = cfg->afe_cfg.aec_init;
     recorder_sr->wn_wakeword      = cfg->wn_wakeword;
@@ -622,7 +640,11 @@ recorder_sr_handle_t recorder_sr_create(recorder_sr_cfg_t *cfg, recorder_sr_ifac
 #endif
     recorder_sr->events = xEventGroupCreate();
     AUDIO_NULL_CHECK(TAG, recorder_sr->events, goto _failed);
-    recorder_sr->out_rb = rb_create(recorder_sr->rb_size, 1);
+    recorder_preroll_cfg_t preroll_cfg = {
+        .size = recorder_sr->rb_size + recorder_sr->preroll_size,
+        .policy = recorder_sr->overflow_policy,
+    };
+    recorder_sr->out_rb = recorder_preroll_create(&preroll_cfg);
     AUDIO_NULL_CHECK(TAG, recorder_sr->out_rb, goto _failed);
 
     *iface = &recorder_sr_iface;
@@ -644,6 +666,13 @@ esp_err_t recorder_sr_destroy(recorder_sr_handle_t handle)
     return ESP_OK;
 }
 
+esp_err_t recorder_sr_get_output_stats(recorder_sr_handle_t handle, recorder_preroll_stats_t *stats)
+{
+    AUDIO_CHECK(TAG, handle, return ESP_FAIL, "Handle is NULL");
+    recorder_sr_t *recorder_sr = (recorder_sr_t *)handle;
+    return recorder_preroll_get_stats(recorder_sr->out_rb, stats);
+}
+
 
 esp_err_t recorder_sr_reset_speech_cmd(recorder_sr_handle_t handle, char *command_str, char *err_phrase_id)
 {
@@ -0,0 +1,19 @@
+#!/usr/bin/perl
+#
+# Build the recorder pre-roll test on host, on the pthread FreeRTOS port of audio_pipeline/test/host/port.
+# It feeds a recorded 16 kHz mono PCM or WAV file through the SR output buffer the way the afe fetch task
+# does. Run it as:
+#   ./build.pl && ./test_recorder_preroll [file]
+#
+# Pass "asan" to build with the address and undefined behaviour sanitizers.
+#
+use strict;
+
+my $r = "../../..";
+my $port = "$r/audio_pipeline/test/host/port";
+my @src = ("$r/audio_sal/audio_mem.c", "$r/audio_sal/audio_mutex.c", "$r/audio_sal/audio_thread.c",
+           "$r/audio_pipeline/ringbuf.c", "$port/freertos_posix.c", "../../recorder_preroll.c");
+my $inc = "-D_GNU_SOURCE -I$port -I$r/audio_sal/include -I$r/audio_pipeline/include -I../../include";
+my $opt = (grep { $_ eq "asan" } @ARGV) ? "-O1 -fsanitize=address,undefined -fno-omit-frame-pointer" : "-O2";
+
+system("gcc $opt -g -Wall @src test_recorder_preroll.c $inc -o ./test_recorder_preroll -lpthread -lm") == 0 or die "build failed";
@@ -0,0 +1,227 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Host test of the recorder pre-roll buffer, see build.pl
+ *
+ * The file is written in 32 ms afe frames, a wake word is marked at a fixed point and the reader is
+ * attached a few frames later, as the recorder task does. The data read back must be the file from
+ * the pre-roll point on, and overflows must drop exactly what the policy says and count it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "ringbuf.h"
+#include "recorder_preroll.h"
+
+#define BYTES_PER_MS        (32)
+#define FRAME_SIZE          (32 * BYTES_PER_MS)
+#define RB_SIZE             (6 * 1024)
+#define PREROLL_MS          (500)
+#define WAKE_MS             (2000)
+#define LATENCY_FRAMES      (3)     /* Frames written between the wake word and the attach */
+#define SPEED               (10)
+
+static uint8_t *s_pcm;
+static int      s_pcm_len;
+static int      s_errors;
+
+#define CHECK(cond, ...) do {                                   \
+        if (!(cond)) {                                          \
+            printf("  FAIL line %d: ", __LINE__);               \
+            printf(__VA_ARGS__);                                \
+            printf("\n");                                       \
+            s_errors++;                                         \
+        }                                                       \
+    } while (0)
+
+static int load_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("Can not open %s\n", path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    s_pcm_len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    s_pcm = malloc(s_pcm_len);
+    s_pcm_len = fread(s_pcm, 1, s_pcm_len, f);
+    fclose(f);
+    // Skip the canonical header of a WAV file, the samples must already be 16 kHz 16 bit mono
+    if (s_pcm_len > 44 && memcmp(s_pcm, "RIFF", 4) == 0) {
+        memmove(s_pcm, s_pcm + 44, s_pcm_len - 44);
+        s_pcm_len -= 44;
+    }
+    return 0;
+}
+
+static int write_range(recorder_preroll_handle_t pr, int from, int to, int pace_us)
+{
+    while (from < to) {
+        int n = to - from > FRAME_SIZE ? FRAME_SIZE : to - from;
+        recorder_preroll_write(pr, s_pcm + from, n);
+        from += n;
+        if (pace_us) {
+            usleep(pace_us);
+        }
+    }
+    return from;
+}
+
+static int read_all(recorder_preroll_handle_t pr, uint8_t *out, int max)
+{
+    int got = 0;
+    while (got < max) {
+        int ret = recorder_preroll_read(pr, out + got, FRAME_SIZE, 1000);
+        if (ret <= 0) {
+            break;
+        }
+        got += ret;
+    }
+    return got;
+}
+
+static recorder_preroll_handle_t create(recorder_overflow_policy_t policy)
+{
+    recorder_preroll_cfg_t cfg = {
+        .size = RB_SIZE + PREROLL_MS * BYTES_PER_MS,
+        .policy = policy,
+    };
+    return recorder_preroll_create(&cfg);
+}
+
+typedef struct {
+    recorder_preroll_handle_t pr;
+    uint8_t                   *out;
+    int                       got;
+} reader_t;
+
+static void *reader_task(void *arg)
+{
+    reader_t *rd = arg;
+    rd->got = read_all(rd->pr, rd->out, s_pcm_len);
+    return NULL;
+}
+
+/* Idle until the wake word, then stream the rest of the file to a reader running alongside */
+static void test_wakeup_preroll(void)
+{
+    printf("wakeup pre-roll\n");
+    recorder_preroll_handle_t pr = create(RECORDER_OVERFLOW_DROP_OLDEST);
+    recorder_preroll_detach(pr);
+    int wake = WAKE_MS * BYTES_PER_MS / FRAME_SIZE * FRAME_SIZE;
+    int pos = write_range(pr, 0, wake, 0);
+    recorder_preroll_mark(pr);
+    pos = write_range(pr, pos, pos + LATENCY_FRAMES * FRAME_SIZE, 0);
+    int history = recorder_preroll_attach(pr, PREROLL_MS * BYTES_PER_MS);
+    CHECK(history == PREROLL_MS * BYTES_PER_MS, "history %d", history);
+
+    reader_t rd = { .pr = pr, .out = malloc(s_pcm_len) };
+    pthread_t t;
+    pthread_create(&t, NULL, reader_task, &rd);
+    write_range(pr, pos, s_pcm_len, 32000 / SPEED);
+    recorder_preroll_done(pr);
+    pthread_join(t, NULL);
+
+    int start = wake - history;
+    CHECK(rd.got == s_pcm_len - start, "read %d, expect %d", rd.got, s_pcm_len - start);
+    CHECK(memcmp(rd.out, s_pcm + start, rd.got) == 0, "data is not the file from %d", start);
+    recorder_preroll_stats_t stats;
+    recorder_preroll_get_stats(pr, &stats);
+    CHECK(stats.dropped == 0 && stats.overflows == 0, "dropped %llu", (unsigned long long)stats.dropped);
+    CHECK(stats.written == s_pcm_len, "written %llu", (unsigned long long)stats.written);
+    printf("  %d ms of pre-roll, %d bytes read, %llu dropped\n", history / BYTES_PER_MS, rd.got,
+           (unsigned long long)stats.dropped);
+    free(rd.out);
+    recorder_preroll_destroy(pr);
+}
+
+/* A wake word right after a reset can only get the history there is */
+static void test_short_history(void)
+{
+    printf("short history\n");
+    recorder_preroll_handle_t pr = create(RECORDER_OVERFLOW_DROP_OLDEST);
+    write_range(pr, 0, s_pcm_len / 2, 0);
+    recorder_preroll_detach(pr);
+    recorder_preroll_reset(pr);
+    int base = s_pcm_len / 2;
+    int pos = write_range(pr, base, base + 100 * BYTES_PER_MS, 0);
+    recorder_preroll_mark(pr);
+    pos = write_range(pr, pos, pos + FRAME_SIZE, 0);
+    int history = recorder_preroll_attach(pr, PREROLL_MS * BYTES_PER_MS);
+    CHECK(history == 100 * BYTES_PER_MS, "history %d", history);
+    recorder_preroll_done(pr);
+    uint8_t *out = malloc(s_pcm_len);
+    int got = read_all(pr, out, s_pcm_len);
+    CHECK(got == pos - base && memcmp(out, s_pcm + base, got) == 0, "read %d", got);
+    CHECK(recorder_preroll_read(pr, out, FRAME_SIZE, 0) == RB_DONE, "no RB_DONE after drain");
+    free(out);
+    recorder_preroll_destroy(pr);
+}
+
+/* The reader stalls for the whole file, check what each policy keeps and that every loss is counted */
+static void test_overflow(recorder_overflow_policy_t policy)
+{
+    printf("overflow, drop %s\n", policy == RECORDER_OVERFLOW_DROP_OLDEST ? "oldest" : "newest");
+    recorder_preroll_handle_t pr = create(policy);
+    int size = RB_SIZE + PREROLL_MS * BYTES_PER_MS;
+    write_range(pr, 0, s_pcm_len, 0);
+    recorder_preroll_done(pr);
+    uint8_t *out = malloc(s_pcm_len);
+    int got = read_all(pr, out, s_pcm_len);
+    recorder_preroll_stats_t stats;
+    recorder_preroll_get_stats(pr, &stats);
+
+    CHECK(got == size, "read %d, expect %d", got, size);
+    CHECK(stats.dropped == s_pcm_len - size, "dropped %llu", (unsigned long long)stats.dropped);
+    CHECK(stats.read + stats.dropped == stats.written, "read + dropped != written");
+    CHECK(stats.overflows == (s_pcm_len - size + FRAME_SIZE - 1) / FRAME_SIZE, "overflows %u", stats.overflows);
+    int start = policy == RECORDER_OVERFLOW_DROP_OLDEST ? s_pcm_len - size : 0;
+    CHECK(memcmp(out, s_pcm + start, got) == 0, "data is not the file from %d", start);
+    printf("  %d bytes read, %llu dropped in %u overflows\n", got, (unsigned long long)stats.dropped, stats.overflows);
+    free(out);
+    recorder_preroll_destroy(pr);
+}
+
+int main(int argc, char *argv[])
+{
+    if (load_file(argc > 1 ? argv[1] : "../1ch16bit16k.pcm") != 0) {
+        return 1;
+    }
+    if (s_pcm_len < (WAKE_MS + 1000) * BYTES_PER_MS) {
+        printf("The file must be longer than %d ms\n", WAKE_MS + 1000);
+        return 1;
+    }
+    test_wakeup_preroll();
+    test_short_history();
+    test_overflow(RECORDER_OVERFLOW_DROP_OLDEST);
+    test_overflow(RECORDER_OVERFLOW_DROP_NEWEST);
+    free(s_pcm);
+    printf("%s\n", s_errors ? "FAILED" : "PASSED");
+    return s_errors ? 1 : 0;
+}
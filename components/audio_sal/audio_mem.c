@@ -23,6 +23,7 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
 #include "string.h"
 #include "sdkconfig.h"
 #include "esp_system.h"
@@ -36,43 +37,569 @@
 #include "esp_efuse.h"
 #endif
 
-#ifdef CONFIG_MEDIA_LIB_MEM_AUTO_TRACE
-#define ENABLE_AUDIO_MEM_TRACE
-#define MALLOC_RAM_FLAG 1
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "AUDIO_MEM";
+
+#define AUDIO_MEM_ALIGN             (8)
+#define AUDIO_MEM_ALIGN_UP(x)       (((x) + AUDIO_MEM_ALIGN - 1) & ~((size_t)AUDIO_MEM_ALIGN - 1))
+#define AUDIO_MEM_POOL_MAX          (8)
+#define AUDIO_MEM_ARENA_TASK_MAX    (16)
+#define AUDIO_MEM_ARENA_RANGE_MIN   (16)
+
+typedef struct {
+    char                *base;
+    char                *end;
+    size_t              block_size;
+    void                *free_list;
+    int                 used;
+} audio_mem_pool_t;
+
+/* Blocks of a chunk are carved from the bottom and linked backwards from `top`,
+   so freeing the topmost blocks in any order moves the bump pointer back down */
+typedef struct arena_chunk {
+    struct arena_chunk  *next;
+    size_t              size;
+    size_t              used;
+    size_t              live_bytes;
+    int                 live;
+    uint32_t            top;
+} arena_chunk_t;
+
+typedef struct arena_large {
+    struct arena_large  *next;
+    struct arena_large  *prev;
+    size_t              size;
+} arena_large_t;
+
+typedef struct {
+    uint32_t            size;
+    uint32_t            prev;
+    uint32_t            offset;     /* Offset of the header in its chunk */
+    uint8_t             large;
+    uint8_t             freed;
+} arena_hdr_t;
+
+/* Address range of an arena chunk or large block */
+typedef struct {
+    char                    *base;
+    char                    *end;
+    struct audio_mem_arena  *arena;
+} arena_range_t;
+
+#define ARENA_NO_BLOCK              (UINT32_MAX)
+
+#define ARENA_CHUNK_HDR             AUDIO_MEM_ALIGN_UP(sizeof(arena_chunk_t))
+#define ARENA_LARGE_HDR             AUDIO_MEM_ALIGN_UP(sizeof(arena_large_t))
+#define ARENA_HDR                   AUDIO_MEM_ALIGN_UP(sizeof(arena_hdr_t))
+#define ARENA_CHUNK_DATA(c)         ((char *)(c) + ARENA_CHUNK_HDR)
+
+struct audio_mem_arena {
+    struct audio_mem_arena  *next;
+    SemaphoreHandle_t       lock;       /* Guards chunks, large blocks and stats of the arena */
+    const char              *name;
+    size_t                  chunk_size;
+    size_t                  budget;
+    audio_mem_place_t       place;
+    arena_chunk_t           *chunks;
+    arena_large_t           *larges;
+    audio_mem_arena_stats_t stats;
+};
+
+typedef struct {
+    TaskHandle_t            task;
+    audio_mem_arena_handle_t arena;
+} arena_binding_t;
+
+static void *_heap_malloc(size_t size, audio_mem_place_t place, void *ctx);
+static void *_heap_realloc(void *ptr, size_t size, audio_mem_place_t place, void *ctx);
+static void _heap_free(void *ptr, void *ctx);
+static size_t _heap_get_size(void *ptr, void *ctx);
+
+static const audio_mem_allocator_t s_heap_allocator = {
+    .malloc = _heap_malloc,
+    .realloc = _heap_realloc,
+    .free = _heap_free,
+    .get_size = _heap_get_size,
+};
+
+static audio_mem_allocator_t s_allocator = {
+    .malloc = _heap_malloc,
+    .realloc = _heap_realloc,
+    .free = _heap_free,
+    .get_size = _heap_get_size,
+};
+
+/* Short lock for pool free lists, task bindings, the arena list and the arena ranges.
+   Blocks of the heap only take it to look up the ranges while arenas hold memory. Counters are updated atomically */
+static portMUX_TYPE s_mem_lock = portMUX_INITIALIZER_UNLOCKED;
+static audio_mem_stats_t s_stats;
+static audio_mem_pool_t s_pools[AUDIO_MEM_POOL_MAX];
+static volatile int s_pool_num;
+static audio_mem_place_t s_pool_place;
+static struct audio_mem_arena *s_arenas;
+static volatile int s_arena_num;
+static arena_range_t *s_ranges;     /* Sorted by base */
+static volatile int s_range_num;
+static int s_range_cap;
+static arena_binding_t s_bindings[AUDIO_MEM_ARENA_TASK_MAX];
+static volatile int s_binding_num;
+
+#define MEM_LOCK()      portENTER_CRITICAL(&s_mem_lock)
+#define MEM_UNLOCK()    portEXIT_CRITICAL(&s_mem_lock)
+
+static uint32_t _place_caps(audio_mem_place_t place)
+{
+    switch (place) {
+        case AUDIO_MEM_PLACE_INTERNAL:
+            return MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+        case AUDIO_MEM_PLACE_DMA:
+            return MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+        case AUDIO_MEM_PLACE_SPIRAM:
+        case AUDIO_MEM_PLACE_DEFAULT:
+        default:
+#if CONFIG_SPIRAM_BOOT_INIT
+            return MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+#else
+            return MALLOC_CAP_8BIT;
 #endif
-/**
- * @brief Memory trace function is replaced by mem_trace module in `media_lib_sal`
- *        Users need follow below steps to let trace function work
- *        1. After app start `#include "media_lib_adapter.h"` and call `media_lib_add_default_adapter();`
- *        2. Automatically enable memory trace function from menuconfig
- *             `ADF Library Configuration --> Support trace memory automatically`
- *           Or call `media_lib_start_mem_trace` manually
- *        3. Call `media_lib_stop_mem_trace` to stop trace and see trace results
- * 
- *        Use weak realization of trace function so that can work without `media_lib_sal`
- */
-#ifdef ENABLE_AUDIO_MEM_TRACE
-int __attribute__((weak)) media_lib_add_trace_mem(const char *module, void *addr, int size, uint8_t flag)
+    }
+}
+
+static void *_heap_malloc(size_t size, audio_mem_place_t place, void *ctx)
 {
-    return 0;
+#if !CONFIG_SPIRAM_BOOT_INIT
+    if (place == AUDIO_MEM_PLACE_DEFAULT || place == AUDIO_MEM_PLACE_SPIRAM) {
+        return malloc(size);
+    }
+#endif
+    return heap_caps_malloc(size, _place_caps(place));
 }
 
-void __attribute__((weak)) media_lib_remove_trace_mem(void *addr)
+static void *_heap_realloc(void *ptr, size_t size, audio_mem_place_t place, void *ctx)
 {
+    return heap_caps_realloc(ptr, size, _place_caps(place));
 }
-#endif
 
-void *audio_malloc(size_t size)
+static void _heap_free(void *ptr, void *ctx)
 {
-    void *data =  NULL;
-#if CONFIG_SPIRAM_BOOT_INIT
-    data = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    free(ptr);
+}
+
+static size_t _heap_get_size(void *ptr, void *ctx)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    return heap_caps_get_allocated_size(ptr);
 #else
-    data = malloc(size);
-#endif
-#ifdef ENABLE_AUDIO_MEM_TRACE
-    media_lib_add_trace_mem(NULL, data, size, 0);
+    return 0;
 #endif
+}
+
+static inline size_t _backend_size(void *ptr)
+{
+    return s_allocator.get_size ? s_allocator.get_size(ptr, s_allocator.ctx) : 0;
+}
+
+static inline void _stats_add(size_t size)
+{
+    __atomic_fetch_add(&s_stats.alloc_count, 1, __ATOMIC_RELAXED);
+    size_t in_use = __atomic_add_fetch(&s_stats.in_use, size, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&s_stats.peak, __ATOMIC_RELAXED);
+    while (in_use > peak
+           && __atomic_compare_exchange_n(&s_stats.peak, &peak, in_use, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) == false) {
+    }
+}
+
+static inline void _stats_sub(size_t size)
+{
+    __atomic_fetch_add(&s_stats.free_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&s_stats.in_use, size, __ATOMIC_RELAXED);
+}
+
+static void _account_alloc(void *ptr)
+{
+    if (ptr) {
+        _stats_add(_backend_size(ptr));
+    }
+}
+
+static audio_mem_arena_handle_t _current_arena(void)
+{
+    if (s_binding_num == 0) {
+        return NULL;
+    }
+    audio_mem_arena_handle_t arena = NULL;
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    MEM_LOCK();
+    for (int i = 0; i < s_binding_num; i++) {
+        if (s_bindings[i].task == task) {
+            arena = s_bindings[i].arena;
+            break;
+        }
+    }
+    MEM_UNLOCK();
+    return arena;
+}
+
+static void *_pool_alloc(size_t size, audio_mem_place_t place)
+{
+    if (s_pool_num == 0 || size == 0 || (place != AUDIO_MEM_PLACE_DEFAULT && place != s_pool_place)
+        || size > s_pools[s_pool_num - 1].block_size) {
+        return NULL;
+    }
+    void *block = NULL;
+    MEM_LOCK();
+    for (int i = 0; i < s_pool_num; i++) {
+        audio_mem_pool_t *pool = &s_pools[i];
+        if (size > pool->block_size || pool->free_list == NULL) {
+            continue;
+        }
+        block = pool->free_list;
+        pool->free_list = *(void **)block;
+        pool->used++;
+        s_stats.pool_hits++;
+        _stats_add(pool->block_size);
+        break;
+    }
+    if (block == NULL) {
+        s_stats.pool_misses++;
+    }
+    MEM_UNLOCK();
+    return block;
+}
+
+/* Pools are only set up or torn down while none of their blocks is in use, so no lock is needed to look them up */
+static audio_mem_pool_t *_pool_find(void *ptr)
+{
+    for (int i = 0; i < s_pool_num; i++) {
+        if ((char *)ptr >= s_pools[i].base && (char *)ptr < s_pools[i].end) {
+            return &s_pools[i];
+        }
+    }
+    return NULL;
+}
+
+/* Called with `s_mem_lock` held, index of the first range starting above `ptr` */
+static int _range_upper(const char *ptr)
+{
+    int lo = 0;
+    int hi = s_range_num;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (s_ranges[mid].base <= ptr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Called with the arena locked, the table is grown outside of the spinlock and swapped in */
+static bool _range_add(struct audio_mem_arena *arena, void *base, size_t size)
+{
+    while (1) {
+        MEM_LOCK();
+        if (s_range_num < s_range_cap) {
+            int i = _range_upper(base);
+            memmove(&s_ranges[i + 1], &s_ranges[i], (s_range_num - i) * sizeof(arena_range_t));
+            s_ranges[i].base = base;
+            s_ranges[i].end = (char *)base + size;
+            s_ranges[i].arena = arena;
+            s_range_num++;
+            MEM_UNLOCK();
+            return true;
+        }
+        int cap = s_range_cap ? s_range_cap * 2 : AUDIO_MEM_ARENA_RANGE_MIN;
+        MEM_UNLOCK();
+        arena_range_t *ranges = s_allocator.malloc(cap * sizeof(arena_range_t), AUDIO_MEM_PLACE_DEFAULT, s_allocator.ctx);
+        if (ranges == NULL) {
+            return false;
+        }
+        MEM_LOCK();
+        if (s_range_cap < cap) {
+            if (s_range_num) {
+                memcpy(ranges, s_ranges, s_range_num * sizeof(arena_range_t));
+            }
+            arena_range_t *old = s_ranges;
+            s_ranges = ranges;
+            s_range_cap = cap;
+            ranges = old;
+        }
+        MEM_UNLOCK();
+        if (ranges) {
+            s_allocator.free(ranges, s_allocator.ctx);
+        }
+    }
+}
+
+static void _range_remove(void *base)
+{
+    MEM_LOCK();
+    int i = _range_upper(base) - 1;
+    if (i >= 0 && s_ranges[i].base == base) {
+        memmove(&s_ranges[i], &s_ranges[i + 1], (s_range_num - i - 1) * sizeof(arena_range_t));
+        s_range_num--;
+    }
+    MEM_UNLOCK();
+}
+
+/* Owner of a block by address, no memory outside the ranges is read, so blocks of any origin may be passed */
+static struct audio_mem_arena *_arena_owner(void *ptr)
+{
+    if (s_range_num == 0) {
+        return NULL;
+    }
+    struct audio_mem_arena *owner = NULL;
+    MEM_LOCK();
+    int i = _range_upper(ptr) - 1;
+    if (i >= 0 && (char *)ptr >= s_ranges[i].base + ARENA_HDR && (char *)ptr < s_ranges[i].end) {
+        owner = s_ranges[i].arena;
+    }
+    MEM_UNLOCK();
+    return owner;
+}
+
+static inline void _arena_stats_add(struct audio_mem_arena *arena, size_t size)
+{
+    arena->stats.alloc_count++;
+    arena->stats.in_use += size;
+    if (arena->stats.in_use > arena->stats.peak) {
+        arena->stats.peak = arena->stats.in_use;
+    }
+    _stats_add(size);
+}
+
+/* Called with the arena locked, account `size` bytes taken from the allocator, fails when it would exceed the budget */
+static bool _arena_reserve(struct audio_mem_arena *arena, size_t size)
+{
+    if (arena->budget && arena->stats.reserved + size > arena->budget) {
+        ESP_LOGE(TAG, "Arena %s over budget, reserved:%d, request:%d, budget:%d", arena->name,
+                 (int)arena->stats.reserved, (int)size, (int)arena->budget);
+        return false;
+    }
+    arena->stats.reserved += size;
+    if (arena->stats.reserved > arena->stats.peak_reserved) {
+        arena->stats.peak_reserved = arena->stats.reserved;
+    }
+    return true;
+}
+
+static arena_hdr_t *_arena_hdr_init(struct audio_mem_arena *arena, arena_hdr_t *hdr, size_t size)
+{
+    hdr->size = size;
+    hdr->freed = 0;
+    _arena_stats_add(arena, size);
+    return hdr;
+}
+
+/* Called with the arena locked */
+static void *_arena_alloc_locked(struct audio_mem_arena *arena, size_t size)
+{
+    size_t need = ARENA_HDR + AUDIO_MEM_ALIGN_UP(size);
+    arena_hdr_t *hdr = NULL;
+    if (need > arena->chunk_size / 2) {
+        if (_arena_reserve(arena, ARENA_LARGE_HDR + need) == false) {
+            return NULL;
+        }
+        arena_large_t *large = s_allocator.malloc(ARENA_LARGE_HDR + need, arena->place, s_allocator.ctx);
+        if (large && _range_add(arena, large, ARENA_LARGE_HDR + need) == false) {
+            s_allocator.free(large, s_allocator.ctx);
+            large = NULL;
+        }
+        if (large == NULL) {
+            arena->stats.reserved -= ARENA_LARGE_HDR + need;
+            return NULL;
+        }
+        large->size = ARENA_LARGE_HDR + need;
+        large->prev = NULL;
+        large->next = arena->larges;
+        if (arena->larges) {
+            arena->larges->prev = large;
+        }
+        arena->larges = large;
+        arena->stats.large_num++;
+        hdr = (arena_hdr_t *)((char *)large + ARENA_LARGE_HDR);
+        hdr->prev = ARENA_NO_BLOCK;
+        hdr->offset = 0;
+        hdr->large = 1;
+        return (char *)_arena_hdr_init(arena, hdr, size) + ARENA_HDR;
+    }
+    arena_chunk_t *chunk = NULL;
+    for (chunk = arena->chunks; chunk; chunk = chunk->next) {
+        if (chunk->size - chunk->used >= need) {
+            break;
+        }
+    }
+    if (chunk == NULL) {
+        if (_arena_reserve(arena, ARENA_CHUNK_HDR + arena->chunk_size) == false) {
+            return NULL;
+        }
+        chunk = s_allocator.malloc(ARENA_CHUNK_HDR + arena->chunk_size, arena->place, s_allocator.ctx);
+        if (chunk && _range_add(arena, chunk, ARENA_CHUNK_HDR + arena->chunk_size) == false) {
+            s_allocator.free(chunk, s_allocator.ctx);
+            chunk = NULL;
+        }
+        if (chunk == NULL) {
+            arena->stats.reserved -= ARENA_CHUNK_HDR + arena->chunk_size;
+            return NULL;
+        }
+        chunk->size = arena->chunk_size;
+        chunk->used = 0;
+        chunk->live_bytes = 0;
+        chunk->live = 0;
+        chunk->top = ARENA_NO_BLOCK;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->stats.chunk_num++;
+    }
+    hdr = (arena_hdr_t *)(ARENA_CHUNK_DATA(chunk) + chunk->used);
+    hdr->prev = chunk->top;
+    hdr->offset = chunk->used;
+    hdr->large = 0;
+    chunk->top = chunk->used;
+    chunk->used += need;
+    chunk->live_bytes += need;
+    chunk->live++;
+    return (char *)_arena_hdr_init(arena, hdr, size) + ARENA_HDR;
+}
+
+static void *_arena_alloc(struct audio_mem_arena *arena, size_t size)
+{
+    xSemaphoreTake(arena->lock, portMAX_DELAY);
+    void *data = _arena_alloc_locked(arena, size);
+    xSemaphoreGive(arena->lock);
+    return data;
+}
+
+/* Called with the arena locked, sets `release` to the block to give back to the allocator, if any */
+static esp_err_t _arena_release(struct audio_mem_arena *arena, void *ptr, void **release)
+{
+    arena_hdr_t *hdr = (arena_hdr_t *)((char *)ptr - ARENA_HDR);
+    if (hdr->freed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    hdr->freed = 1;
+    arena->stats.free_count++;
+    arena->stats.in_use -= hdr->size;
+    _stats_sub(hdr->size);
+    if (hdr->large) {
+        arena_large_t *large = (arena_large_t *)((char *)hdr - ARENA_LARGE_HDR);
+        if (large->prev) {
+            large->prev->next = large->next;
+        } else {
+            arena->larges = large->next;
+        }
+        if (large->next) {
+            large->next->prev = large->prev;
+        }
+        arena->stats.large_num--;
+        arena->stats.reserved -= large->size;
+        _range_remove(large);
+        *release = large;
+        return ESP_OK;
+    }
+    arena_chunk_t *chunk = (arena_chunk_t *)((char *)hdr - hdr->offset - ARENA_CHUNK_HDR);
+    chunk->live--;
+    chunk->live_bytes -= ARENA_HDR + AUDIO_MEM_ALIGN_UP(hdr->size);
+    if (chunk->live == 0) {
+        chunk->used = 0;
+        chunk->top = ARENA_NO_BLOCK;
+        return ESP_OK;
+    }
+    while (chunk->top != ARENA_NO_BLOCK) {
+        arena_hdr_t *top = (arena_hdr_t *)(ARENA_CHUNK_DATA(chunk) + chunk->top);
+        if (top->freed == 0) {
+            break;
+        }
+        chunk->used = chunk->top;
+        chunk->top = top->prev;
+    }
+    return ESP_OK;
+}
+
+static void *_mem_alloc(size_t size, audio_mem_place_t place)
+{
+    audio_mem_arena_handle_t arena = _current_arena();
+    if (arena && (place == AUDIO_MEM_PLACE_DEFAULT || place == arena->place)) {
+        return _arena_alloc(arena, size);
+    }
+    void *data = _pool_alloc(size, place);
+    if (data) {
+        return data;
+    }
+    data = s_allocator.malloc(size, place, s_allocator.ctx);
+    _account_alloc(data);
+    return data;
+}
+
+static void _mem_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    audio_mem_pool_t *pool = _pool_find(ptr);
+    if (pool) {
+        MEM_LOCK();
+        *(void **)ptr = pool->free_list;
+        pool->free_list = ptr;
+        pool->used--;
+        MEM_UNLOCK();
+        _stats_sub(pool->block_size);
+        return;
+    }
+    struct audio_mem_arena *arena = _arena_owner(ptr);
+    if (arena) {
+        void *release = NULL;
+        xSemaphoreTake(arena->lock, portMAX_DELAY);
+        esp_err_t ret = _arena_release(arena, ptr, &release);
+        xSemaphoreGive(arena->lock);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Arena %s, double freed block %p", arena->name, ptr);
+        }
+        if (release) {
+            s_allocator.free(release, s_allocator.ctx);
+        }
+        return;
+    }
+    _stats_sub(_backend_size(ptr));
+    s_allocator.free(ptr, s_allocator.ctx);
+}
+
+/* Size of a pool or arena block, 0 for blocks of the allocator */
+static size_t _mem_managed_size(void *ptr)
+{
+    audio_mem_pool_t *pool = _pool_find(ptr);
+    if (pool) {
+        return pool->block_size;
+    }
+    if (_arena_owner(ptr)) {
+        return ((arena_hdr_t *)((char *)ptr - ARENA_HDR))->size;
+    }
+    return 0;
+}
+
+void *audio_malloc(size_t size)
+{
+    return _mem_alloc(size, AUDIO_MEM_PLACE_DEFAULT);
+}
+
+void *audio_malloc_place(size_t size, audio_mem_place_t place)
+{
+    return _mem_alloc(size, place);
+}
+
+void *audio_calloc_place(size_t nmemb, size_t size, audio_mem_place_t place)
+{
+    if (size && nmemb > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *data = _mem_alloc(nmemb * size, place);
+    if (data) {
+        memset(data, 0, nmemb * size);
+    }
     return data;
 }
 
@@ -84,68 +611,49 @@ void *audio_malloc_align(size_t alignment, size_t size)
 #else
     data = heap_caps_aligned_alloc(alignment, size, MALLOC_CAP_DEFAULT);
 #endif
-#ifdef ENABLE_AUDIO_MEM_TRACE
-    media_lib_add_trace_mem(NULL, data, size, 0);
-#endif
+    _account_alloc(data);
     return data;
 }
 
 void audio_free(void *ptr)
 {
-#ifdef ENABLE_AUDIO_MEM_TRACE
-    media_lib_remove_trace_mem(ptr);
-#endif
-    free(ptr);
+    _mem_free(ptr);
 }
 
 void *audio_calloc(size_t nmemb, size_t size)
 {
-    void *data =  NULL;
-#if CONFIG_SPIRAM_BOOT_INIT
-    data = heap_caps_malloc(nmemb * size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (data) {
-        memset(data, 0, nmemb * size);
-    }
-#else
-    data = calloc(nmemb, size);
-#endif
-#ifdef ENABLE_AUDIO_MEM_TRACE
-    media_lib_add_trace_mem(NULL, data, nmemb*size, 0);
-#endif
-    return data;
+    return audio_calloc_place(nmemb, size, AUDIO_MEM_PLACE_DEFAULT);
 }
 
 void *audio_realloc(void *ptr, size_t size)
 {
-    void *p = NULL;
-#ifdef ENABLE_AUDIO_MEM_TRACE
-    media_lib_remove_trace_mem(ptr);
-#endif
-
-#if CONFIG_SPIRAM_BOOT_INIT
-    p = heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-#else
-    p = heap_caps_realloc(ptr, size, MALLOC_CAP_8BIT);
-#endif
-#ifdef ENABLE_AUDIO_MEM_TRACE
-    media_lib_add_trace_mem(NULL, p, size, 0);
-#endif
+    if (ptr == NULL) {
+        return _mem_alloc(size, AUDIO_MEM_PLACE_DEFAULT);
+    }
+    size_t old_size = _mem_managed_size(ptr);
+    if (old_size) {
+        void *p = _mem_alloc(size, AUDIO_MEM_PLACE_DEFAULT);
+        if (p) {
+            memcpy(p, ptr, old_size < size ? old_size : size);
+            _mem_free(ptr);
+        }
+        return p;
+    }
+    old_size = _backend_size(ptr);
+    void *p = s_allocator.realloc(ptr, size, AUDIO_MEM_PLACE_DEFAULT, s_allocator.ctx);
+    if (p) {
+        __atomic_fetch_sub(&s_stats.in_use, old_size, __ATOMIC_RELAXED);
+        _stats_add(_backend_size(p));
+    }
     return p;
 }
 
 char *audio_strdup(const char *str)
 {
     int size = strlen(str) + 1;
-#if CONFIG_SPIRAM_BOOT_INIT
-    char *copy = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-#else
-    char *copy = malloc(size);
-#endif
+    char *copy = _mem_alloc(size, AUDIO_MEM_PLACE_DEFAULT);
     if (copy) {
-        strcpy(copy, str);
-#ifdef ENABLE_AUDIO_MEM_TRACE
-        media_lib_add_trace_mem(NULL, copy, size, 0);
-#endif
+        memcpy(copy, str, size);
     }
     return copy;
 }
@@ -158,12 +666,249 @@ void *audio_calloc_inner(size_t n, size_t size)
 #else
     data = heap_caps_calloc(n, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
 #endif
-#ifdef ENABLE_AUDIO_MEM_TRACE
-    media_lib_add_trace_mem(NULL, data, n*size, MALLOC_RAM_FLAG);
-#endif
+    _account_alloc(data);
     return data;
 }
 
+esp_err_t audio_mem_set_allocator(const audio_mem_allocator_t *allocator)
+{
+    if (allocator == NULL) {
+        s_allocator = s_heap_allocator;
+        return ESP_OK;
+    }
+    if (allocator->malloc == NULL || allocator->realloc == NULL || allocator->free == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_allocator = *allocator;
+    return ESP_OK;
+}
+
+esp_err_t audio_mem_pool_init(const audio_mem_pool_cfg_t *pools, int num, audio_mem_place_t place)
+{
+    if (pools == NULL || num <= 0 || num > AUDIO_MEM_POOL_MAX || place >= AUDIO_MEM_PLACE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_pool_num) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    audio_mem_pool_t created[AUDIO_MEM_POOL_MAX] = { 0 };
+    esp_err_t ret = ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < num; i++) {
+        size_t block_size = AUDIO_MEM_ALIGN_UP((size_t)pools[i].block_size);
+        if (block_size == 0 || pools[i].block_num <= 0
+            || (i > 0 && block_size <= created[i - 1].block_size)) {
+            ESP_LOGE(TAG, "Invalid pool %d, size:%d, num:%d", i, pools[i].block_size, pools[i].block_num);
+            goto _pool_failed;
+        }
+        created[i].block_size = block_size;
+        created[i].base = s_allocator.malloc(block_size * pools[i].block_num, place, s_allocator.ctx);
+        if (created[i].base == NULL) {
+            ESP_LOGE(TAG, "No memory for pool of %d blocks of %d bytes", pools[i].block_num, (int)block_size);
+            ret = ESP_ERR_NO_MEM;
+            goto _pool_failed;
+        }
+        created[i].end = created[i].base + block_size * pools[i].block_num;
+        for (char *block = created[i].end - block_size; block >= created[i].base; block -= block_size) {
+            *(void **)block = created[i].free_list;
+            created[i].free_list = block;
+        }
+    }
+    MEM_LOCK();
+    memcpy(s_pools, created, sizeof(created));
+    s_pool_place = place;
+    s_pool_num = num;
+    MEM_UNLOCK();
+    return ESP_OK;
+
+_pool_failed:
+    for (int i = 0; i < num; i++) {
+        if (created[i].base) {
+            s_allocator.free(created[i].base, s_allocator.ctx);
+        }
+    }
+    return ret;
+}
+
+esp_err_t audio_mem_pool_deinit(void)
+{
+    audio_mem_pool_t pools[AUDIO_MEM_POOL_MAX];
+    int num = 0;
+    MEM_LOCK();
+    for (int i = 0; i < s_pool_num; i++) {
+        if (s_pools[i].used) {
+            MEM_UNLOCK();
+            ESP_LOGE(TAG, "Pool of %d bytes still has %d blocks in use", (int)s_pools[i].block_size, s_pools[i].used);
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    num = s_pool_num;
+    memcpy(pools, s_pools, sizeof(pools));
+    memset(s_pools, 0, sizeof(s_pools));
+    s_pool_num = 0;
+    MEM_UNLOCK();
+    for (int i = 0; i < num; i++) {
+        s_allocator.free(pools[i].base, s_allocator.ctx);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_mem_get_stats(audio_mem_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    stats->alloc_count = __atomic_load_n(&s_stats.alloc_count, __ATOMIC_RELAXED);
+    stats->free_count = __atomic_load_n(&s_stats.free_count, __ATOMIC_RELAXED);
+    stats->in_use = __atomic_load_n(&s_stats.in_use, __ATOMIC_RELAXED);
+    stats->peak = __atomic_load_n(&s_stats.peak, __ATOMIC_RELAXED);
+    MEM_LOCK();
+    stats->pool_hits = s_stats.pool_hits;
+    stats->pool_misses = s_stats.pool_misses;
+    MEM_UNLOCK();
+    return ESP_OK;
+}
+
+audio_mem_arena_handle_t audio_mem_arena_create(const audio_mem_arena_cfg_t *config)
+{
+    if (config == NULL || config->chunk_size <= (int)(ARENA_HDR * 2) || config->place >= AUDIO_MEM_PLACE_MAX) {
+        ESP_LOGE(TAG, "Invalid arena configuration");
+        return NULL;
+    }
+    struct audio_mem_arena *arena = s_allocator.malloc(sizeof(struct audio_mem_arena), AUDIO_MEM_PLACE_DEFAULT, s_allocator.ctx);
+    if (arena == NULL) {
+        return NULL;
+    }
+    memset(arena, 0, sizeof(struct audio_mem_arena));
+    arena->lock = xSemaphoreCreateMutex();
+    if (arena->lock == NULL) {
+        s_allocator.free(arena, s_allocator.ctx);
+        return NULL;
+    }
+    arena->name = config->name ? config->name : "arena";
+    arena->chunk_size = AUDIO_MEM_ALIGN_UP((size_t)config->chunk_size);
+    arena->budget = config->budget > 0 ? config->budget : 0;
+    arena->place = config->place;
+    MEM_LOCK();
+    arena->next = s_arenas;
+    s_arenas = arena;
+    s_arena_num++;
+    MEM_UNLOCK();
+    return arena;
+}
+
+audio_mem_arena_handle_t audio_mem_arena_enter(audio_mem_arena_handle_t arena)
+{
+    audio_mem_arena_handle_t prev = NULL;
+    bool full = false;
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    MEM_LOCK();
+    int i = 0;
+    for (; i < s_binding_num; i++) {
+        if (s_bindings[i].task == task) {
+            prev = s_bindings[i].arena;
+            break;
+        }
+    }
+    if (arena == NULL) {
+        if (i < s_binding_num) {
+            s_bindings[i] = s_bindings[--s_binding_num];
+        }
+    } else if (i < s_binding_num) {
+        s_bindings[i].arena = arena;
+    } else if (s_binding_num < AUDIO_MEM_ARENA_TASK_MAX) {
+        s_bindings[s_binding_num].task = task;
+        s_bindings[s_binding_num].arena = arena;
+        s_binding_num++;
+    } else {
+        full = true;
+    }
+    MEM_UNLOCK();
+    if (full) {
+        ESP_LOGW(TAG, "Too many tasks in arenas, allocating from heap");
+    }
+    return prev;
+}
+
+void audio_mem_arena_exit(audio_mem_arena_handle_t prev)
+{
+    audio_mem_arena_enter(prev);
+}
+
+esp_err_t audio_mem_arena_get_stats(audio_mem_arena_handle_t arena, audio_mem_arena_stats_t *stats)
+{
+    if (arena == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t chunk_total = 0;
+    size_t chunk_hole = 0;
+    xSemaphoreTake(arena->lock, portMAX_DELAY);
+    *stats = arena->stats;
+    for (arena_chunk_t *c = arena->chunks; c; c = c->next) {
+        chunk_total += c->size;
+        chunk_hole += c->used - c->live_bytes;
+    }
+    xSemaphoreGive(arena->lock);
+    stats->fragmentation = chunk_total ? (int)(chunk_hole * 100 / chunk_total) : 0;
+    return ESP_OK;
+}
+
+esp_err_t audio_mem_arena_destroy(audio_mem_arena_handle_t arena)
+{
+    if (arena == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    MEM_LOCK();
+    for (struct audio_mem_arena **pp = &s_arenas; *pp; pp = &(*pp)->next) {
+        if (*pp == arena) {
+            *pp = arena->next;
+            s_arena_num--;
+            break;
+        }
+    }
+    for (int i = s_binding_num - 1; i >= 0; i--) {
+        if (s_bindings[i].arena == arena) {
+            s_bindings[i] = s_bindings[--s_binding_num];
+        }
+    }
+    int kept = 0;
+    for (int i = 0; i < s_range_num; i++) {
+        if (s_ranges[i].arena != arena) {
+            s_ranges[kept++] = s_ranges[i];
+        }
+    }
+    s_range_num = kept;
+    arena_range_t *ranges = NULL;
+    if (s_arena_num == 0) {
+        ranges = s_ranges;
+        s_ranges = NULL;
+        s_range_cap = 0;
+    }
+    MEM_UNLOCK();
+    if (ranges) {
+        s_allocator.free(ranges, s_allocator.ctx);
+    }
+    uint32_t leaked = arena->stats.alloc_count - arena->stats.free_count;
+    __atomic_fetch_add(&s_stats.free_count, leaked, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&s_stats.in_use, arena->stats.in_use, __ATOMIC_RELAXED);
+    if (leaked) {
+        ESP_LOGW(TAG, "Arena %s released %d blocks, %d bytes still allocated", arena->name, (int)leaked, (int)arena->stats.in_use);
+    }
+    ESP_LOGD(TAG, "Arena %s destroyed, peak:%d, peak reserved:%d", arena->name, (int)arena->stats.peak, (int)arena->stats.peak_reserved);
+    while (arena->chunks) {
+        arena_chunk_t *c = arena->chunks;
+        arena->chunks = c->next;
+        s_allocator.free(c, s_allocator.ctx);
+    }
+    while (arena->larges) {
+        arena_large_t *l = arena->larges;
+        arena->larges = l->next;
+        s_allocator.free(l, s_allocator.ctx);
+    }
+    vSemaphoreDelete(arena->lock);
+    s_allocator.free(arena, s_allocator.ctx);
+    return ESP_OK;
+}
+
 void audio_mem_print(const char *tag, int line, const char *func)
 {
 #ifdef CONFIG_SPIRAM_BOOT_INIT
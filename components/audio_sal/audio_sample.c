@@ -0,0 +1,278 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "esp_log.h"
+#include "audio_error.h"
+#include "audio_sample.h"
+
+static const char *TAG = "AUDIO_SAMPLE";
+
+/*
+ * Two 16 bit samples are handled as one 32 bit word where the layout allows it, that halves the
+ * loads and stores on cores without SIMD and gives the compiler a plain loop to vectorise where
+ * there is. The first sample of a pair is the low half on little endian targets only.
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define SAMPLE_PAIR_ENABLE  (1)
+#else
+#define SAMPLE_PAIR_ENABLE  (0)
+#endif
+
+#define IS_WORD_ALIGNED(p)  ((((uintptr_t)(p)) & 3) == 0)
+
+static inline int16_t _sat16(int32_t v)
+{
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+esp_err_t audio_sample_interleave_16(const int16_t *const src[], int channels, int frames, int16_t *dst)
+{
+    AUDIO_CHECK(TAG, src && dst && frames >= 0, return ESP_ERR_INVALID_ARG, "Invalid argument");
+    AUDIO_CHECK(TAG, channels > 0 && channels <= AUDIO_SAMPLE_MAX_CHANNELS, return ESP_ERR_INVALID_ARG, "Invalid channels");
+    if (channels == 1) {
+        memcpy(dst, src[0], frames * sizeof(int16_t));
+        return ESP_OK;
+    }
+    if (channels == 2) {
+        const int16_t *l = src[0];
+        const int16_t *r = src[1];
+        if (SAMPLE_PAIR_ENABLE && IS_WORD_ALIGNED(dst)) {
+            uint32_t *w = (uint32_t *)dst;
+            for (int i = 0; i < frames; i++) {
+                w[i] = (uint16_t)l[i] | ((uint32_t)(uint16_t)r[i] << 16);
+            }
+        } else {
+            for (int i = 0; i < frames; i++) {
+                dst[2 * i] = l[i];
+                dst[2 * i + 1] = r[i];
+            }
+        }
+        return ESP_OK;
+    }
+    for (int ch = 0; ch < channels; ch++) {
+        const int16_t *s = src[ch];
+        int16_t *d = dst + ch;
+        for (int i = 0; i < frames; i++) {
+            d[i * channels] = s[i];
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_sample_deinterleave_16(const int16_t *src, int channels, int frames, int16_t *const dst[])
+{
+    AUDIO_CHECK(TAG, src && dst && frames >= 0, return ESP_ERR_INVALID_ARG, "Invalid argument");
+    AUDIO_CHECK(TAG, channels > 0 && channels <= AUDIO_SAMPLE_MAX_CHANNELS, return ESP_ERR_INVALID_ARG, "Invalid channels");
+    if (channels == 1) {
+        memcpy(dst[0], src, frames * sizeof(int16_t));
+        return ESP_OK;
+    }
+    if (channels == 2) {
+        int16_t *l = dst[0];
+        int16_t *r = dst[1];
+        if (SAMPLE_PAIR_ENABLE && IS_WORD_ALIGNED(src)) {
+            const uint32_t *w = (const uint32_t *)src;
+            for (int i = 0; i < frames; i++) {
+                uint32_t v = w[i];
+                l[i] = (int16_t)v;
+                r[i] = (int16_t)(v >> 16);
+            }
+        } else {
+            for (int i = 0; i < frames; i++) {
+                l[i] = src[2 * i];
+                r[i] = src[2 * i + 1];
+            }
+        }
+        return ESP_OK;
+    }
+    for (int ch = 0; ch < channels; ch++) {
+        const int16_t *s = src + ch;
+        int16_t *d = dst[ch];
+        for (int i = 0; i < frames; i++) {
+            d[i] = s[i * channels];
+        }
+    }
+    return ESP_OK;
+}
+
+void audio_sample_swap_stereo_16(int16_t *buf, int frames)
+{
+    if (buf == NULL || frames <= 0) {
+        return;
+    }
+    if (SAMPLE_PAIR_ENABLE && IS_WORD_ALIGNED(buf)) {
+        uint32_t *w = (uint32_t *)buf;
+        int i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            uint32_t a = w[i], b = w[i + 1], c = w[i + 2], d = w[i + 3];
+            w[i] = (a << 16) | (a >> 16);
+            w[i + 1] = (b << 16) | (b >> 16);
+            w[i + 2] = (c << 16) | (c >> 16);
+            w[i + 3] = (d << 16) | (d >> 16);
+        }
+        for (; i < frames; i++) {
+            w[i] = (w[i] << 16) | (w[i] >> 16);
+        }
+        return;
+    }
+    for (int i = 0; i < frames; i++) {
+        int16_t tmp = buf[2 * i];
+        buf[2 * i] = buf[2 * i + 1];
+        buf[2 * i + 1] = tmp;
+    }
+}
+
+esp_err_t audio_sample_reorder_16(const int16_t *src, int src_ch, int16_t *dst, const int8_t *map, int dst_ch, int frames)
+{
+    AUDIO_CHECK(TAG, src && dst && map && frames >= 0, return ESP_ERR_INVALID_ARG, "Invalid argument");
+    AUDIO_CHECK(TAG, src_ch > 0 && src_ch <= AUDIO_SAMPLE_MAX_CHANNELS
+                && dst_ch > 0 && dst_ch <= AUDIO_SAMPLE_MAX_CHANNELS, return ESP_ERR_INVALID_ARG, "Invalid channels");
+    AUDIO_CHECK(TAG, src != dst || dst_ch <= src_ch, return ESP_ERR_INVALID_ARG, "Can not widen in place");
+    bool identity = (src_ch == dst_ch);
+    for (int ch = 0; ch < dst_ch; ch++) {
+        AUDIO_CHECK(TAG, map[ch] < src_ch, return ESP_ERR_INVALID_ARG, "Invalid channel map");
+        identity &= (map[ch] == ch);
+    }
+    if (identity) {
+        if (src != dst) {
+            memmove(dst, src, frames * src_ch * sizeof(int16_t));
+        }
+        return ESP_OK;
+    }
+    if (src_ch == 2 && dst_ch == 2 && map[0] == 1 && map[1] == 0) {
+        if (src != dst) {
+            memcpy(dst, src, frames * 2 * sizeof(int16_t));
+        }
+        audio_sample_swap_stereo_16(dst, frames);
+        return ESP_OK;
+    }
+    // Each frame is loaded before it is stored, and a narrower output never passes the input
+    int16_t frame[AUDIO_SAMPLE_MAX_CHANNELS + 1];
+    int8_t idx[AUDIO_SAMPLE_MAX_CHANNELS];
+    frame[AUDIO_SAMPLE_MAX_CHANNELS] = 0;
+    for (int ch = 0; ch < dst_ch; ch++) {
+        idx[ch] = map[ch] < 0 ? AUDIO_SAMPLE_MAX_CHANNELS : map[ch];
+    }
+    for (int i = 0; i < frames; i++) {
+        const int16_t *s = src + i * src_ch;
+        int16_t *d = dst + i * dst_ch;
+        for (int ch = 0; ch < src_ch; ch++) {
+            frame[ch] = s[ch];
+        }
+        for (int ch = 0; ch < dst_ch; ch++) {
+            d[ch] = frame[idx[ch]];
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_sample_gain_16(const int16_t *src, int16_t *dst, int channels, const int32_t *gain, int frames)
+{
+    AUDIO_CHECK(TAG, src && dst && gain && frames >= 0, return ESP_ERR_INVALID_ARG, "Invalid argument");
+    AUDIO_CHECK(TAG, channels > 0 && channels <= AUDIO_SAMPLE_MAX_CHANNELS, return ESP_ERR_INVALID_ARG, "Invalid channels");
+    if (channels == 2) {
+        int32_t gl = gain[0];
+        int32_t gr = gain[1];
+        for (int i = 0; i < frames; i++) {
+            int32_t l = src[2 * i];
+            int32_t r = src[2 * i + 1];
+            dst[2 * i] = _sat16((l * gl) >> AUDIO_SAMPLE_GAIN_SHIFT);
+            dst[2 * i + 1] = _sat16((r * gr) >> AUDIO_SAMPLE_GAIN_SHIFT);
+        }
+        return ESP_OK;
+    }
+    for (int i = 0; i < frames; i++) {
+        for (int ch = 0; ch < channels; ch++) {
+            int32_t v = src[i * channels + ch];
+            dst[i * channels + ch] = _sat16((v * gain[ch]) >> AUDIO_SAMPLE_GAIN_SHIFT);
+        }
+    }
+    return ESP_OK;
+}
+
+static inline int32_t _load24(const uint8_t *p)
+{
+    return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24));
+}
+
+static inline void _store24(uint8_t *p, int32_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 24);
+}
+
+esp_err_t audio_sample_convert(const void *src, int src_bits, void *dst, int dst_bits, int samples)
+{
+    AUDIO_CHECK(TAG, src && dst && samples >= 0, return ESP_ERR_INVALID_ARG, "Invalid argument");
+    AUDIO_CHECK(TAG, (src_bits == 16 || src_bits == 24 || src_bits == 32)
+                && (dst_bits == 16 || dst_bits == 24 || dst_bits == 32), return ESP_ERR_INVALID_ARG, "Invalid sample width");
+    if (src_bits == dst_bits) {
+        if (src != dst) {
+            memmove(dst, src, samples * (src_bits >> 3));
+        }
+        return ESP_OK;
+    }
+    const uint8_t *s8 = src;
+    uint8_t *d8 = dst;
+    const int16_t *s16 = src;
+    int16_t *d16 = dst;
+    const int32_t *s32 = src;
+    int32_t *d32 = dst;
+    // Widening walks backwards and narrowing forwards, so the output never overwrites unread input
+    if (src_bits == 16 && dst_bits == 32) {
+        for (int i = samples - 1; i >= 0; i--) {
+            d32[i] = (int32_t)((uint32_t)(uint16_t)s16[i] << 16);
+        }
+    } else if (src_bits == 16 && dst_bits == 24) {
+        for (int i = samples - 1; i >= 0; i--) {
+            _store24(d8 + 3 * i, (int32_t)((uint32_t)(uint16_t)s16[i] << 16));
+        }
+    } else if (src_bits == 24 && dst_bits == 32) {
+        for (int i = samples - 1; i >= 0; i--) {
+            d32[i] = _load24(s8 + 3 * i);
+        }
+    } else if (src_bits == 32 && dst_bits == 16) {
+        for (int i = 0; i < samples; i++) {
+            d16[i] = (int16_t)(s32[i] >> 16);
+        }
+    } else if (src_bits == 32 && dst_bits == 24) {
+        for (int i = 0; i < samples; i++) {
+            _store24(d8 + 3 * i, s32[i]);
+        }
+    } else {
+        for (int i = 0; i < samples; i++) {
+            d16[i] = (int16_t)(_load24(s8 + 3 * i) >> 16);
+        }
+    }
+    return ESP_OK;
+}
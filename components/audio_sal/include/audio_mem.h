@@ -26,11 +26,81 @@
 #define _AUDIO_MEM_H_
 
 #include <esp_types.h>
+#include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief   Placement hint of memory
+ */
+typedef enum {
+    AUDIO_MEM_PLACE_DEFAULT = 0,    /*!< SPI ram if it is enabled, otherwise internal ram, as `audio_malloc` */
+    AUDIO_MEM_PLACE_INTERNAL,       /*!< Internal ram */
+    AUDIO_MEM_PLACE_DMA,            /*!< DMA capable internal ram */
+    AUDIO_MEM_PLACE_SPIRAM,         /*!< SPI ram, internal ram if SPI ram is not enabled */
+    AUDIO_MEM_PLACE_MAX,
+} audio_mem_place_t;
+
+/**
+ * @brief   Backend of ADF memory functions, all pools and arena chunks are also taken from it
+ */
+typedef struct {
+    void   *(*malloc)(size_t size, audio_mem_place_t place, void *ctx);                /*!< Allocate memory */
+    void   *(*realloc)(void *ptr, size_t size, audio_mem_place_t place, void *ctx);    /*!< Resize memory */
+    void    (*free)(void *ptr, void *ctx);                                              /*!< Free memory */
+    size_t  (*get_size)(void *ptr, void *ctx);                                          /*!< Usable size of an allocated block, optional, used for accounting */
+    void    *ctx;                                                                       /*!< User context passed to all functions */
+} audio_mem_allocator_t;
+
+/**
+ * @brief   Size class of fixed size pool
+ */
+typedef struct {
+    int     block_size;     /*!< Size of each block, requests up to this size are served by the pool */
+    int     block_num;      /*!< Number of blocks */
+} audio_mem_pool_cfg_t;
+
+/**
+ * @brief   Counters of ADF memory
+ */
+typedef struct {
+    uint32_t    alloc_count;    /*!< Number of allocations */
+    uint32_t    free_count;     /*!< Number of frees */
+    size_t      in_use;         /*!< Bytes in use, blocks from heap are only counted when the allocator reports their size */
+    size_t      peak;           /*!< Highest `in_use` */
+    uint32_t    pool_hits;      /*!< Allocations served by a pool */
+    uint32_t    pool_misses;    /*!< Allocations that fit a pool size but found it empty */
+} audio_mem_stats_t;
+
+/**
+ * @brief   Configuration of memory arena
+ */
+typedef struct {
+    const char          *name;          /*!< Name for log */
+    int                 chunk_size;     /*!< Size of chunks that small blocks are carved from, larger blocks are allocated one by one */
+    int                 budget;         /*!< Most bytes the arena may take from the allocator, 0 for no limit */
+    audio_mem_place_t   place;          /*!< Placement of the chunks and blocks */
+} audio_mem_arena_cfg_t;
+
+/**
+ * @brief   Counters of memory arena
+ */
+typedef struct {
+    uint32_t    alloc_count;    /*!< Number of allocations */
+    uint32_t    free_count;     /*!< Number of frees */
+    size_t      in_use;         /*!< Bytes in use */
+    size_t      peak;           /*!< Highest `in_use` */
+    size_t      reserved;       /*!< Bytes taken from the allocator, chunks and large blocks */
+    size_t      peak_reserved;  /*!< Highest `reserved` */
+    int         chunk_num;      /*!< Number of chunks */
+    int         large_num;      /*!< Number of blocks larger than half a chunk */
+    int         fragmentation;  /*!< Percentage of chunk space below the bump pointers that is freed but not reusable yet */
+} audio_mem_arena_stats_t;
+
+typedef struct audio_mem_arena *audio_mem_arena_handle_t;
+
 /**
  * @brief   Malloc memory in ADF
  *
@@ -120,6 +190,137 @@ void *audio_realloc(void *ptr, size_t size);
  */
 char *audio_strdup(const char *str);
 
+/**
+ * @brief   Malloc memory in ADF at the given placement
+ *
+ * @param[in]  size   memory size
+ * @param[in]  place  placement hint
+ *
+ * @return
+ *     - valid pointer on success
+ *     - NULL when any errors
+ */
+void *audio_malloc_place(size_t size, audio_mem_place_t place);
+
+/**
+ * @brief   Malloc zeroed memory in ADF at the given placement
+ *
+ * @param[in]  nmemb  number of block
+ * @param[in]  size   block memory size
+ * @param[in]  place  placement hint
+ *
+ * @return
+ *     - valid pointer on success
+ *     - NULL when any errors
+ */
+void *audio_calloc_place(size_t nmemb, size_t size, audio_mem_place_t place);
+
+/**
+ * @brief   Replace the heap backend of ADF memory functions
+ *
+ * @note    Must be called before anything is allocated, blocks are always freed by the allocator they came from
+ *
+ * @param[in]  allocator  The allocator, NULL to restore the heap
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_mem_set_allocator(const audio_mem_allocator_t *allocator);
+
+/**
+ * @brief   Create fixed size pools for small allocations. A request is served by the smallest pool that fits
+ *          and has a free block, otherwise by the allocator. `audio_free` recognizes pool blocks by address.
+ *
+ * @param[in]  pools  Size classes, in ascending `block_size`
+ * @param[in]  num    Number of size classes
+ * @param[in]  place  Placement of pools, only requests with this placement or the default one use them
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ *     - ESP_ERR_INVALID_STATE, pools already created
+ *     - ESP_ERR_NO_MEM
+ */
+esp_err_t audio_mem_pool_init(const audio_mem_pool_cfg_t *pools, int num, audio_mem_place_t place);
+
+/**
+ * @brief   Free the pools
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_STATE, blocks of pools are still in use
+ */
+esp_err_t audio_mem_pool_deinit(void);
+
+/**
+ * @brief   Get counters of ADF memory
+ *
+ * @param[out] stats  The counters
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_mem_get_stats(audio_mem_stats_t *stats);
+
+/**
+ * @brief   Create a memory arena. Allocations of the tasks that entered the arena are taken from it,
+ *          and everything still allocated is released in one shot when it is destroyed.
+ *
+ * @note    `audio_free` finds the arena of a block by a binary search over the address ranges of all arena chunks
+ *          and large blocks, memory of other origins is never read.
+ *          The arena is guarded by a mutex, its blocks must not be allocated or freed from an ISR
+ *
+ * @param[in]  config  The configuration
+ *
+ * @return
+ *     - The arena handle
+ *     - NULL when any errors
+ */
+audio_mem_arena_handle_t audio_mem_arena_create(const audio_mem_arena_cfg_t *config);
+
+/**
+ * @brief   Make the calling task allocate from `arena`, restore the previous one with `audio_mem_arena_exit`
+ *
+ * @param[in]  arena  The arena handle, NULL to allocate from the allocator
+ *
+ * @return     The arena the task used before
+ */
+audio_mem_arena_handle_t audio_mem_arena_enter(audio_mem_arena_handle_t arena);
+
+/**
+ * @brief   Restore the arena returned by `audio_mem_arena_enter`
+ *
+ * @param[in]  prev  The previous arena
+ */
+void audio_mem_arena_exit(audio_mem_arena_handle_t prev);
+
+/**
+ * @brief   Get counters of a memory arena
+ *
+ * @param[in]  arena  The arena handle
+ * @param[out] stats  The counters
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_mem_arena_get_stats(audio_mem_arena_handle_t arena, audio_mem_arena_stats_t *stats);
+
+/**
+ * @brief   Destroy a memory arena and release all its memory, including blocks that were not freed
+ *
+ * @note    No block of the arena may be used or freed afterwards
+ *
+ * @param[in]  arena  The arena handle
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_mem_arena_destroy(audio_mem_arena_handle_t arena);
+
 /**
  * @brief   SPI ram is enabled or not
  *
@@ -0,0 +1,131 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_SAMPLE_H__
+#define __AUDIO_SAMPLE_H__
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Sample layout helpers shared by the streams and the recorder.
+ *
+ * Samples are signed little endian, 24 bit samples are packed in 3 bytes. Interleaved buffers hold
+ * `frames * channels` samples. The 16 bit kernels move two samples per 32 bit word when the buffers
+ * are word aligned, and fall back to a per sample loop otherwise, so any alignment works.
+ */
+
+#define AUDIO_SAMPLE_MAX_CHANNELS   (8)
+#define AUDIO_SAMPLE_GAIN_SHIFT     (12)
+#define AUDIO_SAMPLE_GAIN_UNITY     (1 << AUDIO_SAMPLE_GAIN_SHIFT)  /*!< Gain of 1.0 for `audio_sample_gain_16` */
+
+/**
+ * @brief Interleave planar 16 bit channels
+ *
+ * @param src       Planar channel buffers, `channels` pointers of `frames` samples each
+ * @param channels  Channel number, 1 to AUDIO_SAMPLE_MAX_CHANNELS
+ * @param frames    Frame number
+ * @param dst       Interleaved output, must not overlap the sources
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_sample_interleave_16(const int16_t *const src[], int channels, int frames, int16_t *dst);
+
+/**
+ * @brief Deinterleave 16 bit samples into planar channels
+ *
+ * @param src       Interleaved input
+ * @param channels  Channel number, 1 to AUDIO_SAMPLE_MAX_CHANNELS
+ * @param frames    Frame number
+ * @param dst       Planar channel buffers, must not overlap the source
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_sample_deinterleave_16(const int16_t *src, int channels, int frames, int16_t *const dst[]);
+
+/**
+ * @brief Pick and reorder the channels of interleaved 16 bit samples.
+ *        Output channel `i` is input channel `map[i]`, a negative `map[i]` gives silence.
+ *        Works in place (`src == dst`) when `dst_ch <= src_ch`.
+ *
+ * @param src       Interleaved input
+ * @param src_ch    Input channel number, 1 to AUDIO_SAMPLE_MAX_CHANNELS
+ * @param dst       Interleaved output
+ * @param map       Source channel of each output channel
+ * @param dst_ch    Output channel number, 1 to AUDIO_SAMPLE_MAX_CHANNELS
+ * @param frames    Frame number
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_sample_reorder_16(const int16_t *src, int src_ch, int16_t *dst, const int8_t *map, int dst_ch, int frames);
+
+/**
+ * @brief Swap the left and right channel of interleaved 16 bit stereo in place
+ *
+ * @param buf       Interleaved stereo samples
+ * @param frames    Frame number
+ */
+void audio_sample_swap_stereo_16(int16_t *buf, int frames);
+
+/**
+ * @brief Apply a per channel gain to interleaved 16 bit samples with saturation, works in place
+ *
+ * @param src       Interleaved input
+ * @param dst       Interleaved output, may be `src`
+ * @param channels  Channel number, 1 to AUDIO_SAMPLE_MAX_CHANNELS
+ * @param gain      Gain of each channel, AUDIO_SAMPLE_GAIN_UNITY is 1.0
+ * @param frames    Frame number
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_sample_gain_16(const int16_t *src, int16_t *dst, int channels, const int32_t *gain, int frames);
+
+/**
+ * @brief Convert between 16, 24 and 32 bit samples, widening shifts the sample up and narrowing truncates.
+ *        Works in place (`src == dst`).
+ *
+ * @param src       Input samples
+ * @param src_bits  Input sample width, 16, 24 or 32
+ * @param dst       Output samples
+ * @param dst_bits  Output sample width, 16, 24 or 32
+ * @param samples   Sample number, i.e. frames multiplied by channels
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG
+ */
+esp_err_t audio_sample_convert(const void *src, int src_bits, void *dst, int dst_bits, int samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_SAMPLE_H__ */
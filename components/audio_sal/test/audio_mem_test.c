@@ -23,6 +23,7 @@
  */
 
 #include <pthread.h>
+#include <string.h>
 #include "unity.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -87,3 +88,82 @@ TEST_CASE("audio_realloc", "esp-adf")
     AUDIO_MEM_SHOW(TAG);
 }
 
+
+TEST_CASE("audio_mem pool", "esp-adf")
+{
+    audio_mem_pool_cfg_t pools[] = {
+        { .block_size = 32, .block_num = 4 },
+        { .block_size = 128, .block_num = 2 },
+    };
+    audio_mem_stats_t before, after;
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mem_get_stats(&before));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mem_pool_init(pools, 2, AUDIO_MEM_PLACE_DEFAULT));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, audio_mem_pool_init(pools, 2, AUDIO_MEM_PLACE_DEFAULT));
+
+    void *blocks[8];
+    for (int i = 0; i < 8; i++) {
+        blocks[i] = audio_calloc(1, 20);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mem_get_stats(&after));
+    TEST_ASSERT_EQUAL(6, after.pool_hits - before.pool_hits);
+    TEST_ASSERT_EQUAL(2, after.pool_misses - before.pool_misses);
+
+    memset(blocks[0], 0x5a, 20);
+    blocks[0] = audio_realloc(blocks[0], 1024);
+    TEST_ASSERT_NOT_NULL(blocks[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x5a, ((uint8_t *)blocks[0])[19]);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, audio_mem_pool_deinit());
+    for (int i = 0; i < 8; i++) {
+        audio_free(blocks[i]);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mem_pool_deinit());
+}
+
+TEST_CASE("audio_mem arena", "esp-adf")
+{
+    audio_mem_arena_cfg_t cfg = {
+        .name = "test",
+        .chunk_size = 4096,
+        .budget = 16 * 1024,
+        .place = AUDIO_MEM_PLACE_DEFAULT,
+    };
+    audio_mem_arena_handle_t arena = audio_mem_arena_create(&cfg);
+    TEST_ASSERT_NOT_NULL(arena);
+
+    audio_mem_arena_handle_t prev = audio_mem_arena_enter(arena);
+    char *small = audio_strdup("audio arena");
+    void *large = audio_malloc(3000);
+    void *top = audio_calloc(1, 100);
+    audio_mem_arena_exit(prev);
+    void *heap = audio_malloc(100);
+    TEST_ASSERT_NOT_NULL(small);
+    TEST_ASSERT_NOT_NULL(large);
+    TEST_ASSERT_NOT_NULL(top);
+    TEST_ASSERT_NOT_NULL(heap);
+
+    audio_mem_arena_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mem_arena_get_stats(arena, &stats));
+    ESP_LOGI(TAG, "arena in use:%d, reserved:%d, chunks:%d, large:%d", (int)stats.in_use, (int)stats.reserved,
+             stats.chunk_num, stats.large_num);
+    TEST_ASSERT_EQUAL(3, stats.alloc_count);
+    TEST_ASSERT_EQUAL(1, stats.chunk_num);
+    TEST_ASSERT_EQUAL(1, stats.large_num);
+    TEST_ASSERT_EQUAL(strlen("audio arena") + 1 + 3000 + 100, stats.in_use);
+
+    audio_free(top);
+    audio_free(large);
+    audio_free(heap);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mem_arena_get_stats(arena, &stats));
+    TEST_ASSERT_EQUAL(0, stats.large_num);
+    TEST_ASSERT_EQUAL(strlen("audio arena") + 1, stats.in_use);
+    TEST_ASSERT_EQUAL(3000 + 100 + strlen("audio arena") + 1, stats.peak);
+
+    prev = audio_mem_arena_enter(arena);
+    TEST_ASSERT_NULL(audio_malloc(32 * 1024));
+    audio_mem_arena_exit(prev);
+
+    // `small` is released together with the arena
+    TEST_ASSERT_EQUAL(ESP_OK, audio_mem_arena_destroy(arena));
+}
@@ -0,0 +1,157 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "unity.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_mem.h"
+#include "audio_sample.h"
+
+static const char *TAG = "AUDIO_SAMPLE_TEST";
+
+#define TEST_FRAMES (512)
+
+static void fill_pattern(int16_t *buf, int n)
+{
+    for (int i = 0; i < n; i++) {
+        buf[i] = (int16_t)(i * 977 - 30000);
+    }
+}
+
+TEST_CASE("audio_sample interleave and deinterleave", "esp-adf")
+{
+    for (int ch = 1; ch <= 4; ch++) {
+        int16_t *inter = audio_calloc(TEST_FRAMES * ch, sizeof(int16_t));
+        int16_t *back = audio_calloc(TEST_FRAMES * ch, sizeof(int16_t));
+        int16_t *planar[4];
+        TEST_ASSERT_NOT_NULL(inter);
+        TEST_ASSERT_NOT_NULL(back);
+        fill_pattern(inter, TEST_FRAMES * ch);
+        for (int c = 0; c < ch; c++) {
+            planar[c] = audio_calloc(TEST_FRAMES, sizeof(int16_t));
+            TEST_ASSERT_NOT_NULL(planar[c]);
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, audio_sample_deinterleave_16(inter, ch, TEST_FRAMES, planar));
+        for (int c = 0; c < ch; c++) {
+            TEST_ASSERT_EQUAL_INT16(inter[5 * ch + c], planar[c][5]);
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, audio_sample_interleave_16((const int16_t *const *)planar, ch, TEST_FRAMES, back));
+        TEST_ASSERT_EQUAL_MEMORY(inter, back, TEST_FRAMES * ch * sizeof(int16_t));
+        for (int c = 0; c < ch; c++) {
+            audio_free(planar[c]);
+        }
+        audio_free(inter);
+        audio_free(back);
+    }
+}
+
+TEST_CASE("audio_sample reorder in place", "esp-adf")
+{
+    int16_t *buf = audio_calloc(TEST_FRAMES * 4, sizeof(int16_t));
+    int16_t *ref = audio_calloc(TEST_FRAMES * 4, sizeof(int16_t));
+    TEST_ASSERT_NOT_NULL(buf);
+    TEST_ASSERT_NOT_NULL(ref);
+
+    // Stereo swap, also through an unaligned buffer
+    fill_pattern(ref, TEST_FRAMES * 2);
+    memcpy(buf, ref, TEST_FRAMES * 2 * sizeof(int16_t));
+    int8_t swap[2] = { 1, 0 };
+    TEST_ASSERT_EQUAL(ESP_OK, audio_sample_reorder_16(buf, 2, buf, swap, 2, TEST_FRAMES));
+    for (int i = 0; i < TEST_FRAMES; i++) {
+        TEST_ASSERT_EQUAL_INT16(ref[2 * i + 1], buf[2 * i]);
+        TEST_ASSERT_EQUAL_INT16(ref[2 * i], buf[2 * i + 1]);
+    }
+    memcpy(buf + 1, ref, (TEST_FRAMES - 1) * 2 * sizeof(int16_t));
+    audio_sample_swap_stereo_16(buf + 1, TEST_FRAMES - 1);
+    TEST_ASSERT_EQUAL_INT16(ref[1], buf[1]);
+    TEST_ASSERT_EQUAL_INT16(ref[0], buf[2]);
+
+    // Pick 3 of 4 channels in place, as the AFE feed does, with one silent output channel after
+    fill_pattern(ref, TEST_FRAMES * 4);
+    memcpy(buf, ref, TEST_FRAMES * 4 * sizeof(int16_t));
+    int8_t pick[4] = { 2, 0, 3, -1 };
+    TEST_ASSERT_EQUAL(ESP_OK, audio_sample_reorder_16(buf, 4, buf, pick, 3, TEST_FRAMES));
+    for (int i = 0; i < TEST_FRAMES; i++) {
+        TEST_ASSERT_EQUAL_INT16(ref[4 * i + 2], buf[3 * i]);
+        TEST_ASSERT_EQUAL_INT16(ref[4 * i + 0], buf[3 * i + 1]);
+        TEST_ASSERT_EQUAL_INT16(ref[4 * i + 3], buf[3 * i + 2]);
+    }
+    memcpy(buf, ref, TEST_FRAMES * 4 * sizeof(int16_t));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_sample_reorder_16(buf, 4, buf, pick, 4, TEST_FRAMES));
+    TEST_ASSERT_EQUAL_INT16(0, buf[4 * 7 + 3]);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, audio_sample_reorder_16(buf, 2, buf, pick, 3, TEST_FRAMES));
+    audio_free(buf);
+    audio_free(ref);
+}
+
+TEST_CASE("audio_sample gain and convert", "esp-adf")
+{
+    int16_t in[4] = { 1000, -1000, 20000, -20000 };
+    int16_t out[4];
+    int32_t gain[2] = { AUDIO_SAMPLE_GAIN_UNITY * 2, AUDIO_SAMPLE_GAIN_UNITY / 2 };
+    TEST_ASSERT_EQUAL(ESP_OK, audio_sample_gain_16(in, out, 2, gain, 2));
+    TEST_ASSERT_EQUAL_INT16(2000, out[0]);
+    TEST_ASSERT_EQUAL_INT16(-500, out[1]);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, out[2]);
+    TEST_ASSERT_EQUAL_INT16(-10000, out[3]);
+
+    int32_t wide[4];
+    int16_t samples[4] = { 0x1234, -2, INT16_MAX, INT16_MIN };
+    memcpy(wide, samples, sizeof(samples));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_sample_convert(wide, 16, wide, 32, 4));
+    TEST_ASSERT_EQUAL_INT32(0x12340000, wide[0]);
+    TEST_ASSERT_EQUAL_INT32(-2 * 65536, wide[1]);
+    TEST_ASSERT_EQUAL(ESP_OK, audio_sample_convert(wide, 32, wide, 24, 4));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_sample_convert(wide, 24, wide, 16, 4));
+    TEST_ASSERT_EQUAL_MEMORY(samples, wide, sizeof(samples));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, audio_sample_convert(wide, 16, wide, 8, 4));
+}
+
+TEST_CASE("audio_sample reorder speed", "esp-adf")
+{
+    int16_t *buf = audio_calloc(TEST_FRAMES * 4, sizeof(int16_t));
+    int16_t *tmp = audio_calloc(TEST_FRAMES * 4, sizeof(int16_t));
+    TEST_ASSERT_NOT_NULL(buf);
+    TEST_ASSERT_NOT_NULL(tmp);
+    fill_pattern(buf, TEST_FRAMES * 4);
+    int8_t swap[2] = { 1, 0 };
+    int64_t start = esp_timer_get_time();
+    for (int n = 0; n < 1000; n++) {
+        for (int i = 0; i < TEST_FRAMES; i++) {
+            tmp[2 * i] = buf[2 * i + 1];
+            tmp[2 * i + 1] = buf[2 * i];
+        }
+    }
+    int64_t copy_us = esp_timer_get_time() - start;
+    start = esp_timer_get_time();
+    for (int n = 0; n < 1000; n++) {
+        audio_sample_reorder_16(buf, 2, buf, swap, 2, TEST_FRAMES);
+    }
+    int64_t in_place_us = esp_timer_get_time() - start;
+    ESP_LOGI(TAG, "Stereo swap of %d frames, copy %d ns, in place %d ns", TEST_FRAMES,
+             (int)copy_us, (int)in_place_us);
+    audio_free(buf);
+    audio_free(tmp);
+}
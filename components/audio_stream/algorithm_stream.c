@@ -29,6 +29,7 @@
 #include "audio_element.h"
 #include "audio_error.h"
 #include "audio_mem.h"
+#include "audio_sample.h"
 #include "audio_thread.h"
 #include "esp_log.h"
 
@@ -74,14 +75,7 @@ typedef struct {
 
 esp_err_t algorithm_mono_fix(uint8_t *sbuff, uint32_t len)
 {
-    int16_t *temp_buf = (int16_t *)sbuff;
-    int16_t temp_box;
-    int k = len >> 1;
-    for (int i = 0; i < k; i += 2) {
-        temp_box = temp_buf[i];
-        temp_buf[i] = temp_buf[i + 1];
-        temp_buf[i + 1] = temp_box;
-    }
+    audio_sample_swap_stereo_16((int16_t *)sbuff, len >> 2);
     return ESP_OK;
 }
 
@@ -234,23 +228,11 @@ static esp_err_t _algo_open(audio_element_handle_t self)
 
 static esp_err_t algorithm_data_gain(int16_t *raw_buff, int len, int linear_lfac, int linear_rfac)
 {
-    for (int i = 0; i < len / 4; i++) {
-        raw_buff[i << 1] = raw_buff[i << 1] * linear_lfac;
-        raw_buff[(i << 1) + 1] = raw_buff[(i << 1) + 1] * linear_rfac;
-    }
-    return ESP_OK;
-}
-
-// Swap left and right channels
-static esp_err_t algorithm_data_swap(int16_t *raw_buff, int len)
-{
-    int16_t tmp;
-    for (int i = 0; i < len / 4; i++) {
-        tmp = raw_buff[i << 1];
-        raw_buff[i << 1]         = raw_buff[(i << 1) + 1];
-        raw_buff[(i << 1) + 1]   = tmp;
+    if (linear_lfac == 1 && linear_rfac == 1) {
+        return ESP_OK;
     }
-    return ESP_OK;
+    int32_t gain[2] = { linear_lfac * AUDIO_SAMPLE_GAIN_UNITY, linear_rfac * AUDIO_SAMPLE_GAIN_UNITY };
+    return audio_sample_gain_16(raw_buff, raw_buff, 2, gain, len / 4);
 }
 
 static int algorithm_data_process_for_type1(audio_element_handle_t self)
@@ -264,7 +246,7 @@ static int algorithm_data_process_for_type1(audio_element_handle_t self)
     bytes_read = audio_element_input(self, (char *)algo->aec_buff, size);
     if (bytes_read > 0) {
         if (algo->swap_ch) {
-            algorithm_data_swap((int16_t *)algo->aec_buff, bytes_read);
+            audio_sample_swap_stereo_16((int16_t *)algo->aec_buff, bytes_read / 4);
         }
         if (algo->debug_input) {
             audio_element_output(self, (char *)algo->aec_buff, size);
@@ -294,11 +276,8 @@ static int algorithm_data_process_for_type2(audio_element_handle_t self)
 
     bytes_read = audio_element_input(self, (char *)algo->record, size);
     if (bytes_read > 0) {
-        int16_t *temp = algo->aec_buff;
-        for (int i = 0; i < (size / 2); i++) {
-            temp[i << 1] = algo->record[i];
-            temp[(i << 1) + 1] = algo->reference[i];
-        }
+        const int16_t *planar[2] = { algo->record, algo->reference };
+        audio_sample_interleave_16(planar, 2, size / 2, algo->aec_buff);
 
         if (algo->debug_input) {
             audio_element_output(self, (char *)algo->aec_buff, 2 * size);
@@ -2,5 +2,5 @@
 # "main" pseudo-component makefile.
 #
 COMPONENT_ADD_INCLUDEDIRS := ./include
-COMPONENT_SRCDIRS := . ./lib/hls ./lib/gzip
-COMPONENT_PRIV_INCLUDEDIRS := ./lib/hls/include ./lib/gzip/include
+COMPONENT_SRCDIRS := . ./lib/hls ./lib/gzip ./lib/file_cache
+COMPONENT_PRIV_INCLUDEDIRS := ./lib/hls/include ./lib/gzip/include ./lib/file_cache/include
@@ -37,6 +37,7 @@
 #include "audio_mem.h"
 #include "audio_element.h"
 #include "wav_head.h"
+#include "file_cache.h"
 #include "esp_log.h"
 #include "unistd.h"
 #include "fcntl.h"
@@ -63,6 +64,10 @@ typedef struct fatfs_stream {
     int file;
     wr_stream_type_t w_type;
     bool write_header;
+    file_write_cache_cfg_t cache_cfg;
+    file_write_cache_handle_t cache;
+    file_read_cache_cfg_t read_cache_cfg;
+    file_read_cache_handle_t read_cache;
 } fatfs_stream_t;
 
 
@@ -104,6 +109,16 @@ static char* get_mount_path(char* uri)
     return skip_scheme;
 }
 
+static void _fatfs_write_header(fatfs_stream_t *fatfs, const char *header, int len)
+{
+    if (fatfs->cache) {
+        file_write_cache_write(fatfs->cache, header, len, portMAX_DELAY);
+    } else {
+        write(fatfs->file, header, len);
+        fsync(fatfs->file);
+    }
+}
+
 static esp_err_t _fatfs_open(audio_element_handle_t self)
 {
     fatfs_stream_t *fatfs = (fatfs_stream_t *)audio_element_getdata(self);
@@ -144,6 +159,13 @@ static esp_err_t _fatfs_open(audio_element_handle_t self)
                 return ESP_FAIL;
             }
         }
+        if (fatfs->read_cache_cfg.block_size > 0) {
+            fatfs->read_cache = file_read_cache_create(fatfs->file, info.byte_pos, &fatfs->read_cache_cfg);
+            if (fatfs->read_cache == NULL) {
+                close(fatfs->file);
+                return ESP_FAIL;
+            }
+        }
     } else if (fatfs->type == AUDIO_STREAM_WRITER) {
         fatfs->file = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU);
         if (fatfs->file == -1) {
@@ -151,16 +173,21 @@ static esp_err_t _fatfs_open(audio_element_handle_t self)
             return ESP_FAIL;
         }
         fatfs->w_type =  get_type(path);
+        if (fatfs->cache_cfg.cache_size > 0) {
+            fatfs->cache = file_write_cache_create(fatfs->file, &fatfs->cache_cfg);
+            if (fatfs->cache == NULL) {
+                close(fatfs->file);
+                return ESP_FAIL;
+            }
+        }
         if ((STREAM_TYPE_WAV == fatfs->w_type) && (fatfs->write_header == true)) {
+            // Placeholder only, the header is patched with the real size on close
             wav_header_t info = {0};
-            write(fatfs->file, &info, sizeof(wav_header_t));
-            fsync(fatfs->file);
+            _fatfs_write_header(fatfs, (const char *)&info, sizeof(wav_header_t));
         } else if ((STREAM_TYPE_AMR == fatfs->w_type) && (fatfs->write_header == true)) {
-            write(fatfs->file, "#!AMR\n", 6);
-            fsync(fatfs->file);
+            _fatfs_write_header(fatfs, "#!AMR\n", 6);
         } else if ((STREAM_TYPE_AMRWB == fatfs->w_type) && (fatfs->write_header == true)) {
-            write(fatfs->file, "#!AMR-WB\n", 9);
-            fsync(fatfs->file);
+            _fatfs_write_header(fatfs, "#!AMR-WB\n", 9);
         }
     } else {
         ESP_LOGE(TAG, "FATFS must be Reader or Writer");
@@ -178,8 +205,13 @@ static int _fatfs_read(audio_element_handle_t self, char *buffer, int len, TickT
     audio_element_getinfo(self, &info);
 
     ESP_LOGD(TAG, "read len=%d, pos=%d/%d", len, (int)info.byte_pos, (int)info.total_bytes);
-    /* use file descriptors to access files */
-    int rlen = read(fatfs->file, buffer, len);
+    int rlen;
+    if (fatfs->read_cache) {
+        rlen = file_read_cache_read(fatfs->read_cache, buffer, len, portMAX_DELAY);
+    } else {
+        /* use file descriptors to access files */
+        rlen = read(fatfs->file, buffer, len);
+    }
     if (rlen == 0) {
         ESP_LOGW(TAG, "No more data, ret:%d", rlen);
     } else if (rlen == -1) {
@@ -195,8 +227,14 @@ static int _fatfs_write(audio_element_handle_t self, char *buffer, int len, Tick
     fatfs_stream_t *fatfs = (fatfs_stream_t *)audio_element_getdata(self);
     audio_element_info_t info;
     audio_element_getinfo(self, &info);
-    int wlen =  write(fatfs->file, buffer, len);
-    fsync(fatfs->file);
+    int wlen = 0;
+    if (fatfs->cache) {
+        // Returns as soon as data is copied, the cache is only full when the card is slower than the stream
+        wlen = file_write_cache_write(fatfs->cache, buffer, len, portMAX_DELAY);
+    } else {
+        wlen = write(fatfs->file, buffer, len);
+        fsync(fatfs->file);
+    }
     if (wlen > 0) {
         audio_element_update_byte_pos(self, wlen);
     } if (wlen == -1) {
@@ -222,6 +260,16 @@ static esp_err_t _fatfs_close(audio_element_handle_t self)
 {
     fatfs_stream_t *fatfs = (fatfs_stream_t *)audio_element_getdata(self);
 
+    if (fatfs->cache) {
+        if (file_write_cache_destroy(fatfs->cache) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to write cached data to file");
+        }
+        fatfs->cache = NULL;
+    }
+    if (fatfs->read_cache) {
+        file_read_cache_destroy(fatfs->read_cache);
+        fatfs->read_cache = NULL;
+    }
     if (AUDIO_STREAM_WRITER == fatfs->type
         && (-1 != fatfs->file)
         && (true == fatfs->write_header)
@@ -285,6 +333,27 @@ audio_element_handle_t fatfs_stream_init(fatfs_stream_cfg_t *config)
     cfg.tag = "file";
     fatfs->type = config->type;
     fatfs->write_header = config->write_header;
+    if (config->type == AUDIO_STREAM_WRITER && config->write_cache_size > 0) {
+        file_write_cache_cfg_t *cache_cfg = &fatfs->cache_cfg;
+        cache_cfg->cache_size = config->write_cache_size;
+        cache_cfg->block_size = config->write_block_size > 0 ? config->write_block_size : FATFS_STREAM_WRITE_BLOCK_SIZE;
+        cache_cfg->sync_interval_ms = config->sync_interval_ms;
+        cache_cfg->sync_bytes = config->sync_bytes;
+        cache_cfg->prealloc_size = config->prealloc_size;
+        cache_cfg->task_stack = FATFS_STREAM_CACHE_TASK_STACK;
+        cache_cfg->task_prio = config->task_prio;
+        cache_cfg->task_core = config->task_core;
+        cache_cfg->ext_stack = config->ext_stack;
+    }
+    if (config->type == AUDIO_STREAM_READER && config->read_block_size > 0) {
+        file_read_cache_cfg_t *cache_cfg = &fatfs->read_cache_cfg;
+        cache_cfg->block_size = config->read_block_size;
+        cache_cfg->block_num = config->read_block_num > 0 ? config->read_block_num : FATFS_STREAM_READ_BLOCK_NUM;
+        cache_cfg->task_stack = FATFS_STREAM_CACHE_TASK_STACK;
+        cache_cfg->task_prio = config->task_prio;
+        cache_cfg->task_core = config->task_core;
+        cache_cfg->ext_stack = config->ext_stack;
+    }
 
     if (config->type == AUDIO_STREAM_WRITER) {
         cfg.write = _fatfs_write;
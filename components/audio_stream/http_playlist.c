@@ -40,6 +40,7 @@ static const char *TAG = "HLS_PLAYLIST";
 typedef struct track_ {
     char *uri;
     bool is_played;
+    uint64_t seq;
     STAILQ_ENTRY(track_) next;
 } track_t;
 
@@ -59,6 +60,11 @@ static void hls_remove_played_entry(http_playlist_t *playlist)
 }
 
 void http_playlist_insert(http_playlist_t *playlist, char *track_uri)
+{
+    http_playlist_insert_seq(playlist, track_uri, 0);
+}
+
+void http_playlist_insert_seq(http_playlist_t *playlist, char *track_uri, uint64_t seq)
 {
     track_t *track;
     const char *host_uri = (const char *) playlist->host_uri;
@@ -88,6 +94,7 @@ void http_playlist_insert(http_playlist_t *playlist, char *track_uri)
         audio_free(track);
         return;
     }
+    track->seq = seq;
 
     track_t *find = NULL;
     STAILQ_FOREACH(find, &playlist->tracks, next) {
@@ -133,6 +140,43 @@ char* http_playlist_get_last_track(http_playlist_t *playlist)
     return uri;
 }
 
+int http_playlist_replace_unplayed(http_playlist_t *playlist, http_playlist_t *from, uint64_t *next_seq)
+{
+    track_t *track, *tmp;
+    bool dropped = false;
+    uint64_t first = *next_seq;
+    STAILQ_FOREACH_SAFE(track, &playlist->tracks, next, tmp) {
+        if (track->is_played) {
+            continue;
+        }
+        if (dropped == false) {
+            first = track->seq;
+            dropped = true;
+        }
+        STAILQ_REMOVE(&playlist->tracks, track, track_, next);
+        audio_free(track->uri);
+        audio_free(track);
+        playlist->total_tracks--;
+    }
+    int moved = 0;
+    *next_seq = first;
+    STAILQ_FOREACH_SAFE(track, &from->tracks, next, tmp) {
+        STAILQ_REMOVE(&from->tracks, track, track_, next);
+        if (track->seq < first) {
+            audio_free(track->uri);
+            audio_free(track);
+            continue;
+        }
+        track->is_played = false;
+        STAILQ_INSERT_TAIL(&playlist->tracks, track, next);
+        playlist->total_tracks++;
+        *next_seq = track->seq + 1;
+        moved++;
+    }
+    from->total_tracks = 0;
+    return moved;
+}
+
 void http_playlist_clear(http_playlist_t *playlist)
 {
     track_t *track, *tmp;
@@ -31,6 +31,7 @@ extern "C" {
 
 #include "esp_err.h"
 #include "stdbool.h"
+#include "stdint.h"
 #include "sys/queue.h"
 
 struct track_; // Forward declaration
@@ -54,6 +55,16 @@ typedef struct {
  */
 void http_playlist_insert(http_playlist_t *playlist, char *track_uri);
 
+/**
+ * @brief       Insert a segment of a HLS media playlist into hls_playlist
+ *
+ * @param       playlist: Playlist handle
+ * @param       track_uri: Track URI to be inserted in playlist
+ * @param       seq: Media sequence number of the segment
+ *
+ */
+void http_playlist_insert_seq(http_playlist_t *playlist, char *track_uri, uint64_t seq);
+
 /**
  * @brief       Get next not-played track from playlist
  *
@@ -80,6 +91,19 @@ char *http_playlist_get_next_track(http_playlist_t *playlist);
  */
 char *http_playlist_get_last_track(http_playlist_t *playlist);
 
+/**
+ * @brief       Replace the tracks not played yet by the tracks of another variant of the same HLS stream,
+ *              from the media sequence number of the first replaced track on
+ *
+ * @param       playlist: Playlist handle
+ * @param       from: Playlist of the other variant, its tracks are moved or freed
+ * @param       next_seq: In, media sequence number to continue from when no track is waiting.
+ *                        Out, media sequence number following the last track queued
+ *
+ * @return      Number of tracks moved from `from`
+ */
+int http_playlist_replace_unplayed(http_playlist_t *playlist, http_playlist_t *from, uint64_t *next_seq);
+
 /**
  * @brief       Clear all the tracks from playlist
  *
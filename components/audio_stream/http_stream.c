@@ -32,13 +32,19 @@
 #include "freertos/ringbuf.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
 
 #include "esp_log.h"
 #include "http_stream.h"
 #include "http_playlist.h"
+#include "http_conn_pool.h"
 #include "audio_mem.h"
 #include "audio_element.h"
+#include "audio_thread.h"
+#include "audio_mutex.h"
+#include "ringbuf.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "esp_http_client.h"
 #include "line_reader.h"
 #include "hls_playlist.h"
@@ -63,6 +69,35 @@ static const char *TAG = "HTTP_STREAM";
 
 #define HLS_PREFER_BITRATE      (200*1024)
 #define HLS_KEY_CACHE_SIZE      (32)
+#define HLS_AES_BLOCK_SIZE      (16)
+#define HLS_DECRYPT_BATCH_SIZE  (4096)  /* Ciphertext decrypted by one AES call, multiple of the block size */
+
+#define HTTP_PREFETCH_CHUNK_SIZE    (1024)
+#define HTTP_PREFETCH_WAIT_MS       (100)
+#define HTTP_PREFETCH_RETRY_MS      (500)
+#define HTTP_PREFETCH_DATA_BIT      BIT(0)
+#define HTTP_PREFETCH_RESUME_BIT    BIT(1)
+#define HTTP_PREFETCH_EXIT_BIT      BIT(2)
+#define HTTP_PREFETCH_MEASURE_SIZE  (16*1024)
+
+typedef struct {
+    ringbuf_handle_t    rb;
+    EventGroupHandle_t  sync;
+    void                *lock;          /* Guards the playlist, the fetch task updates it while other tasks read it */
+    int                 high_water;
+    int                 low_water;
+    int64_t             fetch_pos;      /* Byte offset of the next byte to fetch from the server */
+    bool                running;
+    volatile bool       stop;
+    volatile bool       done;           /* Fetch task finished, no more data will be cached */
+    volatile bool       paused;         /* Fetch task waits for the cache to drain under the low watermark */
+    volatile bool       buffering;      /* Reader waits for the cache to fill up to the low watermark */
+    int                 error;          /* errno of the connection when the fetch task gave up */
+    int64_t             rx_bytes;       /* Bytes received since last throughput update */
+    int64_t             rx_us;          /* Time spent in socket reads since last throughput update */
+    uint32_t            throughput;     /* Smoothed download throughput in bits per second */
+} http_stream_prefetch_t;
+
 typedef struct {
     bool             key_loaded;
     char             *key_url;
@@ -72,12 +107,18 @@ typedef struct {
     uint64_t         sequence_no;
     esp_aes_context  aes_ctx;
     bool             aes_used;
+    uint8_t          *crypt_buf;    /* Batch of ciphertext, decrypted in place */
+    int              crypt_len;     /* Bytes in `crypt_buf`, the tail after `plain_len` is not decrypted yet */
+    int              plain_pos;     /* Read position of decrypted data */
+    int              plain_len;     /* Decrypted bytes ready to read */
+    bool             segment_end;   /* Whole segment decrypted and padding removed */
 } http_stream_hls_key_t;
 
 typedef struct http_stream {
     audio_stream_type_t             type;
     bool                            is_open;
     esp_http_client_handle_t        client;
+    bool                            conn_reused;       /* client borrowed from pool with a kept-alive connection */
     http_stream_event_handle_t      hook;
     audio_stream_type_t             stream_type;
     void                            *user_data;
@@ -97,14 +138,48 @@ typedef struct http_stream {
     gzip_miniz_handle_t             gzip;              /* GZIP instance */
     http_stream_hls_key_t           *hls_key;
     hls_handle_t                    *hls_media;
+    hls_handle_t                    hls_master;        /* master playlist kept to switch variant by throughput */
+    bool                            is_hls;            /* media playlist is HLS, segments are chained in prefetch mode */
+    bool                            hls_updated;       /* last load of media playlist brought new segments */
+    uint64_t                        hls_next_seq;      /* media sequence of the next segment to queue */
+    uint32_t                        hls_target_ms;     /* target duration of media playlist */
+    TickType_t                      hls_load_tick;     /* time media playlist was last loaded */
     int                             request_range_size;
     int64_t                         request_range_end;
     bool                            is_last_range;
     const char                      *user_agent;
+    http_stream_prefetch_t          *prefetch;         /* read-ahead cache, NULL if disabled */
+    int                             task_stack;
+    int                             task_prio;
+    int                             task_core;
+    bool                            stack_in_ext;
 } http_stream_t;
 
+/* Context of the uri callback while a HLS playlist is parsed */
+typedef struct {
+    http_stream_t                   *http;
+    hls_handle_t                    hls;
+    http_playlist_t                 *queue;            /* playlist the segments are queued to */
+    uint64_t                        next_seq;          /* segments before this media sequence are skipped */
+    int                             uri_num;           /* segments found so far */
+} hls_parse_ctx_t;
+
 static esp_err_t http_stream_auto_connect_next_track(audio_element_handle_t el);
 
+static void _playlist_lock(http_stream_t *http)
+{
+    if (http->prefetch) {
+        mutex_lock(http->prefetch->lock);
+    }
+}
+
+static void _playlist_unlock(http_stream_t *http)
+{
+    if (http->prefetch) {
+        mutex_unlock(http->prefetch->lock);
+    }
+}
+
 // `errno` is not thread safe in multiple HTTP-clients,
 // so it is necessary to save the errno number of HTTP clients to avoid reading and writing exceptions of HTTP-clients caused by errno exceptions
 int __attribute__((weak)) esp_http_client_get_errno(esp_http_client_handle_t client)
@@ -233,10 +308,17 @@ static bool _is_playlist(audio_element_info_t *info, const char *uri)
 
 static int _hls_uri_cb(char *uri, void *ctx)
 {
-    http_stream_t *http = (http_stream_t *) ctx;
+    hls_parse_ctx_t *parse = (hls_parse_ctx_t *) ctx;
     if (uri) {
-        http_playlist_insert(http->playlist, uri);
-        http->is_valid_playlist = true;
+        uint64_t seq = hls_playlist_get_sequence_no(parse->hls) + parse->uri_num++;
+        if (seq < parse->next_seq) {
+            return 0;
+        }
+        parse->next_seq = seq + 1;
+        _playlist_lock(parse->http);
+        http_playlist_insert_seq(parse->queue, uri, seq);
+        _playlist_unlock(parse->http);
+        parse->http->is_valid_playlist = true;
     }
     return 0;
 }
@@ -250,6 +332,28 @@ static int _http_read_data(http_stream_t *http, char *buffer, int len)
     return gzip_miniz_read(http->gzip, (uint8_t*) buffer, len);
 }
 
+static void _hls_read_playlist(http_stream_t *http, hls_parse_ctx_t *parse)
+{
+    int need_read = MAX_PLAYLIST_LINE_SIZE;
+    int rlen = need_read;
+    while (rlen == need_read) {
+        rlen = _http_read_data(http, http->playlist->data, need_read);
+        if (rlen < 0) {
+            break;
+        }
+        hls_playlist_parse_data(parse->hls, (uint8_t *)http->playlist->data, rlen, (rlen < need_read));
+    }
+}
+
+static void _hls_update_media(http_stream_t *http, hls_handle_t hls)
+{
+    http->is_hls = true;
+    _playlist_lock(http);
+    http->playlist->is_incomplete = !hls_playlist_is_media_end(hls);
+    _playlist_unlock(http);
+    http->hls_target_ms = hls_playlist_get_target_duration(hls) * 1000;
+}
+
 static esp_err_t _resolve_hls_key(http_stream_t *http)
 {
     int ret = _http_read_data(http, (char*)http->hls_key->key_cache, sizeof(http->hls_key->key_cache));
@@ -276,6 +380,15 @@ static esp_err_t _prepare_crypt(http_stream_t *http)
     if (ret != 0) {
         return ESP_FAIL;
     }
+    if (hls_key->crypt_buf == NULL) {
+        // AES engine reads and writes internal memory by DMA directly, no bounce buffer needed
+        hls_key->crypt_buf = audio_malloc_place(HLS_DECRYPT_BATCH_SIZE, AUDIO_MEM_PLACE_DMA);
+        AUDIO_MEM_CHECK(TAG, hls_key->crypt_buf, return ESP_ERR_NO_MEM);
+    }
+    hls_key->crypt_len = 0;
+    hls_key->plain_pos = 0;
+    hls_key->plain_len = 0;
+    hls_key->segment_end = false;
     esp_aes_init(&hls_key->aes_ctx);
     esp_aes_setkey(&hls_key->aes_ctx, (unsigned char*)hls_key->key.key, 128);
     hls_key->aes_used = true;
@@ -295,6 +408,9 @@ static void _free_hls_key(http_stream_t *http)
     if (http->hls_key->key_url) {
         audio_free(http->hls_key->key_url);
     }
+    if (http->hls_key->crypt_buf) {
+        audio_free(http->hls_key->crypt_buf);
+    }
     audio_free(http->hls_key);
     http->hls_key = NULL;
 }
@@ -313,6 +429,7 @@ static esp_err_t _resolve_playlist(audio_element_handle_t self, const char *uri)
     if (new_uri == NULL) {
         return ESP_FAIL;
     }
+    _playlist_lock(http);
     if (http->is_main_playlist) {
         http_playlist_clear(http->playlist);
     }
@@ -320,6 +437,7 @@ static esp_err_t _resolve_playlist(audio_element_handle_t self, const char *uri)
         audio_free(http->playlist->host_uri);
     }
     http->playlist->host_uri = new_uri;
+    _playlist_unlock(http);
     http->is_valid_playlist = false;
 
     // handle PLS playlist
@@ -350,10 +468,15 @@ static esp_err_t _resolve_playlist(audio_element_handle_t self, const char *uri)
         return http->is_valid_playlist ? ESP_OK : ESP_FAIL;
     }
     http->is_main_playlist = false;
+    http->is_hls = false;
+    hls_parse_ctx_t parse = {
+        .http = http,
+        .queue = http->playlist,
+    };
     hls_playlist_cfg_t cfg = {
         .prefer_bitrate = HLS_PREFER_BITRATE,
         .cb = _hls_uri_cb,
-        .ctx = http,
+        .ctx = &parse,
         .uri = (char *)new_uri,
     };
     hls_handle_t hls = hls_playlist_open(&cfg);
@@ -361,15 +484,9 @@ static esp_err_t _resolve_playlist(audio_element_handle_t self, const char *uri)
         if (hls == NULL) {
             break;
         }
-        int need_read = MAX_PLAYLIST_LINE_SIZE;
-        int rlen = need_read;
-        while (rlen == need_read) {
-            rlen = _http_read_data(http, http->playlist->data, need_read);
-            if (rlen < 0) {
-                break;
-            }
-            hls_playlist_parse_data(hls, (uint8_t *)http->playlist->data, rlen, (rlen < need_read));
-        }
+        parse.hls = hls;
+        _hls_read_playlist(http, &parse);
+        http->hls_next_seq = parse.next_seq;
         if (hls_playlist_is_master(hls)) {
             char *url = hls_playlist_get_prefer_url(hls, HLS_STREAM_TYPE_AUDIO);
             if (url) {
@@ -380,7 +497,9 @@ static esp_err_t _resolve_playlist(audio_element_handle_t self, const char *uri)
                 audio_free(url);
             }
         } else {
-            http->playlist->is_incomplete = !hls_playlist_is_media_end(hls);
+            _hls_update_media(http, hls);
+            http->hls_updated = true;
+            http->hls_load_tick = xTaskGetTickCount();
             if (http->playlist->is_incomplete) {
                 ESP_LOGI(TAG, "Live stream URI. Need to be fetched again!");
             }
@@ -389,7 +508,15 @@ static esp_err_t _resolve_playlist(audio_element_handle_t self, const char *uri)
     if (hls) {
         if (hls_playlist_is_encrypt(hls) == false) {
             _free_hls_key(http);
-            hls_playlist_close(hls);
+            if (http->is_main_playlist && http->prefetch) {
+                // Fetch task selects variant again once download throughput is measured
+                if (http->hls_master) {
+                    hls_playlist_close(http->hls_master);
+                }
+                http->hls_master = hls;
+            } else {
+                hls_playlist_close(hls);
+            }
         } else {
             // When content is encrypted, need keep hls instance
             http->hls_media = hls;
@@ -427,10 +554,13 @@ static esp_err_t _resolve_playlist(audio_element_handle_t self, const char *uri)
 static char *_playlist_get_next_track(audio_element_handle_t self)
 {
     http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    char *track = NULL;
+    _playlist_lock(http);
     if (http->enable_playlist_parser && http->is_playlist_resolved) {
-        return http_playlist_get_next_track(http->playlist);
+        track = http_playlist_get_next_track(http->playlist);
     }
-    return NULL;
+    _playlist_unlock(http);
+    return track;
 }
 
 static void _prepare_range(http_stream_t *http, int64_t pos)
@@ -458,14 +588,19 @@ static esp_err_t _http_load_uri(audio_element_handle_t self, audio_element_info_
     esp_err_t err;
     http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
 
-    esp_http_client_close(http->client);
+    // Keep the connection for next request only if last response was fully read
+    if (esp_http_client_is_complete_data_received(http->client) == false) {
+        esp_http_client_close(http->client);
+        http->conn_reused = false;
+    }
 
     if (dispatch_hook(self, HTTP_STREAM_PRE_REQUEST, NULL, 0) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to process user callback");
         return ESP_FAIL;
     }
 
-    _prepare_range(http, info->byte_pos);
+    int64_t req_pos = info->byte_pos;
+    _prepare_range(http, req_pos);
 
     if (http->stream_type == AUDIO_STREAM_WRITER) {
         err = esp_http_client_open(http->client, -1);
@@ -484,6 +619,9 @@ _stream_redirect:
         http->gzip_encoding = false;
     }
     if ((err = esp_http_client_open(http->client, post_len)) != ESP_OK) {
+        if (http->conn_reused) {
+            goto _stream_reconnect;
+        }
         ESP_LOGE(TAG, "Failed to open http stream");
         return err;
     }
@@ -510,8 +648,12 @@ _stream_redirect:
     * Due to the total byte of content has been changed after seek, set info.total_bytes at beginning only.
     */
     int64_t cur_pos = esp_http_client_fetch_headers(http->client);
+    if (cur_pos < 0 && http->conn_reused) {
+        goto _stream_reconnect;
+    }
+    http->conn_reused = false;
     audio_element_getinfo(self, info);
-    if (info->byte_pos <= 0) {
+    if (req_pos <= 0) {
         info->total_bytes = cur_pos;
         ESP_LOGI(TAG, "total_bytes=%d", (int)info->total_bytes);
         audio_element_set_total_bytes(self, info->total_bytes);
@@ -526,12 +668,374 @@ _stream_redirect:
         && (esp_http_client_get_status_code(http->client) != 416)) {
         ESP_LOGE(TAG, "Invalid HTTP stream, status code = %d", status_code);
         if (http->enable_playlist_parser) {
+            _playlist_lock(http);
             http_playlist_clear(http->playlist);
             http->is_playlist_resolved = false;
+            _playlist_unlock(http);
         }
         return ESP_FAIL;
     }
     return err;
+
+_stream_reconnect:
+    // Server closed the kept-alive connection meanwhile, send the request again on a new one
+    ESP_LOGW(TAG, "Kept-alive connection closed by server, reconnect");
+    esp_http_client_close(http->client);
+    http->conn_reused = false;
+    goto _stream_redirect;
+}
+
+static int _prefetch_hook(audio_element_handle_t self, http_stream_event_id_t type)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    return dispatch_hook(self, type, NULL, rb_bytes_filled(http->prefetch->rb));
+}
+
+static esp_err_t _prefetch_load(audio_element_handle_t self, int64_t pos)
+{
+    audio_element_info_t info = {0};
+    audio_element_getinfo(self, &info);
+    info.byte_pos = pos;
+    return _http_load_uri(self, &info);
+}
+
+static void _prefetch_update_throughput(http_stream_prefetch_t *prefetch)
+{
+    // Short segments give a noisy estimation, keep accumulating into the next one
+    if (prefetch->rx_bytes < HTTP_PREFETCH_MEASURE_SIZE || prefetch->rx_us <= 0) {
+        return;
+    }
+    uint32_t bps = (uint32_t)(prefetch->rx_bytes * 8 * 1000000 / prefetch->rx_us);
+    prefetch->throughput = prefetch->throughput ? (uint32_t)(((uint64_t)prefetch->throughput * 3 + bps) / 4) : bps;
+    prefetch->rx_bytes = 0;
+    prefetch->rx_us = 0;
+}
+
+static esp_err_t _hls_connect(http_stream_t *http, const char *uri)
+{
+    esp_http_client_set_url(http->client, uri);
+_hls_redirect:
+    if (esp_http_client_open(http->client, 0) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    esp_http_client_fetch_headers(http->client);
+    int status_code = esp_http_client_get_status_code(http->client);
+    if (status_code == 301 || status_code == 302) {
+        esp_http_client_set_redirection(http->client);
+        goto _hls_redirect;
+    }
+    if (status_code != 200) {
+        ESP_LOGE(TAG, "Failed to load %s, status code = %d", uri, status_code);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/* Queue the segments of the media playlist at `queue->host_uri` from `*next_seq` on */
+static esp_err_t _hls_load_media(http_stream_t *http, http_playlist_t *queue, uint64_t *next_seq)
+{
+    hls_parse_ctx_t parse = {
+        .http = http,
+        .queue = queue,
+        .next_seq = *next_seq,
+    };
+    hls_playlist_cfg_t cfg = {
+        .prefer_bitrate = HLS_PREFER_BITRATE,
+        .cb = _hls_uri_cb,
+        .ctx = &parse,
+        .uri = queue->host_uri,
+    };
+    hls_handle_t hls = hls_playlist_open(&cfg);
+    AUDIO_MEM_CHECK(TAG, hls, return ESP_ERR_NO_MEM);
+    parse.hls = hls;
+    _hls_read_playlist(http, &parse);
+    bool encrypted = hls_playlist_is_encrypt(hls);
+    if (encrypted == false && parse.uri_num > 0) {
+        _hls_update_media(http, hls);
+        http->hls_updated = (parse.next_seq != *next_seq);
+        *next_seq = parse.next_seq;
+    }
+    hls_playlist_close(hls);
+    if (encrypted) {
+        ESP_LOGE(TAG, "Encrypted media playlist can not be chained by the fetch task");
+        return ESP_FAIL;
+    }
+    if (parse.uri_num == 0) {
+        ESP_LOGE(TAG, "No segment in media playlist %s", queue->host_uri);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void _hls_switch_variant(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    if (http->hls_master == NULL || http->prefetch->throughput == 0) {
+        return;
+    }
+    hls_playlist_set_throughput(http->hls_master, http->prefetch->throughput);
+    char *uri = hls_playlist_get_prefer_url(http->hls_master, HLS_STREAM_TYPE_AUDIO);
+    if (uri == NULL || strcmp(uri, http->playlist->host_uri) == 0 || _hls_connect(http, uri) != ESP_OK) {
+        audio_free(uri);
+        return;
+    }
+    // Load the new variant aside, the current one stays in use when that fails
+    http_playlist_t variant = {
+        .host_uri = uri,
+    };
+    STAILQ_INIT(&variant.tracks);
+    uint64_t variant_seq = 0;
+    if (_hls_load_media(http, &variant, &variant_seq) != ESP_OK) {
+        ESP_LOGW(TAG, "Keep %s, failed to load %s", http->playlist->host_uri, uri);
+        http_playlist_clear(&variant);
+        return;
+    }
+    ESP_LOGI(TAG, "Switch to %s, throughput %d bps", uri, (int)http->prefetch->throughput);
+    // Variants share media sequence numbers, continue from the first segment not fetched yet
+    _playlist_lock(http);
+    http_playlist_replace_unplayed(http->playlist, &variant, &http->hls_next_seq);
+    audio_free(http->playlist->host_uri);
+    http->playlist->host_uri = uri;
+    _playlist_unlock(http);
+    http->hls_load_tick = xTaskGetTickCount();
+}
+
+static esp_err_t _hls_reload(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    http_stream_prefetch_t *prefetch = http->prefetch;
+    // Wait one target duration since last load, or half of it when last load brought nothing new (RFC 8216 6.3.4)
+    uint32_t wait_ms = http->hls_updated ? http->hls_target_ms : http->hls_target_ms / 2;
+    if (wait_ms < HTTP_PREFETCH_RETRY_MS) {
+        wait_ms = HTTP_PREFETCH_RETRY_MS;
+    }
+    TickType_t due = http->hls_load_tick + wait_ms / portTICK_PERIOD_MS;
+    TickType_t now = xTaskGetTickCount();
+    while (prefetch->stop == false && (int32_t)(due - now) > 0) {
+        xEventGroupWaitBits(prefetch->sync, HTTP_PREFETCH_RESUME_BIT, pdTRUE, pdFALSE, due - now);
+        now = xTaskGetTickCount();
+    }
+    if (prefetch->stop) {
+        return ESP_FAIL;
+    }
+    http->hls_load_tick = now;
+    if (_hls_connect(http, http->playlist->host_uri) != ESP_OK) {
+        http->hls_updated = false;
+        return ESP_FAIL;
+    }
+    ESP_LOGD(TAG, "Reload live playlist %s", http->playlist->host_uri);
+    return _hls_load_media(http, http->playlist, &http->hls_next_seq);
+}
+
+static esp_err_t _prefetch_next_track(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    http_stream_prefetch_t *prefetch = http->prefetch;
+    if (http->hls_key) {
+        // Decryption must see where each segment ends, the element task connects the next one
+        return ESP_FAIL;
+    }
+    // HLS segments are chained so that the next one downloads while the current one plays
+    if (http->is_hls == false) {
+        return http->auto_connect_next_track ? http_stream_auto_connect_next_track(self) : ESP_FAIL;
+    }
+    _prefetch_update_throughput(prefetch);
+    _hls_switch_variant(self);
+    int fails = 0;
+    while (prefetch->stop == false) {
+        if (http_stream_auto_connect_next_track(self) == ESP_OK) {
+            return ESP_OK;
+        }
+        if (http->playlist->is_incomplete == false) {
+            break;
+        }
+        // Live playlist runs out of segments, fetch new ones on the target duration timer
+        if (_hls_reload(self) == ESP_OK) {
+            fails = 0;
+        } else if (++fails >= HTTP_MAX_CONNECT_TIMES) {
+            break;
+        }
+    }
+    return ESP_FAIL;
+}
+
+static bool _prefetch_next(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    http_stream_prefetch_t *prefetch = http->prefetch;
+    if (http->request_range_size && http->is_last_range == false) {
+        return _prefetch_load(self, prefetch->fetch_pos) == ESP_OK;
+    }
+    int err = esp_http_client_get_errno(http->client);
+    if (err == 0) {
+        if (_prefetch_next_track(self) == ESP_OK) {
+            prefetch->fetch_pos = 0;
+            return true;
+        }
+        return false;
+    }
+    // Resume from the last fetched byte, what is cached stays valid
+    for (int i = 1; i <= HTTP_MAX_CONNECT_TIMES && prefetch->stop == false; i++) {
+        ESP_LOGW(TAG, "Got %d errno(%s), reconnect from %lld, times:%d", err, strerror(err), prefetch->fetch_pos, i);
+        _prefetch_hook(self, HTTP_STREAM_PREFETCH_RECONNECT);
+        if (_prefetch_load(self, prefetch->fetch_pos) == ESP_OK) {
+            return true;
+        }
+        vTaskDelay(i * HTTP_PREFETCH_RETRY_MS / portTICK_PERIOD_MS);
+    }
+    prefetch->error = err;
+    return false;
+}
+
+static void _prefetch_task(void *pv)
+{
+    audio_element_handle_t self = (audio_element_handle_t)pv;
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    http_stream_prefetch_t *prefetch = http->prefetch;
+    ESP_LOGD(TAG, "Prefetch task start from %lld", prefetch->fetch_pos);
+    while (prefetch->stop == false) {
+        char *buf = NULL;
+        int n = rb_acquire_write(prefetch->rb, &buf, HTTP_PREFETCH_CHUNK_SIZE, portMAX_DELAY);
+        if (n <= 0) {
+            break;
+        }
+        int64_t start = esp_timer_get_time();
+        int rlen = _http_read_data(http, buf, n);
+        prefetch->rx_us += esp_timer_get_time() - start;
+        rb_commit_write(prefetch->rb, rlen > 0 ? rlen : 0);
+        if (rlen <= 0) {
+            if (prefetch->stop || _prefetch_next(self) == false) {
+                break;
+            }
+            continue;
+        }
+        prefetch->fetch_pos += rlen;
+        prefetch->rx_bytes += rlen;
+        int filled = rb_bytes_filled(prefetch->rb);
+        if (prefetch->buffering && filled >= prefetch->low_water) {
+            xEventGroupSetBits(prefetch->sync, HTTP_PREFETCH_DATA_BIT);
+        }
+        if (filled < prefetch->high_water) {
+            continue;
+        }
+        // Cache is full enough, sleep until the reader drains it under the low watermark
+        _prefetch_hook(self, HTTP_STREAM_PREFETCH_FULL);
+        prefetch->paused = true;
+        while (prefetch->stop == false && rb_bytes_filled(prefetch->rb) >= prefetch->low_water) {
+            xEventGroupWaitBits(prefetch->sync, HTTP_PREFETCH_RESUME_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
+        }
+        prefetch->paused = false;
+    }
+    ESP_LOGD(TAG, "Prefetch task exit at %lld, errno:%d", prefetch->fetch_pos, prefetch->error);
+    prefetch->done = true;
+    rb_done_write(prefetch->rb);
+    xEventGroupSetBits(prefetch->sync, HTTP_PREFETCH_DATA_BIT | HTTP_PREFETCH_EXIT_BIT);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t _prefetch_start(audio_element_handle_t self, int64_t pos)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    http_stream_prefetch_t *prefetch = http->prefetch;
+    rb_reset(prefetch->rb);
+    xEventGroupClearBits(prefetch->sync, HTTP_PREFETCH_DATA_BIT | HTTP_PREFETCH_RESUME_BIT | HTTP_PREFETCH_EXIT_BIT);
+    prefetch->fetch_pos = pos;
+    prefetch->stop = false;
+    prefetch->done = false;
+    prefetch->paused = false;
+    prefetch->buffering = true;
+    prefetch->error = 0;
+    if (audio_thread_create(NULL, "http_prefetch", _prefetch_task, self, http->task_stack,
+                            http->task_prio, http->stack_in_ext, http->task_core) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create prefetch task");
+        return ESP_FAIL;
+    }
+    prefetch->running = true;
+    return ESP_OK;
+}
+
+static void _prefetch_stop(http_stream_t *http)
+{
+    http_stream_prefetch_t *prefetch = http->prefetch;
+    if (prefetch == NULL || prefetch->running == false) {
+        return;
+    }
+    prefetch->stop = true;
+    rb_abort(prefetch->rb);
+    xEventGroupSetBits(prefetch->sync, HTTP_PREFETCH_RESUME_BIT);
+    if (prefetch->done == false) {
+        // Unblock a socket read of the fetch task instead of waiting for the network timeout,
+        // the connection is left unfinished so it is not kept alive
+#if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0))
+        esp_http_client_cancel_request(http->client);
+#else
+        esp_http_client_close(http->client);
+#endif
+    }
+    xEventGroupWaitBits(prefetch->sync, HTTP_PREFETCH_EXIT_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
+    prefetch->running = false;
+}
+
+static void _prefetch_check_drained(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    http_stream_prefetch_t *prefetch = http->prefetch;
+    if (prefetch->buffering == false && prefetch->done == false && rb_bytes_filled(prefetch->rb) == 0) {
+        prefetch->buffering = true;
+        _prefetch_hook(self, HTTP_STREAM_PREFETCH_BUFFERING);
+    }
+}
+
+static int _prefetch_read(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    http_stream_prefetch_t *prefetch = http->prefetch;
+    TickType_t start = xTaskGetTickCount();
+    int rlen = 0;
+    _prefetch_check_drained(self);
+    while (rlen <= 0) {
+        while (prefetch->buffering) {
+            if (prefetch->done || rb_bytes_filled(prefetch->rb) >= prefetch->low_water) {
+                prefetch->buffering = false;
+                _prefetch_hook(self, HTTP_STREAM_PREFETCH_READY);
+                break;
+            }
+            if (audio_element_is_stopping(self)) {
+                return AEL_IO_ABORT;
+            }
+            TickType_t wait = HTTP_PREFETCH_WAIT_MS / portTICK_PERIOD_MS;
+            if (ticks_to_wait != portMAX_DELAY) {
+                TickType_t waited = xTaskGetTickCount() - start;
+                if (waited >= ticks_to_wait) {
+                    return AEL_IO_TIMEOUT;
+                }
+                if (ticks_to_wait - waited < wait) {
+                    wait = ticks_to_wait - waited;
+                }
+            }
+            xEventGroupWaitBits(prefetch->sync, HTTP_PREFETCH_DATA_BIT, pdTRUE, pdFALSE, wait);
+        }
+        // Hand over what is cached rather than waiting for `len` bytes
+        rlen = rb_read(prefetch->rb, buffer, len, 0);
+        if (rlen == RB_DONE) {
+            rlen = 0;
+            break;
+        }
+        if (rlen == RB_ABORT || rlen == RB_FAIL) {
+            return AEL_IO_ABORT;
+        }
+        // Less than a word cached, buffer again
+        if (prefetch->done == false) {
+            prefetch->buffering = true;
+            _prefetch_hook(self, HTTP_STREAM_PREFETCH_BUFFERING);
+        }
+    }
+    if (prefetch->paused && rb_bytes_filled(prefetch->rb) < prefetch->low_water) {
+        xEventGroupSetBits(prefetch->sync, HTTP_PREFETCH_RESUME_BIT);
+    }
+    // Report the underrun as soon as this read drains the cache
+    _prefetch_check_drained(self);
+    return rlen;
 }
 
 static esp_err_t _http_open(audio_element_handle_t self)
@@ -545,6 +1049,8 @@ static esp_err_t _http_open(audio_element_handle_t self)
         ESP_LOGE(TAG, "already opened");
         return ESP_OK;
     }
+    // Moving to next track reopens without close, the fetch task must not use the client meanwhile
+    _prefetch_stop(http);
     http->_errno = 0;
     audio_element_getinfo(self, &info);
 _stream_open_begin:
@@ -589,7 +1095,7 @@ _stream_open_begin:
 #endif //  (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0)) && defined CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
             .user_agent = http->user_agent,
         };
-        http->client = esp_http_client_init(&http_cfg);
+        http->client = http_conn_pool_acquire(&http_cfg, &http->conn_reused);
         AUDIO_MEM_CHECK(TAG, http->client, return ESP_ERR_NO_MEM);
     } else {
         esp_http_client_set_url(http->client, uri);
@@ -629,6 +1135,9 @@ _stream_open_begin:
             }
         }
     }
+    if (http->prefetch && _prefetch_start(self, info.byte_pos) != ESP_OK) {
+        return ESP_FAIL;
+    }
     http->is_open = true;
     audio_element_report_codec_fmt(self);
     return ESP_OK;
@@ -638,6 +1147,7 @@ static esp_err_t _http_close(audio_element_handle_t self)
 {
     http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
     ESP_LOGD(TAG, "_http_close");
+    _prefetch_stop(http);
     if (http->is_open) {
         http->is_open = false;
         do {
@@ -656,8 +1166,14 @@ static esp_err_t _http_close(audio_element_handle_t self)
 
     if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
         if (http->enable_playlist_parser) {
+            _playlist_lock(http);
             http_playlist_clear(http->playlist);
             http->is_playlist_resolved = false;
+            _playlist_unlock(http);
+        }
+        if (http->hls_master) {
+            hls_playlist_close(http->hls_master);
+            http->hls_master = NULL;
         }
         audio_element_report_pos(self);
         audio_element_set_byte_pos(self, 0);
@@ -672,9 +1188,10 @@ static esp_err_t _http_close(audio_element_handle_t self)
         http->gzip = NULL;
     }
     if (http->client) {
-        esp_http_client_close(http->client);
-        esp_http_client_cleanup(http->client);
+        // Give the connection back so that next track from the same server skips connection setup
+        http_conn_pool_release(http->client, http->_errno == 0);
         http->client = NULL;
+        http->conn_reused = false;
     }
     return ESP_OK;
 }
@@ -704,6 +1221,131 @@ static bool _check_range_done(audio_element_handle_t self)
     return last_range;
 }
 
+static int _http_fetch(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    if (http->prefetch) {
+        // Range, reconnect and next track are handled by the fetch task
+        return _prefetch_read(self, buffer, len, ticks_to_wait);
+    }
+    int rlen = _http_read_data(http, buffer, len);
+    if (rlen <= 0 && http->request_range_size) {
+        if (_check_range_done(self) == false) {
+            rlen = _http_read_data(http, buffer, len);
+        }
+    }
+    return rlen;
+}
+
+static int _hls_pkcs7_padding(const uint8_t *data, int len)
+{
+    if (len < HLS_AES_BLOCK_SIZE) {
+        return 0;
+    }
+    uint8_t padding = data[len - 1];
+    if (padding == 0 || padding > HLS_AES_BLOCK_SIZE) {
+        ESP_LOGW(TAG, "Invalid PKCS#7 padding %d, keep it", padding);
+        return 0;
+    }
+    for (int i = len - padding; i < len - 1; i++) {
+        if (data[i] != padding) {
+            ESP_LOGW(TAG, "Invalid PKCS#7 padding %d, keep it", padding);
+            return 0;
+        }
+    }
+    return padding;
+}
+
+static int _hls_decrypt_batch(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    http_stream_hls_key_t *hls_key = http->hls_key;
+    if (hls_key->segment_end) {
+        return 0;
+    }
+    // Last block of previous batch is kept encrypted until it is known whether it ends the segment
+    int keep = hls_key->crypt_len - hls_key->plain_len;
+    if (keep) {
+        memmove(hls_key->crypt_buf, hls_key->crypt_buf + hls_key->plain_len, keep);
+    }
+    hls_key->crypt_len = keep;
+    hls_key->plain_pos = 0;
+    hls_key->plain_len = 0;
+    int rlen = 0;
+    while (hls_key->crypt_len < HLS_DECRYPT_BATCH_SIZE) {
+        rlen = _http_fetch(self, (char *)hls_key->crypt_buf + hls_key->crypt_len, HLS_DECRYPT_BATCH_SIZE - hls_key->crypt_len, portMAX_DELAY);
+        if (rlen <= 0) {
+            break;
+        }
+        hls_key->crypt_len += rlen;
+    }
+    if (rlen == AEL_IO_ABORT) {
+        return rlen;
+    }
+    bool end = (hls_key->crypt_len < HLS_DECRYPT_BATCH_SIZE);
+    if (end) {
+        int err = http->prefetch ? http->prefetch->error : esp_http_client_get_errno(http->client);
+        if (err != 0) {
+            return rlen < 0 ? rlen : 0;
+        }
+        if (hls_key->crypt_len % HLS_AES_BLOCK_SIZE) {
+            ESP_LOGE(TAG, "Segment ends with %d bytes of partial block, drop them", hls_key->crypt_len % HLS_AES_BLOCK_SIZE);
+            hls_key->crypt_len -= hls_key->crypt_len % HLS_AES_BLOCK_SIZE;
+        }
+    }
+    int n = end ? hls_key->crypt_len : hls_key->crypt_len - HLS_AES_BLOCK_SIZE;
+    if (n > 0) {
+        // IV is updated to the last ciphertext block, next batch continues the CBC chain
+        int ret = esp_aes_crypt_cbc(&hls_key->aes_ctx, ESP_AES_DECRYPT, n, (unsigned char *)hls_key->key.iv,
+                                    hls_key->crypt_buf, hls_key->crypt_buf);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "Fail to decrypt aes ret %d", ret);
+            return ESP_FAIL;
+        }
+    }
+    hls_key->plain_len = n;
+    if (end) {
+        // Padding only exists at the true end of segment
+        hls_key->plain_len -= _hls_pkcs7_padding(hls_key->crypt_buf, n);
+        hls_key->crypt_len = hls_key->plain_len;
+        hls_key->segment_end = true;
+    }
+    return hls_key->plain_len;
+}
+
+static int _hls_decrypt_read(audio_element_handle_t self, char *buffer, int len)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    http_stream_hls_key_t *hls_key = http->hls_key;
+    if (hls_key->plain_pos >= hls_key->plain_len) {
+        int ret = _hls_decrypt_batch(self);
+        if (ret <= 0) {
+            return ret;
+        }
+    }
+    int n = hls_key->plain_len - hls_key->plain_pos;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(buffer, hls_key->crypt_buf + hls_key->plain_pos, n);
+    hls_key->plain_pos += n;
+    return n;
+}
+
+static esp_err_t _http_connect_next_track(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    if (http->hls_key == NULL) {
+        return http_stream_auto_connect_next_track(self);
+    }
+    // Each encrypted segment starts a new CBC chain, the fetch task of last segment has finished
+    _prefetch_stop(http);
+    if (http_stream_auto_connect_next_track(self) != ESP_OK || _prepare_crypt(http) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return http->prefetch ? _prefetch_start(self, 0) : ESP_OK;
+}
+
 static int _http_read(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
 {
     http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
@@ -712,26 +1354,25 @@ static int _http_read(audio_element_handle_t self, char *buffer, int len, TickTy
     int wrlen = dispatch_hook(self, HTTP_STREAM_ON_RESPONSE, buffer, len);
     int rlen = wrlen;
     if (rlen == 0) {
-        rlen = _http_read_data(http, buffer, len);
+        // Decryption in the element task overlaps with the download in the fetch task
+        rlen = http->hls_key ? _hls_decrypt_read(self, buffer, len) : _http_fetch(self, buffer, len, ticks_to_wait);
     }
-    if (rlen <= 0 && http->request_range_size) {
-        if (_check_range_done(self) == false) {
-            rlen = _http_read_data(http, buffer, len);
-        }
+    if (rlen == AEL_IO_ABORT || rlen == AEL_IO_TIMEOUT) {
+        return rlen;
     }
-    if (rlen <= 0 && http->auto_connect_next_track) {
-        if (http_stream_auto_connect_next_track(self) == ESP_OK) {
-            rlen = _http_read_data(http, buffer, len);
+    if (rlen <= 0 && http->auto_connect_next_track && (http->prefetch == NULL || http->hls_key)) {
+        if (_http_connect_next_track(self) == ESP_OK) {
+            rlen = http->hls_key ? _hls_decrypt_read(self, buffer, len) : _http_fetch(self, buffer, len, ticks_to_wait);
         }
     }
     if (rlen <= 0) {
-        http->_errno = esp_http_client_get_errno(http->client);
+        http->_errno = http->prefetch ? http->prefetch->error : esp_http_client_get_errno(http->client);
         ESP_LOGW(TAG, "No more data,errno:%d, total_bytes:%llu, rlen = %d", http->_errno, info.byte_pos, rlen);
         if (http->_errno != 0) {  // Error occuered, reset connection
             ESP_LOGW(TAG, "Got %d errno(%s)", http->_errno, strerror(http->_errno));
             return http->_errno;
         }
-        if (http->auto_connect_next_track) {
+        if (http->auto_connect_next_track || (http->prefetch && http->is_hls && http->hls_key == NULL)) {
             if (dispatch_hook(self, HTTP_STREAM_FINISH_PLAYLIST, NULL, 0) != ESP_OK) {
                 ESP_LOGE(TAG, "Failed to process user callback");
                 return ESP_FAIL;
@@ -744,36 +1385,6 @@ static int _http_read(audio_element_handle_t self, char *buffer, int len, TickTy
         }
         return ESP_OK;
     } else {
-        if (http->hls_key) {
-            int ret = esp_aes_crypt_cbc(&http->hls_key->aes_ctx, ESP_AES_DECRYPT, 
-                 rlen, (unsigned char*)http->hls_key->key.iv, 
-                 (unsigned char*)buffer, (unsigned char*)buffer);
-            if (rlen % 16 != 0) {
-                ESP_LOGE(TAG, "Data length %d not aligned", rlen);
-            }
-            if (ret != 0) {
-                ESP_LOGE(TAG, "Fail to decrypt aes ret %d", ret);
-                return ESP_FAIL;
-            }
-            if ((info.total_bytes && rlen + info.byte_pos >= info.total_bytes) ||
-                rlen < len) {
-                // Remove padding according PKCS#7
-                uint8_t padding = buffer[rlen-1];
-                if (padding && padding <= rlen) {
-                    int idx = rlen - padding;
-                    int paddin_n = padding -1;
-                    while (paddin_n) {
-                        if (buffer[idx++] != padding) {
-                            break;
-                        }
-                        paddin_n--;
-                    }
-                    if (paddin_n == 0) {
-                        rlen -= padding;
-                    }
-                }
-            }
-        }
         audio_element_update_byte_pos(self, rlen);
     }
     ESP_LOGD(TAG, "req lengh=%d, read=%d, pos=%d/%d", len, rlen, (int)info.byte_pos, (int)info.total_bytes);
@@ -834,9 +1445,32 @@ static int _http_process(audio_element_handle_t self, char *in_buffer, int in_le
     return w_size;
 }
 
+static void _http_prefetch_free(http_stream_t *http)
+{
+    if (http->prefetch == NULL) {
+        return;
+    }
+    if (http->prefetch->rb) {
+        rb_destroy(http->prefetch->rb);
+    }
+    if (http->prefetch->sync) {
+        vEventGroupDelete(http->prefetch->sync);
+    }
+    if (http->prefetch->lock) {
+        mutex_destroy(http->prefetch->lock);
+    }
+    audio_free(http->prefetch);
+    http->prefetch = NULL;
+}
+
 static esp_err_t _http_destroy(audio_element_handle_t self)
 {
     http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    _http_prefetch_free(http);
+    http_conn_pool_drop(self);
+    if (http->hls_master) {
+        hls_playlist_close(http->hls_master);
+    }
     if (http->playlist) {
         audio_free(http->playlist->data);
         audio_free(http->playlist);
@@ -873,6 +1507,10 @@ audio_element_handle_t http_stream_init(http_stream_cfg_t *config)
     http->user_data = config->user_data;
     http->cert_pem = config->cert_pem;
     http->user_agent = config->user_agent;
+    http->task_stack = config->task_stack;
+    http->task_prio = config->task_prio;
+    http->task_core = config->task_core;
+    http->stack_in_ext = config->stack_in_ext;
 
     if (config->crt_bundle_attach) {
 #if  (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0))
@@ -901,6 +1539,28 @@ audio_element_handle_t http_stream_init(http_stream_cfg_t *config)
         STAILQ_INIT(&http->playlist->tracks);
     }
 
+    if (config->type == AUDIO_STREAM_READER && config->prefetch_size > 0) {
+        http->prefetch = audio_calloc(1, sizeof(http_stream_prefetch_t));
+        AUDIO_MEM_CHECK(TAG, http->prefetch, goto _prefetch_failed);
+        http->prefetch->high_water = config->prefetch_high_water;
+        http->prefetch->low_water = config->prefetch_low_water;
+        if (http->prefetch->high_water <= 0 || http->prefetch->high_water > config->prefetch_size) {
+            http->prefetch->high_water = config->prefetch_size * 3 / 4;
+        }
+        if (http->prefetch->low_water <= 0 || http->prefetch->low_water >= http->prefetch->high_water) {
+            http->prefetch->low_water = http->prefetch->high_water / 3;
+        }
+        // The cache is only touched by the fetch task and the element task
+        http->prefetch->rb = rb_create_spsc(config->prefetch_size, 1);
+        AUDIO_MEM_CHECK(TAG, http->prefetch->rb, goto _prefetch_failed);
+        http->prefetch->sync = xEventGroupCreate();
+        AUDIO_MEM_CHECK(TAG, http->prefetch->sync, goto _prefetch_failed);
+        http->prefetch->lock = mutex_create();
+        AUDIO_MEM_CHECK(TAG, http->prefetch->lock, goto _prefetch_failed);
+        ESP_LOGI(TAG, "Read-ahead cache %d bytes, watermark %d/%d", config->prefetch_size,
+                 http->prefetch->low_water, http->prefetch->high_water);
+    }
+
     if (config->type == AUDIO_STREAM_READER) {
         cfg.read = _http_read;
     } else if (config->type == AUDIO_STREAM_WRITER) {
@@ -912,13 +1572,17 @@ audio_element_handle_t http_stream_init(http_stream_cfg_t *config)
     }
 
     el = audio_element_init(&cfg);
-    AUDIO_MEM_CHECK(TAG, el, {
-        audio_free(http->playlist);
-        audio_free(http);
-        return NULL;
-    });
+    AUDIO_MEM_CHECK(TAG, el, goto _prefetch_failed);
     audio_element_setdata(el, http);
     return el;
+_prefetch_failed:
+    _http_prefetch_free(http);
+    if (http->playlist) {
+        audio_free(http->playlist->data);
+        audio_free(http->playlist);
+    }
+    audio_free(http);
+    return NULL;
 }
 
 esp_err_t http_stream_next_track(audio_element_handle_t el)
@@ -974,15 +1638,19 @@ redirection:
 esp_err_t http_stream_fetch_again(audio_element_handle_t el)
 {
     http_stream_t *http = (http_stream_t *)audio_element_getdata(el);
+    esp_err_t ret = ESP_OK;
+    // The fetch task may be switching variant or reloading the live playlist
+    _playlist_lock(http);
     if (!http->playlist->is_incomplete) {
         ESP_LOGI(TAG, "Finished playing.");
-        return ESP_ERR_NOT_SUPPORTED;
+        ret = ESP_ERR_NOT_SUPPORTED;
     } else {
         ESP_LOGI(TAG, "Fetching again %s %p", http->playlist->host_uri, http->playlist->host_uri);
         audio_element_set_uri(el, http->playlist->host_uri);
         http->is_playlist_resolved = false;
     }
-    return ESP_OK;
+    _playlist_unlock(http);
+    return ret;
 }
 
 esp_err_t http_stream_restart(audio_element_handle_t el)
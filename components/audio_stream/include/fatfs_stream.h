@@ -45,6 +45,13 @@ typedef struct {
     int                     task_prio;      /*!< Task priority (based on freeRTOS priority) */
     bool                    ext_stack;      /*!< Allocate stack on extern ram */
     bool                    write_header;   /*!< Choose to write amrnb/amrwb header in fatfs whether or not (true or false, true means choose to write amrnb header) */
+    int                     write_cache_size;   /*!< Size of write-behind cache for writer (in PSRAM if enabled), 0 to write and fsync on every write */
+    int                     write_block_size;   /*!< Size of each write to file with write-behind cache, set it to the cluster size of FAT */
+    int                     sync_interval_ms;   /*!< Max time that written data stays in cache before fsync, 0 to sync only on close */
+    int                     sync_bytes;         /*!< Call fsync after this amount of data is written, 0 to disable */
+    int                     prealloc_size;      /*!< Bytes to preallocate for writer with write-behind cache, 0 to disable */
+    int                     read_block_size;    /*!< Size of each read from file with read-ahead, 0 to read on element task */
+    int                     read_block_num;     /*!< Number of read-ahead blocks, one is returned while the others are read */
 } fatfs_stream_cfg_t;
 
 
@@ -53,6 +60,11 @@ typedef struct {
 #define FATFS_STREAM_TASK_CORE           (0)
 #define FATFS_STREAM_TASK_PRIO           (4)
 #define FATFS_STREAM_RINGBUFFER_SIZE     (8 * 1024)
+#define FATFS_STREAM_WRITE_BLOCK_SIZE    (32 * 1024)
+#define FATFS_STREAM_SYNC_INTERVAL_MS    (2000)
+#define FATFS_STREAM_CACHE_TASK_STACK    (3072)
+#define FATFS_STREAM_READ_BLOCK_SIZE     (32 * 1024)
+#define FATFS_STREAM_READ_BLOCK_NUM      (2)
 
 #define FATFS_STREAM_CFG_DEFAULT() {             \
     .type = AUDIO_STREAM_NONE,                   \
@@ -63,6 +75,13 @@ typedef struct {
     .task_prio = FATFS_STREAM_TASK_PRIO,         \
     .ext_stack = false,                          \
     .write_header = true,                        \
+    .write_cache_size = 0,                       \
+    .write_block_size = FATFS_STREAM_WRITE_BLOCK_SIZE, \
+    .sync_interval_ms = FATFS_STREAM_SYNC_INTERVAL_MS, \
+    .sync_bytes = 0,                             \
+    .prealloc_size = 0,                          \
+    .read_block_size = 0,                        \
+    .read_block_num = FATFS_STREAM_READ_BLOCK_NUM, \
 }
 
 /**
@@ -70,6 +89,13 @@ typedef struct {
  *             or get data from other elements written to FatFs, depending on the configuration
  *             the stream type, either AUDIO_STREAM_READER or AUDIO_STREAM_WRITER.
  *
+ * @note       With `write_cache_size` set, the writer copies data to a cache and a flush task writes it
+ *             to file in `write_block_size` pieces, fsync is called every `sync_interval_ms` or `sync_bytes`
+ *             instead of after every write. The WAV header is patched on close.
+ *
+ * @note       With `read_block_size` set, the reader gets data from blocks that a helper task reads ahead
+ *             from `read_block_size` aligned positions of file, seeking through `byte_pos` drops the blocks.
+ *
  * @param      config  The configuration
  *
  * @return     The Audio Element handle
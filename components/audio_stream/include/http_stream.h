@@ -53,6 +53,11 @@ typedef enum {
     HTTP_STREAM_RESOLVE_ALL_TRACKS,
     HTTP_STREAM_FINISH_TRACK,
     HTTP_STREAM_FINISH_PLAYLIST,
+    HTTP_STREAM_PREFETCH_BUFFERING, /*!< The read-ahead cache ran empty, reads wait until it refills to the low watermark.
+                                     * `buffer_len` is the number of cached bytes for all the prefetch events */
+    HTTP_STREAM_PREFETCH_READY,     /*!< The read-ahead cache reached the low watermark (or the stream end) after buffering */
+    HTTP_STREAM_PREFETCH_FULL,      /*!< The read-ahead cache reached the high watermark, fetching pauses until it drains under the low watermark */
+    HTTP_STREAM_PREFETCH_RECONNECT, /*!< The connection broke, the fetch task reconnects with a `Range` request from the last fetched byte */
 } http_stream_event_id_t;
 
 /**
@@ -95,6 +100,12 @@ typedef struct {
                                                              Request full range of resource if set to 0
                                                              Range size bigger than request size is recommended */
     const char                  *user_agent;            /*!< The User Agent string to send with HTTP requests */
+    int                         prefetch_size;          /*!< Size of the read-ahead cache of a reader, disabled if set to 0
+                                                             A fetch task with the same stack, priority and core as the element fills the cache ahead of the reads,
+                                                             the cache is allocated with `audio_calloc`, so it resides in PSRAM when SPIRAM is enabled */
+    int                         prefetch_high_water;    /*!< Cached bytes at which fetching pauses, defaults to 3/4 of `prefetch_size` if set to 0 */
+    int                         prefetch_low_water;     /*!< Cached bytes at which fetching resumes, and reads start again after the cache ran empty.
+                                                             Defaults to 1/3 of `prefetch_high_water` if set to 0 */
 } http_stream_cfg_t;
 
 #define HTTP_STREAM_TASK_STACK          (6 * 1024)
@@ -124,6 +135,19 @@ typedef struct {
  *             or get data from other elements sent to HTTP, depending on the configuration
  *             the stream type, either AUDIO_STREAM_READER or AUDIO_STREAM_WRITER.
  *
+ * @note       With `prefetch_size` set, the network is read by a dedicated fetch task, the request events of a reconnect
+ *             and the prefetch events can be dispatched from that task.
+ *             A broken connection is resumed from the last fetched byte without dropping the cached data.
+ *             Stopping the element waits for the pending socket read of the fetch task to return.
+ *             For a clear HLS stream, the fetch task chains the segments on the same keep-alive connection,
+ *             so the following segments are downloaded while the current one plays, size the cache to hold about two segments.
+ *             A live media playlist is reloaded on its target duration timer when the queued segments run out,
+ *             and the variant of a master playlist is selected again by the measured throughput at segment boundaries.
+ *             `HTTP_STREAM_FINISH_PLAYLIST` is reported when the fetch task runs out of segments.
+ *             AES-128 encrypted HLS segments are decrypted by the element task in batches of whole blocks,
+ *             so decryption overlaps with the download of the fetch task, each segment ends its own fetch task
+ *             and `auto_connect_next_track` lets the element continue with the next segment.
+ *
  * @param      config  The configuration
  *
  * @return     The Audio Element handle
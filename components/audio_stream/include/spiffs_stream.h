@@ -44,6 +44,8 @@ typedef struct {
     int                     task_core;      /*!< Task running in core (0 or 1) */
     int                     task_prio;      /*!< Task priority (based on freeRTOS priority) */
     bool                    write_header;   /*!< Choose to write amrnb/armwb header in spiffs whether or not (true or false, true means choose to write amrnb header) */
+    int                     read_block_size;    /*!< Size of each read from file with read-ahead, 0 to read on element task */
+    int                     read_block_num;     /*!< Number of read-ahead blocks, one is returned while the others are read */
 } spiffs_stream_cfg_t;
 
 #define SPIFFS_STREAM_BUF_SIZE            (4096)
@@ -51,6 +53,9 @@ typedef struct {
 #define SPIFFS_STREAM_TASK_CORE           (0)
 #define SPIFFS_STREAM_TASK_PRIO           (4)
 #define SPIFFS_STREAM_RINGBUFFER_SIZE     (8 * 1024)
+#define SPIFFS_STREAM_READ_BLOCK_SIZE     (8 * 1024)
+#define SPIFFS_STREAM_READ_BLOCK_NUM      (2)
+#define SPIFFS_STREAM_CACHE_TASK_STACK    (3072)
 
 #define SPIFFS_STREAM_CFG_DEFAULT() {             \
     .type = AUDIO_STREAM_NONE,                    \
@@ -60,6 +65,8 @@ typedef struct {
     .task_core = SPIFFS_STREAM_TASK_CORE,         \
     .task_prio = SPIFFS_STREAM_TASK_PRIO,         \
     .write_header = true,                         \
+    .read_block_size = 0,                         \
+    .read_block_num = SPIFFS_STREAM_READ_BLOCK_NUM, \
 }
 
 /**
@@ -67,6 +74,9 @@ typedef struct {
  *             or get data from other elements written to SPIFFS, depending on the configuration
  *             the stream type, either AUDIO_STREAM_READER or AUDIO_STREAM_WRITER.
  *
+ * @note       With `read_block_size` set, the reader gets data from blocks that a helper task reads ahead
+ *             from `read_block_size` aligned positions of file, seeking through `byte_pos` drops the blocks.
+ *
  * @param      config The configuration
  *
  * @return     The Audio Element handle
@@ -46,6 +46,8 @@ typedef struct
     const char *label;        /*!< Label of tone stored in flash. The default value is `flash_tone`*/
     bool extern_stack;        /*!< Task stack allocate on the extern ram */
     bool use_delegate;        /*!< Read tone partition with esp_delegate. If task stack is on extern ram, this MUST be TRUE */
+    bool use_mmap;            /*!< Keep the tone partition mapped while the element exists and output the mapped flash directly,
+                                   without copying it into the element buffer or reading it through the delegate */
 } tone_stream_cfg_t;
 
 #define TONE_STREAM_BUF_SIZE        (4096)
@@ -55,6 +57,7 @@ typedef struct
 #define TONE_STREAM_RINGBUFFER_SIZE (2 * 1024)
 #define TONE_STREAM_EXT_STACK       (false)
 #define TONE_STREAM_USE_DELEGATE    (false)
+#define TONE_STREAM_USE_MMAP        (true)
 
 #define TONE_STREAM_CFG_DEFAULT()               \
 {                                               \
@@ -67,6 +70,7 @@ typedef struct
     .label        = "flash_tone",               \
     .extern_stack = TONE_STREAM_EXT_STACK,      \
     .use_delegate = TONE_STREAM_USE_DELEGATE,   \
+    .use_mmap     = TONE_STREAM_USE_MMAP,       \
 }
 
 /**
@@ -0,0 +1,550 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_mem.h"
+#include "audio_error.h"
+#include "audio_thread.h"
+#include "file_cache.h"
+
+#define FILE_CACHE_DATA_BIT         BIT(0)
+#define FILE_CACHE_SPACE_BIT        BIT(1)
+#define FILE_CACHE_FLUSHED_BIT      BIT(2)
+#define FILE_CACHE_EXIT_BIT         BIT(3)
+
+typedef enum {
+    READ_BLOCK_EMPTY,
+    READ_BLOCK_FILLING,
+    READ_BLOCK_READY,
+} read_block_state_t;
+
+static const char *TAG = "FILE_CACHE";
+
+struct file_write_cache {
+    int                 fd;
+    char                *buf;
+    int                 size;
+    int                 block_size;
+    off_t               start;          /* File position of the first cached byte */
+    int64_t             wr_total;       /* Bytes copied into cache */
+    int64_t             rd_total;       /* Bytes written to file */
+    int64_t             synced;         /* Bytes written to file at last fsync */
+    int64_t             sync_time;
+    int                 sync_interval_ms;
+    int                 sync_bytes;
+    bool                prealloc;
+    SemaphoreHandle_t   lock;
+    EventGroupHandle_t  sync;
+    volatile bool       flush;
+    volatile bool       stop;
+    volatile int        error;          /* errno of the failed write, the cache refuses data after that */
+    file_write_cache_info_t info;
+};
+
+typedef struct {
+    char                *data;
+    int64_t             offset;         /* File position of the first byte in block */
+    int                 len;            /* Valid bytes, less than block size only at end of file */
+    read_block_state_t  state;
+} file_read_block_t;
+
+struct file_read_cache {
+    int                 fd;
+    int                 block_size;
+    int                 block_num;
+    file_read_block_t   *blocks;
+    int64_t             rd_pos;         /* Position of the next byte to return */
+    int64_t             fill_pos;       /* Position of the next block to read from file */
+    bool                fill_end;       /* End of file reached, nothing more to read until seek */
+    uint32_t            generation;     /* Increased on seek, read of older generation is dropped */
+    SemaphoreHandle_t   lock;
+    EventGroupHandle_t  sync;
+    volatile bool       stop;
+    volatile int        error;
+};
+
+static int _write_cache_sync(struct file_write_cache *cache)
+{
+    int64_t start = esp_timer_get_time();
+    if (fsync(cache->fd) != 0) {
+        ESP_LOGE(TAG, "Failed to sync file, %s", strerror(errno));
+        return -1;
+    }
+    int used = (int)(esp_timer_get_time() - start);
+    if (used > cache->info.max_write_us) {
+        cache->info.max_write_us = used;
+    }
+    cache->info.sync_count++;
+    cache->synced = cache->rd_total;
+    cache->sync_time = esp_timer_get_time();
+    return 0;
+}
+
+/*
+ * Write the cached data in pieces ending on `block_size` boundary of file,
+ * the last piece which does not fill a block is only written on flush.
+ */
+static int _write_cache_drain(struct file_write_cache *cache, bool all)
+{
+    while (!cache->error) {
+        xSemaphoreTake(cache->lock, portMAX_DELAY);
+        int filled = cache->wr_total - cache->rd_total;
+        xSemaphoreGive(cache->lock);
+
+        int rd_pos = cache->rd_total % cache->size;
+        int block_left = cache->block_size - (cache->start + cache->rd_total) % cache->block_size;
+        int len = block_left;
+        if (len > cache->size - rd_pos) {
+            len = cache->size - rd_pos;
+        }
+        if (filled < len) {
+            if (!all || filled == 0) {
+                return 0;
+            }
+            len = filled;
+        }
+        int64_t start = esp_timer_get_time();
+        int wlen = write(cache->fd, cache->buf + rd_pos, len);
+        if (wlen <= 0) {
+            cache->error = wlen < 0 ? errno : ENOSPC;
+            ESP_LOGE(TAG, "Failed to write file, %s", strerror(cache->error));
+            return -1;
+        }
+        int used = (int)(esp_timer_get_time() - start);
+        if (used > cache->info.max_write_us) {
+            cache->info.max_write_us = used;
+        }
+        cache->info.write_count++;
+        xSemaphoreTake(cache->lock, portMAX_DELAY);
+        cache->rd_total += wlen;
+        cache->info.written = cache->rd_total;
+        xSemaphoreGive(cache->lock);
+        xEventGroupSetBits(cache->sync, FILE_CACHE_SPACE_BIT);
+    }
+    return -1;
+}
+
+static void _write_cache_task(void *pv)
+{
+    struct file_write_cache *cache = (struct file_write_cache *)pv;
+    TickType_t wait = portMAX_DELAY;
+    if (cache->sync_interval_ms > 0) {
+        wait = cache->sync_interval_ms / portTICK_PERIOD_MS;
+    }
+    cache->sync_time = esp_timer_get_time();
+    while (1) {
+        xEventGroupWaitBits(cache->sync, FILE_CACHE_DATA_BIT, pdTRUE, pdFALSE, wait);
+        bool flush = cache->flush;
+        // Data older than the sync interval goes to file even if it does not fill a block
+        bool expired = cache->sync_interval_ms > 0
+                       && esp_timer_get_time() - cache->sync_time >= cache->sync_interval_ms * 1000LL;
+        _write_cache_drain(cache, flush || expired);
+
+        bool need_sync = flush || expired;
+        if (cache->sync_bytes > 0 && cache->rd_total - cache->synced >= cache->sync_bytes) {
+            need_sync = true;
+        }
+        if (need_sync && !cache->error) {
+            if (cache->rd_total == cache->synced) {
+                cache->sync_time = esp_timer_get_time();
+            } else if (_write_cache_sync(cache) != 0) {
+                cache->error = errno;
+            }
+        }
+        if (flush) {
+            cache->flush = false;
+            xEventGroupSetBits(cache->sync, FILE_CACHE_FLUSHED_BIT);
+        }
+        if (cache->stop) {
+            break;
+        }
+    }
+    xEventGroupSetBits(cache->sync, FILE_CACHE_EXIT_BIT);
+    vTaskDelete(NULL);
+}
+
+static void _write_cache_free(struct file_write_cache *cache)
+{
+    if (cache->lock) {
+        vSemaphoreDelete(cache->lock);
+    }
+    if (cache->sync) {
+        vEventGroupDelete(cache->sync);
+    }
+    audio_free(cache->buf);
+    audio_free(cache);
+}
+
+file_write_cache_handle_t file_write_cache_create(int fd, const file_write_cache_cfg_t *config)
+{
+    AUDIO_NULL_CHECK(TAG, config, return NULL);
+    if (fd < 0 || config->block_size <= 0 || config->cache_size <= 0) {
+        ESP_LOGE(TAG, "Invalid parameters, fd:%d, block:%d, cache:%d", fd, config->block_size, config->cache_size);
+        return NULL;
+    }
+    struct file_write_cache *cache = audio_calloc(1, sizeof(struct file_write_cache));
+    AUDIO_MEM_CHECK(TAG, cache, return NULL);
+    cache->fd = fd;
+    cache->block_size = config->block_size;
+    cache->size = (config->cache_size + config->block_size - 1) / config->block_size * config->block_size;
+    cache->sync_interval_ms = config->sync_interval_ms;
+    cache->sync_bytes = config->sync_bytes;
+    // Allocated in PSRAM when it is enabled
+    cache->buf = audio_calloc(1, cache->size);
+    AUDIO_MEM_CHECK(TAG, cache->buf, goto _create_fail);
+    cache->lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, cache->lock, goto _create_fail);
+    cache->sync = xEventGroupCreate();
+    AUDIO_MEM_CHECK(TAG, cache->sync, goto _create_fail);
+
+    cache->start = lseek(fd, 0, SEEK_CUR);
+    if (cache->start < 0) {
+        cache->start = 0;
+    }
+    if (config->prealloc_size > cache->start) {
+        // Seek beyond the end and write one byte, FATFS allocates the clusters in between
+        if (lseek(fd, config->prealloc_size - 1, SEEK_SET) < 0
+            || write(fd, "", 1) != 1
+            || lseek(fd, cache->start, SEEK_SET) != cache->start) {
+            ESP_LOGW(TAG, "Failed to preallocate %d bytes, %s", config->prealloc_size, strerror(errno));
+            lseek(fd, cache->start, SEEK_SET);
+        } else {
+            cache->prealloc = true;
+        }
+    }
+
+    if (audio_thread_create(NULL, "file_cache", _write_cache_task, cache, config->task_stack,
+                            config->task_prio, config->ext_stack, config->task_core) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create flush task");
+        goto _create_fail;
+    }
+    return cache;
+
+_create_fail:
+    _write_cache_free(cache);
+    return NULL;
+}
+
+int file_write_cache_write(file_write_cache_handle_t cache, const char *data, int len, TickType_t ticks_to_wait)
+{
+    AUDIO_NULL_CHECK(TAG, cache, return -1);
+    int copied = 0;
+    int64_t wait_start = 0;
+    while (copied < len) {
+        if (cache->error) {
+            return -1;
+        }
+        xEventGroupClearBits(cache->sync, FILE_CACHE_SPACE_BIT);
+        xSemaphoreTake(cache->lock, portMAX_DELAY);
+        int filled = cache->wr_total - cache->rd_total;
+        int wr_pos = cache->wr_total % cache->size;
+        xSemaphoreGive(cache->lock);
+
+        int n = cache->size - filled;
+        if (n == 0) {
+            if (wait_start == 0) {
+                wait_start = esp_timer_get_time();
+            }
+            EventBits_t bits = xEventGroupWaitBits(cache->sync, FILE_CACHE_SPACE_BIT, pdTRUE, pdFALSE, ticks_to_wait);
+            if ((bits & FILE_CACHE_SPACE_BIT) == 0) {
+                ESP_LOGW(TAG, "Cache is full, file is written too slow");
+                break;
+            }
+            continue;
+        }
+        if (n > len - copied) {
+            n = len - copied;
+        }
+        if (n > cache->size - wr_pos) {
+            n = cache->size - wr_pos;
+        }
+        memcpy(cache->buf + wr_pos, data + copied, n);
+        copied += n;
+        xSemaphoreTake(cache->lock, portMAX_DELAY);
+        cache->wr_total += n;
+        xSemaphoreGive(cache->lock);
+        // Wake up flush task only when a block can be written
+        if (filled + n >= cache->block_size) {
+            xEventGroupSetBits(cache->sync, FILE_CACHE_DATA_BIT);
+        }
+    }
+    if (wait_start) {
+        int used = (int)(esp_timer_get_time() - wait_start);
+        if (used > cache->info.max_wait_us) {
+            cache->info.max_wait_us = used;
+        }
+    }
+    return copied;
+}
+
+esp_err_t file_write_cache_flush(file_write_cache_handle_t cache)
+{
+    AUDIO_NULL_CHECK(TAG, cache, return ESP_FAIL);
+    xEventGroupClearBits(cache->sync, FILE_CACHE_FLUSHED_BIT);
+    cache->flush = true;
+    xEventGroupSetBits(cache->sync, FILE_CACHE_DATA_BIT);
+    xEventGroupWaitBits(cache->sync, FILE_CACHE_FLUSHED_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
+    return cache->error ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t file_write_cache_get_info(file_write_cache_handle_t cache, file_write_cache_info_t *info)
+{
+    AUDIO_NULL_CHECK(TAG, cache, return ESP_FAIL);
+    AUDIO_NULL_CHECK(TAG, info, return ESP_FAIL);
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+    *info = cache->info;
+    xSemaphoreGive(cache->lock);
+    return ESP_OK;
+}
+
+esp_err_t file_write_cache_destroy(file_write_cache_handle_t cache)
+{
+    AUDIO_NULL_CHECK(TAG, cache, return ESP_FAIL);
+    xEventGroupClearBits(cache->sync, FILE_CACHE_FLUSHED_BIT);
+    cache->flush = true;
+    cache->stop = true;
+    xEventGroupSetBits(cache->sync, FILE_CACHE_DATA_BIT);
+    xEventGroupWaitBits(cache->sync, FILE_CACHE_EXIT_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
+    esp_err_t ret = cache->error ? ESP_FAIL : ESP_OK;
+    if (cache->prealloc) {
+        off_t end = cache->start + cache->rd_total;
+        if (ftruncate(cache->fd, end) != 0) {
+            ESP_LOGW(TAG, "Failed to truncate preallocated file to %d, %s", (int)end, strerror(errno));
+        }
+        lseek(cache->fd, end, SEEK_SET);
+    }
+    ESP_LOGD(TAG, "Wrote %lld bytes in %d writes, %d fsync, max write %d us, max wait %d us", (long long)cache->info.written,
+             cache->info.write_count, cache->info.sync_count, cache->info.max_write_us, cache->info.max_wait_us);
+    _write_cache_free(cache);
+    return ret;
+}
+
+static int _read_block(int fd, int64_t offset, char *data, int len)
+{
+    if (lseek(fd, offset, SEEK_SET) != offset) {
+        return -1;
+    }
+    int total = 0;
+    while (total < len) {
+        int rlen = read(fd, data + total, len - total);
+        if (rlen < 0) {
+            return -1;
+        }
+        if (rlen == 0) {
+            break;
+        }
+        total += rlen;
+    }
+    return total;
+}
+
+static void _read_cache_task(void *pv)
+{
+    struct file_read_cache *cache = (struct file_read_cache *)pv;
+    while (!cache->stop) {
+        xEventGroupClearBits(cache->sync, FILE_CACHE_SPACE_BIT);
+        xSemaphoreTake(cache->lock, portMAX_DELAY);
+        file_read_block_t *block = &cache->blocks[(cache->fill_pos / cache->block_size) % cache->block_num];
+        if (cache->fill_end || cache->error || block->state != READ_BLOCK_EMPTY) {
+            xSemaphoreGive(cache->lock);
+            xEventGroupWaitBits(cache->sync, FILE_CACHE_SPACE_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
+            continue;
+        }
+        int64_t offset = cache->fill_pos;
+        uint32_t generation = cache->generation;
+        block->state = READ_BLOCK_FILLING;
+        xSemaphoreGive(cache->lock);
+
+        int rlen = _read_block(cache->fd, offset, block->data, cache->block_size);
+
+        xSemaphoreTake(cache->lock, portMAX_DELAY);
+        if (generation != cache->generation) {
+            // Seek happened during the read, the block belongs to the old position
+            block->state = READ_BLOCK_EMPTY;
+        } else if (rlen < 0) {
+            block->state = READ_BLOCK_EMPTY;
+            cache->error = errno ? errno : EIO;
+            ESP_LOGE(TAG, "Failed to read file at %lld, %s", (long long)offset, strerror(cache->error));
+        } else {
+            block->offset = offset;
+            block->len = rlen;
+            block->state = READ_BLOCK_READY;
+            cache->fill_pos += cache->block_size;
+            cache->fill_end = rlen < cache->block_size;
+        }
+        xSemaphoreGive(cache->lock);
+        xEventGroupSetBits(cache->sync, FILE_CACHE_DATA_BIT);
+    }
+    xEventGroupSetBits(cache->sync, FILE_CACHE_EXIT_BIT);
+    vTaskDelete(NULL);
+}
+
+static void _read_cache_free(struct file_read_cache *cache)
+{
+    if (cache->lock) {
+        vSemaphoreDelete(cache->lock);
+    }
+    if (cache->sync) {
+        vEventGroupDelete(cache->sync);
+    }
+    for (int i = 0; cache->blocks && i < cache->block_num; i++) {
+        audio_free(cache->blocks[i].data);
+    }
+    audio_free(cache->blocks);
+    audio_free(cache);
+}
+
+static void _read_cache_reset(struct file_read_cache *cache, int64_t pos)
+{
+    cache->generation++;
+    cache->rd_pos = pos;
+    cache->fill_pos = pos - pos % cache->block_size;
+    cache->fill_end = false;
+    cache->error = 0;
+    for (int i = 0; i < cache->block_num; i++) {
+        // The block in reading is dropped by read task
+        if (cache->blocks[i].state == READ_BLOCK_READY) {
+            cache->blocks[i].state = READ_BLOCK_EMPTY;
+        }
+    }
+}
+
+file_read_cache_handle_t file_read_cache_create(int fd, int64_t pos, const file_read_cache_cfg_t *config)
+{
+    AUDIO_NULL_CHECK(TAG, config, return NULL);
+    if (fd < 0 || pos < 0 || config->block_size <= 0 || config->block_num <= 0) {
+        ESP_LOGE(TAG, "Invalid parameters, fd:%d, block:%d, num:%d", fd, config->block_size, config->block_num);
+        return NULL;
+    }
+    struct file_read_cache *cache = audio_calloc(1, sizeof(struct file_read_cache));
+    AUDIO_MEM_CHECK(TAG, cache, return NULL);
+    cache->fd = fd;
+    cache->block_size = config->block_size;
+    cache->block_num = config->block_num;
+    cache->blocks = audio_calloc(cache->block_num, sizeof(file_read_block_t));
+    AUDIO_MEM_CHECK(TAG, cache->blocks, goto _create_fail);
+    for (int i = 0; i < cache->block_num; i++) {
+        cache->blocks[i].data = audio_malloc(cache->block_size);
+        AUDIO_MEM_CHECK(TAG, cache->blocks[i].data, goto _create_fail);
+    }
+    cache->lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, cache->lock, goto _create_fail);
+    cache->sync = xEventGroupCreate();
+    AUDIO_MEM_CHECK(TAG, cache->sync, goto _create_fail);
+    _read_cache_reset(cache, pos);
+
+    if (audio_thread_create(NULL, "file_read_cache", _read_cache_task, cache, config->task_stack,
+                            config->task_prio, config->ext_stack, config->task_core) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create read task");
+        goto _create_fail;
+    }
+    return cache;
+
+_create_fail:
+    _read_cache_free(cache);
+    return NULL;
+}
+
+int file_read_cache_read(file_read_cache_handle_t cache, char *data, int len, TickType_t ticks_to_wait)
+{
+    AUDIO_NULL_CHECK(TAG, cache, return -1);
+    int copied = 0;
+    while (copied < len) {
+        xEventGroupClearBits(cache->sync, FILE_CACHE_DATA_BIT);
+        xSemaphoreTake(cache->lock, portMAX_DELAY);
+        if (cache->error) {
+            xSemaphoreGive(cache->lock);
+            return copied ? copied : -1;
+        }
+        file_read_block_t *block = &cache->blocks[(cache->rd_pos / cache->block_size) % cache->block_num];
+        if (block->state == READ_BLOCK_READY && block->offset == cache->rd_pos - cache->rd_pos % cache->block_size) {
+            int in_block = cache->rd_pos - block->offset;
+            int n = block->len - in_block;
+            if (n <= 0) {
+                // End of file
+                xSemaphoreGive(cache->lock);
+                break;
+            }
+            if (n > len - copied) {
+                n = len - copied;
+            }
+            memcpy(data + copied, block->data + in_block, n);
+            copied += n;
+            cache->rd_pos += n;
+            bool consumed = in_block + n == cache->block_size;
+            if (consumed) {
+                block->state = READ_BLOCK_EMPTY;
+            }
+            xSemaphoreGive(cache->lock);
+            if (consumed) {
+                xEventGroupSetBits(cache->sync, FILE_CACHE_SPACE_BIT);
+            }
+            continue;
+        }
+        xSemaphoreGive(cache->lock);
+        if (copied) {
+            // Return what we have instead of waiting for the next block
+            break;
+        }
+        EventBits_t bits = xEventGroupWaitBits(cache->sync, FILE_CACHE_DATA_BIT, pdTRUE, pdFALSE, ticks_to_wait);
+        if ((bits & FILE_CACHE_DATA_BIT) == 0) {
+            ESP_LOGW(TAG, "Timeout to read file at %lld", (long long)cache->rd_pos);
+            break;
+        }
+    }
+    return copied;
+}
+
+esp_err_t file_read_cache_seek(file_read_cache_handle_t cache, int64_t pos)
+{
+    AUDIO_NULL_CHECK(TAG, cache, return ESP_FAIL);
+    if (pos < 0) {
+        return ESP_FAIL;
+    }
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+    if (pos != cache->rd_pos) {
+        _read_cache_reset(cache, pos);
+    }
+    xSemaphoreGive(cache->lock);
+    xEventGroupSetBits(cache->sync, FILE_CACHE_SPACE_BIT);
+    return ESP_OK;
+}
+
+esp_err_t file_read_cache_destroy(file_read_cache_handle_t cache)
+{
+    AUDIO_NULL_CHECK(TAG, cache, return ESP_FAIL);
+    cache->stop = true;
+    xEventGroupSetBits(cache->sync, FILE_CACHE_SPACE_BIT);
+    xEventGroupWaitBits(cache->sync, FILE_CACHE_EXIT_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
+    _read_cache_free(cache);
+    return ESP_OK;
+}
@@ -0,0 +1,193 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _FILE_CACHE_H_
+#define _FILE_CACHE_H_
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct file_write_cache *file_write_cache_handle_t;
+typedef struct file_read_cache *file_read_cache_handle_t;
+
+/**
+ * @brief Configuration of write-behind cache
+ */
+typedef struct {
+    int     cache_size;         /*!< Size of cache, rounded up to multiple of `block_size` */
+    int     block_size;         /*!< Size of one write to file, use the cluster size of FAT so that writes are cluster aligned */
+    int     sync_interval_ms;   /*!< Call fsync when data is written and this time passed since last fsync, 0 to disable */
+    int     sync_bytes;         /*!< Call fsync when this amount of data is written since last fsync, 0 to disable */
+    int     prealloc_size;      /*!< Extend file to this size on create so that clusters are allocated in advance, 0 to disable */
+    int     task_stack;         /*!< Stack size of flush task */
+    int     task_prio;          /*!< Priority of flush task */
+    int     task_core;          /*!< Core of flush task */
+    bool    ext_stack;          /*!< Allocate stack of flush task on extern ram */
+} file_write_cache_cfg_t;
+
+/**
+ * @brief Statistics of write-behind cache
+ */
+typedef struct {
+    int64_t     written;        /*!< Bytes written to file */
+    int         write_count;    /*!< Number of writes to file */
+    int         sync_count;     /*!< Number of fsync */
+    int         max_write_us;   /*!< Longest time of a write or fsync in flush task */
+    int         max_wait_us;    /*!< Longest time `file_write_cache_write` waited for free space */
+} file_write_cache_info_t;
+
+/**
+ * @brief      Create a write-behind cache on an opened file, data is written from current file position
+ *
+ * @note       The file must not be accessed until the cache is destroyed
+ *
+ * @param      fd       File descriptor opened for writing
+ * @param      config   The configuration
+ *
+ * @return     The cache handle, NULL if failed
+ */
+file_write_cache_handle_t file_write_cache_create(int fd, const file_write_cache_cfg_t *config);
+
+/**
+ * @brief      Copy data to cache, wait only if cache is full
+ *
+ * @param      cache          The cache handle
+ * @param      data           Data to write
+ * @param      len            Length of data
+ * @param      ticks_to_wait  Max time to wait for free space
+ *
+ * @return
+ *     - Bytes copied to cache, may be less than `len` on timeout
+ *     - -1  writing to file failed
+ */
+int file_write_cache_write(file_write_cache_handle_t cache, const char *data, int len, TickType_t ticks_to_wait);
+
+/**
+ * @brief      Write all the cached data to file and call fsync
+ *
+ * @param      cache    The cache handle
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL  writing to file failed
+ */
+esp_err_t file_write_cache_flush(file_write_cache_handle_t cache);
+
+/**
+ * @brief      Get statistics of cache
+ *
+ * @param      cache    The cache handle
+ * @param[out] info     Statistics
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t file_write_cache_get_info(file_write_cache_handle_t cache, file_write_cache_info_t *info);
+
+/**
+ * @brief      Flush cache, stop flush task and free the cache
+ *
+ * @note       If file was preallocated, it is truncated to the data written, file position is left at the end of data
+ *
+ * @param      cache    The cache handle
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL  writing to file failed, the data may be lost
+ */
+esp_err_t file_write_cache_destroy(file_write_cache_handle_t cache);
+
+/**
+ * @brief Configuration of read-ahead cache
+ */
+typedef struct {
+    int     block_size;         /*!< Size of one read from file, reads start on `block_size` boundary of file */
+    int     block_num;          /*!< Number of blocks, the helper task fills the free ones ahead of the reader */
+    int     task_stack;         /*!< Stack size of read task */
+    int     task_prio;          /*!< Priority of read task */
+    int     task_core;          /*!< Core of read task */
+    bool    ext_stack;          /*!< Allocate stack of read task on extern ram */
+} file_read_cache_cfg_t;
+
+/**
+ * @brief      Create a read-ahead cache on an opened file, reading starts from `pos`
+ *
+ * @note       The file must not be accessed until the cache is destroyed
+ *
+ * @param      fd       File descriptor opened for reading
+ * @param      pos      Position of the first byte to read
+ * @param      config   The configuration
+ *
+ * @return     The cache handle, NULL if failed
+ */
+file_read_cache_handle_t file_read_cache_create(int fd, int64_t pos, const file_read_cache_cfg_t *config);
+
+/**
+ * @brief      Read data from cache, wait only if no data is cached
+ *
+ * @param      cache          The cache handle
+ * @param      data           Buffer to save data
+ * @param      len            Length of buffer
+ * @param      ticks_to_wait  Max time to wait for data
+ *
+ * @return
+ *     - Bytes read, may be less than `len` when the next block is not read yet
+ *     - 0   end of file, or timeout
+ *     - -1  reading from file failed
+ */
+int file_read_cache_read(file_read_cache_handle_t cache, char *data, int len, TickType_t ticks_to_wait);
+
+/**
+ * @brief      Move read position, the cached blocks are dropped unless `pos` is the current position
+ *
+ * @param      cache    The cache handle
+ * @param      pos      New read position
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t file_read_cache_seek(file_read_cache_handle_t cache, int64_t pos);
+
+/**
+ * @brief      Stop read task and free the cache
+ *
+ * @param      cache    The cache handle
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t file_read_cache_destroy(file_read_cache_handle_t cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
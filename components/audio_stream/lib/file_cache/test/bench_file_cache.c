@@ -0,0 +1,238 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Host benchmark of the write-behind cache, see build.pl
+ *
+ * Writes `size_mb` MB in 4 KB chunks, as fatfs_stream writer does, first with write and fsync per chunk,
+ * then through the cache. Reports sustained MB/s and the worst time a write call blocked the caller.
+ *
+ * Then reads the file back in 4 KB chunks, as fatfs_stream reader does, with plain read and through
+ * the read-ahead cache, `decode_us` of work per chunk stands for the decoder, and checks the content
+ * after random seeks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "esp_timer.h"
+#include "file_cache.h"
+
+#define CHUNK_SIZE      (4096)
+
+typedef struct {
+    double  mbps;
+    int     max_us;
+    double  avg_us;
+} bench_result_t;
+
+static void report(const char *name, bench_result_t *r)
+{
+    printf("%-24s %8.1f MB/s, latency avg %7.1f us, max %7d us\n", name, r->mbps, r->avg_us, r->max_us);
+}
+
+static int run(const char *path, int size_mb, file_write_cache_cfg_t *cfg, bench_result_t *r)
+{
+    static char chunk[CHUNK_SIZE];
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    file_write_cache_handle_t cache = cfg ? file_write_cache_create(fd, cfg) : NULL;
+    if (cfg && cache == NULL) {
+        return -1;
+    }
+    int num = size_mb * 1024 * 1024 / CHUNK_SIZE;
+    int64_t total_us = 0;
+    int64_t start = esp_timer_get_time();
+    r->max_us = 0;
+    for (int i = 0; i < num; i++) {
+        memset(chunk, i, sizeof(chunk));
+        int64_t t = esp_timer_get_time();
+        if (cache) {
+            if (file_write_cache_write(cache, chunk, CHUNK_SIZE, portMAX_DELAY) != CHUNK_SIZE) {
+                return -1;
+            }
+        } else {
+            if (write(fd, chunk, CHUNK_SIZE) != CHUNK_SIZE) {
+                return -1;
+            }
+            fsync(fd);
+        }
+        int used = (int)(esp_timer_get_time() - t);
+        total_us += used;
+        if (used > r->max_us) {
+            r->max_us = used;
+        }
+    }
+    if (cache) {
+        file_write_cache_info_t info;
+        file_write_cache_get_info(cache, &info);
+        if (file_write_cache_destroy(cache) != ESP_OK) {
+            return -1;
+        }
+        printf("  %d writes to file, %d fsync, slowest write or fsync %d us\n", info.write_count, info.sync_count, info.max_write_us);
+    }
+    close(fd);
+    double secs = (esp_timer_get_time() - start) / 1000000.0;
+    r->mbps = size_mb / secs;
+    r->avg_us = (double)total_us / num;
+
+    // Verify content and size
+    fd = open(path, O_RDONLY);
+    off_t size = lseek(fd, 0, SEEK_END);
+    lseek(fd, 0, SEEK_SET);
+    for (int i = 0; i < num; i++) {
+        if (read(fd, chunk, CHUNK_SIZE) != CHUNK_SIZE || chunk[0] != (char)i || chunk[CHUNK_SIZE - 1] != (char)i) {
+            printf("Data mismatch at chunk %d\n", i);
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+    if (size != (off_t)num * CHUNK_SIZE) {
+        printf("File size %ld, expect %ld\n", (long)size, (long)num * CHUNK_SIZE);
+        return -1;
+    }
+    return 0;
+}
+
+static void decode(int decode_us)
+{
+    int64_t end = esp_timer_get_time() + decode_us;
+    while (esp_timer_get_time() < end);
+}
+
+static int run_read(const char *path, int size_mb, int decode_us, file_read_cache_cfg_t *cfg, bench_result_t *r)
+{
+    static char chunk[CHUNK_SIZE];
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    file_read_cache_handle_t cache = cfg ? file_read_cache_create(fd, 0, cfg) : NULL;
+    if (cfg && cache == NULL) {
+        return -1;
+    }
+    int num = size_mb * 1024 * 1024 / CHUNK_SIZE;
+    int64_t total_us = 0;
+    int64_t start = esp_timer_get_time();
+    r->max_us = 0;
+    for (int i = 0; i < num; i++) {
+        int64_t t = esp_timer_get_time();
+        int got = 0;
+        while (got < CHUNK_SIZE) {
+            int rlen = cache ? file_read_cache_read(cache, chunk + got, CHUNK_SIZE - got, portMAX_DELAY)
+                             : read(fd, chunk + got, CHUNK_SIZE - got);
+            if (rlen <= 0) {
+                printf("Read failed at chunk %d, ret %d\n", i, rlen);
+                return -1;
+            }
+            got += rlen;
+        }
+        int used = (int)(esp_timer_get_time() - t);
+        total_us += used;
+        if (used > r->max_us) {
+            r->max_us = used;
+        }
+        if (chunk[0] != (char)i || chunk[CHUNK_SIZE - 1] != (char)i) {
+            printf("Data mismatch at chunk %d\n", i);
+            return -1;
+        }
+        decode(decode_us);
+    }
+    if (cache) {
+        if (file_read_cache_read(cache, chunk, CHUNK_SIZE, portMAX_DELAY) != 0) {
+            printf("No end of file\n");
+            return -1;
+        }
+        // Seek to random chunks, including positions in the middle of a block
+        for (int i = 0; i < 200; i++) {
+            int n = rand() % num;
+            int off = rand() % CHUNK_SIZE;
+            if (file_read_cache_seek(cache, (int64_t)n * CHUNK_SIZE + off) != ESP_OK
+                || file_read_cache_read(cache, chunk, 1, portMAX_DELAY) != 1 || chunk[0] != (char)n) {
+                printf("Data mismatch after seek to chunk %d\n", n);
+                return -1;
+            }
+        }
+        file_read_cache_destroy(cache);
+    }
+    close(fd);
+    double secs = (esp_timer_get_time() - start) / 1000000.0;
+    r->mbps = size_mb / secs;
+    r->avg_us = (double)total_us / num;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = argc > 1 ? argv[1] : "/tmp/bench_file_cache.bin";
+    int size_mb = argc > 2 ? atoi(argv[2]) : 64;
+    file_write_cache_cfg_t cfg = {
+        .cache_size = 256 * 1024,
+        .block_size = 32 * 1024,
+        .sync_interval_ms = 2000,
+        .sync_bytes = 0,
+        .prealloc_size = 0,
+    };
+    bench_result_t r;
+    printf("Write %d MB to %s in %d bytes chunks\n", size_mb, path, CHUNK_SIZE);
+    if (run(path, size_mb, NULL, &r) != 0) {
+        return 1;
+    }
+    report("write + fsync", &r);
+    if (run(path, size_mb, &cfg, &r) != 0) {
+        return 1;
+    }
+    report("cache 256K, sync 2s", &r);
+    cfg.sync_interval_ms = 0;
+    cfg.sync_bytes = 4 * 1024 * 1024;
+    cfg.prealloc_size = size_mb * 1024 * 1024 + 1024 * 1024;
+    if (run(path, size_mb, &cfg, &r) != 0) {
+        return 1;
+    }
+    report("cache, sync 4MB, prealloc", &r);
+
+    int decode_us = argc > 3 ? atoi(argv[3]) : 20;
+    file_read_cache_cfg_t rcfg = {
+        .block_size = 32 * 1024,
+        .block_num = 2,
+    };
+    printf("Read %d MB from %s in %d bytes chunks, %d us decode per chunk\n", size_mb, path, CHUNK_SIZE, decode_us);
+    if (run_read(path, size_mb, decode_us, NULL, &r) != 0) {
+        return 1;
+    }
+    report("read", &r);
+    if (run_read(path, size_mb, decode_us, &rcfg, &r) != 0) {
+        return 1;
+    }
+    report("read-ahead 2 x 32K", &r);
+    remove(path);
+    return 0;
+}
@@ -0,0 +1,18 @@
+#!/usr/bin/perl
+#
+# Build the file cache benchmark on host, on the pthread FreeRTOS port of audio_pipeline/test/host/port.
+# Run it as:
+#   ./build.pl && ./bench_file_cache /tmp/bench.wav 64
+#
+# Pass "asan" to build with the address and undefined behaviour sanitizers.
+#
+use strict;
+
+my $r = "../../../..";
+my $port = "$r/audio_pipeline/test/host/port";
+my @src = ("$r/audio_sal/audio_mem.c", "$r/audio_sal/audio_mutex.c", "$r/audio_sal/audio_thread.c",
+           "$port/freertos_posix.c", "../file_cache.c");
+my $inc = "-D_GNU_SOURCE -I$port -I$r/audio_sal/include -I../include";
+my $opt = (grep { $_ eq "asan" } @ARGV) ? "-O1 -fsanitize=address,undefined -fno-omit-frame-pointer" : "-O2";
+
+system("gcc $opt -g -Wall @src bench_file_cache.c $inc -o ./bench_file_cache -lpthread -lm") == 0 or die "build failed";
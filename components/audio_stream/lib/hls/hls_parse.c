@@ -347,8 +347,12 @@ static void hls_parse_key(hls_parse_t* parser, hls_tag_t tag, int attr_num) {
     }
 }
 
-static void hls_parse_value(hls_parse_t* parser, int attr_num) {
+static void hls_parse_value(hls_parse_t* parser, hls_tag_t tag, int attr_num) {
     for (int i = 0; i < attr_num; i++) {
+        // Playlist type is already converted when parse key
+        if (tag == HLS_TAG_PLAYLIST_TYPE && i == 0) {
+            continue;
+        }
         switch (parser->k[i]) {
             case HLS_ATTR_DURATION:
                 parser->v[i].f = hls_get_float_value(parser->v[i].s);
@@ -473,7 +477,7 @@ int hls_parse(hls_parse_t* parser, hls_tag_callback cb, void* ctx)
             parser->attr[attr_num++] = attr;
             attr_num = hls_parse_attr(parser, sep, attr_num);
             hls_parse_key(parser, tag, attr_num);
-            hls_parse_value(parser, attr_num);
+            hls_parse_value(parser, tag, attr_num);
         }
         if (cb) {
             hls_tag_info_t tag_info = {
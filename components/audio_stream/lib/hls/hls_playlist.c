@@ -36,6 +36,9 @@
 #define MEDIA_FLAG_DEFAULT     (2)
 #define MEDIA_FLAG_FORCED      (4)
 
+/* Percentage of measured throughput a variant may use, leave the rest for jitter and playlist reload */
+#define HLS_THROUGHPUT_USAGE   (80)
+
 #define HLS_MALLOC(type) (type*)audio_calloc(1, sizeof(type))
 #define HLS_FREE(b)      if (b) {audio_free(b); b = NULL;}
 
@@ -127,6 +130,7 @@ typedef struct {
     uint8_t                 playlist_num;     /*!< Media playlist number */
     hls_master_playlist_t*  master_playlist;  /*!< Master playlist information */
     hls_media_playlist_t*   media_playlist;   /*!< Media playlist information */
+    uint32_t                throughput;       /*!< Measured download throughput in bits per second */
 } hls_t;
 
 static int hls_fill_media_attr(hls_media_t* m, hls_tag_info_t* tag_info)
@@ -283,7 +287,8 @@ static int hls_media_tag_cb(hls_tag_info_t* tag_info, void* ctx)
             break;
         case HLS_TAG_TARGET_DURATION:
             if (tag_info->attr_num) {
-                media->target_duration = (uint32_t)tag_info->v[0].v;
+                // Parsed as duration attribute which is float
+                media->target_duration = (uint32_t)tag_info->v[0].f;
             }
             break;
         case HLS_TAG_MEDIA_SEQUENCE:
@@ -350,11 +355,17 @@ static int hls_media_tag_cb(hls_tag_info_t* tag_info, void* ctx)
     return 0;
 }
 
-static hls_stream_t* hls_filter_stream(hls_master_playlist_t* main, uint32_t bitrate)
+static hls_stream_t* hls_filter_stream(hls_master_playlist_t* main, uint32_t bitrate, uint32_t throughput)
 {
     if (main->stream_num == 0) {
         return NULL;
     }
+    if (throughput) {
+        uint32_t usable = (uint32_t)((uint64_t)throughput * HLS_THROUGHPUT_USAGE / 100);
+        if (usable < bitrate) {
+            bitrate = usable;
+        }
+    }
     int max_bitrate = 0;
     hls_stream_t* sel_stream = NULL;
     for (int i = 0; i < main->stream_num; i++) {
@@ -368,6 +379,12 @@ static hls_stream_t* hls_filter_stream(hls_master_playlist_t* main, uint32_t bit
     }
     if (sel_stream == NULL) {
         sel_stream = &main->stream[0];
+        // Link is slower than every variant, the lowest one stalls least
+        for (int i = 1; throughput && i < main->stream_num; i++) {
+            if (main->stream[i].bandwidth < sel_stream->bandwidth) {
+                sel_stream = &main->stream[i];
+            }
+        }
     }
     return sel_stream;
 }
@@ -470,7 +487,7 @@ char* hls_playlist_get_prefer_url(hls_handle_t h, hls_stream_type_t type)
         return NULL;
     }
     hls_master_playlist_t* master_playlist = hls->master_playlist;
-    hls_stream_t* stream = hls_filter_stream(master_playlist, hls->cfg.prefer_bitrate);
+    hls_stream_t* stream = hls_filter_stream(master_playlist, hls->cfg.prefer_bitrate, hls->throughput);
     if (stream == NULL || stream->uri == NULL) {
         return NULL;
     }
@@ -628,6 +645,25 @@ int hls_playlist_get_key(hls_handle_t h, uint64_t sequence_no, hls_stream_key_t*
     return -1;
 }
 
+uint32_t hls_playlist_get_target_duration(hls_handle_t h)
+{
+    hls_t* hls = (hls_t*)h;
+    if (hls == NULL || hls->media_playlist == NULL) {
+        return 0;
+    }
+    return hls->media_playlist->target_duration;
+}
+
+int hls_playlist_set_throughput(hls_handle_t h, uint32_t throughput)
+{
+    hls_t* hls = (hls_t*)h;
+    if (hls == NULL) {
+        return -1;
+    }
+    hls->throughput = throughput;
+    return 0;
+}
+
 bool hls_playlist_is_master(hls_handle_t h)
 {
     hls_t* hls = (hls_t*)h;
@@ -61,7 +61,7 @@ typedef int (*hls_uri_callback) (char* uri, void* tag);
  * @brief HLS playlist parser configuration
  */
 typedef struct {
-    uint32_t         prefer_bitrate;   /*!< Prefer bitrate used to filter media playlist */
+    uint32_t         prefer_bitrate;   /*!< Prefer bitrate used to filter media playlist, upper limit of variant bandwidth */
     hls_uri_callback cb;               /*!< HLS media stream uri callback */
     void*            ctx;              /*!< Input context */
     char*            uri;              /*!< M3U8 host url */
@@ -157,6 +157,26 @@ int hls_playlist_get_key(hls_handle_t h, uint64_t sequence_no, hls_stream_key_t*
  */
 int hls_playlist_parse_key(hls_handle_t h, uint8_t* buffer, int size);
 
+/**
+ * @brief         Get target duration of media playlist
+ * @param         h: HLS handle
+ * @return        Maximum segment duration in seconds, 0 if not a media playlist
+ */
+uint32_t hls_playlist_get_target_duration(hls_handle_t h);
+
+/**
+ * @brief         Set measured download throughput
+ *
+ * @note          Variant selection of `hls_playlist_get_prefer_url` keeps below both `prefer_bitrate`
+ *                and the measured throughput with some headroom, set 0 to select by `prefer_bitrate` only
+ *
+ * @param         h: HLS handle
+ * @param         throughput: Download throughput in bits per second
+ * @return        0: On success
+ *                -1: Invalid input
+ */
+int hls_playlist_set_throughput(hls_handle_t h, uint32_t throughput);
+
 /**
  * @brief         Close parse for HLS playlist
  *
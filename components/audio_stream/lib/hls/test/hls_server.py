@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+#
+# Local HLS server to exercise http_stream on a host or a device in the same LAN
+#
+#   ./hls_server.py -port 8000 -rate 24000
+#
+# Serves:
+#   /master.m3u8, /low.m3u8 ...   fixtures in ./fixtures, VOD playlists
+#   /live/<variant>.m3u8          live playlist, the window slides one segment per target duration
+#   /seg/<variant>/<seq>.aac      generated segment, size follows the variant bandwidth
+#   /enc/low.m3u8                 VOD playlist of AES-128 encrypted segments, IV from media sequence
+#   /enc/enc.key, /enc/seg/<seq>.aac
+#                                 key and encrypted segments, plaintext sizes are not block aligned
+#
+# Connections are kept alive and `Range` requests are honored, `-rate` limits the
+# bytes per second of each connection so that variant switching can be observed.
+#
+# `-dump <dir>` writes the key, IV, plaintext and ciphertext of each encrypted segment
+# as test vectors and exits. Encryption uses the `openssl` command.
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+FIXTURE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'fixtures')
+TARGET_DURATION = 2
+LIVE_WINDOW = 4
+BANDWIDTH = {'low': 64000, 'mid': 128000, 'high': 256000}
+ENC_KEY = bytes.fromhex('2b7e151628aed2a6abf7158809cf4f3c')
+ENC_FIRST_SEQ = 5
+ENC_SEGMENTS = 4
+
+
+def segment_data(variant, seq):
+    size = BANDWIDTH[variant] * TARGET_DURATION // 8
+    head = ('SEG %s %d\n' % (variant, seq)).encode()
+    body = bytes((seq * 31 + i) & 0xFF for i in range(size - len(head)))
+    return head + body
+
+
+def encrypted_plain(seq):
+    # Same rule is used by the device test to check the decrypted stream
+    size = BANDWIDTH['low'] * TARGET_DURATION // 8 - seq * 3 - 1
+    return bytes((seq * 31 + i) & 0xFF for i in range(size))
+
+
+def encrypt_segment(seq, cache={}):
+    if seq not in cache:
+        iv = seq.to_bytes(16, 'big')
+        cache[seq] = subprocess.run(['openssl', 'enc', '-aes-128-cbc', '-K', ENC_KEY.hex(), '-iv', iv.hex()],
+                                    input=encrypted_plain(seq), stdout=subprocess.PIPE, check=True).stdout
+    return cache[seq]
+
+
+def encrypted_playlist():
+    lines = ['#EXTM3U', '#EXT-X-VERSION:3', '#EXT-X-TARGETDURATION:%d' % TARGET_DURATION,
+             '#EXT-X-MEDIA-SEQUENCE:%d' % ENC_FIRST_SEQ, '#EXT-X-PLAYLIST-TYPE:VOD',
+             '#EXT-X-KEY:METHOD=AES-128,URI="enc.key"']
+    for seq in range(ENC_FIRST_SEQ, ENC_FIRST_SEQ + ENC_SEGMENTS):
+        lines.append('#EXTINF:%d.000,' % TARGET_DURATION)
+        lines.append('seg/%d.aac' % seq)
+    lines.append('#EXT-X-ENDLIST')
+    return ('\n'.join(lines) + '\n').encode()
+
+
+def dump_vectors(out_dir):
+    os.makedirs(out_dir, exist_ok=True)
+    with open(os.path.join(out_dir, 'enc.key'), 'wb') as f:
+        f.write(ENC_KEY)
+    for seq in range(ENC_FIRST_SEQ, ENC_FIRST_SEQ + ENC_SEGMENTS):
+        for ext, data in (('iv', seq.to_bytes(16, 'big')), ('plain', encrypted_plain(seq)), ('aac', encrypt_segment(seq))):
+            with open(os.path.join(out_dir, '%d.%s' % (seq, ext)), 'wb') as f:
+                f.write(data)
+    print('Test vectors of segment %d to %d written to %s' % (ENC_FIRST_SEQ, ENC_FIRST_SEQ + ENC_SEGMENTS - 1, out_dir))
+
+
+def live_playlist(variant, start_time):
+    first = int((time.time() - start_time) / TARGET_DURATION)
+    lines = ['#EXTM3U', '#EXT-X-VERSION:3', '#EXT-X-TARGETDURATION:%d' % TARGET_DURATION,
+             '#EXT-X-MEDIA-SEQUENCE:%d' % first]
+    for seq in range(first, first + LIVE_WINDOW):
+        lines.append('#EXTINF:%d.000,' % TARGET_DURATION)
+        lines.append('../seg/%s/%d.aac' % (variant, seq))
+    return ('\n'.join(lines) + '\n').encode()
+
+
+class HlsHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def log_message(self, fmt, *args):
+        sys.stderr.write('[conn %d] %s\n' % (self.client_address[1], fmt % args))
+
+    def do_GET(self):
+        path = self.path.split('?')[0]
+        m = re.match(r'^/seg/(\w+)/(\d+)\.aac$', path)
+        if m and m.group(1) in BANDWIDTH:
+            return self.send_data(segment_data(m.group(1), int(m.group(2))), 'audio/aac')
+        if path == '/enc/low.m3u8':
+            return self.send_data(encrypted_playlist(), 'application/vnd.apple.mpegurl')
+        if path == '/enc/enc.key':
+            return self.send_data(ENC_KEY, 'application/octet-stream')
+        m = re.match(r'^/enc/seg/(\d+)\.aac$', path)
+        if m and ENC_FIRST_SEQ <= int(m.group(1)) < ENC_FIRST_SEQ + ENC_SEGMENTS:
+            return self.send_data(encrypt_segment(int(m.group(1))), 'audio/aac')
+        m = re.match(r'^/live/(\w+)\.m3u8$', path)
+        if m and m.group(1) in BANDWIDTH:
+            return self.send_data(live_playlist(m.group(1), self.server.start_time), 'application/vnd.apple.mpegurl')
+        name = os.path.basename(path)
+        file_path = os.path.join(FIXTURE_DIR, name)
+        if name.endswith('.m3u8') and os.path.isfile(file_path):
+            with open(file_path, 'rb') as f:
+                return self.send_data(f.read(), 'application/vnd.apple.mpegurl')
+        self.send_error(404)
+
+    def send_data(self, data, content_type):
+        start, end = 0, len(data) - 1
+        m = re.match(r'bytes=(\d+)-(\d*)', self.headers.get('Range', ''))
+        if m:
+            start = int(m.group(1))
+            if m.group(2):
+                end = min(int(m.group(2)), end)
+            if start > end:
+                self.send_response(416)
+                self.send_header('Content-Range', 'bytes */%d' % len(data))
+                self.send_header('Content-Length', '0')
+                self.end_headers()
+                return
+            self.send_response(206)
+            self.send_header('Content-Range', 'bytes %d-%d/%d' % (start, end, len(data)))
+        else:
+            self.send_response(200)
+        self.send_header('Content-Type', content_type)
+        self.send_header('Content-Length', str(end - start + 1))
+        self.end_headers()
+        self.send_body(data[start:end + 1])
+
+    def send_body(self, body):
+        rate = self.server.rate
+        try:
+            if rate <= 0:
+                self.wfile.write(body)
+                return
+            chunk = max(rate // 20, 512)
+            for i in range(0, len(body), chunk):
+                self.wfile.write(body[i:i + chunk])
+                self.wfile.flush()
+                time.sleep(len(body[i:i + chunk]) / rate)
+        except ConnectionError:
+            # Client stopped or dropped the connection in the middle of a segment
+            self.close_connection = True
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Local HLS test server')
+    parser.add_argument('-port', type=int, default=8000, help='listen port')
+    parser.add_argument('-rate', type=int, default=0, help='bytes per second of each connection, 0 for unlimited')
+    parser.add_argument('-dump', help='write test vectors of the encrypted segments to this directory and exit')
+    args = parser.parse_args()
+    if args.dump:
+        dump_vectors(args.dump)
+        return
+    server = ThreadingHTTPServer(('0.0.0.0', args.port), HlsHandler)
+    server.start_time = time.time()
+    server.rate = args.rate
+    print('Serving HLS on port %d, try http://<host>:%d/master.m3u8 or /live_master.m3u8' % (args.port, args.port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -162,6 +162,18 @@ int parse_data(hls_handle_t hls, char* url)
     return 0;
 }
 
+static void test_throughput(hls_handle_t hls)
+{
+    uint32_t throughput[] = {0, 50 * 1000, 100 * 1000, 200 * 1000, 1000 * 1000};
+    for (int i = 0; i < sizeof(throughput) / sizeof(throughput[0]); i++) {
+        hls_playlist_set_throughput(hls, throughput[i]);
+        char* uri = hls_playlist_get_prefer_url(hls, HLS_STREAM_TYPE_AUDIO);
+        printf("Throughput %d bps select %s\n", (int)throughput[i], uri ? uri : "NULL");
+        free(uri);
+    }
+    hls_playlist_set_throughput(hls, 0);
+}
+
 int test_playlist(char* file)
 {
     hls_playlist_cfg_t cfg = {
@@ -180,6 +192,7 @@ int test_playlist(char* file)
             }
             if (hls_playlist_is_master(hls)) {
                 stream_uri = hls_playlist_get_prefer_url(hls, HLS_STREAM_TYPE_AUDIO);
+                test_throughput(hls);
             }
             hls_playlist_close(hls);
             hls = NULL;
@@ -38,6 +38,7 @@
 #include "audio_element.h"
 #include "wav_head.h"
 #include "esp_log.h"
+#include "file_cache.h"
 
 #define FILE_WAV_SUFFIX_TYPE  "wav"
 #define FILE_OPUS_SUFFIX_TYPE "opus"
@@ -61,6 +62,8 @@ typedef struct spiffs_stream {
     FILE *file;
     wr_stream_type_t w_type;
     bool write_header;
+    file_read_cache_cfg_t read_cache_cfg;
+    file_read_cache_handle_t read_cache;
 } spiffs_stream_t;
 
 static wr_stream_type_t get_type(const char *str)
@@ -141,6 +144,13 @@ static esp_err_t _spiffs_open(audio_element_handle_t self)
         ESP_LOGE(TAG, "Failed to seek to %d/%d", (int)info.byte_pos, (int)info.total_bytes);
         return ESP_FAIL;
     }
+    if (spiffs->type == AUDIO_STREAM_READER && spiffs->read_cache_cfg.block_size > 0) {
+        // The cache reads through the descriptor, FILE is not used until close
+        spiffs->read_cache = file_read_cache_create(fileno(spiffs->file), info.byte_pos, &spiffs->read_cache_cfg);
+        if (spiffs->read_cache == NULL) {
+            return ESP_FAIL;
+        }
+    }
     int ret = audio_element_set_total_bytes(self, info.total_bytes);
     return ret;
 }
@@ -152,7 +162,12 @@ static int _spiffs_read(audio_element_handle_t self, char *buffer, int len, Tick
     audio_element_getinfo(self, &info);
 
     ESP_LOGD(TAG, "read len=%d, pos=%d/%d", len, (int)info.byte_pos, (int)info.total_bytes);
-    int rlen = fread(buffer, 1, len, spiffs->file);
+    int rlen;
+    if (spiffs->read_cache) {
+        rlen = file_read_cache_read(spiffs->read_cache, buffer, len, portMAX_DELAY);
+    } else {
+        rlen = fread(buffer, 1, len, spiffs->file);
+    }
     if (rlen <= 0) {
         ESP_LOGW(TAG, "No more data, ret:%d", rlen);
     } else {
@@ -191,6 +206,10 @@ static esp_err_t _spiffs_close(audio_element_handle_t self)
 {
     spiffs_stream_t *spiffs = (spiffs_stream_t *)audio_element_getdata(self);
 
+    if (spiffs->read_cache) {
+        file_read_cache_destroy(spiffs->read_cache);
+        spiffs->read_cache = NULL;
+    }
     if (AUDIO_STREAM_WRITER == spiffs->type
         && spiffs->file
         && STREAM_TYPE_WAV == spiffs->w_type) {
@@ -253,6 +272,14 @@ audio_element_handle_t spiffs_stream_init(spiffs_stream_cfg_t *config)
     cfg.tag = "spiffs";
     spiffs->type = config->type;
     spiffs->write_header = config->write_header;
+    if (config->type == AUDIO_STREAM_READER && config->read_block_size > 0) {
+        file_read_cache_cfg_t *cache_cfg = &spiffs->read_cache_cfg;
+        cache_cfg->block_size = config->read_block_size;
+        cache_cfg->block_num = config->read_block_num > 0 ? config->read_block_num : SPIFFS_STREAM_READ_BLOCK_NUM;
+        cache_cfg->task_stack = SPIFFS_STREAM_CACHE_TASK_STACK;
+        cache_cfg->task_prio = config->task_prio;
+        cache_cfg->task_core = config->task_core;
+    }
 
     if (config->type == AUDIO_STREAM_WRITER) {
         cfg.write = _spiffs_write;
@@ -84,7 +84,7 @@ TEST_CASE("fatfs stream init memory", "[esp-adf-stream]")
     AUDIO_MEM_SHOW("AFTER FATFS_STREAM_INIT MEMORY TEST");
 }
 
-TEST_CASE("fatfs stream read write loop", "[esp-adf-stream]")
+static void fatfs_read_write_loop(fatfs_stream_cfg_t *fatfs_reader_cfg, fatfs_stream_cfg_t *fatfs_writer_cfg)
 {
     audio_pipeline_handle_t pipeline;
     audio_element_handle_t fatfs_stream_reader, fatfs_stream_writer;
@@ -101,14 +101,10 @@ TEST_CASE("fatfs stream read write loop", "[esp-adf-stream]")
     pipeline = audio_pipeline_init(&pipeline_cfg);
     TEST_ASSERT_NOT_NULL(pipeline);
 
-    fatfs_stream_cfg_t fatfs_reader_cfg = FATFS_STREAM_CFG_DEFAULT();
-    fatfs_reader_cfg.type = AUDIO_STREAM_READER;
-    fatfs_stream_reader = fatfs_stream_init(&fatfs_reader_cfg);
+    fatfs_stream_reader = fatfs_stream_init(fatfs_reader_cfg);
     TEST_ASSERT_NOT_NULL(fatfs_stream_reader);
 
-    fatfs_stream_cfg_t fatfs_writer_cfg = FATFS_STREAM_CFG_DEFAULT();
-    fatfs_writer_cfg.type = AUDIO_STREAM_WRITER;
-    fatfs_stream_writer = fatfs_stream_init(&fatfs_writer_cfg);
+    fatfs_stream_writer = fatfs_stream_init(fatfs_writer_cfg);
     TEST_ASSERT_NOT_NULL(fatfs_stream_writer);
 
     TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, fatfs_stream_reader, "file_reader"));
@@ -159,3 +155,35 @@ TEST_CASE("fatfs stream read write loop", "[esp-adf-stream]")
 
 
 }
+
+TEST_CASE("fatfs stream read write loop", "[esp-adf-stream]")
+{
+    fatfs_stream_cfg_t fatfs_reader_cfg = FATFS_STREAM_CFG_DEFAULT();
+    fatfs_reader_cfg.type = AUDIO_STREAM_READER;
+    fatfs_stream_cfg_t fatfs_writer_cfg = FATFS_STREAM_CFG_DEFAULT();
+    fatfs_writer_cfg.type = AUDIO_STREAM_WRITER;
+    fatfs_read_write_loop(&fatfs_reader_cfg, &fatfs_writer_cfg);
+}
+
+TEST_CASE("fatfs stream read write loop with write-behind cache", "[esp-adf-stream]")
+{
+    fatfs_stream_cfg_t fatfs_reader_cfg = FATFS_STREAM_CFG_DEFAULT();
+    fatfs_reader_cfg.type = AUDIO_STREAM_READER;
+    fatfs_stream_cfg_t fatfs_writer_cfg = FATFS_STREAM_CFG_DEFAULT();
+    fatfs_writer_cfg.type = AUDIO_STREAM_WRITER;
+    fatfs_writer_cfg.write_cache_size = 128 * 1024;
+    fatfs_writer_cfg.prealloc_size = 4 * 1024 * 1024;
+    fatfs_read_write_loop(&fatfs_reader_cfg, &fatfs_writer_cfg);
+    TEST_ASSERT_EQUAL(get_file_size(TEST_FATFS_READER), get_file_size(TEST_FATFS_WRITER));
+}
+
+TEST_CASE("fatfs stream read write loop with read-ahead", "[esp-adf-stream]")
+{
+    fatfs_stream_cfg_t fatfs_reader_cfg = FATFS_STREAM_CFG_DEFAULT();
+    fatfs_reader_cfg.type = AUDIO_STREAM_READER;
+    fatfs_reader_cfg.read_block_size = FATFS_STREAM_READ_BLOCK_SIZE;
+    fatfs_stream_cfg_t fatfs_writer_cfg = FATFS_STREAM_CFG_DEFAULT();
+    fatfs_writer_cfg.type = AUDIO_STREAM_WRITER;
+    fatfs_read_write_loop(&fatfs_reader_cfg, &fatfs_writer_cfg);
+    TEST_ASSERT_EQUAL(get_file_size(TEST_FATFS_READER), get_file_size(TEST_FATFS_WRITER));
+}
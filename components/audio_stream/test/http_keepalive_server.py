@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+
+#  ESPRESSIF MIT License
+#
+#  Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+#
+#  Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+#  it is free of charge, to any person obtaining a copy of this software and associated
+#  documentation files (the "Software"), to deal in the Software without restriction, including
+#  without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+#  and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+#  to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in all copies or
+#  substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+#  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+#  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+#  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+#  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# HTTP/1.1 server with keep-alive, serves /track<N> of generated data and logs every new connection
+# and TLS session resumption, used to check connection reuse of http_conn_pool.
+#
+# HTTPS: openssl req -x509 -newkey rsa:2048 -nodes -days 365 -subj "/CN=<server ip>" -keyout key.pem -out cert.pem
+#        python3 http_keepalive_server.py --port 8443 --cert cert.pem --key key.pem
+
+import argparse
+import http.server
+import socketserver
+import ssl
+
+TRACK_SIZE = 64 * 1024
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def setup(self):
+        super().setup()
+        self.server.connections += 1
+        resumed = ''
+        if isinstance(self.connection, ssl.SSLSocket):
+            resumed = ' TLS resumed' if self.connection.session_reused else ' TLS full handshake'
+        print('Connection {} from {}{}'.format(self.server.connections, self.client_address[0], resumed))
+
+    def do_GET(self):
+        if not self.path.startswith('/track'):
+            self.send_error(404)
+            return
+        body = bytes(i & 0xFF for i in range(TRACK_SIZE))
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/octet-stream')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        print('  ' + format % args)
+
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+    connections = 0
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--host', default='0.0.0.0')
+    parser.add_argument('--port', type=int, default=8000)
+    parser.add_argument('--cert')
+    parser.add_argument('--key')
+    args = parser.parse_args()
+    httpd = Server((args.host, args.port), Handler)
+    scheme = 'http'
+    if args.cert:
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        ctx.load_cert_chain(args.cert, args.key)
+        httpd.socket = ctx.wrap_socket(httpd.socket, server_side=True)
+        scheme = 'https'
+    print('Serving {} on {} port {}'.format(scheme, args.host, args.port))
+    httpd.serve_forever()
+
+
+if __name__ == '__main__':
+    main()
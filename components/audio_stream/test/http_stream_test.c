@@ -33,11 +33,14 @@
 #include "esp_http_client.h"
 #include "nvs_flash.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "audio_pipeline.h"
 #include "audio_mem.h"
 #include "audio_element.h"
 #include "audio_event_iface.h"
 #include "http_stream.h"
+#include "http_conn_pool.h"
+#include "raw_stream.h"
 #include "i2s_stream.h"
 #include "fatfs_stream.h"
 #include "aac_decoder.h"
@@ -51,6 +54,12 @@ static const char *TAG = "HTTP STREAM UNITEST";
 static const char URL_RANDOM[] = "0123456789abcdefghijklmnopqrstuvwxyuzABCDEFGHIJKLMNOPQRSTUVWXYUZ-_.!@#$&*()=:/,;?+~";
 #define AAC_STREAM_URI "http://open.ls.qingting.fm/live/274/64k.m3u8?format=aac"
 #define UNITEST_HTTP_SERVRE_URI  "http://192.168.199.168:8000/upload"
+#define UNITEST_HTTP_KEEPALIVE_URI  "http://192.168.199.168:8000/track"
+#define UNITEST_HTTP_KEEPALIVE_TRACK_SIZE  (64 * 1024)
+#define UNITEST_HLS_ENCRYPTED_URI  "http://192.168.199.168:8000/enc/low.m3u8"
+#define UNITEST_HLS_ENC_FIRST_SEQ  (5)
+#define UNITEST_HLS_ENC_SEGMENTS   (4)
+#define UNITEST_HLS_ENC_PLAIN_SIZE(seq)  (64000 * 2 / 8 - (seq) * 3 - 1)
 
 #define UNITETS_HTTP_STREAM_WIFI_SSID    "ESPRESSIF"
 #define UNITETS_HTTP_STREAM_WIFI_PASSWD    "espressif"
@@ -72,6 +81,22 @@ TEST_CASE("http stream init memory", "[esp-adf-stream]")
     AUDIO_MEM_SHOW("AFTER HTTP_STREAM_INIT MEMORY TEST");
 }
 
+TEST_CASE("http stream prefetch init memory", "[esp-adf-stream]")
+{
+    audio_element_handle_t http_stream_reader;
+    http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+    http_cfg.type = AUDIO_STREAM_READER;
+    http_cfg.prefetch_size = 64 * 1024;
+    int cnt = 500;
+    AUDIO_MEM_SHOW("BEFORE HTTP_STREAM_INIT PREFETCH MEMORY TEST");
+    while (cnt--) {
+        http_stream_reader = http_stream_init(&http_cfg);
+        TEST_ASSERT_NOT_NULL(http_stream_reader);
+        audio_element_deinit(http_stream_reader);
+    }
+    AUDIO_MEM_SHOW("AFTER HTTP_STREAM_INIT PREFETCH MEMORY TEST");
+}
+
 TEST_CASE("http stream url test", "[esp-adf-stream]")
 {
     int url_len = 0;
@@ -567,3 +592,167 @@ TEST_CASE("https stream test", "[esp-adf-stream]")
     TEST_ASSERT_EQUAL(ESP_OK, audio_element_deinit(fatfs_stream_writer));
     TEST_ASSERT_EQUAL(ESP_OK, esp_periph_set_destroy(set));
 }
+
+static int http_read_all(esp_http_client_handle_t client)
+{
+    char buf[512];
+    int total = 0;
+    while (1) {
+        int len = esp_http_client_read(client, buf, sizeof(buf));
+        if (len <= 0) {
+            break;
+        }
+        total += len;
+    }
+    return total;
+}
+
+/*
+ * Note : Before run this unitest, please run the http_keepalive_server.py, and Confirm server ip in UNITEST_HTTP_KEEPALIVE_URI
+ *        Server should log only one connection for all the tracks
+ */
+TEST_CASE("http connection pool reuse", "[esp-adf-stream]")
+{
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    tcpip_adapter_init();
+
+    esp_periph_config_t periph_cfg = DEFAULT_ESP_PERIPH_SET_CONFIG();
+    esp_periph_set_handle_t set = esp_periph_set_init(&periph_cfg);
+    TEST_ASSERT_NOT_NULL(set);
+
+    periph_wifi_cfg_t wifi_cfg = {
+        .wifi_config.sta.ssid = UNITETS_HTTP_STREAM_WIFI_SSID,
+        .wifi_config.sta.password = UNITETS_HTTP_STREAM_WIFI_PASSWD,
+    };
+    esp_periph_handle_t wifi_handle = periph_wifi_init(&wifi_cfg);
+    TEST_ASSERT_NOT_NULL(wifi_handle);
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_periph_start(set, wifi_handle));
+    TEST_ASSERT_EQUAL(ESP_OK, periph_wifi_wait_for_connected(wifi_handle, portMAX_DELAY));
+
+    http_conn_pool_stats_t before, after;
+    TEST_ASSERT_EQUAL(ESP_OK, http_conn_pool_get_stats(&before));
+    char url[64];
+    esp_http_client_config_t config = {
+        .url = url,
+    };
+    for (int i = 0; i < 4; i++) {
+        snprintf(url, sizeof(url), "%s%d", UNITEST_HTTP_KEEPALIVE_URI, i);
+        bool reused = false;
+        int64_t start = esp_timer_get_time();
+        esp_http_client_handle_t client = http_conn_pool_acquire(&config, &reused);
+        TEST_ASSERT_NOT_NULL(client);
+        TEST_ASSERT_EQUAL(i > 0, reused);
+        TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_open(client, 0));
+        TEST_ASSERT_EQUAL(UNITEST_HTTP_KEEPALIVE_TRACK_SIZE, esp_http_client_fetch_headers(client));
+        int64_t first_byte = esp_timer_get_time() - start;
+        TEST_ASSERT_EQUAL(UNITEST_HTTP_KEEPALIVE_TRACK_SIZE, http_read_all(client));
+        ESP_LOGI(TAG, "Track %d reused %d, first byte after %d us", i, reused, (int)first_byte);
+        TEST_ASSERT_EQUAL(ESP_OK, http_conn_pool_release(client, true));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, http_conn_pool_get_stats(&after));
+    TEST_ASSERT_EQUAL(1, after.created - before.created);
+    TEST_ASSERT_EQUAL(3, after.reused - before.reused);
+    http_conn_pool_clear();
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_periph_set_stop_all(set));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_periph_set_destroy(set));
+}
+
+/*
+ * Note : Before run this unitest, please run lib/hls/test/hls_server.py, and Confirm server ip in UNITEST_HLS_ENCRYPTED_URI
+ *        Plaintext of the encrypted segments follows `encrypted_plain` of the server
+ */
+TEST_CASE("http stream encrypted hls", "[esp-adf-stream]")
+{
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    tcpip_adapter_init();
+
+    esp_periph_config_t periph_cfg = DEFAULT_ESP_PERIPH_SET_CONFIG();
+    esp_periph_set_handle_t set = esp_periph_set_init(&periph_cfg);
+    TEST_ASSERT_NOT_NULL(set);
+
+    periph_wifi_cfg_t wifi_cfg = {
+        .wifi_config.sta.ssid = UNITETS_HTTP_STREAM_WIFI_SSID,
+        .wifi_config.sta.password = UNITETS_HTTP_STREAM_WIFI_PASSWD,
+    };
+    esp_periph_handle_t wifi_handle = periph_wifi_init(&wifi_cfg);
+    TEST_ASSERT_NOT_NULL(wifi_handle);
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_periph_start(set, wifi_handle));
+    TEST_ASSERT_EQUAL(ESP_OK, periph_wifi_wait_for_connected(wifi_handle, portMAX_DELAY));
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    TEST_ASSERT_NOT_NULL(pipeline);
+
+    http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+    http_cfg.enable_playlist_parser = true;
+    http_cfg.auto_connect_next_track = true;
+    http_cfg.prefetch_size = 32 * 1024;
+    audio_element_handle_t http_stream_reader = http_stream_init(&http_cfg);
+    TEST_ASSERT_NOT_NULL(http_stream_reader);
+
+    raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+    raw_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t raw_reader = raw_stream_init(&raw_cfg);
+    TEST_ASSERT_NOT_NULL(raw_reader);
+
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, http_stream_reader, "http"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_register(pipeline, raw_reader, "raw"));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_link(pipeline, (const char *[]) { "http", "raw" }, 2));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_element_set_uri(http_stream_reader, UNITEST_HLS_ENCRYPTED_URI));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_run(pipeline));
+
+    // Segments are chained by the element, check the decrypted stream byte by byte
+    char *buf = audio_calloc(1, 1000);
+    TEST_ASSERT_NOT_NULL(buf);
+    int seq = UNITEST_HLS_ENC_FIRST_SEQ;
+    int offset = 0;
+    int total = 0;
+    int mismatch = 0;
+    int64_t start = esp_timer_get_time();
+    while (1) {
+        int len = raw_stream_read(raw_reader, buf, 1000);
+        if (len <= 0) {
+            break;
+        }
+        for (int i = 0; i < len; i++) {
+            if (offset == UNITEST_HLS_ENC_PLAIN_SIZE(seq)) {
+                seq++;
+                offset = 0;
+            }
+            if ((uint8_t)buf[i] != (uint8_t)(seq * 31 + offset)) {
+                mismatch++;
+            }
+            offset++;
+        }
+        total += len;
+    }
+    ESP_LOGI(TAG, "Decrypted %d bytes of %d segments in %d ms", total, seq - UNITEST_HLS_ENC_FIRST_SEQ + 1,
+             (int)((esp_timer_get_time() - start) / 1000));
+    int expect = 0;
+    for (int i = UNITEST_HLS_ENC_FIRST_SEQ; i < UNITEST_HLS_ENC_FIRST_SEQ + UNITEST_HLS_ENC_SEGMENTS; i++) {
+        expect += UNITEST_HLS_ENC_PLAIN_SIZE(i);
+    }
+    TEST_ASSERT_EQUAL(0, mismatch);
+    TEST_ASSERT_EQUAL(expect, total);
+    audio_free(buf);
+
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_terminate(pipeline));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_unregister(pipeline, http_stream_reader));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_unregister(pipeline, raw_reader));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_pipeline_deinit(pipeline));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_element_deinit(http_stream_reader));
+    TEST_ASSERT_EQUAL(ESP_OK, audio_element_deinit(raw_reader));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_periph_set_stop_all(set));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_periph_set_destroy(set));
+}
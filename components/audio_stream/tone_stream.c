@@ -43,6 +43,8 @@ typedef struct tone_stream {
     audio_stream_type_t type;            /*!< File operation type */
     bool is_open;                        /*!< Tone stream status */
     bool use_delegate;                   /*!< Tone read with delegate*/
+    bool use_mmap;                       /*!< Output the mapped tone file directly */
+    const uint8_t *data;                 /*!< Mapped data of current file, NULL to read it */
     tone_partition_handle_t tone_handle; /*!< Tone partition's operation handle*/
     tone_file_info_t cur_file;           /*!< Address to read tone file */
     const char *partition_label;         /*!< Label of tone stored in flash */
@@ -55,9 +57,12 @@ static esp_err_t _tone_open(audio_element_handle_t self)
         ESP_LOGE(TAG, "already opened");
         return ESP_FAIL;
     }
-    stream->tone_handle = tone_partition_init(stream->partition_label, stream->use_delegate);
+    // The partition handle lives as long as the element, so only the first tone pays for loading the file table
     if (stream->tone_handle == NULL) {
-        return ESP_FAIL;
+        stream->tone_handle = tone_partition_init(stream->partition_label, stream->use_delegate);
+        if (stream->tone_handle == NULL) {
+            return ESP_FAIL;
+        }
     }
 
     char *flash_url = audio_element_get_uri(self);
@@ -75,6 +80,7 @@ static esp_err_t _tone_open(audio_element_handle_t self)
         return ESP_FAIL;
     }
 
+    memset(&stream->cur_file, 0, sizeof(tone_file_info_t));
     tone_partition_get_file_info(stream->tone_handle, file_index, &stream->cur_file);
     ESP_LOGI(TAG, "Tone offset:%08"PRIX32", Tone length:%"PRIu32", pos:%d\n", stream->cur_file.song_adr, stream->cur_file.song_len, file_index);
     if (stream->cur_file.song_len <= 0) {
@@ -82,6 +88,11 @@ static esp_err_t _tone_open(audio_element_handle_t self)
         return ESP_FAIL;
     }
 
+    stream->data = NULL;
+    if (stream->use_mmap) {
+        tone_partition_get_file_data(stream->tone_handle, &stream->cur_file, &stream->data);
+    }
+
     audio_element_info_t info = { 0 };
     info.total_bytes = stream->cur_file.song_len;
     audio_element_setdata(self, stream);
@@ -115,8 +126,30 @@ static int _tone_read(audio_element_handle_t self, char *buffer, int len, TickTy
     return len;
 }
 
+static int _tone_mmap_process(audio_element_handle_t self, tone_stream_t *stream, int len)
+{
+    audio_element_info_t info = { 0 };
+    audio_element_getinfo(self, &info);
+    if (info.byte_pos + len > info.total_bytes) {
+        len = info.total_bytes - info.byte_pos;
+    }
+    if (len <= 0) {
+        ESP_LOGD(TAG, "No more data, byte_pos:%llu", info.byte_pos);
+        return AEL_IO_DONE;
+    }
+    int w_size = audio_element_output(self, (char *)stream->data + info.byte_pos, len);
+    if (w_size > 0) {
+        audio_element_update_byte_pos(self, w_size);
+    }
+    return w_size;
+}
+
 static int _tone_process(audio_element_handle_t self, char *in_buffer, int in_len)
 {
+    tone_stream_t *stream = (tone_stream_t *)audio_element_getdata(self);
+    if (stream->data) {
+        return _tone_mmap_process(self, stream, in_len);
+    }
     int r_size = audio_element_input(self, in_buffer, in_len);
     int w_size = 0;
     if (r_size > 0) {
@@ -133,8 +166,7 @@ static esp_err_t _tone_close(audio_element_handle_t self)
     if (stream->is_open) {
         stream->is_open = false;
     }
-    tone_partition_deinit(stream->tone_handle);
-    stream->tone_handle = NULL;
+    stream->data = NULL;
     if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
         audio_element_set_byte_pos(self, 0);
     }
@@ -144,6 +176,9 @@ static esp_err_t _tone_close(audio_element_handle_t self)
 static esp_err_t _tone_destroy(audio_element_handle_t self)
 {
     tone_stream_t *stream = (tone_stream_t *)audio_element_getdata(self);
+    if (stream->tone_handle) {
+        tone_partition_deinit(stream->tone_handle);
+    }
     audio_free(stream);
     return ESP_OK;
 }
@@ -176,6 +211,7 @@ audio_element_handle_t tone_stream_init(tone_stream_cfg_t *config)
     cfg.tag = "flash";
     stream->type = config->type;
     stream->use_delegate = config->use_delegate;
+    stream->use_mmap = config->use_mmap;
 
     if (config->label == NULL) {
         ESP_LOGE(TAG, "Please set your tone label");
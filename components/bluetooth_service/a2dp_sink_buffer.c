@@ -0,0 +1,146 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "audio_mem.h"
+#include "audio_error.h"
+#include "audio_thread.h"
+#include "ringbuf.h"
+#include "a2dp_sink_buffer.h"
+
+#define A2DP_SINK_BUFFER_OUTPUT_SIZE    (4096)
+
+static const char *TAG = "A2DP_SINK_BUF";
+
+struct a2dp_sink_buffer {
+    audio_element_handle_t      el;
+    ringbuf_handle_t            rb;
+    a2dp_stream_sink_stats_t    stats;
+    volatile bool               stop;
+    int                         ref_count;      /* Held by the task and the owner, the last one frees */
+};
+
+static void _sink_buffer_free(struct a2dp_sink_buffer *buf)
+{
+    if (buf->rb) {
+        rb_destroy(buf->rb);
+    }
+    audio_free(buf);
+}
+
+static void _sink_buffer_put(struct a2dp_sink_buffer *buf)
+{
+    if (__atomic_sub_fetch(&buf->ref_count, 1, __ATOMIC_SEQ_CST) == 0) {
+        _sink_buffer_free(buf);
+    }
+}
+
+static void _sink_buffer_task(void *pv)
+{
+    struct a2dp_sink_buffer *buf = (struct a2dp_sink_buffer *)pv;
+    char *data = NULL;
+    while (1) {
+        // Output straight from the jitter buffer, the only copy after the callback
+        int len = rb_acquire_read(buf->rb, &data, A2DP_SINK_BUFFER_OUTPUT_SIZE, portMAX_DELAY);
+        if (len <= 0) {
+            break;
+        }
+        if (!buf->stop) {
+            audio_element_output(buf->el, data, len);
+        }
+        rb_release_read(buf->rb, len);
+    }
+    ESP_LOGI(TAG, "Sink buffer task exit, %d packets received, %d dropped",
+             (int)buf->stats.received_pkts, (int)buf->stats.dropped_pkts);
+    _sink_buffer_put(buf);
+    vTaskDelete(NULL);
+}
+
+a2dp_sink_buffer_handle_t a2dp_sink_buffer_create(audio_element_handle_t el, const a2dp_sink_buffer_cfg_t *config)
+{
+    AUDIO_NULL_CHECK(TAG, config, return NULL);
+    if (config->buffer_size <= 0) {
+        ESP_LOGE(TAG, "Invalid buffer size %d", config->buffer_size);
+        return NULL;
+    }
+    struct a2dp_sink_buffer *buf = audio_calloc(1, sizeof(struct a2dp_sink_buffer));
+    AUDIO_MEM_CHECK(TAG, buf, return NULL);
+    buf->el = el;
+    buf->ref_count = 2;
+    buf->rb = rb_create_spsc(config->buffer_size, 1);
+    AUDIO_MEM_CHECK(TAG, buf->rb, goto _create_fail);
+    if (audio_thread_create(NULL, "a2dp_sink_buffer", _sink_buffer_task, buf, config->task_stack,
+                            config->task_prio, config->ext_stack, config->task_core) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create sink buffer task");
+        goto _create_fail;
+    }
+    return buf;
+
+_create_fail:
+    _sink_buffer_free(buf);
+    return NULL;
+}
+
+int a2dp_sink_buffer_write(a2dp_sink_buffer_handle_t buf, const uint8_t *data, uint32_t len)
+{
+    if (buf == NULL || data == NULL || len == 0) {
+        return 0;
+    }
+    buf->stats.received_pkts++;
+    buf->stats.received_bytes += len;
+    // Drop whole packets, a partial packet would leave a click in the middle of the stream
+    if (buf->stop || rb_bytes_available(buf->rb) < (int)len) {
+        buf->stats.dropped_pkts++;
+        buf->stats.dropped_bytes += len;
+        return 0;
+    }
+    rb_write(buf->rb, (char *)data, len, 0);
+    int filled = rb_bytes_filled(buf->rb);
+    if (filled > buf->stats.max_filled) {
+        buf->stats.max_filled = filled;
+    }
+    return len;
+}
+
+esp_err_t a2dp_sink_buffer_get_stats(a2dp_sink_buffer_handle_t buf, a2dp_stream_sink_stats_t *stats)
+{
+    AUDIO_NULL_CHECK(TAG, buf, return ESP_FAIL);
+    AUDIO_NULL_CHECK(TAG, stats, return ESP_FAIL);
+    memcpy(stats, &buf->stats, sizeof(a2dp_stream_sink_stats_t));
+    stats->filled = rb_bytes_filled(buf->rb);
+    return ESP_OK;
+}
+
+esp_err_t a2dp_sink_buffer_destroy(a2dp_sink_buffer_handle_t buf)
+{
+    AUDIO_NULL_CHECK(TAG, buf, return ESP_FAIL);
+    buf->stop = true;
+    // Do not wait for the task, it may be blocked on the element output until the pipeline is stopped
+    rb_abort(buf->rb);
+    _sink_buffer_put(buf);
+    return ESP_OK;
+}
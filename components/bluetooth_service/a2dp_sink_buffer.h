@@ -0,0 +1,103 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _A2DP_SINK_BUFFER_H_
+#define _A2DP_SINK_BUFFER_H_
+
+#include "audio_element.h"
+#include "a2dp_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Jitter buffer between the Bluetooth data callback and the a2dp sink element.
+ * The callback copies each packet into a preallocated single producer/single consumer ringbuffer
+ * and never blocks or allocates, a packet that does not fit is dropped as a whole and counted.
+ * A task moves the data to the output of the element.
+ */
+typedef struct a2dp_sink_buffer *a2dp_sink_buffer_handle_t;
+
+typedef struct {
+    int     buffer_size;    /*!< Size of jitter buffer in bytes */
+    int     task_stack;     /*!< Stack size of output task */
+    int     task_prio;      /*!< Priority of output task */
+    int     task_core;      /*!< Core of output task */
+    bool    ext_stack;      /*!< Allocate stack of output task on extern ram */
+} a2dp_sink_buffer_cfg_t;
+
+/**
+ * @brief      Create the jitter buffer and the task writing to `el`
+ *
+ * @param      el       The a2dp sink element
+ * @param      config   The configuration
+ *
+ * @return     The buffer handle, NULL if failed
+ */
+a2dp_sink_buffer_handle_t a2dp_sink_buffer_create(audio_element_handle_t el, const a2dp_sink_buffer_cfg_t *config);
+
+/**
+ * @brief      Put a packet of PCM data to buffer, called from the Bluetooth data callback
+ *
+ * @param      buf      The buffer handle
+ * @param      data     PCM data
+ * @param      len      Length of data
+ *
+ * @return
+ *     - len  the packet is buffered
+ *     - 0    the packet is dropped, the buffer is full
+ */
+int a2dp_sink_buffer_write(a2dp_sink_buffer_handle_t buf, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief      Get packet and drop counters
+ *
+ * @param      buf      The buffer handle
+ * @param[out] stats    The counters
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t a2dp_sink_buffer_get_stats(a2dp_sink_buffer_handle_t buf, a2dp_stream_sink_stats_t *stats);
+
+/**
+ * @brief      Stop the output task and free the buffer, data not output yet is dropped
+ *
+ * @note       The data callback must not call `a2dp_sink_buffer_write` any more
+ *
+ * @param      buf      The buffer handle
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t a2dp_sink_buffer_destroy(a2dp_sink_buffer_handle_t buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "audio_mem.h"
+#include "audio_error.h"
+#include "audio_thread.h"
+#include "ringbuf.h"
+#include "a2dp_source_buffer.h"
+
+#define A2DP_SOURCE_BUFFER_INPUT_SIZE   (4096)
+#define A2DP_SOURCE_BUFFER_IDLE_MS      (20)
+
+static const char *TAG = "A2DP_SOURCE_BUF";
+
+struct a2dp_source_buffer {
+    audio_element_handle_t      el;
+    ringbuf_handle_t            rb;
+    int                         prefill_size;
+    bool                        buffering;      /* Sending silence until prefill_size is reached */
+    volatile bool               input_done;
+    volatile bool               flush;          /* Set by the task when the element stops, the reader drops what is left */
+    bool                        running;
+    bool                        done_reported;
+    a2dp_stream_source_stats_t  stats;
+    volatile bool               stop;
+    int                         ref_count;      /* Held by the task and the owner, the last one frees */
+};
+
+static void _source_buffer_free(struct a2dp_source_buffer *buf)
+{
+    if (buf->rb) {
+        rb_destroy(buf->rb);
+    }
+    audio_free(buf);
+}
+
+static void _source_buffer_put(struct a2dp_source_buffer *buf)
+{
+    if (__atomic_sub_fetch(&buf->ref_count, 1, __ATOMIC_SEQ_CST) == 0) {
+        _source_buffer_free(buf);
+    }
+}
+
+static void _source_buffer_task(void *pv)
+{
+    struct a2dp_source_buffer *buf = (struct a2dp_source_buffer *)pv;
+    char *data = NULL;
+    while (!buf->stop) {
+        // The element has no task of its own, only read while the pipeline runs it
+        audio_element_state_t state = audio_element_get_state(buf->el);
+        if (state != AEL_STATE_RUNNING) {
+            if (buf->running && state != AEL_STATE_PAUSED) {
+                // Stopped or finished, what is left belongs to the previous stream
+                buf->running = false;
+                buf->flush = true;
+            }
+            buf->input_done = false;
+            vTaskDelay(A2DP_SOURCE_BUFFER_IDLE_MS / portTICK_PERIOD_MS);
+            continue;
+        }
+        // The reader resets the ring, do not write until it has
+        if (buf->input_done || buf->flush) {
+            vTaskDelay(A2DP_SOURCE_BUFFER_IDLE_MS / portTICK_PERIOD_MS);
+            continue;
+        }
+        buf->running = true;
+        // Wait a bounded time, a full ring must not hide a stop from this task
+        int len = rb_acquire_write(buf->rb, &data, A2DP_SOURCE_BUFFER_INPUT_SIZE, A2DP_SOURCE_BUFFER_IDLE_MS / portTICK_PERIOD_MS);
+        if (len <= 0) {
+            continue;
+        }
+        // Read straight into the buffer, a stalled upstream only blocks this task
+        len = audio_element_input(buf->el, data, len);
+        if (len > 0) {
+            rb_commit_write(buf->rb, len);
+            continue;
+        }
+        rb_commit_write(buf->rb, 0);
+        if (len == AEL_IO_DONE) {
+            buf->input_done = true;
+        } else if (len != AEL_IO_TIMEOUT) {
+            vTaskDelay(A2DP_SOURCE_BUFFER_IDLE_MS / portTICK_PERIOD_MS);
+        }
+    }
+    _source_buffer_put(buf);
+    vTaskDelete(NULL);
+}
+
+a2dp_source_buffer_handle_t a2dp_source_buffer_create(audio_element_handle_t el, const a2dp_source_buffer_cfg_t *config)
+{
+    AUDIO_NULL_CHECK(TAG, config, return NULL);
+    if (config->buffer_size <= 0 || config->prefill_size > config->buffer_size) {
+        ESP_LOGE(TAG, "Invalid buffer size %d, prefill %d", config->buffer_size, config->prefill_size);
+        return NULL;
+    }
+    struct a2dp_source_buffer *buf = audio_calloc(1, sizeof(struct a2dp_source_buffer));
+    AUDIO_MEM_CHECK(TAG, buf, return NULL);
+    buf->el = el;
+    buf->prefill_size = config->prefill_size;
+    buf->buffering = true;
+    buf->ref_count = 2;
+    buf->rb = rb_create_spsc(config->buffer_size, 1);
+    AUDIO_MEM_CHECK(TAG, buf->rb, goto _create_fail);
+    if (audio_thread_create(NULL, "a2dp_source_buffer", _source_buffer_task, buf, config->task_stack,
+                            config->task_prio, config->ext_stack, config->task_core) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create source buffer task");
+        goto _create_fail;
+    }
+    return buf;
+
+_create_fail:
+    _source_buffer_free(buf);
+    return NULL;
+}
+
+int a2dp_source_buffer_read(a2dp_source_buffer_handle_t buf, uint8_t *data, int len)
+{
+    if (buf == NULL || data == NULL || len <= 0) {
+        return 0;
+    }
+    if (buf->flush) {
+        // The task does not write while the flag is set, so the ring is only touched here
+        rb_reset(buf->rb);
+        buf->buffering = true;
+        buf->done_reported = false;
+        buf->flush = false;
+    }
+    int filled = rb_bytes_filled(buf->rb);
+    buf->stats.requested_bytes += len;
+    if (buf->input_done && filled == 0) {
+        if (buf->done_reported) {
+            memset(data, 0, len);
+            return len;
+        }
+        buf->done_reported = true;
+        buf->buffering = true;
+        return A2DP_SOURCE_BUFFER_DONE;
+    }
+    buf->done_reported = false;
+    int rlen = 0;
+    if (!buf->buffering || filled >= buf->prefill_size || buf->input_done) {
+        if (buf->buffering || filled < buf->stats.min_filled) {
+            buf->stats.min_filled = filled;
+        }
+        buf->buffering = false;
+        rlen = rb_read(buf->rb, (char *)data, len, 0);
+        if (rlen < 0) {
+            rlen = 0;
+        }
+        if (rlen < len && !buf->input_done) {
+            // Keep the link running on silence and build up the buffer again
+            buf->stats.underruns++;
+            buf->buffering = true;
+        }
+    }
+    if (rlen < len) {
+        memset(data + rlen, 0, len - rlen);
+        buf->stats.silence_bytes += len - rlen;
+    }
+    return len;
+}
+
+esp_err_t a2dp_source_buffer_get_stats(a2dp_source_buffer_handle_t buf, a2dp_stream_source_stats_t *stats)
+{
+    AUDIO_NULL_CHECK(TAG, buf, return ESP_FAIL);
+    AUDIO_NULL_CHECK(TAG, stats, return ESP_FAIL);
+    memcpy(stats, &buf->stats, sizeof(a2dp_stream_source_stats_t));
+    stats->filled = rb_bytes_filled(buf->rb);
+    return ESP_OK;
+}
+
+esp_err_t a2dp_source_buffer_destroy(a2dp_source_buffer_handle_t buf)
+{
+    AUDIO_NULL_CHECK(TAG, buf, return ESP_FAIL);
+    buf->stop = true;
+    // Do not wait for the task, it may be blocked on the element input until the pipeline is stopped
+    rb_abort(buf->rb);
+    _source_buffer_put(buf);
+    return ESP_OK;
+}
@@ -0,0 +1,106 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _A2DP_SOURCE_BUFFER_H_
+#define _A2DP_SOURCE_BUFFER_H_
+
+#include "audio_element.h"
+#include "a2dp_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define A2DP_SOURCE_BUFFER_DONE     (-2)
+
+/**
+ * Buffer between the a2dp source element and the Bluetooth data callback.
+ * A task fills it from the element input at the pace of the pipeline, the callback drains it
+ * without blocking and pads any shortfall with silence. After an underrun, or at start,
+ * the callback sends silence until `prefill_size` bytes are buffered again.
+ */
+typedef struct a2dp_source_buffer *a2dp_source_buffer_handle_t;
+
+typedef struct {
+    int     buffer_size;    /*!< Size of buffer in bytes */
+    int     prefill_size;   /*!< Bytes to buffer before the callback gets data, at start and after underrun */
+    int     task_stack;     /*!< Stack size of input task */
+    int     task_prio;      /*!< Priority of input task */
+    int     task_core;      /*!< Core of input task */
+    bool    ext_stack;      /*!< Allocate stack of input task on extern ram */
+} a2dp_source_buffer_cfg_t;
+
+/**
+ * @brief      Create the buffer and the task reading from `el`
+ *
+ * @param      el       The a2dp source element
+ * @param      config   The configuration
+ *
+ * @return     The buffer handle, NULL if failed
+ */
+a2dp_source_buffer_handle_t a2dp_source_buffer_create(audio_element_handle_t el, const a2dp_source_buffer_cfg_t *config);
+
+/**
+ * @brief      Get PCM data for the Bluetooth data callback, never blocks
+ *
+ * @param      buf      The buffer handle
+ * @param      data     Buffer to fill
+ * @param      len      Bytes wanted
+ *
+ * @return
+ *     - len                          `data` is filled, padded with silence on underrun
+ *     - A2DP_SOURCE_BUFFER_DONE      the input is done and all data is sent, reported once
+ */
+int a2dp_source_buffer_read(a2dp_source_buffer_handle_t buf, uint8_t *data, int len);
+
+/**
+ * @brief      Get underrun counters and fill level
+ *
+ * @param      buf      The buffer handle
+ * @param[out] stats    The counters
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t a2dp_source_buffer_get_stats(a2dp_source_buffer_handle_t buf, a2dp_stream_source_stats_t *stats);
+
+/**
+ * @brief      Stop the input task and free the buffer
+ *
+ * @note       The data callback must not call `a2dp_source_buffer_read` any more
+ *
+ * @param      buf      The buffer handle
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t a2dp_source_buffer_destroy(a2dp_source_buffer_handle_t buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
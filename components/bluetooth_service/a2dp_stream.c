@@ -36,6 +36,8 @@
 #include "sdkconfig.h"
 
 #include "a2dp_stream.h"
+#include "a2dp_sink_buffer.h"
+#include "a2dp_source_buffer.h"
 
 #if (defined CONFIG_CLASSIC_BT_ENABLED)
 static const char *TAG = "A2DP_STREAM";
@@ -59,19 +61,10 @@ typedef struct {
     bool volume_notify;
 #endif
 
-    audio_thread_t a2dp_thread;
-    QueueHandle_t a2dp_queue;
+    a2dp_sink_buffer_handle_t sink_buffer;
+    a2dp_source_buffer_handle_t source_buffer;
 } aadp_info_t;
 
-typedef struct {
-    enum {
-        A2DP_TYPE_SINK ,
-        A2DP_TYPE_DESTROY,
-    } type;
-    void *data;
-    size_t size;
-} a2dp_data_t;
-
 static aadp_info_t s_aadp_handler = { 0 };
 
 int16_t default_volume = 50;
@@ -82,34 +75,6 @@ static void bt_avrc_tg_cb(esp_avrc_tg_cb_event_t event, esp_avrc_tg_cb_param_t *
 static const char *audio_state_str[] = { "Suspended", "Stopped", "Started" };
 static void bt_avrc_ct_cb(esp_avrc_ct_cb_event_t event, esp_avrc_ct_cb_param_t *param);
 
-static void audio_a2dp_stream_thread(void *pvParameters)
-{
-    (void) pvParameters;
-
-    a2dp_data_t recv_msg;
-    bool _aadp_task_run = true;
-    while(_aadp_task_run) {
-        if ( pdTRUE ==  xQueueReceive (s_aadp_handler.a2dp_queue, &recv_msg, portMAX_DELAY) ) {
-            switch (recv_msg.type) {
-            case A2DP_TYPE_SINK:
-                    audio_element_output(s_aadp_handler.sink_stream, (char *)recv_msg.data, recv_msg.size);
-                    audio_free(recv_msg.data);
-                    recv_msg.data = NULL;
-                break;
-            case A2DP_TYPE_DESTROY:
-                _aadp_task_run = false;
-                break;
-            default:
-                break;
-            }
-        }
-    }
-    ESP_LOGI(TAG, "Delete the audio_a2dp_stream_thread");
-    vQueueDelete(s_aadp_handler.a2dp_queue);
-    s_aadp_handler.a2dp_queue = NULL;
-    vTaskDelete(NULL);
-}
-
 static void bt_a2d_sink_cb(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param)
 {
     if (s_aadp_handler.user_callback.user_a2d_cb) {
@@ -189,23 +154,10 @@ static void bt_a2d_sink_data_cb(const uint8_t *data, uint32_t len)
     if (s_aadp_handler.user_callback.user_a2d_sink_data_cb) {
         s_aadp_handler.user_callback.user_a2d_sink_data_cb(data, len);
     }
-    if (s_aadp_handler.sink_stream) {
-        if (audio_element_get_state(s_aadp_handler.sink_stream) == AEL_STATE_RUNNING) {
-            a2dp_data_t send_msg = {0};
-            send_msg.data = (uint8_t *)audio_calloc(1, len);
-            if (!send_msg.data) {
-                ESP_LOGE(TAG, "No ineffecitive memory to allocate(%d)", __LINE__);
-                return;
-            }
-            memcpy(send_msg.data, data, len);
-            send_msg.size = len;
-            send_msg.type = A2DP_TYPE_SINK;
-            if ((!s_aadp_handler.a2dp_queue) || xQueueSend(s_aadp_handler.a2dp_queue, &send_msg, 0) != pdPASS) {
-                ESP_LOGW(TAG, "discard a2dp(%p) sink pkt, A2DP_STREAM_QUEUE_SIZE value needs to be expanded", s_aadp_handler.a2dp_queue);
-                audio_free(send_msg.data);
-                send_msg.data = NULL;
-            }
-        }
+    a2dp_sink_buffer_handle_t sink_buffer = s_aadp_handler.sink_buffer;
+    if (sink_buffer && s_aadp_handler.sink_stream
+        && audio_element_get_state(s_aadp_handler.sink_stream) == AEL_STATE_RUNNING) {
+        a2dp_sink_buffer_write(sink_buffer, data, len);
     }
 }
 
@@ -249,13 +201,16 @@ static void bt_a2d_source_cb(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param
 
 static int32_t bt_a2d_source_data_cb(uint8_t *data, int32_t len)
 {
-    if (s_aadp_handler.source_stream) {
+    a2dp_source_buffer_handle_t source_buffer = s_aadp_handler.source_buffer;
+    if (source_buffer && s_aadp_handler.source_stream) {
         if (audio_element_get_state(s_aadp_handler.source_stream) == AEL_STATE_RUNNING) {
             if (len < 0 || data == NULL) {
                 return 0;
             }
-            len = audio_element_input(s_aadp_handler.source_stream, (char *)data, len);
-            if (len == AEL_IO_DONE) {
+            // Never blocks, the buffer is filled by the a2dp task and an underrun is sent as silence
+            len = a2dp_source_buffer_read(source_buffer, data, len);
+            if (len == A2DP_SOURCE_BUFFER_DONE) {
+                len = 0;
                 esp_a2d_media_ctrl(ESP_A2D_MEDIA_CTRL_STOP);
                 if (s_aadp_handler.bt_avrc_periph) {
                     esp_periph_send_event(s_aadp_handler.bt_avrc_periph, PERIPH_BLUETOOTH_AUDIO_SUSPENDED, NULL, 0);
@@ -271,21 +226,24 @@ static esp_err_t a2dp_sink_destroy(audio_element_handle_t self)
 {
     ESP_LOGI(TAG, "a2dp_sink_destroy");
 
-    a2dp_data_t destroy_msg = {
-        .type = A2DP_TYPE_DESTROY,
-    };
-    if ( xQueueSend( s_aadp_handler.a2dp_queue, &destroy_msg, 0 )  != pdPASS ) {
-        ESP_LOGE(TAG, "Destroy audio_a2dp_stream_thread failed");
-        return ESP_FAIL;
-    }
+    a2dp_sink_buffer_handle_t sink_buffer = s_aadp_handler.sink_buffer;
+    s_aadp_handler.sink_buffer = NULL;
     s_aadp_handler.sink_stream = NULL;
+    if (sink_buffer) {
+        a2dp_sink_buffer_destroy(sink_buffer);
+    }
     memset(&s_aadp_handler.user_callback, 0, sizeof(a2dp_stream_user_callback_t));
     return ESP_OK;
 }
 
 static esp_err_t a2dp_source_destroy(audio_element_handle_t self)
 {
+    a2dp_source_buffer_handle_t source_buffer = s_aadp_handler.source_buffer;
+    s_aadp_handler.source_buffer = NULL;
     s_aadp_handler.source_stream = NULL;
+    if (source_buffer) {
+        a2dp_source_buffer_destroy(source_buffer);
+    }
     memset(&s_aadp_handler.user_callback, 0, sizeof(a2dp_stream_user_callback_t));
     return ESP_OK;
 }
@@ -344,21 +302,47 @@ audio_element_handle_t a2dp_stream_init(a2dp_stream_config_t *config)
     memcpy(&s_aadp_handler.user_callback, &config->user_callback, sizeof(a2dp_stream_user_callback_t));
 
     if (config->type == AUDIO_STREAM_READER) {
-        s_aadp_handler.a2dp_queue = xQueueCreate(A2DP_STREAM_QUEUE_SIZE, sizeof(a2dp_data_t));
-        if (s_aadp_handler.a2dp_queue == 0) {
-            ESP_LOGE(TAG, "Create a2dp queue failed(%d)", __LINE__);
+        a2dp_sink_buffer_cfg_t buffer_cfg = {
+            .buffer_size = config->jitter_buffer_size > 0 ? config->jitter_buffer_size : A2DP_STREAM_JITTER_BUFFER_SIZE,
+            .task_stack = A2DP_STREAM_TASK_STACK,
+            .task_prio = A2DP_STREAM_TASK_PRIO,
+            .task_core = A2DP_STREAM_TASK_CORE,
+            .ext_stack = A2DP_STREAM_TASK_IN_EXT,
+        };
+        s_aadp_handler.sink_buffer = a2dp_sink_buffer_create(el, &buffer_cfg);
+        if (s_aadp_handler.sink_buffer == NULL) {
+            ESP_LOGE(TAG, "Create a2dp sink buffer failed(%d)", __LINE__);
             return NULL;
         }
-        esp_err_t err = audio_thread_create(&s_aadp_handler.a2dp_thread, "audio_a2dp_stream_thread", audio_a2dp_stream_thread, NULL,
-                                            A2DP_STREAM_TASK_STACK, A2DP_STREAM_TASK_PRIO, A2DP_STREAM_TASK_IN_EXT, A2DP_STREAM_TASK_CORE);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Create audio_a2dp_stream_thread failed(%d)", __LINE__);
+    } else {
+        int buffer_size = config->jitter_buffer_size > 0 ? config->jitter_buffer_size : A2DP_STREAM_JITTER_BUFFER_SIZE;
+        a2dp_source_buffer_cfg_t buffer_cfg = {
+            .buffer_size = buffer_size,
+            .prefill_size = buffer_size / 2,
+            .task_stack = A2DP_STREAM_TASK_STACK,
+            .task_prio = A2DP_STREAM_TASK_PRIO,
+            .task_core = A2DP_STREAM_TASK_CORE,
+            .ext_stack = A2DP_STREAM_TASK_IN_EXT,
+        };
+        s_aadp_handler.source_buffer = a2dp_source_buffer_create(el, &buffer_cfg);
+        if (s_aadp_handler.source_buffer == NULL) {
+            ESP_LOGE(TAG, "Create a2dp source buffer failed(%d)", __LINE__);
             return NULL;
         }
     }
     return el;
 }
 
+esp_err_t a2dp_stream_get_sink_stats(a2dp_stream_sink_stats_t *stats)
+{
+    return a2dp_sink_buffer_get_stats(s_aadp_handler.sink_buffer, stats);
+}
+
+esp_err_t a2dp_stream_get_source_stats(a2dp_stream_source_stats_t *stats)
+{
+    return a2dp_source_buffer_get_stats(s_aadp_handler.source_buffer, stats);
+}
+
 esp_err_t a2dp_destroy()
 {
     if (s_aadp_handler.stream_type == AUDIO_STREAM_READER) {
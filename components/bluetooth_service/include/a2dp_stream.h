@@ -33,6 +33,29 @@
 extern "C" {
 #endif
 
+/**
+ * @brief   Counters of the a2dp sink data path
+ */
+typedef struct {
+    uint32_t    received_pkts;      /*!< Packets received from Bluetooth */
+    uint32_t    received_bytes;     /*!< Bytes received from Bluetooth */
+    uint32_t    dropped_pkts;       /*!< Packets dropped because the jitter buffer was full */
+    uint32_t    dropped_bytes;      /*!< Bytes dropped because the jitter buffer was full */
+    int         filled;             /*!< Bytes in jitter buffer now */
+    int         max_filled;         /*!< Highest fill level of jitter buffer */
+} a2dp_stream_sink_stats_t;
+
+/**
+ * @brief   Counters of the a2dp source data path
+ */
+typedef struct {
+    uint32_t    requested_bytes;    /*!< Bytes requested by Bluetooth */
+    uint32_t    underruns;          /*!< Times the buffer ran dry while the input was not done */
+    uint32_t    silence_bytes;      /*!< Bytes of silence sent, on underrun and while prefilling */
+    int         filled;             /*!< Bytes in buffer now */
+    int         min_filled;         /*!< Lowest fill level seen by the data callback */
+} a2dp_stream_source_stats_t;
+
 #if (defined CONFIG_CLASSIC_BT_ENABLED)
 #include "esp_bt.h"
 #include "esp_bt_main.h"
@@ -56,16 +79,17 @@ typedef struct {
 #if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0))
     audio_hal_handle_t          audio_hal;
 #endif
+    int                         jitter_buffer_size; /*!< Size of buffer between Bluetooth and the pipeline in bytes, for sink and source, 0 to use A2DP_STREAM_JITTER_BUFFER_SIZE */
 } a2dp_stream_config_t;
 
 /**
- * a2dp task is only created in a2dp sink mode
+ * a2dp task moves data between the Bluetooth buffer and the pipeline, in sink and source mode
  */
 #define A2DP_STREAM_TASK_STACK          ( 2 * 1024 )
 #define A2DP_STREAM_TASK_CORE           ( 0 )
 #define A2DP_STREAM_TASK_PRIO           ( 22 )
 #define A2DP_STREAM_TASK_IN_EXT         ( true )
-#define A2DP_STREAM_QUEUE_SIZE          ( 20 )
+#define A2DP_STREAM_JITTER_BUFFER_SIZE  ( 32 * 1024 )  /* About 185 ms of 44.1 kHz 16-bit stereo */
 
 /**
  * @brief      Create a handle to an Audio Element to stream data from A2DP to another Element
@@ -78,6 +102,31 @@ typedef struct {
  */
 audio_element_handle_t a2dp_stream_init(a2dp_stream_config_t *config);
 
+/**
+ * @brief      Get counters of the a2dp sink data path. Packets arriving while the jitter buffer
+ *             is full are dropped whole, the Bluetooth task is never blocked.
+ *
+ * @param[out] stats  The counters
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL, no a2dp sink stream
+ */
+esp_err_t a2dp_stream_get_sink_stats(a2dp_stream_sink_stats_t *stats);
+
+/**
+ * @brief      Get counters of the a2dp source data path. The pipeline fills a buffer at its own pace and the
+ *             Bluetooth data callback drains it without blocking, an underrun is padded with silence and the
+ *             callback sends silence until half of the buffer is filled again.
+ *
+ * @param[out] stats  The counters
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL, no a2dp source stream
+ */
+esp_err_t a2dp_stream_get_source_stats(a2dp_stream_source_stats_t *stats);
+
 /**
  * @brief      Destroy and cleanup A2DP profile.
  *
@@ -0,0 +1,193 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Host benchmark of the a2dp sink data path, see build.pl
+ *
+ * A generator thread stands for the Bluetooth stack, it calls the data callback path with 44.1 kHz
+ * stereo packets in bursts, the element output stands for I2S and drains in real time. Time runs
+ * `SPEED` times faster than real. Each frame carries its packet number and index, the output checks
+ * that only whole packets are missing and that nothing is allocated while streaming.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "audio_mem.h"
+#include "a2dp_sink_buffer.h"
+
+#define SPEED               (10)
+#define SAMPLE_RATE         (44100)
+#define FRAME_SIZE          (4)
+#define PACKET_FRAMES       (512)
+#define PACKET_SIZE         (PACKET_FRAMES * FRAME_SIZE)
+#define BURST_PACKETS       (4)
+
+typedef struct {
+    int         stall_at_ms;    /* Output stops for `stall_ms` at this time */
+    int         stall_ms;
+    int64_t     start_us;
+    int64_t     output_bytes;
+    uint32_t    last_frame;
+    int         whole_packet_gaps;
+    int         errors;
+} output_sim_t;
+
+static output_sim_t s_out;
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(int64_t us)
+{
+    if (us > 0) {
+        usleep(us);
+    }
+}
+
+static int64_t audio_us(int64_t bytes)
+{
+    return bytes * 1000000 / (SAMPLE_RATE * FRAME_SIZE) / SPEED;
+}
+
+int audio_element_output(audio_element_handle_t el, char *buffer, int write_size)
+{
+    uint32_t *frames = (uint32_t *)buffer;
+    for (int i = 0; i < write_size / FRAME_SIZE; i++) {
+        uint32_t f = frames[i];
+        uint32_t expect = s_out.last_frame + 1;
+        if ((expect & 0xffff) == PACKET_FRAMES) {
+            expect = (expect & 0xffff0000) + 0x10000;
+        }
+        if (f != expect && s_out.output_bytes + i * FRAME_SIZE > 0) {
+            if ((f & 0xffff) == 0 && (f >> 16) > (s_out.last_frame >> 16) && (s_out.last_frame & 0xffff) == PACKET_FRAMES - 1) {
+                s_out.whole_packet_gaps++;
+            } else {
+                s_out.errors++;
+            }
+        }
+        s_out.last_frame = f;
+    }
+    s_out.output_bytes += write_size;
+    // Drain like I2S, never faster than real time
+    int64_t played_at = s_out.start_us + audio_us(s_out.output_bytes);
+    int64_t stall_start = s_out.start_us + (int64_t)s_out.stall_at_ms * 1000 / SPEED;
+    if (s_out.stall_ms && now_us() >= stall_start) {
+        sleep_us((int64_t)s_out.stall_ms * 1000 / SPEED);
+        s_out.start_us += (int64_t)s_out.stall_ms * 1000 / SPEED;
+        s_out.stall_ms = 0;
+    }
+    sleep_us(played_at - now_us());
+    return write_size;
+}
+
+static int run(const char *name, int buffer_size, int seconds, int stall_at_ms, int stall_ms)
+{
+    memset(&s_out, 0, sizeof(s_out));
+    s_out.stall_at_ms = stall_at_ms;
+    s_out.stall_ms = stall_ms;
+    s_out.last_frame = 0xffffffff;
+    a2dp_sink_buffer_cfg_t cfg = {
+        .buffer_size = buffer_size,
+    };
+    a2dp_sink_buffer_handle_t buf = a2dp_sink_buffer_create(NULL, &cfg);
+    if (buf == NULL) {
+        return -1;
+    }
+    audio_mem_stats_t mem;
+    audio_mem_get_stats(&mem);
+    uint32_t alloc_before = mem.alloc_count;
+    static uint32_t packet[PACKET_FRAMES];
+    int num = seconds * SAMPLE_RATE / PACKET_FRAMES;
+    int64_t cb_total_us = 0;
+    int cb_max_us = 0;
+    int64_t start = now_us();
+    s_out.start_us = start + audio_us(PACKET_SIZE * BURST_PACKETS);
+    for (int p = 0; p < num; p++) {
+        // The radio delivers in bursts, the average rate matches the output
+        if (p % BURST_PACKETS == 0) {
+            sleep_us(start + audio_us((int64_t)p * PACKET_SIZE) - now_us());
+        }
+        for (int i = 0; i < PACKET_FRAMES; i++) {
+            packet[i] = ((uint32_t)p << 16) | i;
+        }
+        int64_t t = now_us();
+        a2dp_sink_buffer_write(buf, (const uint8_t *)packet, PACKET_SIZE);
+        int used = (int)(now_us() - t);
+        cb_total_us += used;
+        if (used > cb_max_us) {
+            cb_max_us = used;
+        }
+    }
+    a2dp_stream_sink_stats_t stats;
+    do {
+        usleep(1000);
+        a2dp_sink_buffer_get_stats(buf, &stats);
+    } while (stats.filled > 0);
+    usleep(audio_us(PACKET_SIZE) + 1000);
+    audio_mem_get_stats(&mem);
+    int allocs = (int)(mem.alloc_count - alloc_before);
+    a2dp_sink_buffer_destroy(buf);
+    usleep(10000);
+
+    printf("%-26s %5d pkts, dropped %4d, max filled %6d/%d, callback avg %.2f us max %d us, allocs %d\n",
+           name, (int)stats.received_pkts, (int)stats.dropped_pkts, stats.max_filled, buffer_size,
+           (double)cb_total_us / num, cb_max_us, allocs);
+    int64_t expect = (int64_t)(stats.received_bytes - stats.dropped_bytes);
+    if (s_out.errors || allocs || s_out.output_bytes != expect) {
+        printf("  FAILED: %d broken frames, %lld bytes output, expect %lld\n", s_out.errors,
+               (long long)s_out.output_bytes, (long long)expect);
+        return -1;
+    }
+    if (stats.dropped_pkts && s_out.whole_packet_gaps == 0) {
+        printf("  FAILED: dropped packets not seen in output\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 20;
+    printf("Stream %d s of 44.1 kHz stereo in %d byte packets, %dx real time\n", seconds, PACKET_SIZE, SPEED);
+    if (run("steady", 32 * 1024, seconds, 0, 0) != 0) {
+        return 1;
+    }
+    if (run("output stall 100 ms", 32 * 1024, seconds, 3000, 100) != 0) {
+        return 1;
+    }
+    if (run("output stall 500 ms", 32 * 1024, seconds, 3000, 500) != 0) {
+        return 1;
+    }
+    if (run("stall 500 ms, 128K buffer", 128 * 1024, seconds, 3000, 500) != 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,268 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2024 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Host benchmark of the a2dp source data path, see build.pl
+ *
+ * The element input stands for a decoder behind HTTP, it keeps real time but stalls now and then. A thread stands for the Bluetooth stack and asks for 10 ms of 44.1 kHz stereo at the A2DP cadence.
+ * Time runs `SPEED` times faster than real. It compares the buffered path against reading the element
+ * input in the callback, as before, and checks that every frame arrives once and in order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "audio_mem.h"
+#include "a2dp_source_buffer.h"
+
+#define SPEED               (10)
+#define SAMPLE_RATE         (44100)
+#define FRAME_SIZE          (4)
+#define TICK_MS             (10)
+#define TICK_SIZE           (SAMPLE_RATE * TICK_MS / 1000 * FRAME_SIZE)
+
+typedef struct {
+    int         seconds;
+    int         stall_every_ms;     /* Producer stalls this often */
+    int         stall_ms;           /* For this long */
+    int64_t     start_us;
+    uint32_t    next_frame;         /* Frame numbers start from 1, 0 is silence */
+    uint32_t    total_frames;
+} producer_sim_t;
+
+static producer_sim_t s_prod;
+static volatile audio_element_state_t s_state = AEL_STATE_RUNNING;
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(int64_t us)
+{
+    if (us > 0) {
+        usleep(us);
+    }
+}
+
+audio_element_state_t audio_element_get_state(audio_element_handle_t el)
+{
+    return s_state;
+}
+
+int audio_element_output(audio_element_handle_t el, char *buffer, int write_size)
+{
+    return write_size;
+}
+
+int audio_element_input(audio_element_handle_t el, char *buffer, int wanted_size)
+{
+    if (s_prod.next_frame > s_prod.total_frames) {
+        return AEL_IO_DONE;
+    }
+    // Decoding keeps real time, except that it stalls for `stall_ms` every `stall_every_ms` of media
+    int64_t media_us = (int64_t)s_prod.next_frame * 1000000 / SAMPLE_RATE / SPEED;
+    int64_t ready_at = s_prod.start_us + media_us;
+    if (s_prod.stall_every_ms) {
+        int64_t period_us = (int64_t)s_prod.stall_every_ms * 1000 / SPEED;
+        int64_t stall_us = (int64_t)s_prod.stall_ms * 1000 / SPEED;
+        int64_t in_period = media_us % period_us;
+        if (media_us >= period_us && in_period < stall_us) {
+            ready_at += stall_us - in_period;
+        }
+    }
+    sleep_us(ready_at - now_us());
+    uint32_t *frames = (uint32_t *)buffer;
+    int n = wanted_size / FRAME_SIZE;
+    if (n > 512) {
+        n = 512;
+    }
+    int i = 0;
+    for (; i < n && s_prod.next_frame <= s_prod.total_frames; i++) {
+        frames[i] = s_prod.next_frame++;
+    }
+    return i * FRAME_SIZE;
+}
+
+typedef struct {
+    uint32_t    last_frame;
+    int         errors;
+    uint32_t    audio_frames;
+    uint32_t    silent_ticks;
+    int         max_cb_us;
+    int64_t     total_cb_us;
+    int         ticks;
+} link_result_t;
+
+static void check_tick(link_result_t *r, uint8_t *data, int len)
+{
+    uint32_t *frames = (uint32_t *)data;
+    bool silent = false;
+    for (int i = 0; i < len / FRAME_SIZE; i++) {
+        if (frames[i] == 0) {
+            silent = true;
+            continue;
+        }
+        if (frames[i] != r->last_frame + 1) {
+            r->errors++;
+        }
+        r->last_frame = frames[i];
+        r->audio_frames++;
+    }
+    if (silent) {
+        r->silent_ticks++;
+    }
+}
+
+static void start_stream(int seconds, int stall_every_ms, int stall_ms)
+{
+    memset(&s_prod, 0, sizeof(s_prod));
+    s_prod.seconds = seconds;
+    s_prod.stall_every_ms = stall_every_ms;
+    s_prod.stall_ms = stall_ms;
+    s_prod.next_frame = 1;
+    s_prod.total_frames = s_prod.seconds * SAMPLE_RATE;
+    s_prod.start_us = now_us();
+}
+
+static int run(const char *name, bool buffered, int stall_every_ms, int stall_ms)
+{
+    start_stream(20, stall_every_ms, stall_ms);
+
+    a2dp_source_buffer_handle_t buf = NULL;
+    if (buffered) {
+        a2dp_source_buffer_cfg_t cfg = {
+            .buffer_size = 32 * 1024,
+            .prefill_size = 16 * 1024,
+        };
+        buf = a2dp_source_buffer_create(NULL, &cfg);
+        if (buf == NULL) {
+            return -1;
+        }
+    }
+    link_result_t r = { 0 };
+    static uint8_t data[TICK_SIZE];
+    int64_t start = now_us();
+    for (int tick = 0; ; tick++) {
+        sleep_us(start + (int64_t)tick * TICK_MS * 1000 / SPEED - now_us());
+        int64_t t = now_us();
+        int len;
+        if (buffered) {
+            len = a2dp_source_buffer_read(buf, data, TICK_SIZE);
+        } else {
+            memset(data, 0, sizeof(data));
+            len = audio_element_input(NULL, (char *)data, TICK_SIZE);
+        }
+        int used = (int)(now_us() - t);
+        r.total_cb_us += used;
+        r.ticks++;
+        if (used > r.max_cb_us) {
+            r.max_cb_us = used;
+        }
+        if (len <= 0) {
+            break;
+        }
+        check_tick(&r, data, len);
+    }
+    int64_t late_ms = (now_us() - start) * SPEED / 1000 - s_prod.seconds * 1000;
+    a2dp_stream_source_stats_t stats = { 0 };
+    if (buf) {
+        a2dp_source_buffer_get_stats(buf, &stats);
+        a2dp_source_buffer_destroy(buf);
+        usleep(50000);
+    }
+    printf("%-28s callback avg %6.1f us max %6d us, underruns %3d, silent ticks %3d, min filled %5d, end late %4d ms\n",
+           name, (double)r.total_cb_us / r.ticks, r.max_cb_us, (int)stats.underruns, (int)r.silent_ticks,
+           stats.min_filled, (int)late_ms);
+    if (r.errors || r.audio_frames != s_prod.total_frames) {
+        printf("  FAILED: %d frames out of order, %u of %u frames sent\n", r.errors, r.audio_frames, s_prod.total_frames);
+        return -1;
+    }
+    return 0;
+}
+
+/* Stop the element while the buffer holds audio, the next stream must start from its own first frame */
+static int restart(void)
+{
+    a2dp_source_buffer_cfg_t cfg = {
+        .buffer_size = 32 * 1024,
+        .prefill_size = 16 * 1024,
+    };
+    a2dp_source_buffer_handle_t buf = a2dp_source_buffer_create(NULL, &cfg);
+    if (buf == NULL) {
+        return -1;
+    }
+    static uint8_t data[TICK_SIZE];
+    link_result_t first = { 0 };
+    start_stream(20, 0, 0);
+    for (int tick = 0; tick < 100; tick++) {
+        usleep(TICK_MS * 1000 / SPEED);
+        check_tick(&first, data, a2dp_source_buffer_read(buf, data, TICK_SIZE));
+    }
+    s_state = AEL_STATE_STOPPED;
+    usleep(100000);
+    a2dp_stream_source_stats_t stats = { 0 };
+    a2dp_source_buffer_get_stats(buf, &stats);
+
+    link_result_t r = { 0 };
+    start_stream(2, 0, 0);
+    s_state = AEL_STATE_RUNNING;
+    while (r.audio_frames < s_prod.total_frames && r.ticks < 1000) {
+        usleep(TICK_MS * 1000 / SPEED);
+        int len = a2dp_source_buffer_read(buf, data, TICK_SIZE);
+        r.ticks++;
+        if (len <= 0) {
+            break;
+        }
+        check_tick(&r, data, len);
+    }
+    a2dp_source_buffer_destroy(buf);
+    usleep(50000);
+    printf("%-28s %5d bytes left at stop, %u of %u frames of the next stream, %d out of order\n",
+           "buffered, restart", stats.filled, r.audio_frames, s_prod.total_frames, r.errors);
+    if (first.errors || stats.filled == 0 || r.errors || r.audio_frames != s_prod.total_frames) {
+        printf("  FAILED: the next stream does not start clean\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    printf("Send 20 s of 44.1 kHz stereo, %d ms ticks, %dx real time. Callback times are host time, end late is media time\n",
+           TICK_MS, SPEED);
+    if (run("callback reads input", false, 0, 0) != 0
+        || run("buffered", true, 0, 0) != 0
+        || run("callback reads input, stall", false, 2000, 80) != 0
+        || run("buffered, stall", true, 2000, 80) != 0
+        || run("buffered, long stall", true, 2000, 300) != 0
+        || restart() != 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,22 @@
+#!/usr/bin/perl
+#
+# Build the a2dp sink and source data path benchmarks on host, on the pthread FreeRTOS port of
+# audio_pipeline/test/host/port. The Bluetooth data callbacks are driven by synthetic PCM generators.
+# Run them as:
+#   ./build.pl && ./bench_a2dp_sink && ./bench_a2dp_source
+#
+# Pass "asan" to build with the address and undefined behaviour sanitizers.
+#
+use strict;
+
+my $r = "../../..";
+my $port = "$r/audio_pipeline/test/host/port";
+my @src = ("$r/audio_sal/audio_mem.c", "$r/audio_sal/audio_mutex.c", "$r/audio_sal/audio_thread.c",
+           "$r/audio_pipeline/ringbuf.c", "$port/freertos_posix.c");
+my $inc = "-D_GNU_SOURCE -I$port -I$r/audio_sal/include -I$r/audio_pipeline/include -I$r/audio_hal/include -I../.. -I../../include";
+my $opt = (grep { $_ eq "asan" } @ARGV) ? "-O1 -fsanitize=address,undefined -fno-omit-frame-pointer" : "-O2";
+
+foreach my $name ("sink", "source") {
+    system("gcc $opt -g -Wall @src ../../a2dp_${name}_buffer.c bench_a2dp_${name}.c $inc -o ./bench_a2dp_${name} -lpthread -lm") == 0
+        or die "build failed";
+}
@@ -26,6 +26,7 @@
 #define __PARTITION_ACTION__
 
 #include "esp_partition.h"
+#include "esp_idf_version.h"
 #include "esp_action_def.h"
 
 #ifdef __cplusplus
@@ -61,6 +62,28 @@ typedef struct partition_write_args_s {
     size_t size;
 } partition_write_args_t;
 
+/**
+ * @brief   Handle of a partition mapping
+ */
+#if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0))
+typedef esp_partition_mmap_handle_t partition_mmap_handle_t;
+#define PARTITION_MMAP_DATA     ESP_PARTITION_MMAP_DATA
+#else
+typedef spi_flash_mmap_handle_t partition_mmap_handle_t;
+#define PARTITION_MMAP_DATA     SPI_FLASH_MMAP_DATA
+#endif
+
+/**
+ * @brief   The arguments structure of partition mmap action
+ */
+typedef struct partition_mmap_args_s {
+    const esp_partition_t *partition;
+    size_t offset;
+    size_t size;
+    const void **out_ptr;
+    partition_mmap_handle_t *out_handle;
+} partition_mmap_args_t;
+
 /**
  * @brief      Partition find first
  *
@@ -100,6 +123,32 @@ esp_err_t partition_read_action(void *instance, action_arg_t *arg, action_result
  */
 esp_err_t partition_write_action(void *instance, action_arg_t *arg, action_result_t *result);
 
+/**
+ * @brief      Partition mmap, map a region of the partition into data memory
+ *
+ * @param instance          The execution instance
+ * @param arg               The arguments of execution function, `partition_mmap_args_t`
+ * @param result            The result of execution function
+ *
+ * @return
+ *     - ESP_OK, success
+ *     - Others, error
+ */
+esp_err_t partition_mmap_action(void *instance, action_arg_t *arg, action_result_t *result);
+
+/**
+ * @brief      Partition munmap, release a mapping made by `partition_mmap_action`
+ *
+ * @param instance          The execution instance
+ * @param arg               The arguments of execution function, pointer to `partition_mmap_handle_t`
+ * @param result            The result of execution function
+ *
+ * @return
+ *     - ESP_OK, success
+ *     - Others, error
+ */
+esp_err_t partition_munmap_action(void *instance, action_arg_t *arg, action_result_t *result);
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,6 +9,14 @@
 #include "audio_codec_sw_vol.h"
 
 #define GAIN_0DB_SHIFT (15)
+#define GAIN_0DB       (1 << GAIN_0DB_SHIFT)
+
+/* Gain is updated once every RAMP_BLOCK_FRAMES frames during fade instead of every frame */
+#define RAMP_BLOCK_FRAMES (32)
+
+#define SAT_INT16(v) ((v) > INT16_MAX ? INT16_MAX : ((v) < INT16_MIN ? INT16_MIN : (v)))
+#define SAT_INT24(v) ((v) > 0x7FFFFF ? 0x7FFFFF : ((v) < -0x800000 ? -0x800000 : (v)))
+#define SAT_INT32(v) ((v) > INT32_MAX ? INT32_MAX : ((v) < INT32_MIN ? INT32_MIN : (v)))
 
 typedef struct {
     audio_codec_vol_if_t        base;
@@ -21,6 +29,90 @@ typedef struct {
     int                         duration;
 } audio_vol_t;
 
+static void _vol_apply_16(const int16_t *in, int16_t *out, int n, int gain)
+{
+    int32_t v0, v1, v2, v3;
+    // Unrolled so that loads and multiplies of 4 samples can be interleaved
+    while (n >= 4) {
+        v0 = ((int32_t) in[0] * gain) >> GAIN_0DB_SHIFT;
+        v1 = ((int32_t) in[1] * gain) >> GAIN_0DB_SHIFT;
+        v2 = ((int32_t) in[2] * gain) >> GAIN_0DB_SHIFT;
+        v3 = ((int32_t) in[3] * gain) >> GAIN_0DB_SHIFT;
+        out[0] = (int16_t) SAT_INT16(v0);
+        out[1] = (int16_t) SAT_INT16(v1);
+        out[2] = (int16_t) SAT_INT16(v2);
+        out[3] = (int16_t) SAT_INT16(v3);
+        in += 4;
+        out += 4;
+        n -= 4;
+    }
+    while (n-- > 0) {
+        v0 = ((int32_t) *in++ * gain) >> GAIN_0DB_SHIFT;
+        *out++ = (int16_t) SAT_INT16(v0);
+    }
+}
+
+static void _vol_apply_24(const uint8_t *in, uint8_t *out, int n, int gain)
+{
+    while (n-- > 0) {
+        // Little endian packed 24 bits, sign extended through the top byte
+        int32_t s = (int32_t) (((uint32_t) in[0] << 8) | ((uint32_t) in[1] << 16) | ((uint32_t) in[2] << 24)) >> 8;
+        int32_t v = (int32_t) (((int64_t) s * gain) >> GAIN_0DB_SHIFT);
+        v = SAT_INT24(v);
+        out[0] = (uint8_t) v;
+        out[1] = (uint8_t) (v >> 8);
+        out[2] = (uint8_t) (v >> 16);
+        in += 3;
+        out += 3;
+    }
+}
+
+static void _vol_apply_32(const int32_t *in, int32_t *out, int n, int gain)
+{
+    int64_t v0, v1;
+    while (n >= 2) {
+        v0 = ((int64_t) in[0] * gain) >> GAIN_0DB_SHIFT;
+        v1 = ((int64_t) in[1] * gain) >> GAIN_0DB_SHIFT;
+        out[0] = (int32_t) SAT_INT32(v0);
+        out[1] = (int32_t) SAT_INT32(v1);
+        in += 2;
+        out += 2;
+        n -= 2;
+    }
+    if (n > 0) {
+        v0 = ((int64_t) in[0] * gain) >> GAIN_0DB_SHIFT;
+        out[0] = (int32_t) SAT_INT32(v0);
+    }
+}
+
+static void _vol_apply(audio_vol_t *vol, uint8_t *in, uint8_t *out, int frames, int gain)
+{
+    int n = frames * vol->fs.channel;
+    if (gain == 0) {
+        memset(out, 0, frames * vol->block_size);
+        return;
+    }
+    if (gain == GAIN_0DB) {
+        if (in != out) {
+            memmove(out, in, frames * vol->block_size);
+        }
+        return;
+    }
+    switch (vol->fs.bits_per_sample) {
+        case 16:
+            _vol_apply_16((const int16_t *) in, (int16_t *) out, n, gain);
+            break;
+        case 24:
+            _vol_apply_24(in, out, n, gain);
+            break;
+        case 32:
+            _vol_apply_32((const int32_t *) in, (int32_t *) out, n, gain);
+            break;
+        default:
+            break;
+    }
+}
+
 static int _sw_vol_close(const audio_codec_vol_if_t *h)
 {
     audio_vol_t *vol = (audio_vol_t *)h;
@@ -37,7 +129,7 @@ static int _sw_vol_open(const audio_codec_vol_if_t *h, esp_codec_dev_sample_info
     if (vol == NULL || fs == NULL) {
         return ESP_CODEC_DEV_INVALID_ARG;
     }
-    if (fs->bits_per_sample != 16) {
+    if (fs->bits_per_sample != 16 && fs->bits_per_sample != 24 && fs->bits_per_sample != 32) {
         return ESP_CODEC_DEV_NOT_SUPPORT;
     }
     vol->fs = *fs;
@@ -58,40 +150,24 @@ static int _sw_vol_process(const audio_codec_vol_if_t *h, uint8_t *in, int len,
         return ESP_CODEC_DEV_WRONG_STATE;
     }
     int sample = len / vol->block_size;
-    if (vol->fs.bits_per_sample == 16) {
-        int16_t *v_in = (int16_t *) in;
-        int16_t *v_out = (int16_t *) out;
-        if (vol->cur == vol->gain) {
-            if (vol->gain == 0) {
-                memset(out, 0, len);
-                return 0;
-            } else {
-                for (int i = 0; i < sample; i++) {
-                    for (int j = 0; j < vol->fs.channel; j++) {
-                        *(v_out++) = ((*v_in++) * vol->cur) >> GAIN_0DB_SHIFT;
-                    }
-                }
-                return 0;
-            }
+    if (vol->cur == vol->gain) {
+        _vol_apply(vol, in, out, sample, vol->cur);
+        return 0;
+    }
+    // Fade in blocks, keep gain constant inside one block and move by the accumulated step after it
+    while (sample > 0) {
+        int frames = (vol->step && sample > RAMP_BLOCK_FRAMES) ? RAMP_BLOCK_FRAMES : sample;
+        _vol_apply(vol, in, out, frames, vol->cur);
+        in += frames * vol->block_size;
+        out += frames * vol->block_size;
+        sample -= frames;
+        if (vol->step == 0) {
+            continue;
         }
-        for (int i = 0; i < sample; i++) {
-            for (int j = 0; j < vol->fs.channel; j++) {
-                *(v_out++) = ((*v_in++) * vol->cur) >> GAIN_0DB_SHIFT;
-            }
-            if (vol->step) {
-                vol->cur += vol->step;
-                if (vol->step > 0) {
-                    if (vol->cur > vol->gain) {
-                        vol->cur = vol->gain;
-                        vol->step = 0;
-                    }
-                } else {
-                    if (vol->cur < vol->gain) {
-                        vol->cur = vol->gain;
-                        vol->step = 0;
-                    }
-                }
-            }
+        vol->cur += vol->step * frames;
+        if ((vol->step > 0 && vol->cur > vol->gain) || (vol->step < 0 && vol->cur < vol->gain)) {
+            vol->cur = vol->gain;
+            vol->step = 0;
         }
     }
     return 0;
@@ -14,7 +14,7 @@ extern "C" {
 
 /**
  * @brief         New software volume processor interface
- *                Notes: currently only support 16bits input
+ *                Notes: support 16, 24 (packed) and 32 bits input, results are saturated
  * @return        NULL: Memory not enough
  *                -Others: Software volume interface handle
  */
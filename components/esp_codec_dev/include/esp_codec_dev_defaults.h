@@ -73,6 +73,70 @@ typedef struct {
     int     clock_speed; /*!< SPI clock unit hz (use 10MHZif set to 0)*/
 } audio_codec_spi_cfg_t;
 
+/**
+ * @brief Register cache control configuration
+ *        Registers with 8 bits address and 8 bits value are cached, other accesses go to `ctrl_if` directly
+ */
+typedef struct {
+    const audio_codec_ctrl_if_t *ctrl_if;        /*!< Control interface to access codec registers */
+    int                          reg_num;        /*!< Registers to be cached (from address 0, max 256) */
+    bool                         auto_increment; /*!< Codec supports register address auto increment,
+                                                      adjacent registers are written in one transaction */
+    int                          max_burst;      /*!< Maximum registers in one transaction (16 if set to 0) */
+    const uint8_t               *volatile_regs;  /*!< Registers never cached like status and reset registers */
+    int                          volatile_num;   /*!< Number of volatile registers */
+} audio_codec_cache_ctrl_cfg_t;
+
+/**
+ * @brief Capture source type of software data interface
+ */
+typedef enum {
+    AUDIO_CODEC_SW_DATA_SRC_SILENCE,  /*!< Capture silence */
+    AUDIO_CODEC_SW_DATA_SRC_FILE,     /*!< Capture from WAV file (must use same format as input device) */
+    AUDIO_CODEC_SW_DATA_SRC_GEN,      /*!< Capture from user generator */
+    AUDIO_CODEC_SW_DATA_SRC_LOOPBACK, /*!< Capture played data after `loopback_delay_ms` */
+} audio_codec_sw_data_src_t;
+
+/**
+ * @brief Generator callback of software data interface
+ * @param         ctx: User context
+ * @param         fs: Input audio format
+ * @param         pos: Frame position from the start of capture
+ * @param         data: Data to be filled
+ * @param         frames: Frames to be filled
+ */
+typedef void (*audio_codec_sw_data_gen_t)(void *ctx, esp_codec_dev_sample_info_t *fs, int64_t pos, uint8_t *data, int frames);
+
+/**
+ * @brief Software data interface configuration
+ *        Read and write run at the pace of a virtual sample clock
+ *        so that playback and capture timing can be tested without real codec
+ */
+typedef struct {
+    float                     clock_ratio;       /*!< Virtual clock speed relative to real time (1.0 if set to 0) */
+    int                       buffer_ms;         /*!< Emulated DMA buffer for each direction (20ms if set to 0) */
+    const char               *out_file;          /*!< WAV file to store played data, set to NULL if not used */
+    uint8_t                  *mem_sink;          /*!< Memory to store played data, extra data is dropped when full */
+    int                       mem_sink_size;     /*!< Memory sink size */
+    audio_codec_sw_data_src_t src_type;          /*!< Capture source type */
+    const char               *in_file;           /*!< WAV file to capture from */
+    audio_codec_sw_data_gen_t gen;               /*!< Generator to capture from */
+    void                     *gen_ctx;           /*!< Generator context */
+    int                       loopback_delay_ms; /*!< Delay between played and captured data for loopback */
+} audio_codec_sw_data_cfg_t;
+
+/**
+ * @brief Software data interface statistics
+ */
+typedef struct {
+    uint32_t underrun;        /*!< Times playback buffer drained before new data written */
+    uint32_t overrun;         /*!< Times capture buffer full and oldest data dropped */
+    int64_t  played_frames;   /*!< Frames output by virtual clock */
+    int      pending_frames;  /*!< Frames written but not played yet */
+    int64_t  captured_frames; /*!< Frames read by user */
+    int      sink_size;       /*!< Data size stored in memory sink or output file */
+} audio_codec_sw_data_stats_t;
+
 /**
  * @brief         Get default codec GPIO interface
  * @return        NULL: Failed
@@ -94,6 +158,50 @@ const audio_codec_ctrl_if_t *audio_codec_new_spi_ctrl(audio_codec_spi_cfg_t *spi
  */
 const audio_codec_ctrl_if_t *audio_codec_new_i2c_ctrl(audio_codec_i2c_cfg_t *i2c_cfg);
 
+/**
+ * @brief         Get register cache control interface
+ * @note          It wraps another control interface, reads are served from register shadow
+ *                and writes of unchanged value are skipped
+ *                The wrapped interface is not deleted together, user need delete it after this interface deleted
+ * @return        NULL: Failed
+ *                Others: Register cache control interface
+ */
+const audio_codec_ctrl_if_t *audio_codec_new_cache_ctrl(audio_codec_cache_ctrl_cfg_t *cache_cfg);
+
+/**
+ * @brief         Defer register writes of cache control interface
+ * @note          Deferred writes are flushed in register address order when defer disabled,
+ *                so only defer sequences whose write order does not matter
+ *                Access to uncached registers flush pending writes firstly
+ * @param         ctrl_if: Register cache control interface
+ * @param         defer: Defer writes or not
+ * @return        ESP_CODEC_DEV_OK: Set defer success
+ *                ESP_CODEC_DEV_INVALID_ARG: Invalid arguments or not register cache control interface
+ *                ESP_CODEC_DEV_WRONG_STATE: Control interface not opened
+ *                Others: Fail to flush pending writes
+ */
+int audio_codec_cache_ctrl_defer(const audio_codec_ctrl_if_t *ctrl_if, bool defer);
+
+/**
+ * @brief         Flush pending writes of cache control interface
+ * @param         ctrl_if: Register cache control interface
+ * @return        ESP_CODEC_DEV_OK: Flush success
+ *                ESP_CODEC_DEV_INVALID_ARG: Invalid arguments or not register cache control interface
+ *                ESP_CODEC_DEV_WRONG_STATE: Control interface not opened
+ *                Others: Fail to write registers
+ */
+int audio_codec_cache_ctrl_flush(const audio_codec_ctrl_if_t *ctrl_if);
+
+/**
+ * @brief         Invalidate register shadow, need call after codec reset by GPIO or power
+ * @note          Pending writes are dropped
+ * @param         ctrl_if: Register cache control interface
+ * @return        ESP_CODEC_DEV_OK: Invalidate success
+ *                ESP_CODEC_DEV_INVALID_ARG: Invalid arguments or not register cache control interface
+ *                ESP_CODEC_DEV_WRONG_STATE: Control interface not opened
+ */
+int audio_codec_cache_ctrl_invalidate(const audio_codec_ctrl_if_t *ctrl_if);
+
 /**
  * @brief         Get default I2S data interface
  * @return        NULL: Failed
@@ -101,6 +209,25 @@ const audio_codec_ctrl_if_t *audio_codec_new_i2c_ctrl(audio_codec_i2c_cfg_t *i2c
  */
 const audio_codec_data_if_t *audio_codec_new_i2s_data(audio_codec_i2s_cfg_t *i2s_cfg);
 
+/**
+ * @brief         Get software data interface
+ * @note          Played data is stored into memory or WAV file, silence is stored when playback underrun
+ *                Output WAV header is updated when the data interface closed
+ * @return        NULL: Failed
+ *                Others: Software data interface
+ */
+const audio_codec_data_if_t *audio_codec_new_sw_data(audio_codec_sw_data_cfg_t *sw_cfg);
+
+/**
+ * @brief         Get statistics of software data interface
+ * @param         data_if: Software data interface
+ * @param         stats: Statistics to be filled
+ * @return        ESP_CODEC_DEV_OK: Get statistics success
+ *                ESP_CODEC_DEV_INVALID_ARG: Invalid arguments or not software data interface
+ *                ESP_CODEC_DEV_WRONG_STATE: Data interface not opened
+ */
+int audio_codec_sw_data_get_stats(const audio_codec_data_if_t *data_if, audio_codec_sw_data_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
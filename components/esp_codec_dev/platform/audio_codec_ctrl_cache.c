@@ -0,0 +1,300 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "audio_codec_ctrl_if.h"
+#include "esp_codec_dev_defaults.h"
+#include "esp_log.h"
+
+#define TAG "Cache_If"
+
+#define DEFAULT_MAX_BURST (16)
+#define REG_VALID         (1 << 0)
+#define REG_DIRTY         (1 << 1)
+#define REG_VOLATILE      (1 << 2)
+
+typedef struct {
+    audio_codec_ctrl_if_t        base;
+    bool                         is_open;
+    const audio_codec_ctrl_if_t *ctrl_if;
+    bool                         auto_increment;
+    int                          max_burst;
+    int                          reg_num;
+    bool                         defer;
+    int                          dirty_num;
+    uint8_t                     *value;
+    uint8_t                     *flag;
+} cache_ctrl_t;
+
+static bool is_cacheable(cache_ctrl_t *cache, int addr, int addr_len, int data_len)
+{
+    if (addr_len != 1 || addr < 0 || data_len <= 0 || addr + data_len > cache->reg_num) {
+        return false;
+    }
+    if (data_len > 1 && cache->auto_increment == false) {
+        return false;
+    }
+    for (int i = 0; i < data_len; i++) {
+        if (cache->flag[addr + i] & REG_VOLATILE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void invalidate_range(cache_ctrl_t *cache, int addr, int data_len)
+{
+    for (int i = 0; i < data_len; i++) {
+        if (addr + i >= 0 && addr + i < cache->reg_num) {
+            if (cache->flag[addr + i] & REG_DIRTY) {
+                cache->dirty_num--;
+            }
+            cache->flag[addr + i] &= REG_VOLATILE;
+        }
+    }
+}
+
+static int flush_dirty(cache_ctrl_t *cache)
+{
+    int ret = ESP_CODEC_DEV_OK;
+    int addr = 0;
+    while (cache->dirty_num > 0 && addr < cache->reg_num) {
+        if ((cache->flag[addr] & REG_DIRTY) == 0) {
+            addr++;
+            continue;
+        }
+        // Coalesce adjacent dirty registers into one transaction
+        int n = 1;
+        if (cache->auto_increment) {
+            while (n < cache->max_burst && addr + n < cache->reg_num && (cache->flag[addr + n] & REG_DIRTY)) {
+                n++;
+            }
+        }
+        int err = cache->ctrl_if->write_reg(cache->ctrl_if, addr, 1, cache->value + addr, n);
+        for (int i = 0; i < n; i++) {
+            cache->flag[addr + i] &= ~REG_DIRTY;
+            if (err != ESP_CODEC_DEV_OK) {
+                cache->flag[addr + i] &= ~REG_VALID;
+            }
+        }
+        cache->dirty_num -= n;
+        if (err != ESP_CODEC_DEV_OK) {
+            ESP_LOGE(TAG, "Fail to flush reg %x len %d", addr, n);
+            ret = err;
+        }
+        addr += n;
+    }
+    return ret;
+}
+
+static int _cache_ctrl_open(const audio_codec_ctrl_if_t *ctrl, void *cfg, int cfg_size)
+{
+    if (ctrl == NULL || cfg == NULL || cfg_size != sizeof(audio_codec_cache_ctrl_cfg_t)) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    audio_codec_cache_ctrl_cfg_t *cache_cfg = (audio_codec_cache_ctrl_cfg_t *) cfg;
+    if (cache_cfg->ctrl_if == NULL || cache_cfg->reg_num <= 0 || cache_cfg->reg_num > 256) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    cache->ctrl_if = cache_cfg->ctrl_if;
+    cache->reg_num = cache_cfg->reg_num;
+    cache->auto_increment = cache_cfg->auto_increment;
+    cache->max_burst = cache_cfg->max_burst > 0 ? cache_cfg->max_burst : DEFAULT_MAX_BURST;
+    cache->value = (uint8_t *) calloc(2, cache->reg_num);
+    if (cache->value == NULL) {
+        return ESP_CODEC_DEV_NO_MEM;
+    }
+    cache->flag = cache->value + cache->reg_num;
+    for (int i = 0; i < cache_cfg->volatile_num; i++) {
+        if (cache_cfg->volatile_regs[i] < cache->reg_num) {
+            cache->flag[cache_cfg->volatile_regs[i]] = REG_VOLATILE;
+        }
+    }
+    cache->is_open = true;
+    return ESP_CODEC_DEV_OK;
+}
+
+static bool _cache_ctrl_is_open(const audio_codec_ctrl_if_t *ctrl)
+{
+    if (ctrl) {
+        cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+        return cache->is_open;
+    }
+    return false;
+}
+
+static int _cache_ctrl_read_reg(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
+{
+    if (ctrl == NULL || data == NULL) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache->is_open == false) {
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    if (is_cacheable(cache, addr, addr_len, data_len) == false) {
+        // Device state may depend on pending writes, keep the order seen by codec
+        flush_dirty(cache);
+        return cache->ctrl_if->read_reg(cache->ctrl_if, addr, addr_len, data, data_len);
+    }
+    bool hit = true;
+    for (int i = 0; i < data_len; i++) {
+        if ((cache->flag[addr + i] & REG_VALID) == 0) {
+            hit = false;
+            break;
+        }
+    }
+    if (hit == false) {
+        int ret = cache->ctrl_if->read_reg(cache->ctrl_if, addr, addr_len, data, data_len);
+        if (ret != ESP_CODEC_DEV_OK) {
+            return ret;
+        }
+        // Do not overwrite pending values with the old device values
+        for (int i = 0; i < data_len; i++) {
+            if ((cache->flag[addr + i] & REG_DIRTY) == 0) {
+                cache->value[addr + i] = ((uint8_t *) data)[i];
+                cache->flag[addr + i] |= REG_VALID;
+            }
+        }
+    }
+    memcpy(data, cache->value + addr, data_len);
+    return ESP_CODEC_DEV_OK;
+}
+
+static int _cache_ctrl_write_reg(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
+{
+    if (ctrl == NULL || data == NULL) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache->is_open == false) {
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    if (is_cacheable(cache, addr, addr_len, data_len) == false) {
+        flush_dirty(cache);
+        if (addr_len == 1) {
+            invalidate_range(cache, addr, data_len);
+        }
+        return cache->ctrl_if->write_reg(cache->ctrl_if, addr, addr_len, data, data_len);
+    }
+    uint8_t *v = (uint8_t *) data;
+    // Skip registers which already hold the value
+    while (data_len > 0 && (cache->flag[addr] & REG_VALID) && cache->value[addr] == v[0]) {
+        addr++;
+        v++;
+        data_len--;
+    }
+    while (data_len > 0 && (cache->flag[addr + data_len - 1] & REG_VALID) &&
+           cache->value[addr + data_len - 1] == v[data_len - 1]) {
+        data_len--;
+    }
+    if (data_len == 0) {
+        return ESP_CODEC_DEV_OK;
+    }
+    memcpy(cache->value + addr, v, data_len);
+    if (cache->defer) {
+        for (int i = 0; i < data_len; i++) {
+            if ((cache->flag[addr + i] & REG_DIRTY) == 0) {
+                cache->dirty_num++;
+            }
+            cache->flag[addr + i] |= REG_VALID | REG_DIRTY;
+        }
+        return ESP_CODEC_DEV_OK;
+    }
+    int ret = cache->ctrl_if->write_reg(cache->ctrl_if, addr, addr_len, v, data_len);
+    for (int i = 0; i < data_len; i++) {
+        if (ret == ESP_CODEC_DEV_OK) {
+            cache->flag[addr + i] |= REG_VALID;
+        } else {
+            cache->flag[addr + i] &= ~REG_VALID;
+        }
+    }
+    return ret;
+}
+
+static int _cache_ctrl_close(const audio_codec_ctrl_if_t *ctrl)
+{
+    if (ctrl == NULL) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache->is_open) {
+        flush_dirty(cache);
+    }
+    if (cache->value) {
+        free(cache->value);
+        cache->value = NULL;
+        cache->flag = NULL;
+    }
+    cache->is_open = false;
+    return ESP_CODEC_DEV_OK;
+}
+
+int audio_codec_cache_ctrl_defer(const audio_codec_ctrl_if_t *ctrl, bool defer)
+{
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache == NULL || ctrl->open != _cache_ctrl_open) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    if (cache->is_open == false) {
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    cache->defer = defer;
+    if (defer == false) {
+        return flush_dirty(cache);
+    }
+    return ESP_CODEC_DEV_OK;
+}
+
+int audio_codec_cache_ctrl_flush(const audio_codec_ctrl_if_t *ctrl)
+{
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache == NULL || ctrl->open != _cache_ctrl_open) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    if (cache->is_open == false) {
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    return flush_dirty(cache);
+}
+
+int audio_codec_cache_ctrl_invalidate(const audio_codec_ctrl_if_t *ctrl)
+{
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache == NULL || ctrl->open != _cache_ctrl_open) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    if (cache->is_open == false) {
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    invalidate_range(cache, 0, cache->reg_num);
+    return ESP_CODEC_DEV_OK;
+}
+
+const audio_codec_ctrl_if_t *audio_codec_new_cache_ctrl(audio_codec_cache_ctrl_cfg_t *cache_cfg)
+{
+    if (cache_cfg == NULL) {
+        ESP_LOGE(TAG, "Bad configuration");
+        return NULL;
+    }
+    cache_ctrl_t *ctrl = calloc(1, sizeof(cache_ctrl_t));
+    if (ctrl == NULL) {
+        ESP_LOGE(TAG, "No memory for instance");
+        return NULL;
+    }
+    ctrl->base.open = _cache_ctrl_open;
+    ctrl->base.is_open = _cache_ctrl_is_open;
+    ctrl->base.read_reg = _cache_ctrl_read_reg;
+    ctrl->base.write_reg = _cache_ctrl_write_reg;
+    ctrl->base.close = _cache_ctrl_close;
+    int ret = _cache_ctrl_open(&ctrl->base, cache_cfg, sizeof(audio_codec_cache_ctrl_cfg_t));
+    if (ret != 0) {
+        free(ctrl);
+        return NULL;
+    }
+    return &ctrl->base;
+}
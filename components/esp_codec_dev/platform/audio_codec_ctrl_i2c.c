@@ -3,6 +3,8 @@
  *
  * SPDX-License-Identifier: Apache-2.0
  */
+#include <string.h>
+#include <stdlib.h>
 #include "audio_codec_ctrl_if.h"
 #include "esp_codec_dev_defaults.h"
 #include "esp_log.h"
@@ -14,6 +16,7 @@
 #endif
 #define DEFAULT_I2C_CLOCK         (100000)
 #define DEFAULT_I2C_TRANS_TIMEOUT (100)
+#define MAX_I2C_STACK_WRITE       (18)
 
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0) && !CONFIG_CODEC_I2C_BACKWARD_COMPATIBLE
 #include "driver/i2c_master.h"
@@ -88,9 +91,10 @@ static int _i2c_master_write_reg(i2c_ctrl_t *i2c_ctrl, int addr, int addr_len, v
 {
     esp_err_t ret = ESP_CODEC_DEV_NOT_SUPPORT;
     int len = addr_len + data_len;
-    if (len <= 4) {
-        // Not support write huge data
-        uint8_t write_data[4] = {0};
+    // Register bursts need address and data in one transaction, allocate only for huge data
+    uint8_t stack_data[MAX_I2C_STACK_WRITE];
+    uint8_t *write_data = len <= MAX_I2C_STACK_WRITE ? stack_data : (uint8_t *) malloc(len);
+    if (write_data) {
         int i = 0;
         if (addr_len > 1) {
             write_data[i++] = addr >> 8;
@@ -98,11 +102,11 @@ static int _i2c_master_write_reg(i2c_ctrl_t *i2c_ctrl, int addr, int addr_len, v
         } else {
             write_data[i++] = addr & 0xff;
         }
-        uint8_t *w = (uint8_t*)data;
-        while (i < len) {
-            write_data[i++] = *(w++);
-        }
+        memcpy(write_data + i, data, data_len);
         ret = i2c_master_transmit(i2c_ctrl->dev_handle, write_data, len, DEFAULT_I2C_TRANS_TIMEOUT);
+        if (write_data != stack_data) {
+            free(write_data);
+        }
     }
     if (ret != 0) {
         ESP_LOGE(TAG, "Fail to write to dev %x", i2c_ctrl->addr);
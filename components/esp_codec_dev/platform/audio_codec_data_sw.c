@@ -0,0 +1,527 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_codec_dev_defaults.h"
+#include "esp_codec_dev_os.h"
+#include "esp_codec_dev.h"
+
+#define TAG                  "SW_DATA_IF"
+#define WAV_HEADER_SIZE      (44)
+#define DEFAULT_BUFFER_MS    (20)
+#define MAX_SLEEP_MS         (20)
+
+typedef struct {
+    esp_codec_dev_sample_info_t fs;
+    bool                        enabled;
+    int                         frame_size;
+    int64_t                     pos;      /*!< Frames written or read from the start of the stream */
+    int64_t                     base;     /*!< Virtual clock frame count when stream enabled */
+    int64_t                     start_us; /*!< Real time when stream enabled */
+} sw_data_dir_t;
+
+typedef struct {
+    audio_codec_data_if_t       base;
+    bool                        is_open;
+    audio_codec_sw_data_cfg_t   cfg;
+    SemaphoreHandle_t           lock;
+    sw_data_dir_t               in;
+    sw_data_dir_t               out;
+    FILE                       *out_fp;
+    uint32_t                    out_file_size;
+    FILE                       *in_fp;
+    bool                        in_eof;
+    int                         mem_filled;
+    uint8_t                    *loop_buf;
+    int                         loop_frames;
+    int                         loop_frame_size;
+    uint32_t                    underrun;
+    uint32_t                    overrun;
+} sw_data_t;
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    put_le16(p, v & 0xFFFF);
+    put_le16(p + 2, v >> 16);
+}
+
+static uint32_t get_le32(uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void write_wav_header(sw_data_t *sw_data)
+{
+    uint8_t header[WAV_HEADER_SIZE];
+    esp_codec_dev_sample_info_t *fs = &sw_data->out.fs;
+    uint32_t data_size = sw_data->out_file_size;
+    memcpy(header, "RIFF", 4);
+    put_le32(header + 4, data_size + WAV_HEADER_SIZE - 8);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le32(header + 16, 16);
+    put_le16(header + 20, 1);
+    put_le16(header + 22, fs->channel);
+    put_le32(header + 24, fs->sample_rate);
+    put_le32(header + 28, fs->sample_rate * sw_data->out.frame_size);
+    put_le16(header + 32, sw_data->out.frame_size);
+    put_le16(header + 34, fs->bits_per_sample);
+    memcpy(header + 36, "data", 4);
+    put_le32(header + 40, data_size);
+    fseek(sw_data->out_fp, 0, SEEK_SET);
+    fwrite(header, 1, WAV_HEADER_SIZE, sw_data->out_fp);
+    fseek(sw_data->out_fp, 0, SEEK_END);
+}
+
+static int skip_to_wav_data(FILE *fp)
+{
+    uint8_t chunk[12];
+    if (fread(chunk, 1, 12, fp) != 12 || memcmp(chunk, "RIFF", 4) || memcmp(chunk + 8, "WAVE", 4)) {
+        return -1;
+    }
+    while (fread(chunk, 1, 8, fp) == 8) {
+        uint32_t size = get_le32(chunk + 4);
+        if (memcmp(chunk, "data", 4) == 0) {
+            return 0;
+        }
+        // Chunks are word aligned
+        if (fseek(fp, (size + 1) & ~1, SEEK_CUR) != 0) {
+            break;
+        }
+    }
+    return -1;
+}
+
+static int64_t clock_frames(sw_data_t *sw_data, sw_data_dir_t *dir, int64_t now)
+{
+    double elapsed = (double) (now - dir->start_us) * sw_data->cfg.clock_ratio;
+    return dir->base + (int64_t) (elapsed * dir->fs.sample_rate / 1000000);
+}
+
+static int frames_to_ms(sw_data_t *sw_data, sw_data_dir_t *dir, int64_t frames)
+{
+    double ms = (double) frames * 1000 / dir->fs.sample_rate / sw_data->cfg.clock_ratio;
+    int wait = ms > MAX_SLEEP_MS ? MAX_SLEEP_MS : (int) ms;
+    // Round up to whole ticks, a sleep shorter than one tick returns at once and the caller would spin
+    return (wait / portTICK_PERIOD_MS + 1) * portTICK_PERIOD_MS;
+}
+
+static int64_t buffer_frames(sw_data_t *sw_data, sw_data_dir_t *dir)
+{
+    return (int64_t) sw_data->cfg.buffer_ms * dir->fs.sample_rate / 1000;
+}
+
+/* Frames to wait for before a transfer of `frames`, half a buffer at most */
+static int64_t part_frames(sw_data_t *sw_data, sw_data_dir_t *dir, int frames)
+{
+    int64_t half = buffer_frames(sw_data, dir) / 2;
+    if (half < 1) {
+        half = 1;
+    }
+    return frames < half ? frames : half;
+}
+
+static void loop_put(sw_data_t *sw_data, int64_t pos, uint8_t *data, int frames)
+{
+    if (sw_data->loop_buf == NULL) {
+        return;
+    }
+    int frame_size = sw_data->loop_frame_size;
+    while (frames > 0) {
+        int idx = (int) (pos % sw_data->loop_frames);
+        int n = sw_data->loop_frames - idx;
+        if (n > frames) {
+            n = frames;
+        }
+        if (data) {
+            memcpy(sw_data->loop_buf + idx * frame_size, data, n * frame_size);
+            data += n * frame_size;
+        } else {
+            memset(sw_data->loop_buf + idx * frame_size, 0, n * frame_size);
+        }
+        pos += n;
+        frames -= n;
+    }
+}
+
+static void loop_get(sw_data_t *sw_data, int64_t pos, uint8_t *data, int frames)
+{
+    int frame_size = sw_data->loop_frame_size;
+    int64_t delay = (int64_t) sw_data->cfg.loopback_delay_ms * sw_data->in.fs.sample_rate / 1000;
+    // Map capture position to the playback frame output at the same virtual time
+    int64_t offset = clock_frames(sw_data, &sw_data->out, sw_data->in.start_us) - sw_data->in.base - delay;
+    for (int i = 0; i < frames; i++, data += frame_size) {
+        int64_t src = pos + i + offset;
+        if (src < 0 || src >= sw_data->out.pos || src < sw_data->out.pos - sw_data->loop_frames) {
+            memset(data, 0, frame_size);
+        } else {
+            memcpy(data, sw_data->loop_buf + (int) (src % sw_data->loop_frames) * frame_size, frame_size);
+        }
+    }
+}
+
+static void sink_put(sw_data_t *sw_data, uint8_t *data, int size)
+{
+    if (sw_data->out_fp) {
+        if (data) {
+            fwrite(data, 1, size, sw_data->out_fp);
+        } else {
+            uint8_t zero[64] = {0};
+            for (int left = size; left > 0; left -= sizeof(zero)) {
+                fwrite(zero, 1, left > sizeof(zero) ? sizeof(zero) : left, sw_data->out_fp);
+            }
+        }
+        sw_data->out_file_size += size;
+    }
+    if (sw_data->cfg.mem_sink) {
+        int n = sw_data->cfg.mem_sink_size - sw_data->mem_filled;
+        if (n > size) {
+            n = size;
+        }
+        if (data) {
+            memcpy(sw_data->cfg.mem_sink + sw_data->mem_filled, data, n);
+        } else {
+            memset(sw_data->cfg.mem_sink + sw_data->mem_filled, 0, n);
+        }
+        sw_data->mem_filled += n;
+    }
+}
+
+static void source_get(sw_data_t *sw_data, uint8_t *data, int frames)
+{
+    int size = frames * sw_data->in.frame_size;
+    switch (sw_data->cfg.src_type) {
+        case AUDIO_CODEC_SW_DATA_SRC_FILE: {
+            int got = sw_data->in_eof ? 0 : fread(data, 1, size, sw_data->in_fp);
+            if (got < size) {
+                sw_data->in_eof = true;
+                memset(data + got, 0, size - got);
+            }
+            break;
+        }
+        case AUDIO_CODEC_SW_DATA_SRC_GEN:
+            sw_data->cfg.gen(sw_data->cfg.gen_ctx, &sw_data->in.fs, sw_data->in.pos, data, frames);
+            break;
+        case AUDIO_CODEC_SW_DATA_SRC_LOOPBACK:
+            loop_get(sw_data, sw_data->in.pos, data, frames);
+            break;
+        default:
+            memset(data, 0, size);
+            break;
+    }
+}
+
+static int alloc_loop_buffer(sw_data_t *sw_data)
+{
+    sw_data_dir_t *in = &sw_data->in;
+    sw_data_dir_t *out = &sw_data->out;
+    if (in->fs.sample_rate != out->fs.sample_rate || in->frame_size != out->frame_size) {
+        ESP_LOGE(TAG, "Loopback need same input and output format");
+        return ESP_CODEC_DEV_NOT_SUPPORT;
+    }
+    // Hold delay plus both buffers so that pending capture never reads overwritten frames
+    int frames = (int) ((sw_data->cfg.loopback_delay_ms + sw_data->cfg.buffer_ms * 2 + MAX_SLEEP_MS)
+                        * (int64_t) in->fs.sample_rate / 1000);
+    if (sw_data->loop_buf && frames == sw_data->loop_frames && in->frame_size == sw_data->loop_frame_size) {
+        return ESP_CODEC_DEV_OK;
+    }
+    free(sw_data->loop_buf);
+    sw_data->loop_buf = (uint8_t *) calloc(frames, in->frame_size);
+    if (sw_data->loop_buf == NULL) {
+        ESP_LOGE(TAG, "No memory for loopback buffer");
+        return ESP_CODEC_DEV_NO_MEM;
+    }
+    sw_data->loop_frames = frames;
+    sw_data->loop_frame_size = in->frame_size;
+    return ESP_CODEC_DEV_OK;
+}
+
+static int _sw_data_open(const audio_codec_data_if_t *h, void *data_cfg, int cfg_size)
+{
+    sw_data_t *sw_data = (sw_data_t *) h;
+    if (h == NULL || data_cfg == NULL || cfg_size != sizeof(audio_codec_sw_data_cfg_t)) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    audio_codec_sw_data_cfg_t *cfg = (audio_codec_sw_data_cfg_t *) data_cfg;
+    if ((cfg->src_type == AUDIO_CODEC_SW_DATA_SRC_FILE && cfg->in_file == NULL) ||
+        (cfg->src_type == AUDIO_CODEC_SW_DATA_SRC_GEN && cfg->gen == NULL) ||
+        (cfg->mem_sink && cfg->mem_sink_size <= 0)) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    sw_data->cfg = *cfg;
+    if (sw_data->cfg.clock_ratio <= 0) {
+        sw_data->cfg.clock_ratio = 1.0;
+    }
+    if (sw_data->cfg.buffer_ms <= 0) {
+        sw_data->cfg.buffer_ms = DEFAULT_BUFFER_MS;
+    }
+    sw_data->lock = xSemaphoreCreateMutex();
+    if (sw_data->lock == NULL) {
+        return ESP_CODEC_DEV_NO_MEM;
+    }
+    if (cfg->out_file) {
+        sw_data->out_fp = fopen(cfg->out_file, "wb");
+        if (sw_data->out_fp == NULL) {
+            ESP_LOGE(TAG, "Fail to open %s", cfg->out_file);
+            return ESP_CODEC_DEV_DRV_ERR;
+        }
+    }
+    if (cfg->src_type == AUDIO_CODEC_SW_DATA_SRC_FILE) {
+        sw_data->in_fp = fopen(cfg->in_file, "rb");
+        if (sw_data->in_fp == NULL || skip_to_wav_data(sw_data->in_fp) != 0) {
+            ESP_LOGE(TAG, "Fail to open wav file %s", cfg->in_file);
+            return ESP_CODEC_DEV_DRV_ERR;
+        }
+    }
+    sw_data->is_open = true;
+    return ESP_CODEC_DEV_OK;
+}
+
+static bool _sw_data_is_open(const audio_codec_data_if_t *h)
+{
+    sw_data_t *sw_data = (sw_data_t *) h;
+    if (sw_data) {
+        return sw_data->is_open;
+    }
+    return false;
+}
+
+static void enable_dir(sw_data_dir_t *dir, bool enable)
+{
+    dir->enabled = enable;
+    if (enable) {
+        dir->start_us = esp_timer_get_time();
+        dir->base = dir->pos;
+    }
+}
+
+static int _sw_data_enable(const audio_codec_data_if_t *h, esp_codec_dev_type_t dev_type, bool enable)
+{
+    sw_data_t *sw_data = (sw_data_t *) h;
+    if (sw_data == NULL) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    if (sw_data->is_open == false) {
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    xSemaphoreTake(sw_data->lock, portMAX_DELAY);
+    if (dev_type & ESP_CODEC_DEV_TYPE_OUT) {
+        enable_dir(&sw_data->out, enable);
+    }
+    if (dev_type & ESP_CODEC_DEV_TYPE_IN) {
+        enable_dir(&sw_data->in, enable);
+    }
+    xSemaphoreGive(sw_data->lock);
+    return ESP_CODEC_DEV_OK;
+}
+
+static int _sw_data_set_fmt(const audio_codec_data_if_t *h, esp_codec_dev_type_t dev_type, esp_codec_dev_sample_info_t *fs)
+{
+    sw_data_t *sw_data = (sw_data_t *) h;
+    if (sw_data == NULL || fs == NULL || fs->sample_rate == 0 || fs->channel == 0 || fs->bits_per_sample == 0) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    if (sw_data->is_open == false) {
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    int frame_size = fs->channel * (fs->bits_per_sample >> 3);
+    int ret = ESP_CODEC_DEV_OK;
+    xSemaphoreTake(sw_data->lock, portMAX_DELAY);
+    if (dev_type & ESP_CODEC_DEV_TYPE_OUT) {
+        sw_data->out.fs = *fs;
+        sw_data->out.frame_size = frame_size;
+        if (sw_data->out_fp) {
+            write_wav_header(sw_data);
+        }
+    }
+    if (dev_type & ESP_CODEC_DEV_TYPE_IN) {
+        sw_data->in.fs = *fs;
+        sw_data->in.frame_size = frame_size;
+    }
+    if (sw_data->cfg.src_type == AUDIO_CODEC_SW_DATA_SRC_LOOPBACK && sw_data->in.frame_size && sw_data->out.frame_size) {
+        ret = alloc_loop_buffer(sw_data);
+    }
+    xSemaphoreGive(sw_data->lock);
+    return ret;
+}
+
+static int _sw_data_read(const audio_codec_data_if_t *h, uint8_t *data, int size)
+{
+    sw_data_t *sw_data = (sw_data_t *) h;
+    if (sw_data == NULL || data == NULL) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    if (sw_data->is_open == false || sw_data->in.enabled == false || sw_data->in.frame_size == 0) {
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    sw_data_dir_t *in = &sw_data->in;
+    int frames = size / in->frame_size;
+    xSemaphoreTake(sw_data->lock, portMAX_DELAY);
+    if (sw_data->cfg.src_type == AUDIO_CODEC_SW_DATA_SRC_LOOPBACK && sw_data->loop_buf == NULL) {
+        xSemaphoreGive(sw_data->lock);
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    while (frames > 0) {
+        int64_t captured = clock_frames(sw_data, in, esp_timer_get_time());
+        // Capture buffer full, the oldest frames are lost as DMA does
+        if (captured - in->pos > buffer_frames(sw_data, in)) {
+            int64_t dropped = captured - buffer_frames(sw_data, in) - in->pos;
+            sw_data->overrun++;
+            in->pos += dropped;
+            if (sw_data->in_fp && sw_data->in_eof == false) {
+                fseek(sw_data->in_fp, (long) (dropped * in->frame_size), SEEK_CUR);
+            }
+        }
+        // Read longer than the buffer is taken part by part so that the buffer never overflows meanwhile
+        int64_t need = part_frames(sw_data, in, frames);
+        if (captured - in->pos < need) {
+            xSemaphoreGive(sw_data->lock);
+            esp_codec_dev_sleep(frames_to_ms(sw_data, in, in->pos + need - captured));
+            xSemaphoreTake(sw_data->lock, portMAX_DELAY);
+            continue;
+        }
+        int n = captured - in->pos < frames ? (int) (captured - in->pos) : frames;
+        source_get(sw_data, data, n);
+        in->pos += n;
+        data += n * in->frame_size;
+        frames -= n;
+    }
+    xSemaphoreGive(sw_data->lock);
+    return ESP_CODEC_DEV_OK;
+}
+
+static int _sw_data_write(const audio_codec_data_if_t *h, uint8_t *data, int size)
+{
+    sw_data_t *sw_data = (sw_data_t *) h;
+    if (sw_data == NULL || data == NULL) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    if (sw_data->is_open == false || sw_data->out.enabled == false || sw_data->out.frame_size == 0) {
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    sw_data_dir_t *out = &sw_data->out;
+    int frames = size / out->frame_size;
+    xSemaphoreTake(sw_data->lock, portMAX_DELAY);
+    while (frames > 0) {
+        int64_t played = clock_frames(sw_data, out, esp_timer_get_time());
+        // Playback buffer drained, silence is output until new data arrive
+        if (played > out->pos) {
+            if (out->pos > out->base) {
+                sw_data->underrun++;
+            }
+            int gap = (int) (played - out->pos);
+            sink_put(sw_data, NULL, gap * out->frame_size);
+            loop_put(sw_data, out->pos, NULL, gap);
+            out->pos = played;
+        }
+        // Write longer than the buffer is queued part by part so that the buffer never drains meanwhile
+        int64_t room = buffer_frames(sw_data, out) - (out->pos - played);
+        int64_t need = part_frames(sw_data, out, frames);
+        if (room < need) {
+            xSemaphoreGive(sw_data->lock);
+            esp_codec_dev_sleep(frames_to_ms(sw_data, out, need - room));
+            xSemaphoreTake(sw_data->lock, portMAX_DELAY);
+            continue;
+        }
+        int n = room < frames ? (int) room : frames;
+        sink_put(sw_data, data, n * out->frame_size);
+        loop_put(sw_data, out->pos, data, n);
+        out->pos += n;
+        data += n * out->frame_size;
+        frames -= n;
+    }
+    xSemaphoreGive(sw_data->lock);
+    return ESP_CODEC_DEV_OK;
+}
+
+static int _sw_data_close(const audio_codec_data_if_t *h)
+{
+    sw_data_t *sw_data = (sw_data_t *) h;
+    if (sw_data == NULL) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    if (sw_data->out_fp) {
+        if (sw_data->out.frame_size) {
+            write_wav_header(sw_data);
+        }
+        fclose(sw_data->out_fp);
+        sw_data->out_fp = NULL;
+    }
+    if (sw_data->in_fp) {
+        fclose(sw_data->in_fp);
+        sw_data->in_fp = NULL;
+    }
+    if (sw_data->lock) {
+        vSemaphoreDelete(sw_data->lock);
+        sw_data->lock = NULL;
+    }
+    free(sw_data->loop_buf);
+    sw_data->loop_buf = NULL;
+    sw_data->is_open = false;
+    return ESP_CODEC_DEV_OK;
+}
+
+int audio_codec_sw_data_get_stats(const audio_codec_data_if_t *h, audio_codec_sw_data_stats_t *stats)
+{
+    sw_data_t *sw_data = (sw_data_t *) h;
+    if (sw_data == NULL || stats == NULL || h->open != _sw_data_open) {
+        return ESP_CODEC_DEV_INVALID_ARG;
+    }
+    if (sw_data->is_open == false) {
+        return ESP_CODEC_DEV_WRONG_STATE;
+    }
+    xSemaphoreTake(sw_data->lock, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    stats->underrun = sw_data->underrun;
+    stats->overrun = sw_data->overrun;
+    stats->played_frames = 0;
+    stats->pending_frames = 0;
+    stats->captured_frames = sw_data->in.pos;
+    stats->sink_size = sw_data->cfg.mem_sink ? sw_data->mem_filled : (int) sw_data->out_file_size;
+    if (sw_data->out.frame_size) {
+        int64_t played = sw_data->out.enabled ? clock_frames(sw_data, &sw_data->out, now) : sw_data->out.pos;
+        if (played > sw_data->out.pos) {
+            played = sw_data->out.pos;
+        }
+        stats->played_frames = played;
+        stats->pending_frames = (int) (sw_data->out.pos - played);
+    }
+    xSemaphoreGive(sw_data->lock);
+    return ESP_CODEC_DEV_OK;
+}
+
+const audio_codec_data_if_t *audio_codec_new_sw_data(audio_codec_sw_data_cfg_t *sw_cfg)
+{
+    sw_data_t *sw_data = calloc(1, sizeof(sw_data_t));
+    if (sw_data == NULL) {
+        ESP_LOGE(TAG, "No memory for instance");
+        return NULL;
+    }
+    sw_data->base.open = _sw_data_open;
+    sw_data->base.is_open = _sw_data_is_open;
+    sw_data->base.enable = _sw_data_enable;
+    sw_data->base.read = _sw_data_read;
+    sw_data->base.write = _sw_data_write;
+    sw_data->base.set_fmt = _sw_data_set_fmt;
+    sw_data->base.close = _sw_data_close;
+    int ret = _sw_data_open(&sw_data->base, sw_cfg, sizeof(audio_codec_sw_data_cfg_t));
+    if (ret != 0) {
+        _sw_data_close(&sw_data->base);
+        free(sw_data);
+        return NULL;
+    }
+    return &sw_data->base;
+}
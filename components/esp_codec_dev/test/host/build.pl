@@ -0,0 +1,20 @@
+#!/usr/bin/perl
+#
+# Build the software data interface test cases of test_apps/codec_dev_test on host, on the pthread
+# FreeRTOS port of audio_pipeline/test/host/port. Unity is replaced by the subset in ./unity.h.
+# Run them as:
+#   ./build.pl && ./test_sw_data ["test case name"]
+#
+# Pass "asan" to build with the address and undefined behaviour sanitizers.
+#
+use strict;
+
+my $r = "../..";
+my $port = "$r/../audio_pipeline/test/host/port";
+my @src = ("$r/esp_codec_dev.c", "$r/esp_codec_dev_vol.c", "$r/esp_codec_dev_if.c", "$r/audio_codec_sw_vol.c",
+           "$r/platform/audio_codec_data_sw.c", "$r/platform/esp_codec_dev_os.c", "$port/freertos_posix.c");
+my $inc = "-D_GNU_SOURCE -I. -I$port -I$r -I$r/include -I$r/interface -I$r/device/include";
+my $opt = (grep { $_ eq "asan" } @ARGV) ? "-O1 -fsanitize=address,undefined -fno-omit-frame-pointer" : "-O2";
+
+system("gcc $opt -g -Wall @src $r/test_apps/codec_dev_test/main/test_sw_data.c test_host_main.c $inc -o ./test_sw_data -lpthread -lm") == 0
+    or die "build failed";
@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+
+#define MAX_TEST_NUM (32)
+
+static struct {
+    const char      *name;
+    host_test_func_t func;
+} s_tests[MAX_TEST_NUM];
+static int s_test_num;
+
+void host_test_register(const char *name, host_test_func_t func)
+{
+    if (s_test_num < MAX_TEST_NUM) {
+        s_tests[s_test_num].name = name;
+        s_tests[s_test_num].func = func;
+        s_test_num++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int run = 0;
+    for (int i = 0; i < s_test_num; i++) {
+        // Optional argument selects the test cases whose name contains it
+        if (argc > 1 && strstr(s_tests[i].name, argv[1]) == NULL) {
+            continue;
+        }
+        printf("Running %s\n", s_tests[i].name);
+        s_tests[i].func();
+        printf("PASS %s\n", s_tests[i].name);
+        run++;
+    }
+    printf("%d tests passed\n", run);
+    return run ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Subset of Unity used by the test app, so that its test cases run on host unchanged.
+ * A failed assertion prints the line and exits.
+ */
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef void (*host_test_func_t)(void);
+
+void host_test_register(const char *name, host_test_func_t func);
+
+#define HOST_TEST_FAIL(line)    do { printf("FAIL at %s:%d\n", __FILE__, line); exit(1); } while (0)
+
+#define TEST_CASE(name, tag)    HOST_TEST_CASE(name, __LINE__)
+#define HOST_TEST_CASE(name, line)  HOST_TEST_CASE_(name, line)
+#define HOST_TEST_CASE_(name, line)                                                 \
+    static void host_test_##line(void);                                             \
+    __attribute__((constructor)) static void host_test_reg_##line(void)             \
+    {                                                                               \
+        host_test_register(name, host_test_##line);                                 \
+    }                                                                               \
+    static void host_test_##line(void)
+
+#define TEST_ASSERT_TRUE(x)     do { if (!(x)) { HOST_TEST_FAIL(__LINE__); } } while (0)
+#define TEST_ASSERT_NOT_NULL(x) TEST_ASSERT_TRUE((x) != NULL)
+#define TEST_ASSERT_EQUAL(expected, actual) do {                                    \
+        long long _e = (long long) (expected), _a = (long long) (actual);           \
+        if (_e != _a) {                                                             \
+            printf("Expected %lld was %lld\n", _e, _a);                             \
+            HOST_TEST_FAIL(__LINE__);                                               \
+        }                                                                           \
+    } while (0)
+#define TEST_ASSERT_EQUAL_HEX8(expected, actual)    TEST_ASSERT_EQUAL((uint8_t) (expected), (uint8_t) (actual))
+#define TEST_ASSERT_INT_WITHIN(delta, expected, actual) do {                        \
+        long long _d = (long long) (actual) - (long long) (expected);               \
+        if (_d > (delta) || _d < -(delta)) {                                        \
+            printf("Expected %lld +/- %d was %lld\n", (long long) (expected), (int) (delta), (long long) (actual)); \
+            HOST_TEST_FAIL(__LINE__);                                               \
+        }                                                                           \
+    } while (0)
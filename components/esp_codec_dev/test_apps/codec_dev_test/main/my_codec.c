@@ -124,8 +124,10 @@ static bool my_codec_ctrl_is_open(const audio_codec_ctrl_if_t *ctrl)
 static int my_codec_ctrl_read_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
 {
     my_codec_ctrl_t *ctrl_if = (my_codec_ctrl_t *) ctrl;
-    if (data_len == 1 && addr < MY_CODEC_REG_MAX) {
-        *(uint8_t *) data = ctrl_if->reg[addr];
+    // Register address auto increments for multiple bytes
+    if (data_len >= 1 && addr + data_len <= MY_CODEC_REG_MAX) {
+        memcpy(data, &ctrl_if->reg[addr], data_len);
+        ctrl_if->read_count++;
         return 0;
     }
     return -1;
@@ -134,8 +136,9 @@ static int my_codec_ctrl_read_addr(const audio_codec_ctrl_if_t *ctrl, int addr,
 static int my_codec_ctrl_write_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
 {
     my_codec_ctrl_t *ctrl_if = (my_codec_ctrl_t *) ctrl;
-    if (data_len == 1 && addr < MY_CODEC_REG_MAX) {
-        ctrl_if->reg[addr] = *(uint8_t *) data;
+    if (data_len >= 1 && addr + data_len <= MY_CODEC_REG_MAX) {
+        memcpy(&ctrl_if->reg[addr], data, data_len);
+        ctrl_if->write_count++;
         return 0;
     }
     return -1;
@@ -42,6 +42,8 @@ typedef struct {
     audio_codec_ctrl_if_t base;
     uint8_t               reg[MY_CODEC_REG_MAX];
     bool                  is_open;
+    int                   read_count;  /*!< Read transactions, used to check bus access */
+    int                   write_count; /*!< Write transactions, used to check bus access */
 } my_codec_ctrl_t;
 
 /**
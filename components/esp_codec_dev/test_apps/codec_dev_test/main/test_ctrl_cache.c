@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "my_codec.h"
+#include "esp_codec_dev_defaults.h"
+
+#define TEST_LOOP (20)
+
+static const audio_codec_ctrl_if_t *new_cache_ctrl(const audio_codec_ctrl_if_t *ctrl_if, bool auto_increment)
+{
+    static const uint8_t volatile_regs[] = {MY_CODEC_REG_SUSPEND};
+    audio_codec_cache_ctrl_cfg_t cache_cfg = {
+        .ctrl_if = ctrl_if,
+        .reg_num = MY_CODEC_REG_MAX,
+        .auto_increment = auto_increment,
+        .volatile_regs = volatile_regs,
+        .volatile_num = sizeof(volatile_regs),
+    };
+    const audio_codec_ctrl_if_t *cache_if = audio_codec_new_cache_ctrl(&cache_cfg);
+    TEST_ASSERT_NOT_NULL(cache_if);
+    return cache_if;
+}
+
+// Read-modify-write toggle of a bit as codec drivers do for mute
+static void toggle_mute(const audio_codec_ctrl_if_t *ctrl_if, int loop)
+{
+    for (int i = 0; i < loop; i++) {
+        int value = 0;
+        TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, ctrl_if->read_reg(ctrl_if, MY_CODEC_REG_MUTE, 1, &value, 1));
+        value ^= 0x01;
+        TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, ctrl_if->write_reg(ctrl_if, MY_CODEC_REG_MUTE, 1, &value, 1));
+    }
+}
+
+TEST_CASE("cache ctrl read-modify-write", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    my_codec_ctrl_t *codec_ctrl = (my_codec_ctrl_t *) ctrl_if;
+    toggle_mute(ctrl_if, TEST_LOOP);
+    TEST_ASSERT_EQUAL(TEST_LOOP, codec_ctrl->read_count);
+    TEST_ASSERT_EQUAL(TEST_LOOP, codec_ctrl->write_count);
+
+    codec_ctrl->read_count = codec_ctrl->write_count = 0;
+    const audio_codec_ctrl_if_t *cache_if = new_cache_ctrl(ctrl_if, false);
+    toggle_mute(cache_if, TEST_LOOP);
+    // Only first read goes to bus
+    TEST_ASSERT_EQUAL(1, codec_ctrl->read_count);
+    TEST_ASSERT_EQUAL(TEST_LOOP, codec_ctrl->write_count);
+    TEST_ASSERT_EQUAL(0, codec_ctrl->reg[MY_CODEC_REG_MUTE]);
+
+    // Write same value is skipped
+    uint8_t vol = 30;
+    for (int i = 0; i < TEST_LOOP; i++) {
+        cache_if->write_reg(cache_if, MY_CODEC_REG_VOL, 1, &vol, 1);
+    }
+    TEST_ASSERT_EQUAL(TEST_LOOP + 1, codec_ctrl->write_count);
+    TEST_ASSERT_EQUAL(30, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+
+    // Volatile register always go to bus
+    uint8_t value = 0;
+    for (int i = 0; i < TEST_LOOP; i++) {
+        cache_if->read_reg(cache_if, MY_CODEC_REG_SUSPEND, 1, &value, 1);
+    }
+    TEST_ASSERT_EQUAL(TEST_LOOP + 1, codec_ctrl->read_count);
+
+    // Codec reset outside, need invalidate to read back new value
+    codec_ctrl->reg[MY_CODEC_REG_VOL] = 0;
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, audio_codec_cache_ctrl_invalidate(cache_if));
+    cache_if->read_reg(cache_if, MY_CODEC_REG_VOL, 1, &value, 1);
+    TEST_ASSERT_EQUAL(0, value);
+    TEST_ASSERT_EQUAL(TEST_LOOP + 2, codec_ctrl->read_count);
+
+    audio_codec_delete_ctrl_if(cache_if);
+    audio_codec_delete_ctrl_if(ctrl_if);
+}
+
+TEST_CASE("cache ctrl deferred burst write", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    my_codec_ctrl_t *codec_ctrl = (my_codec_ctrl_t *) ctrl_if;
+    const audio_codec_ctrl_if_t *cache_if = new_cache_ctrl(ctrl_if, true);
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, audio_codec_cache_ctrl_defer(cache_if, true));
+    // Ramp volume then set other registers, only final values are written
+    for (int i = 0; i < TEST_LOOP; i++) {
+        uint8_t vol = i + 1;
+        cache_if->write_reg(cache_if, MY_CODEC_REG_VOL, 1, &vol, 1);
+    }
+    uint8_t value = 1;
+    cache_if->write_reg(cache_if, MY_CODEC_REG_MUTE, 1, &value, 1);
+    value = 20;
+    cache_if->write_reg(cache_if, MY_CODEC_REG_MIC_GAIN, 1, &value, 1);
+    TEST_ASSERT_EQUAL(0, codec_ctrl->write_count);
+    // Pending value is read back without bus access
+    cache_if->read_reg(cache_if, MY_CODEC_REG_MIC_GAIN, 1, &value, 1);
+    TEST_ASSERT_EQUAL(20, value);
+    TEST_ASSERT_EQUAL(0, codec_ctrl->read_count);
+
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, audio_codec_cache_ctrl_defer(cache_if, false));
+    // Adjacent registers coalesced into one transaction
+    TEST_ASSERT_EQUAL(1, codec_ctrl->write_count);
+    TEST_ASSERT_EQUAL(TEST_LOOP, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    TEST_ASSERT_EQUAL(1, codec_ctrl->reg[MY_CODEC_REG_MUTE]);
+    TEST_ASSERT_EQUAL(20, codec_ctrl->reg[MY_CODEC_REG_MIC_GAIN]);
+
+    // Access to volatile register flush pending writes firstly
+    audio_codec_cache_ctrl_defer(cache_if, true);
+    value = 0;
+    cache_if->write_reg(cache_if, MY_CODEC_REG_MUTE, 1, &value, 1);
+    cache_if->read_reg(cache_if, MY_CODEC_REG_SUSPEND, 1, &value, 1);
+    TEST_ASSERT_EQUAL(2, codec_ctrl->write_count);
+    TEST_ASSERT_EQUAL(0, codec_ctrl->reg[MY_CODEC_REG_MUTE]);
+    audio_codec_delete_ctrl_if(cache_if);
+    audio_codec_delete_ctrl_if(ctrl_if);
+}
+
+TEST_CASE("cache ctrl with codec device", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    my_codec_ctrl_t *codec_ctrl = (my_codec_ctrl_t *) ctrl_if;
+    const audio_codec_ctrl_if_t *cache_if = new_cache_ctrl(ctrl_if, true);
+    const audio_codec_data_if_t *data_if = my_codec_data_new();
+    TEST_ASSERT_NOT_NULL(data_if);
+    const audio_codec_gpio_if_t *gpio_if = audio_codec_new_gpio();
+    TEST_ASSERT_NOT_NULL(gpio_if);
+    my_codec_cfg_t codec_cfg = {
+        .ctrl_if = cache_if,
+        .gpio_if = gpio_if,
+    };
+    const audio_codec_if_t *codec_if = my_codec_new(&codec_cfg);
+    TEST_ASSERT_NOT_NULL(codec_if);
+    esp_codec_dev_cfg_t dev_cfg = {
+        .dev_type = ESP_CODEC_DEV_TYPE_OUT,
+        .codec_if = codec_if,
+        .data_if = data_if,
+    };
+    esp_codec_dev_handle_t dev = esp_codec_dev_new(&dev_cfg);
+    TEST_ASSERT_NOT_NULL(dev);
+    esp_codec_dev_sample_info_t fs = {
+        .bits_per_sample = 16,
+        .sample_rate = 48000,
+        .channel = 2,
+    };
+    // Defer register setting during open
+    audio_codec_cache_ctrl_defer(cache_if, true);
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_open(dev, &fs));
+    audio_codec_cache_ctrl_defer(cache_if, false);
+    int open_writes = codec_ctrl->write_count;
+    printf("Open use %d write transactions\n", open_writes);
+
+    // Repeat setting of same volume and mute cost nothing
+    for (int i = 0; i < TEST_LOOP; i++) {
+        TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_set_out_vol(dev, 60));
+        TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_set_out_mute(dev, false));
+    }
+    TEST_ASSERT_TRUE(codec_ctrl->write_count - open_writes <= 2);
+    TEST_ASSERT_EQUAL(0, codec_ctrl->read_count);
+    esp_codec_dev_close(dev);
+    esp_codec_dev_delete(dev);
+    audio_codec_delete_codec_if(codec_if);
+    audio_codec_delete_ctrl_if(cache_if);
+    audio_codec_delete_ctrl_if(ctrl_if);
+    audio_codec_delete_gpio_if(gpio_if);
+    audio_codec_delete_data_if(data_if);
+}
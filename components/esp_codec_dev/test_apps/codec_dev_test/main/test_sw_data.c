@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_codec_dev.h"
+#include "esp_codec_dev_defaults.h"
+#include "esp_codec_dev_os.h"
+
+#define TEST_SAMPLE_RATE (16000)
+#define TEST_CHUNK_MS    (10)
+#define TEST_CHUNK       (TEST_SAMPLE_RATE * TEST_CHUNK_MS / 1000)
+#define TEST_DELAY_MS    (30)
+#define TEST_LOOP        (50)
+#define IMPULSE_FRAME    (TEST_CHUNK * 20 + 7)
+
+static esp_codec_dev_handle_t open_sw_dev(audio_codec_sw_data_cfg_t *cfg, const audio_codec_data_if_t **data_if)
+{
+    *data_if = audio_codec_new_sw_data(cfg);
+    TEST_ASSERT_NOT_NULL(*data_if);
+    esp_codec_dev_cfg_t dev_cfg = {
+        .dev_type = ESP_CODEC_DEV_TYPE_IN_OUT,
+        .data_if = *data_if,
+    };
+    esp_codec_dev_handle_t dev = esp_codec_dev_new(&dev_cfg);
+    TEST_ASSERT_NOT_NULL(dev);
+    esp_codec_dev_sample_info_t fs = {
+        .bits_per_sample = 16,
+        .sample_rate = TEST_SAMPLE_RATE,
+        .channel = 1,
+    };
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_open(dev, &fs));
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_set_out_vol(dev, 100));
+    return dev;
+}
+
+TEST_CASE("sw data loopback latency", "[esp_codec_dev]")
+{
+    audio_codec_sw_data_cfg_t cfg = {
+        .buffer_ms = TEST_CHUNK_MS * 4,
+        .src_type = AUDIO_CODEC_SW_DATA_SRC_LOOPBACK,
+        .loopback_delay_ms = TEST_DELAY_MS,
+    };
+    const audio_codec_data_if_t *data_if = NULL;
+    esp_codec_dev_handle_t dev = open_sw_dev(&cfg, &data_if);
+    int16_t out[TEST_CHUNK];
+    int16_t in[TEST_CHUNK];
+    // Keep playback buffer filled so that sleep granularity of reader can not cause underrun
+    memset(out, 0, sizeof(out));
+    int written = 0;
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_write(dev, out, sizeof(out)));
+        written += TEST_CHUNK;
+    }
+    int found = -1;
+    for (int i = 0; i < TEST_LOOP; i++) {
+        memset(out, 0, sizeof(out));
+        if (IMPULSE_FRAME >= written && IMPULSE_FRAME < written + TEST_CHUNK) {
+            out[IMPULSE_FRAME - written] = 20000;
+        }
+        TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_write(dev, out, sizeof(out)));
+        written += TEST_CHUNK;
+        TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_read(dev, in, sizeof(in)));
+        for (int j = 0; j < TEST_CHUNK && found < 0; j++) {
+            if (in[j] > 10000) {
+                found = i * TEST_CHUNK + j;
+            }
+        }
+    }
+    audio_codec_sw_data_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, audio_codec_sw_data_get_stats(data_if, &stats));
+    printf("Impulse played at %d captured at %d, underrun %d overrun %d\n", IMPULSE_FRAME, found,
+           (int) stats.underrun, (int) stats.overrun);
+    TEST_ASSERT_EQUAL(0, stats.underrun);
+    TEST_ASSERT_EQUAL(0, stats.overrun);
+    TEST_ASSERT_EQUAL(TEST_CHUNK * TEST_LOOP, (int) stats.captured_frames);
+    // Both directions enabled together, allow one frame error for the clock start
+    TEST_ASSERT_INT_WITHIN(1, IMPULSE_FRAME + TEST_SAMPLE_RATE * TEST_DELAY_MS / 1000, found);
+    esp_codec_dev_close(dev);
+    esp_codec_dev_delete(dev);
+    audio_codec_delete_data_if(data_if);
+}
+
+TEST_CASE("sw data report underrun and overrun", "[esp_codec_dev]")
+{
+    int sink_size = TEST_SAMPLE_RATE * sizeof(int16_t);
+    uint8_t *sink = (uint8_t *) malloc(sink_size);
+    TEST_ASSERT_NOT_NULL(sink);
+    memset(sink, 0xFF, sink_size);
+    audio_codec_sw_data_cfg_t cfg = {
+        .buffer_ms = TEST_CHUNK_MS * 2,
+        .mem_sink = sink,
+        .mem_sink_size = sink_size,
+    };
+    const audio_codec_data_if_t *data_if = NULL;
+    esp_codec_dev_handle_t dev = open_sw_dev(&cfg, &data_if);
+    int16_t buf[TEST_CHUNK];
+    memset(buf, 0, sizeof(buf));
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_write(dev, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_read(dev, buf, sizeof(buf)));
+    // Stall longer than buffer on both directions
+    esp_codec_dev_sleep(TEST_CHUNK_MS * 6);
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_write(dev, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_read(dev, buf, sizeof(buf)));
+    audio_codec_sw_data_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, audio_codec_sw_data_get_stats(data_if, &stats));
+    TEST_ASSERT_EQUAL(1, stats.underrun);
+    TEST_ASSERT_EQUAL(1, stats.overrun);
+    // Silence is inserted for the stall so that sink keeps the playback timeline
+    TEST_ASSERT_TRUE(stats.sink_size >= (int) sizeof(buf) * 6);
+    TEST_ASSERT_EQUAL(stats.sink_size, (stats.played_frames + stats.pending_frames) * (int) sizeof(int16_t));
+    for (int i = 0; i < stats.sink_size; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0, sink[i]);
+    }
+    esp_codec_dev_close(dev);
+    esp_codec_dev_delete(dev);
+    audio_codec_delete_data_if(data_if);
+    free(sink);
+}
+
+TEST_CASE("sw data write longer than buffer", "[esp_codec_dev]")
+{
+    int frames = TEST_CHUNK * 10;
+    int sink_size = frames * 2 * sizeof(int16_t);
+    uint8_t *sink = (uint8_t *) malloc(sink_size);
+    int16_t *buf = (int16_t *) calloc(frames, sizeof(int16_t));
+    TEST_ASSERT_NOT_NULL(sink);
+    TEST_ASSERT_NOT_NULL(buf);
+    audio_codec_sw_data_cfg_t cfg = {
+        .buffer_ms = TEST_CHUNK_MS * 2,
+        .mem_sink = sink,
+        .mem_sink_size = sink_size,
+    };
+    const audio_codec_data_if_t *data_if = NULL;
+    esp_codec_dev_handle_t dev = open_sw_dev(&cfg, &data_if);
+    // Each write holds five buffers, it is queued part by part without draining the buffer
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_write(dev, buf, frames * sizeof(int16_t)));
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, esp_codec_dev_write(dev, buf, frames * sizeof(int16_t)));
+    audio_codec_sw_data_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, audio_codec_sw_data_get_stats(data_if, &stats));
+    TEST_ASSERT_EQUAL(0, stats.underrun);
+    TEST_ASSERT_EQUAL(sink_size, stats.sink_size);
+    TEST_ASSERT_TRUE(stats.pending_frames <= TEST_CHUNK * 2);
+    esp_codec_dev_close(dev);
+    esp_codec_dev_delete(dev);
+    audio_codec_delete_data_if(data_if);
+    free(buf);
+    free(sink);
+}
@@ -0,0 +1,149 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "unity.h"
+#include "esp_timer.h"
+#include "audio_codec_vol_if.h"
+
+#define TEST_FRAMES      (1024)
+#define BENCH_LOOP       (200)
+
+// Software volume is not exported in public header, declare it here
+const audio_codec_vol_if_t *audio_codec_new_sw_vol(void);
+
+/*
+ * Reference of the former per-sample 16 bits implementation at constant gain
+ */
+static void ref_vol_16(int16_t *in, int16_t *out, int n, float db_value)
+{
+    int gain = db_value <= -96.0 ? 0 : (int) (exp(db_value / 20 * log(10)) * (1 << 15));
+    for (int i = 0; i < n; i++) {
+        out[i] = (in[i] * gain) >> 15;
+    }
+}
+
+static const audio_codec_vol_if_t *open_sw_vol(int bits, float db_value)
+{
+    const audio_codec_vol_if_t *vol = audio_codec_new_sw_vol();
+    TEST_ASSERT_NOT_NULL(vol);
+    esp_codec_dev_sample_info_t fs = {
+        .bits_per_sample = bits,
+        .channel = 2,
+        .sample_rate = 48000,
+    };
+    // Set before open so that no fade is applied
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, vol->set_vol(vol, db_value));
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, vol->open(vol, &fs, 50));
+    return vol;
+}
+
+TEST_CASE("sw volume 16 bits bit exact", "[esp_codec_dev]")
+{
+    int n = TEST_FRAMES * 2;
+    int16_t *in = (int16_t *) malloc(n * sizeof(int16_t));
+    int16_t *out = (int16_t *) malloc(n * sizeof(int16_t));
+    int16_t *ref = (int16_t *) malloc(n * sizeof(int16_t));
+    TEST_ASSERT_NOT_NULL(in);
+    TEST_ASSERT_NOT_NULL(out);
+    TEST_ASSERT_NOT_NULL(ref);
+    for (int i = 0; i < n; i++) {
+        in[i] = (int16_t) (rand() & 0xFFFF);
+    }
+    in[0] = INT16_MIN;
+    in[1] = INT16_MAX;
+    for (float db = -100.0; db <= 0.0; db += 0.5) {
+        const audio_codec_vol_if_t *vol = open_sw_vol(16, db);
+        // Length not aligned to 4 samples also checks the tail of the unrolled loop
+        TEST_ASSERT_EQUAL(0, vol->process(vol, (uint8_t *) in, (n - 2) * sizeof(int16_t), (uint8_t *) out, n * sizeof(int16_t)));
+        ref_vol_16(in, ref, n - 2, db);
+        TEST_ASSERT_EQUAL_INT16_ARRAY(ref, out, n - 2);
+        audio_codec_delete_vol_if(vol);
+    }
+    free(in);
+    free(out);
+    free(ref);
+}
+
+TEST_CASE("sw volume saturation for 16/24/32 bits", "[esp_codec_dev]")
+{
+    // +6dB doubles the amplitude, full scale samples must clip instead of wrapping
+    const audio_codec_vol_if_t *vol = open_sw_vol(16, 6.0);
+    int16_t s16[4] = {INT16_MAX, INT16_MIN, 1000, -1000};
+    vol->process(vol, (uint8_t *) s16, sizeof(s16), (uint8_t *) s16, sizeof(s16));
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, s16[0]);
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, s16[1]);
+    TEST_ASSERT_INT_WITHIN(5, 1995, s16[2]);
+    TEST_ASSERT_INT_WITHIN(5, -1995, s16[3]);
+    audio_codec_delete_vol_if(vol);
+
+    vol = open_sw_vol(24, 6.0);
+    uint8_t s24[12] = {0xFF, 0xFF, 0x7F, 0x00, 0x00, 0x80, 0xE8, 0x03, 0x00, 0x18, 0xFC, 0xFF};
+    vol->process(vol, s24, sizeof(s24), s24, sizeof(s24));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(((uint8_t[]) {0xFF, 0xFF, 0x7F, 0x00, 0x00, 0x80}), s24, 6);
+    int32_t v = (int32_t) (((uint32_t) s24[6] << 8) | ((uint32_t) s24[7] << 16) | ((uint32_t) s24[8] << 24)) >> 8;
+    TEST_ASSERT_INT_WITHIN(5, 1995, v);
+    v = (int32_t) (((uint32_t) s24[9] << 8) | ((uint32_t) s24[10] << 16) | ((uint32_t) s24[11] << 24)) >> 8;
+    TEST_ASSERT_INT_WITHIN(5, -1995, v);
+    audio_codec_delete_vol_if(vol);
+
+    vol = open_sw_vol(32, 6.0);
+    int32_t s32[4] = {INT32_MAX, INT32_MIN, 1000, -1000};
+    vol->process(vol, (uint8_t *) s32, sizeof(s32), (uint8_t *) s32, sizeof(s32));
+    TEST_ASSERT_EQUAL_INT32(INT32_MAX, s32[0]);
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, s32[1]);
+    TEST_ASSERT_INT_WITHIN(5, 1995, s32[2]);
+    TEST_ASSERT_INT_WITHIN(5, -1995, s32[3]);
+    audio_codec_delete_vol_if(vol);
+}
+
+TEST_CASE("sw volume fade reach target gain", "[esp_codec_dev]")
+{
+    const audio_codec_vol_if_t *vol = open_sw_vol(16, -96.0);
+    int n = TEST_FRAMES * 2;
+    int16_t *buf = (int16_t *) malloc(n * sizeof(int16_t));
+    TEST_ASSERT_NOT_NULL(buf);
+    TEST_ASSERT_EQUAL(ESP_CODEC_DEV_OK, vol->set_vol(vol, 0.0));
+    // 50ms fade at 48kHz needs 2400 frames, feed constant samples and check the gain never goes back
+    int16_t last = 0;
+    for (int loop = 0; loop < 4; loop++) {
+        for (int i = 0; i < n; i++) {
+            buf[i] = 10000;
+        }
+        vol->process(vol, (uint8_t *) buf, n * sizeof(int16_t), (uint8_t *) buf, n * sizeof(int16_t));
+        for (int i = 0; i < n; i++) {
+            TEST_ASSERT_TRUE(buf[i] >= last);
+            last = buf[i];
+        }
+    }
+    TEST_ASSERT_INT_WITHIN(1, 10000, last);
+    free(buf);
+    audio_codec_delete_vol_if(vol);
+}
+
+TEST_CASE("sw volume performance", "[esp_codec_dev]")
+{
+    int bits[] = {16, 24, 32};
+    int size = TEST_FRAMES * 2 * sizeof(int32_t);
+    uint8_t *buf = (uint8_t *) malloc(size);
+    TEST_ASSERT_NOT_NULL(buf);
+    memset(buf, 0x35, size);
+    for (int i = 0; i < sizeof(bits) / sizeof(bits[0]); i++) {
+        const audio_codec_vol_if_t *vol = open_sw_vol(bits[i], -10.0);
+        int len = TEST_FRAMES * 2 * bits[i] / 8;
+        int64_t start = esp_timer_get_time();
+        for (int j = 0; j < BENCH_LOOP; j++) {
+            vol->process(vol, buf, len, buf, len);
+        }
+        int64_t used = esp_timer_get_time() - start;
+        printf("%d bits: %d frames in %d us, %.2f ns per sample\n", bits[i], TEST_FRAMES * BENCH_LOOP, (int) used,
+               (float) used * 1000 / (TEST_FRAMES * 2 * BENCH_LOOP));
+        audio_codec_delete_vol_if(vol);
+    }
+    free(buf);
+}
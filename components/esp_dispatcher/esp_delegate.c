@@ -37,6 +37,7 @@ esp_dispatcher_handle_t esp_dispatcher_get_delegate_handle(void)
         d_cfg.task_prio = CONFIG_ESP_DISPATCHER_DELEGATE_TASK_PRIO;
         d_cfg.task_stack = CONFIG_ESP_DISPATCHER_DELEGATE_STACK_SIZE;
         d_cfg.stack_in_ext = false;
+        d_cfg.worker_num = CONFIG_ESP_DISPATCHER_DELEGATE_WORKER_NUM;
         shared_handle = esp_dispatcher_create(&d_cfg);
     }
     return shared_handle;
@@ -21,7 +21,6 @@
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  *
  */
-
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
@@ -29,6 +28,7 @@
 #include "freertos/event_groups.h"
 #include "sys/queue.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "esp_dispatcher.h"
 #include "audio_mutex.h"
@@ -39,6 +39,7 @@
 static const char *TAG = "DISPATCHER";
 
 #define  ESP_DISPATCHER_EVENT_SIZE  (3)
+#define  ESP_DISPATCHER_BUCKET_MIN  (8)
 
 typedef enum {
     ESP_DISPCH_EVENT_TYPE_UNKNOWN,
@@ -46,6 +47,16 @@ typedef enum {
     ESP_DISPCH_EVENT_TYPE_EXE,
 } esp_dispatcher_event_type_t;
 
+/**
+ * Completion of a synchronous call, it lives on the caller's stack so that callers
+ * only ever wait for their own action
+ */
+typedef struct {
+    StaticSemaphore_t               sem_buf;
+    SemaphoreHandle_t               sem;
+    action_result_t                 result;
+} esp_dispatcher_completion_t;
+
 typedef struct {
     esp_dispatcher_event_type_t     type;
     int                             sub_index;
@@ -54,121 +65,284 @@ typedef struct {
     action_arg_t                    arg;
     func_ret_cb_t                   ret_cb;
     void                            *user_data;
+    esp_dispatcher_completion_t     *done;
+    int64_t                         enqueue_us;
 } esp_dispatcher_info_t;
 
 typedef struct evt_exe_item {
-    STAILQ_ENTRY(evt_exe_item)              entries;
+    SLIST_ENTRY(evt_exe_item)               entries;
     int                                     sub_index;
     esp_action_exe                          exe_func;
     void*                                   exe_instance;
+    esp_dispatcher_prio_t                   prio;
+    uint32_t                                count;
+    uint64_t                                total_wait_us;
+    uint64_t                                total_exec_us;
+    uint32_t                                max_wait_us;
+    uint32_t                                max_exec_us;
 } esp_action_exe_item_t;
 
+SLIST_HEAD(action_exe_list, evt_exe_item);
+
 typedef struct esp_dispatcher {
-    audio_thread_t                                 thread;
-    QueueHandle_t                                  exe_que;
-    QueueHandle_t                                  result_que;
-    SemaphoreHandle_t                              mutex;
-    TaskHandle_t                                   task_handle;
-    STAILQ_HEAD(action_exe_list, evt_exe_item)     exe_list;
+    QueueHandle_t                                  lane_que[2];    /* Indexed by esp_dispatcher_prio_t */
+    SemaphoreHandle_t                              pending;        /* Counts the queued actions of both lanes */
+    SemaphoreHandle_t                              exited;
+    SemaphoreHandle_t                              mutex;          /* Guards the table and the statistics */
+    int                                            worker_num;
+    struct action_exe_list                         *buckets;
+    int                                            bucket_num;     /* Power of 2 */
+    int                                            exe_num;
+    esp_action_exe_item_t                          all;            /* Statistics of every action */
+    uint32_t                                       max_queue_depth;
 } esp_dispatcher_t;
 
+static inline struct action_exe_list *exe_bucket(esp_dispatcher_t *impl, int idx)
+{
+    uint32_t hash = (uint32_t)idx * 2654435761u;
+    return &impl->buckets[(hash ^ (hash >> 16)) & (impl->bucket_num - 1)];
+}
 
-static esp_err_t execute_index_exist(esp_dispatcher_handle_t h, int idx)
+static esp_action_exe_item_t *found_exe_func(esp_dispatcher_t *impl, int idx)
 {
-    esp_dispatcher_t *impl = (esp_dispatcher_t *)h;
     esp_action_exe_item_t *item;
-    STAILQ_FOREACH(item, &impl->exe_list, entries) {
+    SLIST_FOREACH(item, exe_bucket(impl, idx), entries) {
         if (idx == item->sub_index) {
-            return ESP_OK;
+            return item;
         }
     }
-    return ESP_FAIL;
+    return NULL;
 }
 
-static esp_action_exe_item_t *found_exe_func(esp_dispatcher_handle_t h, int idx)
+static esp_err_t exe_table_grow(esp_dispatcher_t *impl)
 {
-    esp_dispatcher_t *impl = (esp_dispatcher_t *)h;
-    esp_action_exe_item_t *item;
-    STAILQ_FOREACH(item, &impl->exe_list, entries) {
-        if (idx == item->sub_index) {
-            return item;
+    int bucket_num = impl->bucket_num ? impl->bucket_num * 2 : ESP_DISPATCHER_BUCKET_MIN;
+    struct action_exe_list *buckets = audio_calloc(bucket_num, sizeof(struct action_exe_list));
+    AUDIO_MEM_CHECK(TAG, buckets, return ESP_ERR_NO_MEM);
+    struct action_exe_list *old = impl->buckets;
+    int old_num = impl->bucket_num;
+    impl->buckets = buckets;
+    impl->bucket_num = bucket_num;
+    for (int i = 0; i < old_num; i++) {
+        esp_action_exe_item_t *item;
+        while ((item = SLIST_FIRST(&old[i])) != NULL) {
+            SLIST_REMOVE_HEAD(&old[i], entries);
+            SLIST_INSERT_HEAD(exe_bucket(impl, item->sub_index), item, entries);
         }
     }
-    return NULL;
+    audio_free(old);
+    return ESP_OK;
+}
+
+static void exe_stats_update(esp_action_exe_item_t *item, uint32_t wait_us, uint32_t exec_us)
+{
+    item->count++;
+    item->total_wait_us += wait_us;
+    item->total_exec_us += exec_us;
+    if (wait_us > item->max_wait_us) {
+        item->max_wait_us = wait_us;
+    }
+    if (exec_us > item->max_exec_us) {
+        item->max_exec_us = exec_us;
+    }
+}
+
+static void exe_stats_get(esp_action_exe_item_t *item, esp_dispatcher_exe_stats_t *stats)
+{
+    stats->count = item->count;
+    stats->max_wait_us = item->max_wait_us;
+    stats->max_exec_us = item->max_exec_us;
+    stats->avg_wait_us = item->count ? (uint32_t)(item->total_wait_us / item->count) : 0;
+    stats->avg_exec_us = item->count ? (uint32_t)(item->total_exec_us / item->count) : 0;
+}
+
+static void dispatcher_run_action(esp_dispatcher_t *dispch, esp_dispatcher_info_t *msg)
+{
+    action_result_t result = {0};
+    esp_action_exe exe_func = NULL;
+    void *exe_handle = NULL;
+    int64_t start_us = esp_timer_get_time();
+
+    ESP_LOGD(TAG, "EXE type:%d, index:%x, pfunc:%p, %p, %d",
+            msg->type, msg->sub_index, msg->pfunc, msg->arg.data, msg->arg.len);
+    if (msg->sub_index != -1) {
+        mutex_lock(dispch->mutex);
+        esp_action_exe_item_t *exe_item = found_exe_func(dispch, msg->sub_index);
+        if (exe_item) {
+            exe_func = exe_item->exe_func;
+            exe_handle = exe_item->exe_instance;
+        }
+        mutex_unlock(dispch->mutex);
+        if (exe_func == NULL) {
+            result.err = ESP_ERR_ADF_NOT_SUPPORT;
+            ESP_LOGW(TAG, "Not found index:%x", msg->sub_index);
+        }
+    } else if (msg->pfunc != NULL) {
+        exe_func = msg->pfunc;
+        exe_handle = msg->instance;
+    } else {
+        result.err = ESP_ERR_ADF_NOT_SUPPORT;
+        ESP_LOGW(TAG, "Unsupported type index:%x, pfunc:%p", msg->sub_index, msg->pfunc);
+    }
+    if (exe_func) {
+        result.err = exe_func(exe_handle, &msg->arg, &result);
+    }
+
+    uint32_t wait_us = (uint32_t)(start_us - msg->enqueue_us);
+    uint32_t exec_us = (uint32_t)(esp_timer_get_time() - start_us);
+    mutex_lock(dispch->mutex);
+    exe_stats_update(&dispch->all, wait_us, exec_us);
+    if (msg->sub_index != -1) {
+        // Items are never removed before destroy, look it up again rather than hold the lock across the call
+        esp_action_exe_item_t *exe_item = found_exe_func(dispch, msg->sub_index);
+        if (exe_item) {
+            exe_stats_update(exe_item, wait_us, exec_us);
+        }
+    }
+    mutex_unlock(dispch->mutex);
+
+    if (msg->done) {
+        msg->done->result = result;
+        xSemaphoreGive(msg->done->sem);
+    } else if (msg->ret_cb) {
+        msg->ret_cb(result, msg->user_data);
+    }
 }
 
 static void dispatcher_event_task(void *parameters)
 {
     esp_dispatcher_t *dispch = (esp_dispatcher_t *)parameters;
     esp_dispatcher_info_t msg = {0};
-    action_result_t result = {0};
-    esp_action_exe_item_t *exe_item = NULL;
     bool task_run = true;
     ESP_LOGI(TAG, "%s is running...", __func__);
     while (task_run) {
-        if (xQueueReceive(dispch->exe_que, &msg, portMAX_DELAY) == pdTRUE) {
-            if (msg.type == ESP_DISPCH_EVENT_TYPE_EXE) {
-                esp_action_exe exe_func = NULL;
-                void *exe_handle = NULL;
-                result.err = ESP_OK;
-                result.data = 0;
-                result.len = 0;
-                ESP_LOGD(TAG, "EXE type:%d, index:%x, pfunc:%p, %p, %d",
-                        msg.type, msg.sub_index, msg.pfunc, msg.arg.data, msg.arg.len);
-                if (msg.sub_index != -1) {
-                    exe_item = found_exe_func(dispch, msg.sub_index);
-                    if (exe_item) {
-                        exe_func = exe_item->exe_func;
-                        exe_handle = exe_item->exe_instance;
-                    } else {
-                        result.err = ESP_ERR_ADF_NOT_SUPPORT;
-                        ESP_LOGW(TAG, "Not found index:%x", msg.sub_index);
-                    }
-                } else if (msg.sub_index == -1 && msg.pfunc != NULL) {
-                    exe_func = msg.pfunc;
-                    exe_handle = msg.instance;
-                } else {
-                    result.err = ESP_ERR_ADF_NOT_SUPPORT;
-                    ESP_LOGW(TAG, "Unsupported type index:%x, pfunc:%p", msg.sub_index, msg.pfunc);
-                }
-                if (exe_func) {
-                    result.err = exe_func(exe_handle, &msg.arg, &result);
-                }
-                if (msg.ret_cb) {
-                    msg.ret_cb(result, msg.user_data);
-                } else {
-                    if (xQueueSend(dispch->result_que, &result, pdMS_TO_TICKS(0)) == pdFALSE) {
-                        ESP_LOGW(TAG, "Send result failed, pfunc: %p, index:%x", msg.pfunc, msg.sub_index);
-                    }
-                }
-            } else if (msg.type == ESP_DISPCH_EVENT_TYPE_CMD) {
-                task_run = false;
-            }
-        } else {
+        xSemaphoreTake(dispch->pending, portMAX_DELAY);
+        if (xQueueReceive(dispch->lane_que[ESP_DISPATCHER_PRIO_HIGH], &msg, 0) != pdTRUE
+            && xQueueReceive(dispch->lane_que[ESP_DISPATCHER_PRIO_NORMAL], &msg, 0) != pdTRUE) {
             ESP_LOGE(TAG, "Unknown queue or receive error");
+            continue;
+        }
+        if (msg.type == ESP_DISPCH_EVENT_TYPE_EXE) {
+            dispatcher_run_action(dispch, &msg);
+        } else if (msg.type == ESP_DISPCH_EVENT_TYPE_CMD) {
+            task_run = false;
         }
     }
-    result.err = ESP_OK;
-    result.data = 0;
-    result.len = 0;
-    xQueueSend(dispch->result_que, &result, 0 / portTICK_PERIOD_MS);
+    xSemaphoreGive(dispch->exited);
     vTaskDelete(NULL);
 }
 
+/*
+ * Callers used to queue up on a mutex without a time limit, so a full queue is waited out the same way,
+ * with a warning every `ticks` so that a stuck action still shows up
+ */
+static void dispatcher_send(esp_dispatcher_t *impl, esp_dispatcher_info_t *info, TickType_t ticks)
+{
+    esp_dispatcher_prio_t prio = ESP_DISPATCHER_PRIO_NORMAL;
+    if (info->sub_index != -1) {
+        mutex_lock(impl->mutex);
+        esp_action_exe_item_t *item = found_exe_func(impl, info->sub_index);
+        if (item) {
+            prio = item->prio;
+        }
+        mutex_unlock(impl->mutex);
+    }
+    info->enqueue_us = esp_timer_get_time();
+    while (xQueueSend(impl->lane_que[prio], info, ticks) != pdPASS) {
+        ESP_LOGW(TAG, "Queue full for %d ms, index:%x, pfunc:%p", (int)((esp_timer_get_time() - info->enqueue_us) / 1000),
+                 info->sub_index, info->pfunc);
+    }
+    xSemaphoreGive(impl->pending);
+
+    uint32_t depth = uxQueueMessagesWaiting(impl->lane_que[0]) + uxQueueMessagesWaiting(impl->lane_que[1]);
+    if (depth > impl->max_queue_depth) {
+        impl->max_queue_depth = depth;
+    }
+}
+
+static void dispatcher_send_wait(esp_dispatcher_t *impl, esp_dispatcher_info_t *info, action_result_t *ret)
+{
+    esp_dispatcher_completion_t done;
+    done.sem = xSemaphoreCreateBinaryStatic(&done.sem_buf);
+    info->done = &done;
+    dispatcher_send(impl, info, pdMS_TO_TICKS(5000));
+    xSemaphoreTake(done.sem, portMAX_DELAY);
+    vSemaphoreDelete(done.sem);
+    memcpy(ret, &done.result, sizeof(action_result_t));
+}
+
 esp_err_t esp_dispatcher_reg_exe_func(esp_dispatcher_handle_t dh, void *exe_inst, int sub_event_index, esp_action_exe func)
 {
     esp_dispatcher_t *impl = (esp_dispatcher_t *)dh;
     AUDIO_NULL_CHECK(TAG, impl, return ESP_ERR_INVALID_ARG);
-    if (execute_index_exist(dh, sub_event_index) == ESP_OK) {
+    mutex_lock(impl->mutex);
+    if (found_exe_func(impl, sub_event_index)) {
+        mutex_unlock(impl->mutex);
         ESP_LOGW(TAG, "The %x index of function already exists", sub_event_index);
         return ESP_ERR_ADF_ALREADY_EXISTS;
     }
+    if (impl->exe_num >= impl->bucket_num && exe_table_grow(impl) != ESP_OK) {
+        mutex_unlock(impl->mutex);
+        return ESP_ERR_NO_MEM;
+    }
     esp_action_exe_item_t *item = audio_calloc(1, sizeof(esp_action_exe_item_t));
+    AUDIO_MEM_CHECK(TAG, item, {
+        mutex_unlock(impl->mutex);
+        return ESP_ERR_NO_MEM;
+    });
     item->sub_index = sub_event_index;
     item->exe_func = func;
     item->exe_instance = exe_inst;
+    item->prio = ESP_DISPATCHER_PRIO_NORMAL;
+    SLIST_INSERT_HEAD(exe_bucket(impl, sub_event_index), item, entries);
+    impl->exe_num++;
+    mutex_unlock(impl->mutex);
+    return ESP_OK;
+}
 
-    STAILQ_INSERT_TAIL(&impl->exe_list, item, entries);
+esp_err_t esp_dispatcher_set_exe_prio(esp_dispatcher_handle_t dh, int sub_event_index, esp_dispatcher_prio_t prio)
+{
+    esp_dispatcher_t *impl = (esp_dispatcher_t *)dh;
+    AUDIO_NULL_CHECK(TAG, impl, return ESP_ERR_INVALID_ARG);
+    AUDIO_CHECK(TAG, prio == ESP_DISPATCHER_PRIO_NORMAL || prio == ESP_DISPATCHER_PRIO_HIGH,
+                return ESP_ERR_INVALID_ARG, "Invalid prio");
+    esp_err_t ret = ESP_ERR_ADF_NOT_SUPPORT;
+    mutex_lock(impl->mutex);
+    esp_action_exe_item_t *item = found_exe_func(impl, sub_event_index);
+    if (item) {
+        item->prio = prio;
+        ret = ESP_OK;
+    }
+    mutex_unlock(impl->mutex);
+    return ret;
+}
+
+esp_err_t esp_dispatcher_get_exe_stats(esp_dispatcher_handle_t dh, int sub_event_index, esp_dispatcher_exe_stats_t *stats)
+{
+    esp_dispatcher_t *impl = (esp_dispatcher_t *)dh;
+    AUDIO_NULL_CHECK(TAG, impl, return ESP_ERR_INVALID_ARG);
+    AUDIO_NULL_CHECK(TAG, stats, return ESP_ERR_INVALID_ARG);
+    esp_err_t ret = ESP_ERR_ADF_NOT_SUPPORT;
+    mutex_lock(impl->mutex);
+    esp_action_exe_item_t *item = found_exe_func(impl, sub_event_index);
+    if (item) {
+        exe_stats_get(item, stats);
+        ret = ESP_OK;
+    }
+    mutex_unlock(impl->mutex);
+    return ret;
+}
+
+esp_err_t esp_dispatcher_get_stats(esp_dispatcher_handle_t dh, esp_dispatcher_stats_t *stats)
+{
+    esp_dispatcher_t *impl = (esp_dispatcher_t *)dh;
+    AUDIO_NULL_CHECK(TAG, impl, return ESP_ERR_INVALID_ARG);
+    AUDIO_NULL_CHECK(TAG, stats, return ESP_ERR_INVALID_ARG);
+    mutex_lock(impl->mutex);
+    exe_stats_get(&impl->all, &stats->all);
+    mutex_unlock(impl->mutex);
+    stats->queue_depth = uxQueueMessagesWaiting(impl->lane_que[0]) + uxQueueMessagesWaiting(impl->lane_que[1]);
+    stats->max_queue_depth = impl->max_queue_depth;
     return ESP_OK;
 }
 
@@ -186,15 +360,8 @@ esp_err_t esp_dispatcher_execute(esp_dispatcher_handle_t dh, int sub_event_index
     ESP_LOGI(TAG, "EXE IN, cmd type:%d, index:%x, data:%p, len:%d",
              info.type, info.sub_index, info.arg.data, info.arg.len);
 
-    mutex_lock(impl->mutex);
-    if (xQueueSend(impl->exe_que, &info, 5000 / portTICK_PERIOD_MS) == pdFALSE) {
-        ESP_LOGE(TAG, "Send timeout type:%d, index:%x", info.type, info.sub_index);
-        mutex_unlock(impl->mutex);
-        return ESP_ERR_ADF_TIMEOUT;
-    }
     action_result_t ret = {0};
-    xQueueReceive(impl->result_que, &ret, portMAX_DELAY);
-    mutex_unlock(impl->mutex);
+    dispatcher_send_wait(impl, &info, &ret);
     if (out_result) {
         memcpy(out_result, &ret, sizeof(action_result_t));
     }
@@ -219,16 +386,7 @@ esp_err_t esp_dispatcher_execute_async(esp_dispatcher_handle_t dh, int sub_event
     ESP_LOGI(TAG, "EXE IN, cmd type:%d, index:%x, data:%p, len:%d",
              info.type, info.sub_index, info.arg.data, info.arg.len);
 
-    mutex_lock(impl->mutex);
-    if (xQueueSend(impl->exe_que, &info, pdMS_TO_TICKS(5000)) != pdPASS) {
-        ESP_LOGE(TAG, "Message send timeout");
-        action_result_t result = {0};
-        result.err = ESP_FAIL;
-        ret_cb(result, user_data);
-        mutex_unlock(impl->mutex);
-        return ESP_ERR_ADF_TIMEOUT;
-    }
-    mutex_unlock(impl->mutex);
+    dispatcher_send(impl, &info, pdMS_TO_TICKS(5000));
     return ESP_OK;
 }
 
@@ -247,20 +405,10 @@ esp_err_t esp_dispatcher_execute_with_func(esp_dispatcher_handle_t dh,
     delegate.sub_index = -1;
     delegate.pfunc = func;
     delegate.instance = instance;
-    delegate.ret_cb = NULL;
-    delegate.user_data = NULL;
     if (arg) {
         memcpy(&delegate.arg, arg, sizeof(action_arg_t));
     }
-    mutex_lock(impl->mutex);
-    if (xQueueSend(impl->exe_que, &delegate, pdMS_TO_TICKS(5000)) != pdPASS) {
-        ret->err = ESP_FAIL;
-        ESP_LOGE(TAG, "Message send timeout");
-        mutex_unlock(impl->mutex);
-        return ESP_ERR_ADF_TIMEOUT;
-    }
-    xQueueReceive(impl->result_que, ret, portMAX_DELAY);
-    mutex_unlock(impl->mutex);
+    dispatcher_send_wait(impl, &delegate, ret);
     return ret->err;
 }
 
@@ -286,34 +434,73 @@ esp_err_t esp_dispatcher_execute_with_func_async(esp_dispatcher_handle_t dh,
         memcpy(&delegate.arg, arg, sizeof(action_arg_t));
     }
 
-    mutex_lock(impl->mutex);
-    if (xQueueSend(impl->exe_que, &delegate, pdMS_TO_TICKS(5000)) != pdPASS) {
-        ESP_LOGE(TAG, "Message send timeout");
-        action_result_t result = {0};
-        result.err = ESP_FAIL;
-        ret_cb(result, user_data);
-        mutex_unlock(impl->mutex);
-        return ESP_ERR_ADF_TIMEOUT;
-    }
-    mutex_unlock(impl->mutex);
+    dispatcher_send(impl, &delegate, pdMS_TO_TICKS(5000));
     return ESP_OK;
 }
 
+static void dispatcher_free(esp_dispatcher_t *impl)
+{
+    for (int i = 0; i < 2; i++) {
+        if (impl->lane_que[i]) {
+            vQueueDelete(impl->lane_que[i]);
+        }
+    }
+    if (impl->pending) {
+        vSemaphoreDelete(impl->pending);
+    }
+    if (impl->exited) {
+        vSemaphoreDelete(impl->exited);
+    }
+    if (impl->mutex) {
+        mutex_destroy(impl->mutex);
+    }
+    for (int i = 0; i < impl->bucket_num; i++) {
+        esp_action_exe_item_t *item;
+        while ((item = SLIST_FIRST(&impl->buckets[i])) != NULL) {
+            SLIST_REMOVE_HEAD(&impl->buckets[i], entries);
+            audio_free(item);
+        }
+    }
+    audio_free(impl->buckets);
+    audio_free(impl);
+}
+
+static void dispatcher_stop_workers(esp_dispatcher_t *impl, int num)
+{
+    esp_dispatcher_info_t info = {0};
+    info.type = ESP_DISPCH_EVENT_TYPE_CMD;
+    info.sub_index = -1;
+    // The stop commands go behind the actions already queued in the normal lane
+    for (int i = 0; i < num; i++) {
+        xQueueSend(impl->lane_que[ESP_DISPATCHER_PRIO_NORMAL], &info, portMAX_DELAY);
+        xSemaphoreGive(impl->pending);
+    }
+    for (int i = 0; i < num; i++) {
+        xSemaphoreTake(impl->exited, portMAX_DELAY);
+    }
+}
+
 esp_dispatcher_handle_t esp_dispatcher_create(esp_dispatcher_config_t *cfg)
 {
     AUDIO_NULL_CHECK(TAG, cfg, return NULL);
     esp_dispatcher_handle_t impl = audio_calloc(1, sizeof(esp_dispatcher_t));
     AUDIO_MEM_CHECK(TAG, impl, return NULL);
-    impl->result_que = xQueueCreate(1, sizeof(action_result_t));
-    AUDIO_MEM_CHECK(TAG, impl->result_que, goto _failed;);
-    impl->exe_que = xQueueCreate(ESP_DISPATCHER_EVENT_SIZE, sizeof(esp_dispatcher_info_t));
-    AUDIO_MEM_CHECK(TAG, impl->exe_que, goto _failed;);
+    impl->worker_num = cfg->worker_num > 0 ? cfg->worker_num : 1;
+    for (int i = 0; i < 2; i++) {
+        impl->lane_que[i] = xQueueCreate(ESP_DISPATCHER_EVENT_SIZE, sizeof(esp_dispatcher_info_t));
+        AUDIO_MEM_CHECK(TAG, impl->lane_que[i], goto _failed;);
+    }
+    impl->pending = xSemaphoreCreateCounting(2 * ESP_DISPATCHER_EVENT_SIZE, 0);
+    AUDIO_MEM_CHECK(TAG, impl->pending, goto _failed;);
+    impl->exited = xSemaphoreCreateCounting(impl->worker_num, 0);
+    AUDIO_MEM_CHECK(TAG, impl->exited, goto _failed;);
     impl->mutex = mutex_create();
     AUDIO_MEM_CHECK(TAG, impl->mutex, goto _failed;);
-    STAILQ_INIT(&impl->exe_list);
-    ESP_LOGE(TAG, "exe first list: %p", STAILQ_FIRST(&impl->exe_list));
+    AUDIO_MEM_CHECK(TAG, exe_table_grow(impl) == ESP_OK, goto _failed;);
 
-    if (ESP_OK != audio_thread_create(&impl->thread,
+    for (int i = 0; i < impl->worker_num; i++) {
+        audio_thread_t thread = NULL;
+        if (ESP_OK != audio_thread_create(&thread,
                                           "esp_dispatcher",
                                           dispatcher_event_task,
                                           impl,
@@ -321,56 +508,22 @@ esp_dispatcher_handle_t esp_dispatcher_create(esp_dispatcher_config_t *cfg)
                                           cfg->task_prio,
                                           cfg->stack_in_ext,
                                           cfg->task_core)) {
-        ESP_LOGE(TAG, "Create task failed on %s", __func__);
-        goto _failed;
+            ESP_LOGE(TAG, "Create task failed on %s", __func__);
+            dispatcher_stop_workers(impl, i);
+            goto _failed;
+        }
     }
     return impl;
 _failed:
-    if (impl->result_que) {
-        vQueueDelete(impl->result_que);
-        impl->result_que = NULL;
-    }
-    if (impl->exe_que) {
-        vQueueDelete(impl->exe_que);
-        impl->exe_que = NULL;
-    }
-    if (impl->mutex) {
-        mutex_destroy(impl->mutex);
-        impl->mutex = NULL;
-    }
-    audio_free(impl);
-    impl = NULL;
-    return impl;
+    dispatcher_free(impl);
+    return NULL;
 }
 
 esp_err_t esp_dispatcher_destroy(esp_dispatcher_handle_t dh)
 {
     esp_dispatcher_t *impl = (esp_dispatcher_t *)dh;
     AUDIO_NULL_CHECK(TAG, impl, return ESP_ERR_INVALID_ARG);
-    esp_dispatcher_info_t info = {0};
-    action_result_t ret = {0};
-    info.type = ESP_DISPCH_EVENT_TYPE_CMD;
-    xQueueSend(impl->exe_que, &info, portMAX_DELAY);
-    xQueueReceive(impl->result_que, &ret, portMAX_DELAY);
-    esp_action_exe_item_t *item;
-    STAILQ_FOREACH(item, &impl->exe_list, entries) {
-        STAILQ_REMOVE(&impl->exe_list, item, evt_exe_item, entries);
-        audio_free(item);
-    }
-
-    if (impl->result_que) {
-        vQueueDelete(impl->result_que);
-        impl->result_que = NULL;
-    }
-    if (impl->exe_que) {
-        vQueueDelete(impl->exe_que);
-        impl->exe_que = NULL;
-    }
-    if (impl->mutex) {
-        mutex_destroy(impl->mutex);
-        impl->mutex = NULL;
-    }
-    audio_free(impl);
-    impl = NULL;
+    dispatcher_stop_workers(impl, impl->worker_num);
+    dispatcher_free(impl);
     return ESP_OK;
 }
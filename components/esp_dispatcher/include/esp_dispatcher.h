@@ -26,6 +26,7 @@
 #define __ESP_DISPATCHER_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "esp_err.h"
 #include "esp_action_def.h"
@@ -37,6 +38,7 @@ extern "C" {
 #define DEFAULT_ESP_DISPATCHER_STACK_SIZE      (4*1024)
 #define DEFAULT_ESP_DISPATCHER_TASK_PRIO       (10)
 #define DEFAULT_ESP_DISPATCHER_TASK_CORE       (0)
+#define DEFAULT_ESP_DISPATCHER_WORKER_NUM      (1)
 
 /**
  * @brief The dispatcher configuration
@@ -46,8 +48,38 @@ typedef struct {
     int                         task_prio;              /*!< Task priority (based on freeRTOS priority) */
     int                         task_core;              /*!< Task running in core (0 or 1) */
     bool                        stack_in_ext;           /*!< Try to allocate stack in external memory */
+    int                         worker_num;             /*!< Number of worker tasks sharing the queue, 0 is taken as 1.
+                                                             With more than one worker the execution functions may run concurrently */
 } esp_dispatcher_config_t;
 
+/**
+ * @brief Priority lane of an execution function, queued high priority actions run before any normal one
+ */
+typedef enum {
+    ESP_DISPATCHER_PRIO_NORMAL,
+    ESP_DISPATCHER_PRIO_HIGH,
+} esp_dispatcher_prio_t;
+
+/**
+ * @brief Statistics of one registered execution function
+ */
+typedef struct {
+    uint32_t                    count;                  /*!< Times executed */
+    uint32_t                    max_wait_us;            /*!< Longest time queued before a worker took it */
+    uint32_t                    avg_wait_us;            /*!< Average time queued */
+    uint32_t                    max_exec_us;            /*!< Longest execution time */
+    uint32_t                    avg_exec_us;            /*!< Average execution time */
+} esp_dispatcher_exe_stats_t;
+
+/**
+ * @brief Statistics of the ESP dispatcher instance
+ */
+typedef struct {
+    esp_dispatcher_exe_stats_t  all;                    /*!< All actions, including the ones invoked with a function */
+    uint32_t                    queue_depth;            /*!< Actions queued now */
+    uint32_t                    max_queue_depth;        /*!< Most actions queued at once */
+} esp_dispatcher_stats_t;
+
 typedef struct esp_dispatcher *esp_dispatcher_handle_t;
 
 /**
@@ -60,6 +92,7 @@ typedef void (*func_ret_cb_t)(action_result_t ret, void *user_data);
     .task_prio = DEFAULT_ESP_DISPATCHER_TASK_PRIO, \
     .task_core = DEFAULT_ESP_DISPATCHER_TASK_CORE, \
     .stack_in_ext = false, \
+    .worker_num = DEFAULT_ESP_DISPATCHER_WORKER_NUM, \
 }
 
 /**
@@ -99,6 +132,46 @@ esp_err_t esp_dispatcher_destroy(esp_dispatcher_handle_t handle);
  */
 esp_err_t esp_dispatcher_reg_exe_func(esp_dispatcher_handle_t handle, void *exe_inst, int sub_event_index, esp_action_exe func);
 
+/**
+ * brief      Set the priority lane of a registered execution function, ESP_DISPATCHER_PRIO_NORMAL by default
+ *
+ * @param handle            The ESP dispatcher instance
+ * @param sub_event_index   The index of event
+ * @param prio              The priority lane
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ *     - ESP_ERR_ADF_NOT_SUPPORT, the index is not registered
+ */
+esp_err_t esp_dispatcher_set_exe_prio(esp_dispatcher_handle_t handle, int sub_event_index, esp_dispatcher_prio_t prio);
+
+/**
+ * brief      Get the statistics of a registered execution function
+ *
+ * @param handle            The ESP dispatcher instance
+ * @param sub_event_index   The index of event
+ * @param stats             The statistics output
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ *     - ESP_ERR_ADF_NOT_SUPPORT, the index is not registered
+ */
+esp_err_t esp_dispatcher_get_exe_stats(esp_dispatcher_handle_t handle, int sub_event_index, esp_dispatcher_exe_stats_t *stats);
+
+/**
+ * brief      Get the statistics of the ESP dispatcher instance
+ *
+ * @param handle            The ESP dispatcher instance
+ * @param stats             The statistics output
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ */
+esp_err_t esp_dispatcher_get_stats(esp_dispatcher_handle_t handle, esp_dispatcher_stats_t *stats);
+
 /**
  * brief      Execution function with specific index of event.
  *            This is a synchronization interface.
@@ -33,6 +33,7 @@
 #include "esp_action_def.h"
 #include "esp_delegate.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "audio_thread.h"
 
@@ -111,3 +112,107 @@ TEST_CASE("esp_dispatcher stress test async", "esp-adf")
     vQueueDelete(que);
     esp_dispatcher_destroy(dispatcher);
 }
+
+static esp_err_t echo(void *instance, action_arg_t *arg, action_result_t *result)
+{
+    result->data = instance;
+    result->len = arg->len;
+    return ESP_OK;
+}
+
+static esp_err_t slow(void *instance, action_arg_t *arg, action_result_t *result)
+{
+    vTaskDelay(pdMS_TO_TICKS(300));
+    return ESP_OK;
+}
+
+static esp_err_t gate(void *instance, action_arg_t *arg, action_result_t *result)
+{
+    xQueueReceive((QueueHandle_t)instance, &arg->len, portMAX_DELAY);
+    return ESP_OK;
+}
+
+static esp_err_t record_order(void *instance, action_arg_t *arg, action_result_t *result)
+{
+    xQueueSend(que, &arg->len, portMAX_DELAY);
+    return ESP_OK;
+}
+
+TEST_CASE("esp_dispatcher worker pool and lookup", "esp-adf")
+{
+    esp_dispatcher_config_t d_cfg = ESP_DISPATCHER_CONFIG_DEFAULT();
+    d_cfg.worker_num = 2;
+    esp_dispatcher_handle_t dispatcher = esp_dispatcher_create(&d_cfg);
+    TEST_ASSERT_NOT_NULL(dispatcher);
+
+    // Enough indices to grow the table a few times
+    for (int i = 0; i < 40; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_reg_exe_func(dispatcher, (void *)(intptr_t)(i + 1), 0x100 + i * 7, echo));
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_ADF_ALREADY_EXISTS, esp_dispatcher_reg_exe_func(dispatcher, NULL, 0x100, echo));
+    for (int i = 0; i < 40; i++) {
+        action_arg_t arg = { .len = i };
+        action_result_t result = { 0 };
+        TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_execute(dispatcher, 0x100 + i * 7, &arg, &result));
+        TEST_ASSERT_EQUAL(i + 1, (intptr_t)result.data);
+        TEST_ASSERT_EQUAL(i, result.len);
+    }
+    action_result_t result = { 0 };
+    TEST_ASSERT_EQUAL(ESP_ERR_ADF_NOT_SUPPORT, esp_dispatcher_execute(dispatcher, 0x101, NULL, &result));
+
+    // A slow action keeps one worker, the other still serves
+    que = xQueueCreate(1, sizeof(uint8_t));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_execute_with_func_async(dispatcher, slow, NULL, NULL, invoke_cb, NULL));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_execute(dispatcher, 0x100, NULL, &result));
+    TEST_ASSERT_LESS_THAN(100 * 1000, esp_timer_get_time() - start);
+    int cmd;
+    xQueueReceive(que, &cmd, portMAX_DELAY);
+    vQueueDelete(que);
+
+    esp_dispatcher_exe_stats_t exe_stats = { 0 };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_get_exe_stats(dispatcher, 0x100, &exe_stats));
+    TEST_ASSERT_EQUAL(2, exe_stats.count);
+    esp_dispatcher_stats_t stats = { 0 };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_get_stats(dispatcher, &stats));
+    // 40 lookups, the unknown index, the slow action and the fast one
+    TEST_ASSERT_EQUAL(43, stats.all.count);
+    TEST_ASSERT_GREATER_OR_EQUAL(300 * 1000, stats.all.max_exec_us);
+    esp_dispatcher_destroy(dispatcher);
+}
+
+TEST_CASE("esp_dispatcher priority lanes", "esp-adf")
+{
+    esp_dispatcher_config_t d_cfg = ESP_DISPATCHER_CONFIG_DEFAULT();
+    esp_dispatcher_handle_t dispatcher = esp_dispatcher_create(&d_cfg);
+    TEST_ASSERT_NOT_NULL(dispatcher);
+    QueueHandle_t gate_que = xQueueCreate(1, sizeof(int));
+    que = xQueueCreate(4, sizeof(int));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_reg_exe_func(dispatcher, NULL, 1, record_order));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_reg_exe_func(dispatcher, NULL, 2, record_order));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_set_exe_prio(dispatcher, 2, ESP_DISPATCHER_PRIO_HIGH));
+    TEST_ASSERT_EQUAL(ESP_ERR_ADF_NOT_SUPPORT, esp_dispatcher_set_exe_prio(dispatcher, 3, ESP_DISPATCHER_PRIO_HIGH));
+
+    // Hold the only worker, queue a normal action and then a high one
+    TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_execute_with_func_async(dispatcher, gate, gate_que, NULL, NULL, NULL));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    action_arg_t arg = { .len = 1 };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_execute_async(dispatcher, 1, &arg, NULL, NULL));
+    arg.len = 2;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_dispatcher_execute_async(dispatcher, 2, &arg, NULL, NULL));
+    esp_dispatcher_stats_t stats = { 0 };
+    esp_dispatcher_get_stats(dispatcher, &stats);
+    TEST_ASSERT_EQUAL(2, stats.queue_depth);
+    int open = 0;
+    xQueueSend(gate_que, &open, portMAX_DELAY);
+
+    int first = 0, second = 0;
+    xQueueReceive(que, &first, portMAX_DELAY);
+    xQueueReceive(que, &second, portMAX_DELAY);
+    TEST_ASSERT_EQUAL(2, first);
+    TEST_ASSERT_EQUAL(1, second);
+    esp_dispatcher_destroy(dispatcher);
+    vQueueDelete(gate_que);
+    vQueueDelete(que);
+}
@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/task.h"
 #include "audio_mutex.h"
 #include "esp_event_cast.h"
 #include "sys/queue.h"
@@ -38,15 +39,44 @@ static const char *TAG = "EVT_CAST";
 typedef struct esp_evt_cast_item {
     STAILQ_ENTRY(esp_evt_cast_item)     next;
     QueueHandle_t                       que;
+    bool                                zero_copy;
+    uint32_t                            event_mask;
 } esp_evt_cast_item_t;
 
 typedef STAILQ_HEAD(esp_event_cast_list, esp_evt_cast_item) esp_event_cast_list_t;
 
 typedef struct esp_event_cast {
     SemaphoreHandle_t       _mux;
+    portMUX_TYPE            _lock;     // Held only around list links, so ISR walk the list without the mutex
     esp_event_cast_list_t   evt_list;
 } esp_event_cast_t;
 
+static esp_err_t esp_event_cast_add(esp_event_cast_handle_t handle, QueueHandle_t que, bool zero_copy, uint32_t event_mask)
+{
+    if ((handle == NULL) || (que == NULL)) {
+        ESP_LOGE(TAG, "func:%s, invalid parameters, handle=%p, que=%p", __func__, handle, que);
+        return ESP_FAIL;
+    }
+    esp_evt_cast_item_t *local_list = audio_calloc(1, sizeof(esp_evt_cast_item_t));
+    AUDIO_MEM_CHECK(TAG, local_list, {return ESP_FAIL;});
+    local_list->que = que;
+    local_list->zero_copy = zero_copy;
+    local_list->event_mask = event_mask;
+    mutex_lock(handle->_mux);
+    portENTER_CRITICAL(&handle->_lock);
+    STAILQ_INSERT_TAIL(&handle->evt_list, local_list, next);
+    portEXIT_CRITICAL(&handle->_lock);
+    mutex_unlock(handle->_mux);
+    ESP_LOGD(TAG, "INERT, list[%p], que:%p", handle, que);
+
+    return ESP_OK;
+}
+
+static inline bool esp_event_cast_match(esp_evt_cast_item_t *item, esp_event_cast_msg_t *msg)
+{
+    return item->zero_copy && (item->event_mask & ESP_EVENT_CAST_EVENT_MASK(msg->event_id));
+}
+
 
 esp_event_cast_handle_t esp_event_cast_create(void)
 {
@@ -56,6 +86,7 @@ esp_event_cast_handle_t esp_event_cast_create(void)
     AUDIO_NULL_CHECK(TAG, obj->_mux, {audio_free(obj);
                                       return NULL;
                                      });
+    portMUX_INITIALIZE(&obj->_lock);
     STAILQ_INIT(&obj->evt_list);
     return obj;
 }
@@ -77,19 +108,12 @@ esp_err_t esp_event_cast_destroy(esp_event_cast_handle_t handle)
 
 esp_err_t esp_event_cast_register(esp_event_cast_handle_t handle, QueueHandle_t que)
 {
-    if ((handle == NULL) || (que == NULL)) {
-        ESP_LOGE(TAG, "func:%s, invalid parameters, handle=%p, que=%p", __func__, handle, que);
-        return ESP_FAIL;
-    }
-    esp_evt_cast_item_t *local_list = audio_calloc(1, sizeof(esp_evt_cast_item_t));
-    AUDIO_MEM_CHECK(TAG, local_list, {return ESP_FAIL;});
-    mutex_lock(handle->_mux);
-    local_list->que = que;
-    STAILQ_INSERT_TAIL(&handle->evt_list, local_list, next);
-    mutex_unlock(handle->_mux);
-    ESP_LOGD(TAG, "INERT, list[%p], que:%p", handle, que);
+    return esp_event_cast_add(handle, que, false, 0);
+}
 
-    return ESP_OK;
+esp_err_t esp_event_cast_subscribe(esp_event_cast_handle_t handle, QueueHandle_t que, uint32_t event_mask)
+{
+    return esp_event_cast_add(handle, que, true, event_mask);
 }
 
 esp_err_t esp_event_cast_unregister(esp_event_cast_handle_t handle, QueueHandle_t que)
@@ -103,7 +127,9 @@ esp_err_t esp_event_cast_unregister(esp_event_cast_handle_t handle, QueueHandle_
     STAILQ_FOREACH_SAFE(item,  &handle->evt_list, next, tmp) {
         ESP_LOGD(TAG, "func:%s, list=%p, que=%p, target que:%p", __func__, item, item->que, que);
         if (item->que == que) {
+            portENTER_CRITICAL(&handle->_lock);
             STAILQ_REMOVE(&handle->evt_list, item, esp_evt_cast_item, next);
+            portEXIT_CRITICAL(&handle->_lock);
             audio_free(item);
             break;
         }
@@ -124,7 +150,7 @@ esp_err_t esp_event_cast_broadcasting(esp_event_cast_handle_t handle, void *data
     esp_evt_cast_item_t *item, *tmp;
     STAILQ_FOREACH_SAFE(item,  &handle->evt_list, next, tmp) {
         ESP_LOGD(TAG, "func:%s, list=%p, que=%p, data:%p", __func__, item, item->que, data);
-        if (item->que) {
+        if (item->que && !item->zero_copy) {
             if (pdFALSE == xQueueSend(item->que, data, 0)) {
                 ESP_LOGW(TAG, "Queue[%p] send failed, free size:%d", item->que, uxQueueSpacesAvailable(item->que));
             }
@@ -140,16 +166,16 @@ esp_err_t esp_event_cast_broadcasting_isr(esp_event_cast_handle_t handle, void *
         ESP_EARLY_LOGE(TAG, "func:%s, invalid parameters, handle=%p, data=%p", __func__, handle, data);
         return ESP_FAIL;
     }
-    mutex_lock(handle->_mux);
+    portENTER_CRITICAL_ISR(&handle->_lock);
     esp_evt_cast_item_t *item, *tmp;
     STAILQ_FOREACH_SAFE(item,  &handle->evt_list, next, tmp) {
-        if (item->que) {
+        if (item->que && !item->zero_copy) {
             if (pdFALSE == xQueueSendFromISR(item->que, data, 0)) {
-                ESP_EARLY_LOGW(TAG, "Queue[%p] send failed, free size:%d", item->que, uxQueueSpacesAvailable(item->que));
+                ESP_EARLY_LOGW(TAG, "Queue[%p] send failed", item->que);
             }
         }
     }
-    mutex_unlock(handle->_mux);
+    portEXIT_CRITICAL_ISR(&handle->_lock);
     return 0;
 }
 
@@ -167,4 +193,95 @@ esp_err_t esp_event_cast_get_count(esp_event_cast_handle_t handle)
     }
     mutex_unlock(handle->_mux);
     return cnt;
-}
\ No newline at end of file
+}
+
+esp_event_cast_msg_t *esp_event_cast_msg_create(int event_id, const void *data, int len)
+{
+    AUDIO_CHECK(TAG, (event_id >= 0) && (event_id <= ESP_EVENT_CAST_MAX_EVENT_ID), return NULL, "Invalid event id");
+    AUDIO_CHECK(TAG, len >= 0, return NULL, "Invalid length");
+    esp_event_cast_msg_t *msg = audio_calloc(1, sizeof(esp_event_cast_msg_t) + len);
+    AUDIO_MEM_CHECK(TAG, msg, return NULL);
+    msg->event_id = event_id;
+    msg->len = len;
+    msg->refs = 1;
+    if (len) {
+        msg->data = msg + 1;
+        if (data) {
+            memcpy(msg->data, data, len);
+        }
+    }
+    return msg;
+}
+
+esp_event_cast_msg_t *esp_event_cast_msg_ref(esp_event_cast_msg_t *msg)
+{
+    if (msg) {
+        __atomic_add_fetch(&msg->refs, 1, __ATOMIC_SEQ_CST);
+    }
+    return msg;
+}
+
+void esp_event_cast_msg_unref(esp_event_cast_msg_t *msg)
+{
+    if (msg && __atomic_sub_fetch(&msg->refs, 1, __ATOMIC_SEQ_CST) == 0) {
+        audio_free(msg);
+    }
+}
+
+esp_err_t esp_event_cast_publish(esp_event_cast_handle_t handle, esp_event_cast_msg_t *msg, TickType_t ticks_to_wait, int *undelivered)
+{
+    if ((handle == NULL) || (msg == NULL)) {
+        ESP_LOGE(TAG, "func:%s, invalid parameters, handle=%p, msg=%p", __func__, handle, msg);
+        return ESP_FAIL;
+    }
+    int missed = 0;
+    TickType_t start = xTaskGetTickCount();
+    mutex_lock(handle->_mux);
+    esp_evt_cast_item_t *item;
+    STAILQ_FOREACH(item, &handle->evt_list, next) {
+        if (!esp_event_cast_match(item, msg)) {
+            continue;
+        }
+        // The wait is shared by all the subscribers, one slow queue must not multiply it
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        TickType_t wait = elapsed < ticks_to_wait ? ticks_to_wait - elapsed : 0;
+        esp_event_cast_msg_ref(msg);
+        if (pdFALSE == xQueueSend(item->que, &msg, wait)) {
+            __atomic_sub_fetch(&msg->refs, 1, __ATOMIC_SEQ_CST);
+            missed++;
+            ESP_LOGW(TAG, "Queue[%p] full, event %d not delivered", item->que, msg->event_id);
+        }
+    }
+    mutex_unlock(handle->_mux);
+    if (undelivered) {
+        *undelivered = missed;
+    }
+    return missed ? ESP_ERR_ADF_TIMEOUT : ESP_OK;
+}
+
+esp_err_t esp_event_cast_publish_from_isr(esp_event_cast_handle_t handle, esp_event_cast_msg_t *msg, BaseType_t *task_woken)
+{
+    if ((handle == NULL) || (msg == NULL)) {
+        return ESP_FAIL;
+    }
+    int missed = 0;
+    BaseType_t woken = pdFALSE;
+    portENTER_CRITICAL_ISR(&handle->_lock);
+    esp_evt_cast_item_t *item;
+    STAILQ_FOREACH(item, &handle->evt_list, next) {
+        if (!esp_event_cast_match(item, msg)) {
+            continue;
+        }
+        // The caller holds a reference, so dropping ours on failure never frees it here
+        __atomic_add_fetch(&msg->refs, 1, __ATOMIC_SEQ_CST);
+        if (pdFALSE == xQueueSendFromISR(item->que, &msg, &woken)) {
+            __atomic_sub_fetch(&msg->refs, 1, __ATOMIC_SEQ_CST);
+            missed++;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&handle->_lock);
+    if (task_woken) {
+        *task_woken |= woken;
+    }
+    return missed ? ESP_ERR_ADF_TIMEOUT : ESP_OK;
+}
@@ -25,8 +25,27 @@
 #ifndef __ESP_EVENT_CAST_H__
 #define __ESP_EVENT_CAST_H__
 
+#include <stdint.h>
+
+#define ESP_EVENT_CAST_EVENT_MASK(id)   (1UL << (id))   /*!< Subscriber mask bit of the given event id */
+#define ESP_EVENT_CAST_ALL_EVENTS       (0xFFFFFFFF)    /*!< Subscriber mask that receives every event id */
+#define ESP_EVENT_CAST_MAX_EVENT_ID     (31)            /*!< Largest event id a message can carry */
+
 typedef struct esp_event_cast *esp_event_cast_handle_t;
 
+/**
+ * @brief Reference counted message published by `esp_event_cast_publish`
+ *
+ *        The payload is stored once right after this header, each subscriber queue only carries a
+ *        pointer to the message. Whoever receives one must call `esp_event_cast_msg_unref` when done.
+ */
+typedef struct esp_event_cast_msg {
+    int         event_id;   /*!< Event id, 0 ~ ESP_EVENT_CAST_MAX_EVENT_ID, matched against the subscriber masks */
+    void        *data;      /*!< Payload, NULL when len is 0 */
+    int         len;        /*!< Payload length in bytes */
+    uint32_t    refs;       /*!< Reference count, only touched through esp_event_cast_msg_ref/unref */
+} esp_event_cast_msg_t;
+
 /**
  * @brief Create esp_event_cast instance
  *
@@ -86,7 +105,7 @@ esp_err_t esp_event_cast_broadcasting(esp_event_cast_handle_t handle, void *data
 /**
  * @brief Broadcasting the data to receiver from ISR
  *
- * @note This API is untested
+ * @note The receiver list is guarded by a spinlock here, not the mutex
  *
  * @param  handle: A poniter to esp_event_cast_handle_t
  * @param  data:   Data packet will be broadcasting
@@ -108,4 +127,87 @@ esp_err_t esp_event_cast_broadcasting_isr(esp_event_cast_handle_t handle, void *
  */
 esp_err_t esp_event_cast_get_count(esp_event_cast_handle_t handle);
 
+/**
+ * @brief Add a zero-copy subscriber queue to esp_event_cast_handle_t object
+ *
+ * @note The queue item size must be `sizeof(esp_event_cast_msg_t *)`, it only receives messages sent by
+ *       `esp_event_cast_publish` and `esp_event_cast_publish_from_isr` whose event id is set in `event_mask`.
+ *       Use `esp_event_cast_unregister` to remove it.
+ *
+ * @param  handle:      A poniter to esp_event_cast_handle_t
+ * @param  que:         The queue receiving `esp_event_cast_msg_t *` items
+ * @param  event_mask:  Bitwise OR of ESP_EVENT_CAST_EVENT_MASK(id), or ESP_EVENT_CAST_ALL_EVENTS
+ *
+ * @return
+ *     - ESP_OK: success
+ *     - ESP_FAIL: others
+ */
+esp_err_t esp_event_cast_subscribe(esp_event_cast_handle_t handle, QueueHandle_t que, uint32_t event_mask);
+
+/**
+ * @brief Create a message with one reference owned by the caller, the payload is copied once
+ *
+ * @param  event_id:  Event id, 0 ~ ESP_EVENT_CAST_MAX_EVENT_ID
+ * @param  data:      Payload to copy, can be NULL to leave it zeroed
+ * @param  len:       Payload length in bytes
+ *
+ * @return
+ *     - Valid pointer on success
+ *     - NULL when any errors
+ */
+esp_event_cast_msg_t *esp_event_cast_msg_create(int event_id, const void *data, int len);
+
+/**
+ * @brief Take one more reference of the message
+ *
+ * @param  msg:  The message
+ *
+ * @return The same message
+ */
+esp_event_cast_msg_t *esp_event_cast_msg_ref(esp_event_cast_msg_t *msg);
+
+/**
+ * @brief Drop one reference of the message, it is freed with the last one
+ *
+ * @note Must be called from task context
+ *
+ * @param  msg:  The message
+ */
+void esp_event_cast_msg_unref(esp_event_cast_msg_t *msg);
+
+/**
+ * @brief Publish one message to every subscriber whose event mask matches
+ *
+ *        Each delivery takes its own reference, the caller keeps its reference and releases it when done.
+ *        A subscriber whose queue stays full for `ticks_to_wait` is reported instead of silently skipped.
+ *
+ * @param  handle:         A poniter to esp_event_cast_handle_t
+ * @param  msg:            Message created by esp_event_cast_msg_create
+ * @param  ticks_to_wait:  Total time to wait for full subscriber queues
+ * @param  undelivered:    Optional, number of subscribers the message did not reach
+ *
+ * @return
+ *     - ESP_OK: delivered to all matching subscribers
+ *     - ESP_ERR_ADF_TIMEOUT: at least one subscriber queue stayed full
+ *     - ESP_FAIL: invalid parameters
+ */
+esp_err_t esp_event_cast_publish(esp_event_cast_handle_t handle, esp_event_cast_msg_t *msg, TickType_t ticks_to_wait, int *undelivered);
+
+/**
+ * @brief Publish one message from ISR, the subscriber list is walked under a spinlock instead of the mutex
+ *
+ * @note Create the message in task context and keep its reference while it may be published, so that
+ *       the last reference is never dropped in the ISR
+ *
+ * @param  handle:         A poniter to esp_event_cast_handle_t
+ * @param  msg:            Message created by esp_event_cast_msg_create
+ * @param  task_woken:     Set to pdTRUE when a higher priority task was woken, can be NULL
+ *
+ * @return
+ *     - ESP_OK: delivered to all matching subscribers
+ *     - ESP_ERR_ADF_TIMEOUT: at least one subscriber queue was full
+ *     - ESP_FAIL: invalid parameters
+ */
+esp_err_t esp_event_cast_publish_from_isr(esp_event_cast_handle_t handle, esp_event_cast_msg_t *msg, BaseType_t *task_woken);
+
 #endif  //__ESP_EVENT_CAST_H__
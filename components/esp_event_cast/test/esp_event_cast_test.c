@@ -32,6 +32,7 @@
 #include "esp_event_cast.h"
 #include "esp_log.h"
 #include "audio_mem.h"
+#include "audio_error.h"
 
 static const char *TAG = "EVT_CAST_TEST";
 #define TEST_QUEUE_NUMBER 50
@@ -257,4 +258,59 @@ TEST_CASE("Received data in real time", "[esp_event_cast]")
     vTaskDelay(3000 / portTICK_PERIOD_MS);
     AUDIO_MEM_SHOW(TAG);
     esp_event_cast_destroy(broadcast);
-}
\ No newline at end of file
+}
+
+TEST_CASE("publish refcounted message with filter", "[esp_event_cast]")
+{
+    esp_event_cast_handle_t broadcast = esp_event_cast_create();
+    TEST_ASSERT_NOT_NULL(broadcast);
+    xQueueHandle all_que = xQueueCreate(2, sizeof(esp_event_cast_msg_t *));
+    xQueueHandle one_que = xQueueCreate(2, sizeof(esp_event_cast_msg_t *));
+    xQueueHandle legacy_que = xQueueCreate(2, 12);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_cast_subscribe(broadcast, all_que, ESP_EVENT_CAST_ALL_EVENTS));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_cast_subscribe(broadcast, one_que, ESP_EVENT_CAST_EVENT_MASK(3)));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_cast_register(broadcast, legacy_que));
+    TEST_ASSERT_EQUAL(3, esp_event_cast_get_count(broadcast));
+
+    int buf[3] = {1, 2, 3};
+    int undelivered = -1;
+    esp_event_cast_msg_t *msg = esp_event_cast_msg_create(3, buf, sizeof(buf));
+    TEST_ASSERT_NOT_NULL(msg);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_cast_publish(broadcast, msg, 0, &undelivered));
+    TEST_ASSERT_EQUAL(0, undelivered);
+    TEST_ASSERT_EQUAL(3, msg->refs);
+    TEST_ASSERT_EQUAL(0, uxQueueMessagesWaiting(legacy_que));
+
+    // Only the catch-all subscriber wants event 5
+    esp_event_cast_msg_t *other = esp_event_cast_msg_create(5, NULL, 0);
+    TEST_ASSERT_NOT_NULL(other);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_cast_publish_from_isr(broadcast, other, NULL));
+    TEST_ASSERT_EQUAL(1, uxQueueMessagesWaiting(one_que));
+    TEST_ASSERT_EQUAL(2, uxQueueMessagesWaiting(all_que));
+
+    // The catch-all queue is full now, that is reported rather than dropped silently
+    TEST_ASSERT_EQUAL(ESP_ERR_ADF_TIMEOUT, esp_event_cast_publish(broadcast, msg, 10 / portTICK_PERIOD_MS, &undelivered));
+    TEST_ASSERT_EQUAL(1, undelivered);
+    TEST_ASSERT_EQUAL(4, msg->refs);
+
+    esp_event_cast_msg_t *recv = NULL;
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(all_que, &recv, 0));
+    TEST_ASSERT_EQUAL_PTR(msg, recv);
+    TEST_ASSERT_EQUAL(0, memcmp(recv->data, buf, sizeof(buf)));
+    esp_event_cast_msg_unref(recv);
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(all_que, &recv, 0));
+    TEST_ASSERT_EQUAL_PTR(other, recv);
+    esp_event_cast_msg_unref(recv);
+    while (xQueueReceive(one_que, &recv, 0) == pdTRUE) {
+        esp_event_cast_msg_unref(recv);
+    }
+    TEST_ASSERT_EQUAL(1, msg->refs);
+    TEST_ASSERT_EQUAL(1, other->refs);
+    esp_event_cast_msg_unref(msg);
+    esp_event_cast_msg_unref(other);
+
+    esp_event_cast_destroy(broadcast);
+    vQueueDelete(all_que);
+    vQueueDelete(one_que);
+    vQueueDelete(legacy_que);
+}
@@ -31,6 +31,23 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Sdcard playlist configuration
+ */
+typedef struct {
+    const char *dir;        /*!< Directory to save the list files, NULL for "/sdcard/__playlist" */
+    uint8_t    list_id;     /*!< Id of the list, lists with different ids use different files */
+    bool       persistent;  /*!< Load the list saved by last boot on create, and keep the files on destroy */
+    int        batch_size;  /*!< Size of buffer to batch the URLs before writing to sdcard, should be larger than 2048 */
+} sdcard_list_cfg_t;
+
+#define SDCARD_LIST_CFG_DEFAULT() {     \
+    .dir = NULL,                        \
+    .list_id = 0,                       \
+    .persistent = false,                \
+    .batch_size = 4 * 1024,             \
+}
+
 /**
  * @brief Create a playlist in sdcard by list id
  *
@@ -42,6 +59,33 @@ extern "C" {
  */
 esp_err_t sdcard_list_create(playlist_operator_handle_t *handle);
 
+/**
+ * @brief Create a playlist in sdcard with configuration
+ *
+ * @note The URLs are kept in an in-memory index, so `choose` and `exist` do not scan the files.
+ *       Saved URLs are written to sdcard in batches, call `sdcard_list_flush` after a scan
+ *       or the URLs in the last batch are only written on destroy of a persistent list.
+ *
+ * @param      config   The configuration
+ * @param[out] handle   The playlist handle from application layer
+ *
+ * @return 
+ *     - ESP_OK   success
+ *     - ESP_FAIL failed
+ */
+esp_err_t sdcard_list_create_with_cfg(const sdcard_list_cfg_t *config, playlist_operator_handle_t *handle);
+
+/**
+ * @brief Write the batched URLs to sdcard
+ *
+ * @param handle     Playlist handle
+ *
+ * @return 
+ *     - ESP_OK   success
+ *     - ESP_FAIL failed
+ */
+esp_err_t sdcard_list_flush(playlist_operator_handle_t handle);
+
 /**
  * @brief Show all the URLs in sdcard playlist
  *
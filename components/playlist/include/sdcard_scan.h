@@ -29,8 +29,83 @@
 extern "C" {
 #endif
 
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
 typedef void (*sdcard_scan_cb_t)(void *user_data, char *url);
 
+/**
+ * @brief Callback to receive a batch of URLs
+ *
+ * @note The URLs are only valid in the callback, copy them if needed
+ */
+typedef void (*sdcard_scan_batch_cb_t)(void *user_data, const char *urls[], int num);
+
+/**
+ * @brief How to judge whether a directory is changed since last scan
+ */
+typedef enum {
+    SDCARD_SCAN_CHECK_ENTRIES,  /*!< Read the directory and compare number and names of entries, safe on all filesystems.
+                                     The URLs of an unchanged directory come from the cache, but every directory is still read
+                                     from the card */
+    SDCARD_SCAN_CHECK_MTIME,    /*!< Compare modified time of directory only, an unchanged directory is not read at all.
+                                     This is the only mode that avoids card reads for unchanged directories.
+                                     FATFS does not update the time of a directory when files are added by the device itself,
+                                     so only use it for cards filled by a PC */
+} sdcard_scan_check_mode_t;
+
+/**
+ * @brief Sdcard scan configuration
+ */
+typedef struct {
+    const char              *path;           /*!< The path to be scanned */
+    int                     depth;           /*!< The depth of file scanning, 0 to scan files in `path` only */
+    const char              **file_extension;/*!< File extensions to be saved, NULL for all files. Must be valid until scan finished */
+    int                     filter_num;      /*!< Number of file extensions */
+    const char              *cache_file;     /*!< File to save directories of last scan, NULL to disable incremental scan */
+    sdcard_scan_check_mode_t check_mode;     /*!< How to detect changed directories when `cache_file` is set */
+    int                     batch_num;       /*!< Max number of URLs in one batch */
+    sdcard_scan_batch_cb_t  cb;              /*!< Callback to receive URLs */
+    void                    *user_data;      /*!< The data to be used by callback function */
+    int                     task_stack;      /*!< Stack size of scan task */
+    int                     task_prio;       /*!< Priority of scan task */
+    int                     task_core;       /*!< Core of scan task */
+    bool                    stack_in_ext;    /*!< Try to allocate stack in external memory */
+} sdcard_scan_cfg_t;
+
+#define SDCARD_SCAN_TASK_STACK          (4 * 1024)
+#define SDCARD_SCAN_TASK_PRIO           (3)
+#define SDCARD_SCAN_TASK_CORE           (0)
+#define SDCARD_SCAN_BATCH_NUM           (32)
+
+#define SDCARD_SCAN_CFG_DEFAULT() {                 \
+    .path = "/sdcard",                              \
+    .depth = 5,                                     \
+    .file_extension = NULL,                         \
+    .filter_num = 0,                                \
+    .cache_file = NULL,                             \
+    .check_mode = SDCARD_SCAN_CHECK_ENTRIES,        \
+    .batch_num = SDCARD_SCAN_BATCH_NUM,             \
+    .cb = NULL,                                     \
+    .user_data = NULL,                              \
+    .task_stack = SDCARD_SCAN_TASK_STACK,           \
+    .task_prio = SDCARD_SCAN_TASK_PRIO,             \
+    .task_core = SDCARD_SCAN_TASK_CORE,             \
+    .stack_in_ext = false,                          \
+}
+
+/**
+ * @brief Progress of sdcard scan
+ */
+typedef struct {
+    int     dir_num;        /*!< Directories scanned */
+    int     dir_skipped;    /*!< Directories unchanged since last scan */
+    int     url_num;        /*!< URLs found */
+    bool    finished;       /*!< Scan is finished or cancelled */
+} sdcard_scan_progress_t;
+
+typedef struct sdcard_scan_task *sdcard_scan_handle_t;
+
 /**
  * @brief Scan files in SD card and use callback function to save files that meet filtering conditions.
  *
@@ -51,6 +126,83 @@ typedef void (*sdcard_scan_cb_t)(void *user_data, char *url);
  */
 esp_err_t sdcard_scan(sdcard_scan_cb_t cb, const char *path, int depth, const char *file_extension[], int filter_num, void *user_data);
 
+/**
+ * @brief Scan files in SD card with configuration, URLs are passed to callback in batches.
+ *
+ * @note  With `cache_file` set, the directories are saved after scan. On next scan the URLs of unchanged
+ *        directories are taken from the cache, and the cache is replaced only if the scan is not cancelled.
+ *        Files of a directory are reported before the files in its subdirectories.
+ *
+ * @param      cfg        The configuration
+ * @param[out] progress   Result of the scan, can be NULL
+ *
+ * @return
+ *     - ESP_OK   success
+ *     - ESP_FAIL failed
+ */
+esp_err_t sdcard_scan_with_cfg(const sdcard_scan_cfg_t *cfg, sdcard_scan_progress_t *progress);
+
+/**
+ * @brief Start to scan files in SD card in a background task
+ *
+ * @note  The callback is called in the scan task
+ *
+ * @param      cfg        The configuration
+ * @param[out] handle     The scan handle
+ *
+ * @return
+ *     - ESP_OK   success
+ *     - ESP_FAIL failed
+ */
+esp_err_t sdcard_scan_start(const sdcard_scan_cfg_t *cfg, sdcard_scan_handle_t *handle);
+
+/**
+ * @brief Get progress of a background scan
+ *
+ * @param      handle     The scan handle
+ * @param[out] progress   Progress of the scan
+ *
+ * @return
+ *     - ESP_OK   success
+ *     - ESP_FAIL failed
+ */
+esp_err_t sdcard_scan_get_progress(sdcard_scan_handle_t handle, sdcard_scan_progress_t *progress);
+
+/**
+ * @brief Request a background scan to stop, the URLs found already are kept
+ *
+ * @param handle     The scan handle
+ *
+ * @return
+ *     - ESP_OK   success
+ *     - ESP_FAIL failed
+ */
+esp_err_t sdcard_scan_cancel(sdcard_scan_handle_t handle);
+
+/**
+ * @brief Wait for a background scan to finish
+ *
+ * @param handle            The scan handle
+ * @param ticks_to_wait     Max time to wait
+ *
+ * @return
+ *     - ESP_OK           scan finished
+ *     - ESP_ERR_TIMEOUT  scan is still running
+ *     - ESP_FAIL         scan failed
+ */
+esp_err_t sdcard_scan_wait(sdcard_scan_handle_t handle, TickType_t ticks_to_wait);
+
+/**
+ * @brief Cancel a background scan, wait for the task to exit and free the handle
+ *
+ * @param handle     The scan handle
+ *
+ * @return
+ *     - ESP_OK   success
+ *     - ESP_FAIL failed
+ */
+esp_err_t sdcard_scan_destroy(sdcard_scan_handle_t handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,13 +33,15 @@
 #include "sdcard_list.h"
 
 #define SDCARD_DEFAULT_DIR_NAME         "/sdcard/__playlist"
-#define SDCARD_DEFAULT_URL_FILE_NAME    "/sdcard/__playlist/_playlist_url"
-#define SDCARD_DEFAULT_OFFSET_FILE_NAME "/sdcard/__playlist/_offset"
-
-#define SDCARD_URL_FILE_NAME_LENGTH     (strlen(SDCARD_DEFAULT_URL_FILE_NAME) + 10)
-#define SDCARD_OFFSET_FILE_NAME_LENGTH  (strlen(SDCARD_DEFAULT_OFFSET_FILE_NAME) + 10)
+#define SDCARD_URL_FILE_NAME            "_playlist_url"
+#define SDCARD_OFFSET_FILE_NAME         "_offset"
 
 #define SDCARD_LIST_URL_MAX_LENGTH      (1024 * 2)
+#define SDCARD_LIST_BATCH_SIZE          (1024 * 4)
+#define SDCARD_LIST_OFFSET_BATCH_NUM    (256)
+#define SDCARD_LIST_INDEX_STEP          (256)
+#define SDCARD_LIST_MAX_URL_NUM         (UINT16_MAX - 1)
+#define SDCARD_OFFSET_RECORD_SIZE       (sizeof(uint32_t) + sizeof(uint16_t))
 
 #define CHECK_ERROR(TAG, para, action)  {\
     if ((para) == false) {\
@@ -50,6 +52,15 @@
 
 static const char *TAG = "PLAYLIST_SDCARD";
 
+/**
+ * @brief Location of an URL in URL file, mirror of a record in offset file
+ */
+typedef struct {
+    uint32_t pos;                        /*!< Offset of URL in file to save URLs */
+    uint32_t hash;                       /*!< Hash of URL */
+    uint16_t len;                        /*!< Length of URL */
+} sdcard_list_index_t;
+
 /**
  * @brief Sdcard list management unit
  */
@@ -61,12 +72,123 @@ typedef struct sdcard_list {
     char *cur_url;                       /*!< Point to current URL */
     uint16_t url_num;                    /*!< Number of URLs */
     uint16_t cur_url_id;                 /*!< Current url ID */
-    uint32_t total_size_save_file;       /*!< Size of file to save URLs */
-    uint32_t total_size_offset_file;     /*!< Size of file to save offset */
+    uint32_t total_size_save_file;       /*!< Size of file to save URLs, including URLs not flushed yet */
+    uint32_t total_size_offset_file;     /*!< Size of file to save offset, including records not flushed yet */
+    bool persistent;                     /*!< Keep the files for next boot */
+    sdcard_list_index_t *index;          /*!< Locations of all the URLs */
+    int index_size;                      /*!< Allocated entries of index */
+    uint16_t *hash_table;                /*!< Open addressing table of URL id + 1, 0 for empty slot */
+    int hash_size;                       /*!< Slots of hash table, power of 2 */
+    char *url_batch;                     /*!< URLs not written to file yet */
+    int url_batch_len;                   /*!< Bytes in URL batch */
+    int batch_size;                      /*!< Size of URL batch */
+    uint8_t *offset_batch;               /*!< Offset records not written to file yet */
+    int offset_batch_len;                /*!< Bytes in offset batch */
+    uint32_t flushed_size;               /*!< Size of URLs already written to file */
 } sdcard_list_t;
 
 esp_err_t sdcard_list_get_operation(playlist_operation_t *operation);
 
+static uint32_t sdcard_list_hash(const char *url, int len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        hash ^= (uint8_t)url[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void hash_table_insert(sdcard_list_t *playlist, uint16_t id)
+{
+    int mask = playlist->hash_size - 1;
+    int slot = playlist->index[id].hash & mask;
+    while (playlist->hash_table[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    playlist->hash_table[slot] = id + 1;
+}
+
+static esp_err_t hash_table_grow(sdcard_list_t *playlist, int url_num)
+{
+    // Keep load factor under 1/2 so that probing stays short
+    if (url_num * 2 <= playlist->hash_size) {
+        return ESP_OK;
+    }
+    int size = playlist->hash_size ? playlist->hash_size : SDCARD_LIST_INDEX_STEP;
+    while (url_num * 2 > size) {
+        size *= 2;
+    }
+    uint16_t *table = audio_calloc(size, sizeof(uint16_t));
+    AUDIO_NULL_CHECK(TAG, table, return ESP_FAIL);
+    audio_free(playlist->hash_table);
+    playlist->hash_table = table;
+    playlist->hash_size = size;
+    for (int i = 0; i < playlist->url_num; i++) {
+        hash_table_insert(playlist, i);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t index_append(sdcard_list_t *playlist, uint32_t pos, uint16_t len, uint32_t hash)
+{
+    if (playlist->url_num >= SDCARD_LIST_MAX_URL_NUM) {
+        ESP_LOGE(TAG, "Too many urls in sdcard list, max %d", SDCARD_LIST_MAX_URL_NUM);
+        return ESP_FAIL;
+    }
+    if (playlist->url_num >= playlist->index_size) {
+        int size = playlist->index_size + SDCARD_LIST_INDEX_STEP + playlist->index_size / 2;
+        sdcard_list_index_t *index = audio_realloc(playlist->index, size * sizeof(sdcard_list_index_t));
+        AUDIO_NULL_CHECK(TAG, index, return ESP_FAIL);
+        playlist->index = index;
+        playlist->index_size = size;
+    }
+    if (hash_table_grow(playlist, playlist->url_num + 1) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    sdcard_list_index_t *item = &playlist->index[playlist->url_num];
+    item->pos = pos;
+    item->len = len;
+    item->hash = hash;
+    hash_table_insert(playlist, playlist->url_num);
+    playlist->url_num++;
+    return ESP_OK;
+}
+
+static esp_err_t read_url(sdcard_list_t *playlist, int id, char *url)
+{
+    sdcard_list_index_t *item = &playlist->index[id];
+    if (item->pos >= playlist->flushed_size) {
+        memcpy(url, playlist->url_batch + item->pos - playlist->flushed_size, item->len);
+    } else {
+        CHECK_ERROR(TAG, ((fseek(playlist->save_file, item->pos, SEEK_SET)) == 0), return ESP_FAIL);
+        CHECK_ERROR(TAG, ((fread(url, 1, item->len, playlist->save_file)) == item->len), return ESP_FAIL);
+    }
+    url[item->len] = 0;
+    return ESP_OK;
+}
+
+static esp_err_t sdcard_list_flush_batch(sdcard_list_t *playlist)
+{
+    if (playlist->offset_batch_len == 0) {
+        return ESP_OK;
+    }
+    CHECK_ERROR(TAG, ((fseek(playlist->save_file, playlist->flushed_size, SEEK_SET)) == 0), return ESP_FAIL);
+    CHECK_ERROR(TAG, (fwrite(playlist->url_batch, 1, playlist->url_batch_len, playlist->save_file) == playlist->url_batch_len), return ESP_FAIL);
+    CHECK_ERROR(TAG, ((fseek(playlist->offset_file, playlist->total_size_offset_file - playlist->offset_batch_len, SEEK_SET)) == 0), return ESP_FAIL);
+    CHECK_ERROR(TAG, (fwrite(playlist->offset_batch, 1, playlist->offset_batch_len, playlist->offset_file) == playlist->offset_batch_len), return ESP_FAIL);
+    CHECK_ERROR(TAG, (fflush(playlist->save_file) == 0), return ESP_FAIL);
+    CHECK_ERROR(TAG, (fflush(playlist->offset_file) == 0), return ESP_FAIL);
+    // URL file goes first, so that a record in offset file never points to missing data
+    CHECK_ERROR(TAG, (fsync(fileno(playlist->save_file)) == 0), return ESP_FAIL);
+    CHECK_ERROR(TAG, (fsync(fileno(playlist->offset_file)) == 0), return ESP_FAIL);
+    playlist->flushed_size += playlist->url_batch_len;
+    playlist->url_batch_len = 0;
+    playlist->offset_batch_len = 0;
+    return ESP_OK;
+}
+
 static esp_err_t save_url_to_sdcard(sdcard_list_t *playlist, const char *path)
 {
     if (playlist->save_file == NULL || playlist->offset_file == NULL) {
@@ -74,96 +196,188 @@ static esp_err_t save_url_to_sdcard(sdcard_list_t *playlist, const char *path)
         return ESP_FAIL;
     }
     uint16_t len = strlen(path);
-    CHECK_ERROR(TAG, ((fseek(playlist->offset_file, playlist->total_size_offset_file, SEEK_SET)) == 0), return ESP_FAIL);
-    CHECK_ERROR(TAG, ((fseek(playlist->save_file, playlist->total_size_save_file, SEEK_SET)) == 0), return ESP_FAIL);
-    CHECK_ERROR(TAG, (fwrite(path, 1, len, playlist->save_file) == len), return ESP_FAIL);
-    CHECK_ERROR(TAG, (fwrite(&playlist->total_size_save_file, 1, sizeof(uint32_t), playlist->offset_file) == sizeof(uint32_t)), return ESP_FAIL);
-    CHECK_ERROR(TAG, (fwrite(&len, 1, sizeof(uint16_t), playlist->offset_file)) == sizeof(uint16_t), return ESP_FAIL);
-    CHECK_ERROR(TAG, (fsync(fileno(playlist->save_file)) == 0), return ESP_FAIL);
-    CHECK_ERROR(TAG, (fsync(fileno(playlist->offset_file)) == 0), return ESP_FAIL);
+    if (playlist->url_batch_len + len > playlist->batch_size
+        || playlist->offset_batch_len + SDCARD_OFFSET_RECORD_SIZE > SDCARD_LIST_OFFSET_BATCH_NUM * SDCARD_OFFSET_RECORD_SIZE) {
+        CHECK_ERROR(TAG, (sdcard_list_flush_batch(playlist) == ESP_OK), return ESP_FAIL);
+    }
+    if (index_append(playlist, playlist->total_size_save_file, len, sdcard_list_hash(path, len)) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    memcpy(playlist->url_batch + playlist->url_batch_len, path, len);
+    playlist->url_batch_len += len;
+    uint8_t *record = playlist->offset_batch + playlist->offset_batch_len;
+    memcpy(record, &playlist->total_size_save_file, sizeof(uint32_t));
+    memcpy(record + sizeof(uint32_t), &len, sizeof(uint16_t));
+    playlist->offset_batch_len += SDCARD_OFFSET_RECORD_SIZE;
     playlist->total_size_save_file += len;
-    playlist->total_size_offset_file += (sizeof(uint16_t) + sizeof(uint32_t));
-    playlist->url_num++;
-
+    playlist->total_size_offset_file += SDCARD_OFFSET_RECORD_SIZE;
     return ESP_OK;
 }
 
-static esp_err_t sdcard_list_open(sdcard_list_t *playlist, uint8_t list_id)
+static esp_err_t sdcard_list_load(sdcard_list_t *playlist)
 {
-    playlist->save_file_name = audio_calloc(1, SDCARD_URL_FILE_NAME_LENGTH);
-    AUDIO_NULL_CHECK(TAG, playlist->save_file_name, return ESP_FAIL);
-    playlist->offset_file_name = audio_calloc(1, SDCARD_OFFSET_FILE_NAME_LENGTH);
-    AUDIO_NULL_CHECK(TAG, playlist->offset_file_name, {
-        audio_free(playlist->save_file_name);
-        return ESP_FAIL;
-    });
-
-    sprintf(playlist->save_file_name, "%s%d", SDCARD_DEFAULT_URL_FILE_NAME, list_id);
-    sprintf(playlist->offset_file_name, "%s%d", SDCARD_DEFAULT_OFFSET_FILE_NAME, list_id);
+    CHECK_ERROR(TAG, (fseek(playlist->save_file, 0, SEEK_END) == 0), return ESP_FAIL);
+    long url_file_size = ftell(playlist->save_file);
+    CHECK_ERROR(TAG, (fseek(playlist->offset_file, 0, SEEK_SET) == 0), return ESP_FAIL);
+    // Use URL batch as read window of URL file, URLs are saved one by one so the window moves forward only
+    char *window = playlist->url_batch;
+    uint32_t window_pos = 0;
+    int window_len = 0;
+    uint8_t record[SDCARD_OFFSET_RECORD_SIZE];
+    while (fread(record, 1, sizeof(record), playlist->offset_file) == sizeof(record)) {
+        uint32_t pos = 0;
+        uint16_t len = 0;
+        memcpy(&pos, record, sizeof(uint32_t));
+        memcpy(&len, record + sizeof(uint32_t), sizeof(uint16_t));
+        if (len >= SDCARD_LIST_URL_MAX_LENGTH || pos != playlist->total_size_save_file || pos + len > url_file_size) {
+            ESP_LOGW(TAG, "Drop broken records from %d of %s", playlist->url_num, playlist->offset_file_name);
+            break;
+        }
+        if (pos + len > window_pos + window_len) {
+            window_pos = pos;
+            CHECK_ERROR(TAG, (fseek(playlist->save_file, pos, SEEK_SET) == 0), return ESP_FAIL);
+            window_len = fread(window, 1, playlist->batch_size, playlist->save_file);
+            CHECK_ERROR(TAG, (window_len >= len), return ESP_FAIL);
+        }
+        if (index_append(playlist, pos, len, sdcard_list_hash(window + pos - window_pos, len)) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        playlist->total_size_save_file += len;
+        playlist->total_size_offset_file += SDCARD_OFFSET_RECORD_SIZE;
+    }
+    playlist->flushed_size = playlist->total_size_save_file;
+    ESP_LOGI(TAG, "Loaded %d urls from %s", playlist->url_num, playlist->save_file_name);
+    return ESP_OK;
+}
 
-    mkdir(SDCARD_DEFAULT_DIR_NAME, 0777);
+static void sdcard_list_clear(sdcard_list_t *playlist)
+{
+    if (playlist->cur_url) {
+        audio_free(playlist->cur_url);
+        playlist->cur_url = NULL;
+    }
+    if (playlist->hash_table) {
+        memset(playlist->hash_table, 0, playlist->hash_size * sizeof(uint16_t));
+    }
+    playlist->url_num = 0;
+    playlist->cur_url_id = 0;
+    playlist->total_size_offset_file = 0;
+    playlist->total_size_save_file = 0;
+    playlist->flushed_size = 0;
+    playlist->url_batch_len = 0;
+    playlist->offset_batch_len = 0;
+}
 
+static esp_err_t sdcard_list_open_files(sdcard_list_t *playlist, bool keep)
+{
+    if (keep) {
+        playlist->save_file = fopen(playlist->save_file_name, "r+");
+        playlist->offset_file = fopen(playlist->offset_file_name, "r+");
+        if (playlist->save_file && playlist->offset_file) {
+            return ESP_OK;
+        }
+        if (playlist->save_file) {
+            fclose(playlist->save_file);
+        }
+        if (playlist->offset_file) {
+            fclose(playlist->offset_file);
+        }
+    }
     playlist->save_file = fopen(playlist->save_file_name, "w+");
     playlist->offset_file = fopen(playlist->offset_file_name, "w+");
-
     if (playlist->save_file == NULL || NULL == playlist->offset_file) {
         ESP_LOGE(TAG, "open file error, line: %d, have you mounted sdcard, set the long file name and UTF-8 encoding configuration ?", __LINE__);
-        audio_free(playlist->save_file_name);
-        audio_free(playlist->offset_file_name);
         if (playlist->save_file) {
             fclose(playlist->save_file);
+            playlist->save_file = NULL;
         }
         if (playlist->offset_file) {
             fclose(playlist->offset_file);
+            playlist->offset_file = NULL;
         }
         return ESP_FAIL;
     }
     return ESP_OK;
 }
 
+static esp_err_t sdcard_list_open(sdcard_list_t *playlist, const sdcard_list_cfg_t *config)
+{
+    const char *dir = config->dir ? config->dir : SDCARD_DEFAULT_DIR_NAME;
+    int name_len = strlen(dir) + strlen(SDCARD_URL_FILE_NAME) + 8;
+    playlist->save_file_name = audio_calloc(1, name_len);
+    AUDIO_NULL_CHECK(TAG, playlist->save_file_name, return ESP_FAIL);
+    playlist->offset_file_name = audio_calloc(1, name_len);
+    AUDIO_NULL_CHECK(TAG, playlist->offset_file_name, return ESP_FAIL);
+    sprintf(playlist->save_file_name, "%s/%s%d", dir, SDCARD_URL_FILE_NAME, config->list_id);
+    sprintf(playlist->offset_file_name, "%s/%s%d", dir, SDCARD_OFFSET_FILE_NAME, config->list_id);
+
+    playlist->persistent = config->persistent;
+    playlist->batch_size = config->batch_size > SDCARD_LIST_URL_MAX_LENGTH ? config->batch_size : SDCARD_LIST_BATCH_SIZE;
+    playlist->url_batch = audio_calloc(1, playlist->batch_size);
+    AUDIO_NULL_CHECK(TAG, playlist->url_batch, return ESP_FAIL);
+    playlist->offset_batch = audio_calloc(SDCARD_LIST_OFFSET_BATCH_NUM, SDCARD_OFFSET_RECORD_SIZE);
+    AUDIO_NULL_CHECK(TAG, playlist->offset_batch, return ESP_FAIL);
+
+    mkdir(dir, 0777);
+    if (sdcard_list_open_files(playlist, playlist->persistent) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (playlist->persistent && sdcard_list_load(playlist) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
 static esp_err_t sdcard_list_close(sdcard_list_t *playlist)
 {
-    fclose(playlist->offset_file);
-    fclose(playlist->save_file);
+    if (playlist->offset_file) {
+        fclose(playlist->offset_file);
+    }
+    if (playlist->save_file) {
+        fclose(playlist->save_file);
+    }
     playlist->offset_file = NULL;
     playlist->save_file = NULL;
     return ESP_OK;
 }
 
-static esp_err_t sdcard_list_choose_id(sdcard_list_t *playlist, int id, char **url_buff)
+static void sdcard_list_free(sdcard_list_t *playlist)
 {
-    uint32_t pos = 0;
-    uint16_t  size = 0;
-    int offset = id * (sizeof(uint32_t) + sizeof(uint16_t));
-
-    CHECK_ERROR(TAG, ((fseek(playlist->offset_file, offset, SEEK_SET)) == 0), return ESP_FAIL);
-    CHECK_ERROR(TAG, ((fread(&pos, 1, sizeof(uint32_t), playlist->offset_file)) == sizeof(uint32_t)), return ESP_FAIL);
-    CHECK_ERROR(TAG, ((fread(&size, 1, sizeof(uint16_t), playlist->offset_file)) == sizeof(uint16_t)), return ESP_FAIL);
+    sdcard_list_close(playlist);
+    audio_free(playlist->save_file_name);
+    audio_free(playlist->offset_file_name);
+    audio_free(playlist->cur_url);
+    audio_free(playlist->index);
+    audio_free(playlist->hash_table);
+    audio_free(playlist->url_batch);
+    audio_free(playlist->offset_batch);
+    audio_free(playlist);
+}
 
-    if (playlist->cur_url) {
-        audio_free(playlist->cur_url);
-    }
-    playlist->cur_url = (char *)audio_calloc(1, size + 1);
-    AUDIO_NULL_CHECK(TAG, playlist->cur_url, {
+static esp_err_t sdcard_list_choose_id(sdcard_list_t *playlist, int id, char **url_buff)
+{
+    char *url = (char *)audio_calloc(1, playlist->index[id].len + 1);
+    AUDIO_NULL_CHECK(TAG, url, {
         ESP_LOGE(TAG, "Fail to allocate memory for url");
-        fclose(playlist->offset_file);
-        fclose(playlist->save_file);
         return ESP_FAIL;
     });
-
-    CHECK_ERROR(TAG, ((fseek(playlist->save_file, pos, SEEK_SET)) == 0), return ESP_FAIL);
-    CHECK_ERROR(TAG, ((fread(playlist->cur_url, 1, size, playlist->save_file)) == size), return ESP_FAIL);
-
-    playlist->cur_url[size] = 0;
+    if (read_url(playlist, id, url) != ESP_OK) {
+        audio_free(url);
+        return ESP_FAIL;
+    }
+    if (playlist->cur_url) {
+        audio_free(playlist->cur_url);
+    }
+    playlist->cur_url = url;
     playlist->cur_url_id = id;
     *url_buff = playlist->cur_url;
 
     return ESP_OK;
 }
 
-esp_err_t sdcard_list_create(playlist_operator_handle_t *handle)
+esp_err_t sdcard_list_create_with_cfg(const sdcard_list_cfg_t *config, playlist_operator_handle_t *handle)
 {
-    esp_err_t ret = ESP_OK;
+    AUDIO_NULL_CHECK(TAG, config, return ESP_FAIL);
     AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
 
     playlist_operator_handle_t sdcard_handle = (playlist_operator_handle_t )audio_calloc(1, sizeof(playlist_operator_t));
@@ -178,11 +392,9 @@ esp_err_t sdcard_list_create(playlist_operator_handle_t *handle)
     sdcard_handle->playlist = sdcard_list;
     sdcard_handle->get_operation = sdcard_list_get_operation;
 
-    static int list_id;
-    ret |= sdcard_list_open(sdcard_list, list_id++);
-    if (ret != ESP_OK) {
+    if (sdcard_list_open(sdcard_list, config) != ESP_OK) {
+        sdcard_list_free(sdcard_list);
         audio_free(sdcard_handle);
-        audio_free(sdcard_list);
         return ESP_FAIL;
     }
 
@@ -190,26 +402,29 @@ esp_err_t sdcard_list_create(playlist_operator_handle_t *handle)
     return ESP_OK;
 }
 
+esp_err_t sdcard_list_create(playlist_operator_handle_t *handle)
+{
+    static int list_id;
+    sdcard_list_cfg_t config = SDCARD_LIST_CFG_DEFAULT();
+    config.list_id = list_id++;
+    return sdcard_list_create_with_cfg(&config, handle);
+}
+
 esp_err_t sdcard_list_show(playlist_operator_handle_t handle)
 {
     AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
     sdcard_list_t *playlist = handle->playlist;
     AUDIO_NULL_CHECK(TAG, playlist, return ESP_FAIL);
 
-    uint32_t pos = 0;
-    uint16_t  size = 0;
     char *url = audio_calloc(1, SDCARD_LIST_URL_MAX_LENGTH);
-
-    CHECK_ERROR(TAG, (fseek(playlist->save_file, 0, SEEK_SET) == 0), return ESP_FAIL);
-    CHECK_ERROR(TAG, (fseek(playlist->offset_file, 0, SEEK_SET) == 0), return ESP_FAIL);
+    AUDIO_NULL_CHECK(TAG, url, return ESP_FAIL);
 
     ESP_LOGI(TAG, "ID   URL");
     for (int i = 0; i < playlist->url_num; i++) {
-        memset(url, 0, SDCARD_LIST_URL_MAX_LENGTH);
-        CHECK_ERROR(TAG, (fread(&pos, 1, sizeof(uint32_t), playlist->offset_file) == sizeof(uint32_t)), return ESP_FAIL);
-        CHECK_ERROR(TAG, (fread(&size, 1, sizeof(uint16_t), playlist->offset_file) == sizeof(uint16_t)), return ESP_FAIL);
-        CHECK_ERROR(TAG, (fseek(playlist->save_file, pos, SEEK_SET) == 0), return ESP_FAIL);
-        CHECK_ERROR(TAG, (fread(url, 1, size, playlist->save_file) == size), return ESP_FAIL);
+        CHECK_ERROR(TAG, (read_url(playlist, i, url) == ESP_OK), {
+            audio_free(url);
+            return ESP_FAIL;
+        });
         ESP_LOGI(TAG, "%d   %s", i, url);
     }
 
@@ -325,36 +540,51 @@ esp_err_t sdcard_list_save(playlist_operator_handle_t handle, const char *url)
     return ret;
 }
 
-bool sdcard_list_exist(playlist_operator_handle_t handle, const char *url)
+esp_err_t sdcard_list_flush(playlist_operator_handle_t handle)
 {
     AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
     sdcard_list_t *playlist = handle->playlist;
     AUDIO_NULL_CHECK(TAG, playlist, return ESP_FAIL);
 
-    uint32_t pos = 0;
-    uint16_t  size = 0;
-    char *url_buff = audio_calloc(1, SDCARD_LIST_URL_MAX_LENGTH);
+    return sdcard_list_flush_batch(playlist);
+}
 
-    CHECK_ERROR(TAG, (fseek(playlist->save_file, 0, SEEK_SET) == 0), return ESP_FAIL);
-    CHECK_ERROR(TAG, (fseek(playlist->offset_file, 0, SEEK_SET) == 0), return ESP_FAIL);
+bool sdcard_list_exist(playlist_operator_handle_t handle, const char *url)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return false);
+    AUDIO_NULL_CHECK(TAG, url, return false);
+    sdcard_list_t *playlist = handle->playlist;
+    AUDIO_NULL_CHECK(TAG, playlist, return false);
 
-    for (int i = 0; i < playlist->url_num; i++) {
-        memset(url_buff, 0, SDCARD_LIST_URL_MAX_LENGTH);
-        CHECK_ERROR(TAG, (fread(&pos, 1, sizeof(uint32_t), playlist->offset_file) == sizeof(uint32_t)), return ESP_FAIL);
-        CHECK_ERROR(TAG, (fread(&size, 1, sizeof(uint16_t), playlist->offset_file) == sizeof(uint16_t)), return ESP_FAIL);
-        CHECK_ERROR(TAG, (fseek(playlist->save_file, pos, SEEK_SET) == 0), return ESP_FAIL);
-        CHECK_ERROR(TAG, (fread(url_buff, 1, size, playlist->save_file) == size), return ESP_FAIL);
-        if (strlen(url_buff) != strlen(url)) {
+    if (playlist->url_num == 0) {
+        return false;
+    }
+    int len = strlen(url);
+    if (len >= SDCARD_LIST_URL_MAX_LENGTH) {
+        return false;
+    }
+    uint32_t hash = sdcard_list_hash(url, len);
+    char *url_buff = NULL;
+    bool found = false;
+    int mask = playlist->hash_size - 1;
+    // Only the URLs with the same hash and length are read back to compare
+    for (int slot = hash & mask; playlist->hash_table[slot]; slot = (slot + 1) & mask) {
+        int id = playlist->hash_table[slot] - 1;
+        if (playlist->index[id].hash != hash || playlist->index[id].len != len) {
             continue;
         }
-        if (strcmp(url, url_buff) == 0) {
-            audio_free(url_buff);
-            return true;
+        if (url_buff == NULL) {
+            url_buff = audio_calloc(1, len + 1);
+            AUDIO_NULL_CHECK(TAG, url_buff, return false);
+        }
+        if (read_url(playlist, id, url_buff) == ESP_OK && strcmp(url, url_buff) == 0) {
+            found = true;
+            break;
         }
     }
 
     audio_free(url_buff);
-    return false;
+    return found;
 }
 
 esp_err_t sdcard_list_reset(playlist_operator_handle_t handle)
@@ -364,23 +594,12 @@ esp_err_t sdcard_list_reset(playlist_operator_handle_t handle)
     AUDIO_NULL_CHECK(TAG, playlist, return ESP_FAIL);
 
     /**
-     * ftruncate() function is not supported now, it won't affect the operation result.
-     *
-       CHECK_ERROR(TAG, (ftruncate(playlist->save_file, 0) == ESP_OK), return ESP_FAIL);
-       CHECK_ERROR(TAG, (ftruncate(playlist->offset_file, 0) == ESP_OK), return ESP_FAIL);
-       CHECK_ERROR(TAG, (fseek(playlist->save_file, 0, SEEK_SET) == 0), return ESP_FAIL);
-       CHECK_ERROR(TAG, (fseek(playlist->offset_file, 0, SEEK_SET) == 0), return ESP_FAIL);
-    */
-    if (playlist->cur_url) {
-        audio_free(playlist->cur_url);
-        playlist->cur_url = NULL;
-    }
-
-    playlist->url_num = 0;
-    playlist->cur_url_id = 0;
-    playlist->total_size_offset_file = 0;
-    playlist->total_size_save_file = 0;
-    return ESP_OK;
+     * ftruncate() function is not supported now, reopen the files to drop the content,
+     * otherwise a persistent list would load the stale URLs on next boot.
+     */
+    sdcard_list_close(playlist);
+    sdcard_list_clear(playlist);
+    return sdcard_list_open_files(playlist, false);
 }
 
 int sdcard_list_get_url_num(playlist_operator_handle_t handle)
@@ -407,16 +626,17 @@ esp_err_t sdcard_list_destroy(playlist_operator_handle_t handle)
     sdcard_list_t *playlist = handle->playlist;
     AUDIO_NULL_CHECK(TAG, playlist, return ESP_FAIL);
 
-    sdcard_list_close(playlist);
-    remove(playlist->save_file_name);
-    remove(playlist->offset_file_name);
-    audio_free(playlist->save_file_name);
-    audio_free(playlist->offset_file_name);
-    if (playlist->cur_url) {
-        audio_free(playlist->cur_url);
-        playlist->cur_url = NULL;
+    if (playlist->persistent) {
+        if (playlist->save_file && playlist->offset_file && sdcard_list_flush_batch(playlist) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to flush urls to %s", playlist->save_file_name);
+        }
+        sdcard_list_close(playlist);
+    } else {
+        sdcard_list_close(playlist);
+        remove(playlist->save_file_name);
+        remove(playlist->offset_file_name);
     }
-    audio_free(playlist);
+    sdcard_list_free(playlist);
     handle->playlist = NULL;
     audio_free(handle);
     return ESP_OK;
@@ -27,71 +27,507 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "audio_error.h"
 #include "audio_mem.h"
+#include "audio_thread.h"
 #include "sdcard_scan.h"
 
 #define SDCARD_FILE_PREV_NAME           "file:/"
+#define SDCARD_FILE_PREV_NAME_LEN       (sizeof(SDCARD_FILE_PREV_NAME) - 1)
 #define SDCARD_SCAN_URL_MAX_LENGTH      (1024 * 2)
+#define SDCARD_SCAN_AVG_URL_LENGTH      (128)
+#define SDCARD_SCAN_NAMES_STEP          (512)
+#define SDCARD_SCAN_CACHE_MAGIC         (0x43534453)
+#define SDCARD_SCAN_CACHE_TMP_SUFFIX    ".tmp"
+#define SDCARD_SCAN_FINISHED_BIT        BIT(0)
 
 static const char *TAG = "SDCARD_SCAN";
 
-static void scan_dir(sdcard_scan_cb_t save_url_cb, const char *path, int cur_depth, int depth, const char *file_extension[] , int filter_num, void *user_data)
+/**
+ * Layout of the cache file:
+ *   sdcard_scan_cache_header_t
+ *   sdcard_scan_dir_record_t, path, subdir names, file names  (repeated for every directory)
+ * Names are '\0' terminated, only the files that match the extensions are saved.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t option_hash;                /*!< Hash of path, depth and extensions of the scan */
+    uint32_t dir_num;
+} sdcard_scan_cache_header_t;
+
+typedef struct {
+    uint16_t path_len;
+    uint16_t entries;                    /*!< Number of entries in directory, including the filtered ones */
+    uint32_t name_hash;                  /*!< Hash of all the entry names */
+    uint32_t mtime;                      /*!< Modified time of directory */
+    uint16_t subdir_num;
+    uint16_t file_num;
+    uint32_t names_len;
+} sdcard_scan_dir_record_t;
+
+typedef struct {
+    char *data;
+    int len;
+    int size;
+} sdcard_scan_names_t;
+
+typedef struct {
+    sdcard_scan_cfg_t       cfg;
+    char                    *url;        /*!< "file:/" followed by path of current directory */
+    uint32_t                option_hash;
+    char                    *cache;      /*!< Cache of last scan */
+    int                     cache_len;
+    uint32_t                *cache_table;/*!< Open addressing table of record offset + 1 in cache */
+    int                     cache_table_size;
+    FILE                    *new_cache;
+    uint32_t                new_dir_num;
+    char                    *batch;
+    int                     batch_len;
+    int                     batch_size;
+    const char              **batch_urls;
+    int                     batch_num;
+    sdcard_scan_progress_t  progress;
+    volatile bool           cancel;
+} sdcard_scan_ctx_t;
+
+struct sdcard_scan_task {
+    sdcard_scan_ctx_t       ctx;
+    EventGroupHandle_t      state_event;
+    esp_err_t               result;
+};
+
+static uint32_t hash_update(uint32_t hash, const void *data, int len)
 {
-    if (cur_depth > depth) {
-        ESP_LOGD(TAG, "scan depth = %d, exit", cur_depth);
+    // FNV-1a
+    const uint8_t *p = (const uint8_t *)data;
+    for (int i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static esp_err_t names_append(sdcard_scan_names_t *names, const char *name, int len)
+{
+    if (names->len + len + 1 > names->size) {
+        int size = names->size + len + 1 + SDCARD_SCAN_NAMES_STEP;
+        char *data = audio_realloc(names->data, size);
+        AUDIO_MEM_CHECK(TAG, data, return ESP_FAIL);
+        names->data = data;
+        names->size = size;
+    }
+    memcpy(names->data + names->len, name, len);
+    names->len += len;
+    names->data[names->len++] = 0;
+    return ESP_OK;
+}
+
+static bool extension_match(sdcard_scan_ctx_t *ctx, const char *name)
+{
+    if (NULL == ctx->cfg.file_extension) {
+        return true;
+    }
+    const char *detect = strrchr(name, '.');
+    if (NULL == detect) {
+        return false;
+    }
+    detect ++;
+    for (int i = 0; i < ctx->cfg.filter_num; i++) {
+        if (strcasecmp(detect, ctx->cfg.file_extension[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void batch_flush(sdcard_scan_ctx_t *ctx)
+{
+    if (ctx->batch_num) {
+        ctx->cfg.cb(ctx->cfg.user_data, ctx->batch_urls, ctx->batch_num);
+    }
+    ctx->batch_num = 0;
+    ctx->batch_len = 0;
+}
+
+static void batch_add(sdcard_scan_ctx_t *ctx, int path_len, const char *name)
+{
+    int prefix_len = SDCARD_FILE_PREV_NAME_LEN + path_len;
+    int len = prefix_len + 1 + strlen(name) + 1;
+    if (len > SDCARD_SCAN_URL_MAX_LENGTH) {
+        ESP_LOGE(TAG, "The file name is too long, invalid url");
         return;
     }
-    char *file_url = audio_calloc(1, SDCARD_SCAN_URL_MAX_LENGTH);
-    AUDIO_NULL_CHECK(TAG, file_url, return);
+    if (ctx->batch_len + len > ctx->batch_size || ctx->batch_num >= ctx->cfg.batch_num) {
+        batch_flush(ctx);
+    }
+    char *url = ctx->batch + ctx->batch_len;
+    memcpy(url, ctx->url, prefix_len);
+    url[prefix_len] = '/';
+    strcpy(url + prefix_len + 1, name);
+    ctx->batch_urls[ctx->batch_num++] = url;
+    ctx->batch_len += len;
+    ctx->progress.url_num++;
+}
 
-    DIR *dir = opendir(path);
-    if (dir == NULL) {
-        ESP_LOGE(TAG, "Open [%s] directory failed", path);
-        audio_free(file_url);
+static void cache_load(sdcard_scan_ctx_t *ctx)
+{
+    FILE *f = fopen(ctx->cfg.cache_file, "r");
+    if (f == NULL) {
         return;
     }
+    sdcard_scan_cache_header_t header = { 0 };
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size <= sizeof(header)
+        || fread(&header, 1, sizeof(header), f) != sizeof(header)
+        || header.magic != SDCARD_SCAN_CACHE_MAGIC
+        || header.option_hash != ctx->option_hash) {
+        ESP_LOGI(TAG, "No valid scan cache in %s", ctx->cfg.cache_file);
+        fclose(f);
+        return;
+    }
+    ctx->cache_len = size - sizeof(header);
+    ctx->cache = audio_malloc(ctx->cache_len);
+    int table_size = 16;
+    while (table_size < header.dir_num * 2) {
+        table_size *= 2;
+    }
+    ctx->cache_table = audio_calloc(table_size, sizeof(uint32_t));
+    if (ctx->cache == NULL || ctx->cache_table == NULL
+        || fread(ctx->cache, 1, ctx->cache_len, f) != ctx->cache_len) {
+        ESP_LOGW(TAG, "Failed to load scan cache");
+        goto _load_fail;
+    }
+    fclose(f);
+    ctx->cache_table_size = table_size;
 
+    int pos = 0;
+    for (int i = 0; i < header.dir_num; i++) {
+        sdcard_scan_dir_record_t record;
+        if (pos + sizeof(record) > ctx->cache_len) {
+            goto _broken;
+        }
+        memcpy(&record, ctx->cache + pos, sizeof(record));
+        if (pos + sizeof(record) + record.path_len + record.names_len > ctx->cache_len) {
+            goto _broken;
+        }
+        int slot = hash_update(2166136261u, ctx->cache + pos + sizeof(record), record.path_len) & (table_size - 1);
+        while (ctx->cache_table[slot]) {
+            slot = (slot + 1) & (table_size - 1);
+        }
+        ctx->cache_table[slot] = pos + 1;
+        pos += sizeof(record) + record.path_len + record.names_len;
+    }
+    ESP_LOGI(TAG, "Loaded scan cache of %d directories", header.dir_num);
+    return;
+
+_broken:
+    ESP_LOGW(TAG, "Scan cache is broken, ignore it");
+    f = NULL;
+_load_fail:
+    if (f) {
+        fclose(f);
+    }
+    audio_free(ctx->cache);
+    audio_free(ctx->cache_table);
+    ctx->cache = NULL;
+    ctx->cache_table = NULL;
+    ctx->cache_table_size = 0;
+}
+
+static const char *cache_find(sdcard_scan_ctx_t *ctx, const char *path, int path_len, sdcard_scan_dir_record_t *record)
+{
+    if (ctx->cache_table == NULL) {
+        return NULL;
+    }
+    int mask = ctx->cache_table_size - 1;
+    for (int slot = hash_update(2166136261u, path, path_len) & mask; ctx->cache_table[slot]; slot = (slot + 1) & mask) {
+        const char *item = ctx->cache + ctx->cache_table[slot] - 1;
+        memcpy(record, item, sizeof(sdcard_scan_dir_record_t));
+        if (record->path_len == path_len && memcmp(item + sizeof(sdcard_scan_dir_record_t), path, path_len) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void cache_write(sdcard_scan_ctx_t *ctx, sdcard_scan_dir_record_t *record, const char *path,
+                        const char *subdirs, int subdirs_len, const char *files, int files_len)
+{
+    if (ctx->new_cache == NULL) {
+        return;
+    }
+    record->names_len = subdirs_len + files_len;
+    if (fwrite(record, 1, sizeof(*record), ctx->new_cache) != sizeof(*record)
+        || fwrite(path, 1, record->path_len, ctx->new_cache) != record->path_len
+        || (subdirs_len && fwrite(subdirs, 1, subdirs_len, ctx->new_cache) != subdirs_len)
+        || (files_len && fwrite(files, 1, files_len, ctx->new_cache) != files_len)) {
+        ESP_LOGW(TAG, "Failed to write scan cache");
+        fclose(ctx->new_cache);
+        ctx->new_cache = NULL;
+        return;
+    }
+    ctx->new_dir_num++;
+}
+
+/* Count and hash the entries of `dir`, names are only matched and collected when `files` is given */
+static void read_dir(sdcard_scan_ctx_t *ctx, DIR *dir, sdcard_scan_dir_record_t *record, sdcard_scan_names_t *subdirs, sdcard_scan_names_t *files)
+{
+    uint32_t name_hash = 2166136261u;
     struct dirent *file_info = NULL;
     while (NULL != (file_info = readdir(dir))) {
-        if ((strlen(file_info->d_name) + strlen(path)) > (SDCARD_SCAN_URL_MAX_LENGTH - strlen(SDCARD_FILE_PREV_NAME))) {
-            ESP_LOGE(TAG, "The file name is too long, invalid url");
+        const char *name = file_info->d_name;
+        int len = strlen(name);
+        if (name[0] == '.') {
             continue;
         }
-        if (file_info->d_name[0] == '.') {
+        record->entries++;
+        name_hash = hash_update(name_hash, name, len + 1);
+        if (files == NULL) {
             continue;
         }
-
         if (file_info->d_type == DT_DIR) {
-            if (file_info->d_name[0] == '_' && file_info->d_name[1] == '_') {
+            if (name[0] == '_' && name[1] == '_') {
                 continue;
             }
-            memset(file_url, 0, SDCARD_SCAN_URL_MAX_LENGTH);
-            sprintf(file_url, "%s/%s", path, file_info->d_name);
-            scan_dir(save_url_cb, file_url, cur_depth + 1, depth, file_extension, filter_num, user_data);
-        } else {
-            memset(file_url, 0, SDCARD_SCAN_URL_MAX_LENGTH);
-            sprintf(file_url, "%s%s/%s", SDCARD_FILE_PREV_NAME, path, file_info->d_name);
-            if (NULL == file_extension) {
-                save_url_cb(user_data, file_url);
-                continue;
+            if (names_append(subdirs, name, len) != ESP_OK) {
+                break;
             }
-            char *detect = strrchr(file_info->d_name, '.');
-            if (NULL == detect) {
-                continue;
+            record->subdir_num++;
+        } else if (extension_match(ctx, name)) {
+            if (names_append(files, name, len) != ESP_OK) {
+                break;
             }
-            detect ++;
-            for (int i = 0; i < filter_num; i++) {
-                if (strcasecmp(detect, file_extension[i]) == 0) {
-                    save_url_cb(user_data, file_url);
-                    break;
-                }
+            record->file_num++;
+        }
+    }
+    record->name_hash = name_hash;
+}
+
+static void scan_dir(sdcard_scan_ctx_t *ctx, int path_len, int cur_depth)
+{
+    if (cur_depth > ctx->cfg.depth) {
+        ESP_LOGD(TAG, "scan depth = %d, exit", cur_depth);
+        return;
+    }
+    if (ctx->cancel) {
+        return;
+    }
+    const char *path = ctx->url + SDCARD_FILE_PREV_NAME_LEN;
+    struct stat st;
+    uint32_t mtime = stat(path, &st) == 0 ? (uint32_t)st.st_mtime : 0;
+    sdcard_scan_dir_record_t cached = { 0 };
+    const char *cached_item = ctx->cache ? cache_find(ctx, path, path_len, &cached) : NULL;
+
+    sdcard_scan_dir_record_t record = { 0 };
+    sdcard_scan_names_t subdirs = { 0 };
+    sdcard_scan_names_t files = { 0 };
+    const char *subdir_names = NULL;
+    const char *file_names = NULL;
+    int subdir_names_len = 0;
+    int file_names_len = 0;
+    ctx->progress.dir_num++;
+
+    // Directory is not touched since last scan, no need to read it
+    bool unchanged = cached_item && ctx->cfg.check_mode == SDCARD_SCAN_CHECK_MTIME && mtime && mtime == cached.mtime;
+    if (unchanged == false) {
+        DIR *dir = opendir(path);
+        if (dir == NULL) {
+            ESP_LOGE(TAG, "Open [%s] directory failed", path);
+            return;
+        }
+        if (cached_item) {
+            // Compare the entries first, names of an unchanged directory are taken from the cache
+            read_dir(ctx, dir, &record, NULL, NULL);
+            unchanged = (cached.entries == record.entries && cached.name_hash == record.name_hash);
+            if (unchanged == false) {
+                memset(&record, 0, sizeof(record));
+                rewinddir(dir);
             }
         }
+        if (unchanged == false) {
+            read_dir(ctx, dir, &record, &subdirs, &files);
+        }
+        closedir(dir);
+    }
+    if (unchanged) {
+        record = cached;
+        record.mtime = mtime;
+        subdir_names = cached_item + sizeof(cached) + path_len;
+        file_names = subdir_names;
+        for (int i = 0; i < record.subdir_num; i++) {
+            file_names += strlen(file_names) + 1;
+        }
+        subdir_names_len = file_names - subdir_names;
+        file_names_len = record.names_len - subdir_names_len;
+        ctx->progress.dir_skipped++;
+    } else {
+        record.path_len = path_len;
+        record.mtime = mtime;
+        subdir_names = subdirs.data;
+        subdir_names_len = subdirs.len;
+        file_names = files.data;
+        file_names_len = files.len;
+    }
+    cache_write(ctx, &record, path, subdir_names, subdir_names_len, file_names, file_names_len);
+
+    const char *name = file_names;
+    for (int i = 0; i < record.file_num; i++) {
+        batch_add(ctx, path_len, name);
+        name += strlen(name) + 1;
+    }
+    name = subdir_names;
+    for (int i = 0; i < record.subdir_num && !ctx->cancel; i++) {
+        int len = strlen(name);
+        if (path_len + len + 1 + SDCARD_FILE_PREV_NAME_LEN >= SDCARD_SCAN_URL_MAX_LENGTH) {
+            ESP_LOGE(TAG, "The file name is too long, invalid url");
+        } else {
+            ctx->url[SDCARD_FILE_PREV_NAME_LEN + path_len] = '/';
+            strcpy(ctx->url + SDCARD_FILE_PREV_NAME_LEN + path_len + 1, name);
+            scan_dir(ctx, path_len + 1 + len, cur_depth + 1);
+            ctx->url[SDCARD_FILE_PREV_NAME_LEN + path_len] = 0;
+        }
+        name += len + 1;
+    }
+    audio_free(subdirs.data);
+    audio_free(files.data);
+}
+
+static esp_err_t sdcard_scan_run(sdcard_scan_ctx_t *ctx)
+{
+    esp_err_t ret = ESP_OK;
+    char *tmp_name = NULL;
+    int path_len = strlen(ctx->cfg.path);
+    while (path_len > 1 && ctx->cfg.path[path_len - 1] == '/') {
+        path_len--;
+    }
+    if (path_len + SDCARD_FILE_PREV_NAME_LEN >= SDCARD_SCAN_URL_MAX_LENGTH) {
+        ESP_LOGE(TAG, "The path is too long");
+        return ESP_FAIL;
+    }
+    ctx->batch_size = ctx->cfg.batch_num * SDCARD_SCAN_AVG_URL_LENGTH;
+    if (ctx->batch_size < SDCARD_SCAN_URL_MAX_LENGTH) {
+        ctx->batch_size = SDCARD_SCAN_URL_MAX_LENGTH;
+    }
+    ctx->url = audio_calloc(1, SDCARD_SCAN_URL_MAX_LENGTH);
+    ctx->batch = audio_malloc(ctx->batch_size);
+    ctx->batch_urls = audio_calloc(ctx->cfg.batch_num, sizeof(char *));
+    AUDIO_MEM_CHECK(TAG, ctx->url && ctx->batch && ctx->batch_urls, {
+        ret = ESP_FAIL;
+        goto _exit;
+    });
+    memcpy(ctx->url, SDCARD_FILE_PREV_NAME, SDCARD_FILE_PREV_NAME_LEN);
+    memcpy(ctx->url + SDCARD_FILE_PREV_NAME_LEN, ctx->cfg.path, path_len);
+
+    if (ctx->cfg.cache_file) {
+        uint32_t hash = hash_update(2166136261u, ctx->cfg.path, path_len);
+        hash = hash_update(hash, &ctx->cfg.depth, sizeof(ctx->cfg.depth));
+        for (int i = 0; ctx->cfg.file_extension && i < ctx->cfg.filter_num; i++) {
+            hash = hash_update(hash, ctx->cfg.file_extension[i], strlen(ctx->cfg.file_extension[i]) + 1);
+        }
+        ctx->option_hash = hash;
+        cache_load(ctx);
+        tmp_name = audio_calloc(1, strlen(ctx->cfg.cache_file) + sizeof(SDCARD_SCAN_CACHE_TMP_SUFFIX));
+        AUDIO_MEM_CHECK(TAG, tmp_name, {
+            ret = ESP_FAIL;
+            goto _exit;
+        });
+        sprintf(tmp_name, "%s%s", ctx->cfg.cache_file, SDCARD_SCAN_CACHE_TMP_SUFFIX);
+        ctx->new_cache = fopen(tmp_name, "w");
+        sdcard_scan_cache_header_t header = { 0 };
+        if (ctx->new_cache && fwrite(&header, 1, sizeof(header), ctx->new_cache) != sizeof(header)) {
+            fclose(ctx->new_cache);
+            ctx->new_cache = NULL;
+        }
+        if (ctx->new_cache == NULL) {
+            ESP_LOGW(TAG, "Failed to create %s, the scan result will not be cached", tmp_name);
+        }
+    }
+
+    scan_dir(ctx, path_len, 0);
+    batch_flush(ctx);
+
+    if (ctx->new_cache) {
+        sdcard_scan_cache_header_t header = {
+            .magic = SDCARD_SCAN_CACHE_MAGIC,
+            .option_hash = ctx->option_hash,
+            .dir_num = ctx->new_dir_num,
+        };
+        bool ok = !ctx->cancel
+                  && fseek(ctx->new_cache, 0, SEEK_SET) == 0
+                  && fwrite(&header, 1, sizeof(header), ctx->new_cache) == sizeof(header);
+        ok = (fclose(ctx->new_cache) == 0) && ok;
+        ctx->new_cache = NULL;
+        // A cancelled scan only visited part of the tree, keep the old cache then
+        if (ok) {
+            remove(ctx->cfg.cache_file);
+            ok = rename(tmp_name, ctx->cfg.cache_file) == 0;
+        }
+        if (!ok) {
+            remove(tmp_name);
+        }
+    }
+    ESP_LOGI(TAG, "Scanned %d directories, %d unchanged, %d urls%s", ctx->progress.dir_num, ctx->progress.dir_skipped,
+             ctx->progress.url_num, ctx->cancel ? ", cancelled" : "");
+_exit:
+    audio_free(tmp_name);
+    audio_free(ctx->url);
+    audio_free(ctx->batch);
+    audio_free(ctx->batch_urls);
+    audio_free(ctx->cache);
+    audio_free(ctx->cache_table);
+    ctx->url = NULL;
+    ctx->batch = NULL;
+    ctx->batch_urls = NULL;
+    ctx->cache = NULL;
+    ctx->cache_table = NULL;
+    ctx->progress.finished = true;
+    return ret;
+}
+
+static esp_err_t sdcard_scan_check_cfg(const sdcard_scan_cfg_t *cfg)
+{
+    AUDIO_NULL_CHECK(TAG, cfg, return ESP_FAIL);
+    AUDIO_NULL_CHECK(TAG, cfg->cb, return ESP_FAIL);
+    AUDIO_NULL_CHECK(TAG, cfg->path, return ESP_FAIL);
+    if (cfg->depth < 0 || cfg->filter_num < 0 || cfg->batch_num <= 0) {
+        ESP_LOGE(TAG, "Invalid parameters, please check");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sdcard_scan_with_cfg(const sdcard_scan_cfg_t *cfg, sdcard_scan_progress_t *progress)
+{
+    if (sdcard_scan_check_cfg(cfg) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    sdcard_scan_ctx_t ctx = {
+        .cfg = *cfg,
+    };
+    esp_err_t ret = sdcard_scan_run(&ctx);
+    if (progress) {
+        *progress = ctx.progress;
+    }
+    return ret;
+}
+
+typedef struct {
+    sdcard_scan_cb_t cb;
+    void *user_data;
+} sdcard_scan_legacy_t;
+
+static void sdcard_scan_legacy_cb(void *user_data, const char *urls[], int num)
+{
+    sdcard_scan_legacy_t *legacy = (sdcard_scan_legacy_t *)user_data;
+    for (int i = 0; i < num; i++) {
+        legacy->cb(legacy->user_data, (char *)urls[i]);
     }
-    audio_free(file_url);
-    closedir(dir);
 }
 
 esp_err_t sdcard_scan(sdcard_scan_cb_t cb, const char *path, int depth, const char *file_extension[], int filter_num, void *user_data)
@@ -104,6 +540,96 @@ esp_err_t sdcard_scan(sdcard_scan_cb_t cb, const char *path, int depth, const ch
         return ESP_FAIL;
     }
 
-    scan_dir(cb, path, 0, depth, file_extension, filter_num, user_data);
+    sdcard_scan_legacy_t legacy = {
+        .cb = cb,
+        .user_data = user_data,
+    };
+    sdcard_scan_cfg_t cfg = SDCARD_SCAN_CFG_DEFAULT();
+    cfg.path = path;
+    cfg.depth = depth;
+    cfg.file_extension = file_extension;
+    cfg.filter_num = filter_num;
+    cfg.cb = sdcard_scan_legacy_cb;
+    cfg.user_data = &legacy;
+    return sdcard_scan_with_cfg(&cfg, NULL);
+}
+
+static void sdcard_scan_task(void *pv)
+{
+    sdcard_scan_handle_t scan = (sdcard_scan_handle_t)pv;
+    scan->result = sdcard_scan_run(&scan->ctx);
+    xEventGroupSetBits(scan->state_event, SDCARD_SCAN_FINISHED_BIT);
+    vTaskDelete(NULL);
+}
+
+esp_err_t sdcard_scan_start(const sdcard_scan_cfg_t *cfg, sdcard_scan_handle_t *handle)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
+    if (sdcard_scan_check_cfg(cfg) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    sdcard_scan_handle_t scan = audio_calloc(1, sizeof(struct sdcard_scan_task));
+    AUDIO_MEM_CHECK(TAG, scan, return ESP_FAIL);
+    scan->ctx.cfg = *cfg;
+    scan->ctx.cfg.path = audio_strdup(cfg->path);
+    AUDIO_MEM_CHECK(TAG, scan->ctx.cfg.path, goto _start_fail);
+    if (cfg->cache_file) {
+        scan->ctx.cfg.cache_file = audio_strdup(cfg->cache_file);
+        AUDIO_MEM_CHECK(TAG, scan->ctx.cfg.cache_file, goto _start_fail);
+    }
+    scan->state_event = xEventGroupCreate();
+    AUDIO_MEM_CHECK(TAG, scan->state_event, goto _start_fail);
+    if (audio_thread_create(NULL, "sdcard_scan", sdcard_scan_task, scan, cfg->task_stack, cfg->task_prio,
+                            cfg->stack_in_ext, cfg->task_core) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create scan task");
+        goto _start_fail;
+    }
+    *handle = scan;
+    return ESP_OK;
+
+_start_fail:
+    if (scan->state_event) {
+        vEventGroupDelete(scan->state_event);
+    }
+    audio_free((void *)scan->ctx.cfg.path);
+    audio_free((void *)scan->ctx.cfg.cache_file);
+    audio_free(scan);
+    return ESP_FAIL;
+}
+
+esp_err_t sdcard_scan_get_progress(sdcard_scan_handle_t handle, sdcard_scan_progress_t *progress)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
+    AUDIO_NULL_CHECK(TAG, progress, return ESP_FAIL);
+    *progress = handle->ctx.progress;
+    return ESP_OK;
+}
+
+esp_err_t sdcard_scan_cancel(sdcard_scan_handle_t handle)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
+    handle->ctx.cancel = true;
+    return ESP_OK;
+}
+
+esp_err_t sdcard_scan_wait(sdcard_scan_handle_t handle, TickType_t ticks_to_wait)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
+    EventBits_t bits = xEventGroupWaitBits(handle->state_event, SDCARD_SCAN_FINISHED_BIT, false, true, ticks_to_wait);
+    if ((bits & SDCARD_SCAN_FINISHED_BIT) == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return handle->result;
+}
+
+esp_err_t sdcard_scan_destroy(sdcard_scan_handle_t handle)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
+    handle->ctx.cancel = true;
+    xEventGroupWaitBits(handle->state_event, SDCARD_SCAN_FINISHED_BIT, false, true, portMAX_DELAY);
+    vEventGroupDelete(handle->state_event);
+    audio_free((void *)handle->ctx.cfg.path);
+    audio_free((void *)handle->ctx.cfg.cache_file);
+    audio_free(handle);
     return ESP_OK;
 }
@@ -0,0 +1,196 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Host benchmark of the sdcard playlist, see build.pl
+ *
+ * Generates a tree of `num` files in `root`, scans it into a persistent sdcard list,
+ * then times `exist`, `choose` and loading the list again as on next boot.
+ * At last times the rescan with scan cache, and a scan in background task.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "sdcard_list.h"
+#include "sdcard_scan.h"
+
+#define FILES_PER_DIR   (100)
+#define LOOKUP_NUM      (10000)
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void gen_tree(const char *root, int num)
+{
+    char path[256];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/album_%d/disc_0/track_%d.mp3", root, (num - 1) / FILES_PER_DIR, (num - 1) % FILES_PER_DIR);
+    if (stat(path, &st) == 0) {
+        return;
+    }
+    mkdir(root, 0777);
+    for (int i = 0; i < num; i++) {
+        if (i % FILES_PER_DIR == 0) {
+            snprintf(path, sizeof(path), "%s/album_%d", root, i / FILES_PER_DIR);
+            mkdir(path, 0777);
+            snprintf(path, sizeof(path), "%s/album_%d/disc_0", root, i / FILES_PER_DIR);
+            mkdir(path, 0777);
+        }
+        snprintf(path, sizeof(path), "%s/album_%d/disc_0/track_%d.mp3", root, i / FILES_PER_DIR, i % FILES_PER_DIR);
+        FILE *f = fopen(path, "w");
+        if (f) {
+            fclose(f);
+        }
+    }
+}
+
+static void save_cb(void *user_data, const char *urls[], int num)
+{
+    playlist_operator_handle_t list = (playlist_operator_handle_t)user_data;
+    for (int i = 0; list && i < num; i++) {
+        if (sdcard_list_save(list, urls[i]) != ESP_OK) {
+            printf("save %s failed\n", urls[i]);
+            exit(1);
+        }
+    }
+}
+
+static int rescan(const char *root, const char *cache, sdcard_scan_check_mode_t mode, int num)
+{
+    sdcard_scan_cfg_t cfg = SDCARD_SCAN_CFG_DEFAULT();
+    sdcard_scan_progress_t progress;
+    cfg.path = root;
+    cfg.file_extension = (const char *[]) {"mp3"};
+    cfg.filter_num = 1;
+    cfg.cache_file = cache;
+    cfg.check_mode = mode;
+    cfg.cb = save_cb;
+    double start = now_ms();
+    sdcard_scan_with_cfg(&cfg, &progress);
+    printf("%s scan, %s: %.1f ms, %d dirs, %d unchanged, %d urls\n", cache ? "cached" : "plain",
+           mode == SDCARD_SCAN_CHECK_MTIME ? "mtime" : "entries", now_ms() - start,
+           progress.dir_num, progress.dir_skipped, progress.url_num);
+    return progress.url_num != num;
+}
+
+static int lookup(playlist_operator_handle_t list, const char *root, int num)
+{
+    char url[256];
+    int miss = 0;
+    for (int i = 0; i < LOOKUP_NUM; i++) {
+        int n = rand() % num;
+        snprintf(url, sizeof(url), "file:/%s/album_%d/disc_0/track_%d.mp3", root, n / FILES_PER_DIR, n % FILES_PER_DIR);
+        miss += !sdcard_list_exist(list, url);
+    }
+    // Never saved, walks the whole probe chain
+    miss += sdcard_list_exist(list, "file://sdcard/not_exist.mp3");
+    return miss;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *root = argc > 1 ? argv[1] : "/tmp/sdcard_bench";
+    int num = argc > 2 ? atoi(argv[2]) : 10000;
+    char dir[256];
+    snprintf(dir, sizeof(dir), "%s/__playlist", root);
+    gen_tree(root, num);
+
+    sdcard_list_cfg_t cfg = SDCARD_LIST_CFG_DEFAULT();
+    cfg.dir = dir;
+    cfg.persistent = true;
+    playlist_operator_handle_t list = NULL;
+    if (sdcard_list_create_with_cfg(&cfg, &list) != ESP_OK) {
+        return 1;
+    }
+    sdcard_list_reset(list);
+
+    sdcard_scan_cfg_t scan_cfg = SDCARD_SCAN_CFG_DEFAULT();
+    scan_cfg.path = root;
+    scan_cfg.file_extension = (const char *[]) {"mp3"};
+    scan_cfg.filter_num = 1;
+    scan_cfg.cb = save_cb;
+    scan_cfg.user_data = list;
+    double start = now_ms();
+    sdcard_scan_with_cfg(&scan_cfg, NULL);
+    sdcard_list_flush(list);
+    double used = now_ms() - start;
+    printf("scan and save %d urls: %.1f ms\n", sdcard_list_get_url_num(list), used);
+    if (sdcard_list_get_url_num(list) != num) {
+        printf("expect %d urls\n", num);
+        return 1;
+    }
+
+    start = now_ms();
+    int miss = lookup(list, root, num);
+    printf("exist x %d: %.1f ms, %d wrong\n", LOOKUP_NUM + 1, now_ms() - start, miss);
+
+    char *url = NULL;
+    start = now_ms();
+    for (int i = 0; i < LOOKUP_NUM; i++) {
+        sdcard_list_choose(list, rand() % num, &url);
+    }
+    printf("choose x %d: %.1f ms\n", LOOKUP_NUM, now_ms() - start);
+    sdcard_list_destroy(list);
+
+    start = now_ms();
+    if (sdcard_list_create_with_cfg(&cfg, &list) != ESP_OK) {
+        return 1;
+    }
+    printf("load %d urls on next boot: %.1f ms\n", sdcard_list_get_url_num(list), now_ms() - start);
+    sdcard_list_choose(list, num - 1, &url);
+    printf("last url: %s\n", url);
+    miss += lookup(list, root, num);
+    sdcard_list_destroy(list);
+
+    char cache[sizeof(dir) + 16];
+    snprintf(cache, sizeof(cache), "%s/_scan_cache", dir);
+    remove(cache);
+    miss += rescan(root, NULL, SDCARD_SCAN_CHECK_ENTRIES, num);
+    miss += rescan(root, cache, SDCARD_SCAN_CHECK_ENTRIES, num);
+    miss += rescan(root, cache, SDCARD_SCAN_CHECK_ENTRIES, num);
+    miss += rescan(root, cache, SDCARD_SCAN_CHECK_MTIME, num);
+
+    sdcard_scan_handle_t scan = NULL;
+    sdcard_scan_progress_t progress;
+    scan_cfg.user_data = NULL;
+    scan_cfg.cache_file = cache;
+    start = now_ms();
+    if (sdcard_scan_start(&scan_cfg, &scan) != ESP_OK) {
+        return 1;
+    }
+    sdcard_scan_get_progress(scan, &progress);
+    printf("background scan started in %.2f ms, %d urls so far\n", now_ms() - start, progress.url_num);
+    sdcard_scan_wait(scan, portMAX_DELAY);
+    sdcard_scan_get_progress(scan, &progress);
+    printf("background scan finished in %.1f ms, %d urls\n", now_ms() - start, progress.url_num);
+    miss += progress.url_num != num;
+    sdcard_scan_destroy(scan);
+    return miss ? 1 : 0;
+}
@@ -521,6 +521,91 @@ TEST_CASE("Create a sdcard playlist and scan sdcard then save the specified url
 }
 
 
+static void scan_sdcard_batch_cb(void *user_data, const char *urls[], int num)
+{
+    playlist_handle_t handle = (playlist_handle_t)user_data;
+    for (int i = 0; i < num; i++) {
+        playlist_save(handle, urls[i]);
+    }
+}
+
+TEST_CASE("Scan sdcard in background task twice with scan cache", "[playlist]")
+{
+    esp_periph_set_handle_t set;
+    TEST_ASSERT_FALSE(initialize_sdcard(&set));
+
+    playlist_handle_t handle = playlist_create();
+    TEST_ASSERT_NOT_NULL(handle);
+    playlist_operator_handle_t sdcard_handle = NULL;
+    TEST_ASSERT_FALSE(sdcard_list_create(&sdcard_handle));
+    TEST_ASSERT_FALSE(playlist_add(handle, sdcard_handle, 0));
+
+    sdcard_scan_cfg_t cfg = SDCARD_SCAN_CFG_DEFAULT();
+    cfg.file_extension = (const char *[]) {"mp3", "wav", "aac"};
+    cfg.filter_num = 3;
+    cfg.cache_file = "/sdcard/__playlist/_scan_cache";
+    cfg.cb = scan_sdcard_batch_cb;
+    cfg.user_data = handle;
+    sdcard_scan_progress_t progress[2];
+    for (int i = 0; i < 2; i++) {
+        sdcard_scan_handle_t scan = NULL;
+        TEST_ASSERT_FALSE(sdcard_scan_start(&cfg, &scan));
+        TEST_ASSERT_FALSE(sdcard_scan_wait(scan, portMAX_DELAY));
+        TEST_ASSERT_FALSE(sdcard_scan_get_progress(scan, &progress[i]));
+        TEST_ASSERT_TRUE(progress[i].finished);
+        TEST_ASSERT_FALSE(sdcard_scan_destroy(scan));
+        ESP_LOGI(TAG, "Scan %d: %d directories, %d unchanged, %d urls", i, progress[i].dir_num, progress[i].dir_skipped, progress[i].url_num);
+    }
+    TEST_ASSERT_EQUAL(progress[0].url_num, progress[1].url_num);
+    TEST_ASSERT_EQUAL(progress[1].dir_num, progress[1].dir_skipped);
+    TEST_ASSERT_EQUAL(progress[0].url_num * 2, playlist_get_current_list_url_num(handle));
+
+    remove(cfg.cache_file);
+    TEST_ASSERT_FALSE(playlist_destroy(handle));
+    TEST_ASSERT_FALSE(esp_periph_set_destroy(set));
+}
+
+TEST_CASE("Create a persistent sdcard playlist and load it again", "[playlist]")
+{
+    esp_periph_set_handle_t set;
+    TEST_ASSERT_FALSE(initialize_sdcard(&set));
+
+    sdcard_list_cfg_t cfg = SDCARD_LIST_CFG_DEFAULT();
+    cfg.list_id = 100;
+    cfg.persistent = true;
+    playlist_operator_handle_t sdcard_handle = NULL;
+    TEST_ASSERT_FALSE(sdcard_list_create_with_cfg(&cfg, &sdcard_handle));
+    TEST_ASSERT_FALSE(sdcard_list_reset(sdcard_handle));
+
+    char url[64];
+    for (int i = 0; i < 1000; i++) {
+        sprintf(url, "file://sdcard/persistent/%d.mp3", i);
+        TEST_ASSERT_FALSE(sdcard_list_save(sdcard_handle, url));
+    }
+    // URLs in the batch not written yet should be found too
+    TEST_ASSERT_TRUE(sdcard_list_exist(sdcard_handle, "file://sdcard/persistent/999.mp3"));
+    TEST_ASSERT_FALSE(sdcard_list_destroy(sdcard_handle));
+
+    ESP_LOGI(TAG, "Load the list saved before");
+    TEST_ASSERT_FALSE(sdcard_list_create_with_cfg(&cfg, &sdcard_handle));
+    TEST_ASSERT_EQUAL(1000, sdcard_list_get_url_num(sdcard_handle));
+    TEST_ASSERT_TRUE(sdcard_list_exist(sdcard_handle, "file://sdcard/persistent/0.mp3"));
+    TEST_ASSERT_TRUE(sdcard_list_exist(sdcard_handle, "file://sdcard/persistent/999.mp3"));
+    TEST_ASSERT_FALSE(sdcard_list_exist(sdcard_handle, "file://sdcard/persistent/1000.mp3"));
+    char *url_buff = NULL;
+    TEST_ASSERT_FALSE(sdcard_list_choose(sdcard_handle, 500, &url_buff));
+    TEST_ASSERT_EQUAL_STRING("file://sdcard/persistent/500.mp3", url_buff);
+
+    TEST_ASSERT_FALSE(sdcard_list_reset(sdcard_handle));
+    TEST_ASSERT_FALSE(sdcard_list_destroy(sdcard_handle));
+    TEST_ASSERT_FALSE(sdcard_list_create_with_cfg(&cfg, &sdcard_handle));
+    TEST_ASSERT_EQUAL(0, sdcard_list_get_url_num(sdcard_handle));
+    TEST_ASSERT_FALSE(sdcard_list_destroy(sdcard_handle));
+
+    TEST_ASSERT_FALSE(esp_periph_set_destroy(set));
+}
+
+
 /**
  * Abnormal operation and stress test
  */
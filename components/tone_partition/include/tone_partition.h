@@ -81,7 +81,9 @@ typedef enum tone_format {
 } tone_format_t;
 
 /**
- * @brief      Initial the tone partition.
+ * @brief      Initial the tone partition. The file table is read once and the tone bin is mapped into data memory,
+ *             so that file reads afterwards neither access flash through the driver nor go through the delegate.
+ *             The crc of a format 1 bin is checked when it is mapped.
  *
  * @param[in]  handle           Pointer to 'tone_partition_handle_t' structure
  * @param[in]  use_delegate     Whether to use esp delegate to read flash
@@ -143,6 +145,20 @@ esp_err_t tone_partition_get_file_info(tone_partition_handle_t handle, uint16_t
  */
 esp_err_t tone_partition_file_read(tone_partition_handle_t handle, tone_file_info_t *file, uint32_t offset, char *dst, int read_len);
 
+/**
+ * @brief      Get the mapped data of a file, valid until `tone_partition_deinit`
+ *
+ * @param[in]  handle   Pointer to 'tone_partition_handle_t' structure
+ * @param[in]  file     File to get
+ * @param[out] data     Start of the file in data memory
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_NOT_SUPPORTED: The partition is not mapped, use `tone_partition_file_read`
+ *      - others: Failed
+ */
+esp_err_t tone_partition_get_file_data(tone_partition_handle_t handle, tone_file_info_t *file, const uint8_t **data);
+
 #ifdef __cplusplus
 }
 #endif
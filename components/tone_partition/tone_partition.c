@@ -29,6 +29,14 @@
 #include "esp_delegate.h"
 #include "esp_log.h"
 #include "esp_partition.h"
+#include "esp_idf_version.h"
+#if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0))
+#include "esp_rom_crc.h"
+#define tone_crc32_le(crc, buf, len)    esp_rom_crc32_le(crc, buf, len)
+#else
+#include "rom/crc.h"
+#define tone_crc32_le(crc, buf, len)    crc32_le(crc, buf, len)
+#endif
 
 #include "partition_action.h"
 #include "tone_partition.h"
@@ -40,6 +48,11 @@
 typedef struct tone_partition_s {
     const esp_partition_t *partition;
     flash_tone_header_t header;
+    tone_file_info_t *files;            /*!< File table, read once at init */
+    uint32_t image_len;                 /*!< Bytes of the tone bin in the partition */
+    const uint8_t *map;                 /*!< The tone bin mapped into data memory, NULL if it could not be mapped */
+    partition_mmap_handle_t map_handle;
+    bool use_delegate;
     const esp_partition_t *(*find)(esp_partition_type_t, esp_partition_subtype_t, const char *);
     esp_err_t (*read)(const esp_partition_t *, size_t, void *, size_t);
 } tone_partition_t;
@@ -87,34 +100,149 @@ static esp_err_t partition_read_with_dispatcher(const esp_partition_t *partition
     return result.err;
 }
 
+static esp_err_t tone_partition_mmap(tone_partition_t *tone)
+{
+    const void *ptr = NULL;
+    partition_mmap_args_t mmap_arg = {
+        .partition = tone->partition,
+        .offset = 0,
+        .size = tone->image_len,
+        .out_ptr = &ptr,
+        .out_handle = &tone->map_handle,
+    };
+    action_arg_t arg = {
+        .data = &mmap_arg,
+        .len = sizeof(partition_mmap_args_t),
+    };
+    action_result_t result = { 0 };
+    // Mapping touches the flash cache, so it runs where flash reads run. Reading the mapping later does not
+    if (tone->use_delegate) {
+        esp_dispatcher_handle_t dispatcher = esp_dispatcher_get_delegate_handle();
+        if (!dispatcher) {
+            return ESP_FAIL;
+        }
+        esp_dispatcher_execute_with_func(dispatcher, partition_mmap_action, NULL, &arg, &result);
+    } else {
+        partition_mmap_action(NULL, &arg, &result);
+    }
+    if (result.err == ESP_OK) {
+        tone->map = (const uint8_t *)ptr;
+    }
+    return result.err;
+}
+
+static void tone_partition_munmap(tone_partition_t *tone)
+{
+    if (tone->map == NULL) {
+        return;
+    }
+    action_arg_t arg = {
+        .data = &tone->map_handle,
+        .len = sizeof(partition_mmap_handle_t),
+    };
+    action_result_t result = { 0 };
+    esp_dispatcher_handle_t dispatcher = tone->use_delegate ? esp_dispatcher_get_delegate_handle() : NULL;
+    if (dispatcher) {
+        esp_dispatcher_execute_with_func(dispatcher, partition_munmap_action, NULL, &arg, &result);
+    } else {
+        partition_munmap_action(NULL, &arg, &result);
+    }
+    tone->map = NULL;
+}
+
+static int tone_partition_table_offset(tone_partition_t *tone)
+{
+    if (tone->header.format == TONE_VERSION_0) {
+        return sizeof(flash_tone_header_t);
+    } else if (tone->header.format == TONE_VERSION_1) {
+        return sizeof(flash_tone_header_t) + sizeof(esp_app_desc_t);
+    }
+    return -1;
+}
+
+static esp_err_t tone_partition_load_table(tone_partition_t *tone)
+{
+    int start_adr = tone_partition_table_offset(tone);
+    if (start_adr < 0 || tone->header.total_num == 0) {
+        ESP_LOGE(TAG, "Tone format not support! format:%"PRIu32", total:%"PRIu16, tone->header.format, tone->header.total_num);
+        return ESP_FAIL;
+    }
+    tone->files = audio_calloc(tone->header.total_num, sizeof(tone_file_info_t));
+    AUDIO_MEM_CHECK(TAG, tone->files, return ESP_ERR_NO_MEM);
+    if (ESP_OK != tone->read(tone->partition, start_adr, tone->files, tone->header.total_num * sizeof(tone_file_info_t))) {
+        ESP_LOGE(TAG, "Read tone file table failed");
+        return ESP_FAIL;
+    }
+    tone_file_info_t *last = &tone->files[tone->header.total_num - 1];
+    uint32_t end = last->song_adr + last->song_len + ((4 - last->song_len % 4) % 4);
+    if (tone->header.format == TONE_VERSION_1) {
+        end += sizeof(uint32_t) + sizeof(uint16_t);     // crc + tail
+    }
+    if (end > tone->partition->size || end < start_adr + tone->header.total_num * sizeof(tone_file_info_t)) {
+        ESP_LOGE(TAG, "Tone bin size %"PRIu32" out of partition", end);
+        return ESP_FAIL;
+    }
+    tone->image_len = end;
+    return ESP_OK;
+}
+
+static esp_err_t tone_partition_check_tail(tone_partition_t *tone)
+{
+    uint32_t crc_addr = tone->image_len - sizeof(uint16_t) - sizeof(uint32_t);
+    uint16_t tail = 0;
+    uint32_t crc = 0;
+    if (tone->map) {
+        memcpy(&tail, tone->map + crc_addr + sizeof(uint32_t), sizeof(tail));
+    } else if (ESP_OK != tone->read(tone->partition, crc_addr + sizeof(uint32_t), &tail, sizeof(tail))) {
+        return ESP_FAIL;
+    }
+    if (tail != FLASH_TONE_TAIL) {
+        ESP_LOGE(TAG, "Flash tone init failed at tail check %X", tail);
+        return ESP_FAIL;
+    }
+    // The whole image is only checked when mapped, reading it through the delegate would delay the first tone too long
+    if (tone->map == NULL) {
+        return ESP_OK;
+    }
+    memcpy(&crc, tone->map + crc_addr, sizeof(crc));
+    uint32_t calc = tone_crc32_le(0, tone->map, crc_addr);
+    if (calc != crc) {
+        ESP_LOGE(TAG, "Flash tone crc mismatch, stored:%08"PRIX32", calculated:%08"PRIX32, crc, calc);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
 esp_err_t tone_partition_get_file_info(tone_partition_handle_t handle, uint16_t index, tone_file_info_t *info)
 {
     AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
     AUDIO_NULL_CHECK(TAG, info, return ESP_FAIL);
 
-    if (handle->header.total_num < index) {
+    if (handle->header.total_num <= index) {
         ESP_LOGE(TAG, "Wanted index out of range index[%d]", index);
         return ESP_FAIL;
     }
-    tone_file_info_t info_tmp = { 0 };
-    int start_adr = 0;
-    if (handle->header.format == TONE_VERSION_0) {
-        start_adr = sizeof(flash_tone_header_t) + FLASH_TONE_FILE_INFO_BLOCK * index;
-    } else if (handle->header.format == TONE_VERSION_1) {
-        start_adr = sizeof(flash_tone_header_t) + sizeof(esp_app_desc_t) + FLASH_TONE_FILE_INFO_BLOCK * index;
-    } else {
-        ESP_LOGE(TAG, "Tone format not support!");
+    if (handle->files[index].file_tag != FLASH_TONE_FILE_TAG) {
+        ESP_LOGE(TAG, "Get tone file tag error %x", handle->files[index].file_tag);
         return ESP_FAIL;
     }
-    if (ESP_OK == handle->read(handle->partition, start_adr, &info_tmp, sizeof(info_tmp))) {
-        //TODO check crc
-        if (info_tmp.file_tag == FLASH_TONE_FILE_TAG) {
-            memcpy(info, &info_tmp, sizeof(info_tmp));
-        }
-    } else {
-        ESP_LOGE(TAG, "Get tone file tag error %x", info_tmp.file_tag);
+    memcpy(info, &handle->files[index], sizeof(tone_file_info_t));
+    return ESP_OK;
+}
+
+esp_err_t tone_partition_get_file_data(tone_partition_handle_t handle, tone_file_info_t *file, const uint8_t **data)
+{
+    AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
+    AUDIO_NULL_CHECK(TAG, file, return ESP_FAIL);
+    AUDIO_NULL_CHECK(TAG, data, return ESP_FAIL);
+    if (handle->map == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if ((uint64_t)file->song_adr + file->song_len > handle->image_len) {
+        ESP_LOGE(TAG, "Tone file out of range, addr:%"PRIX32", len:%"PRIu32, file->song_adr, file->song_len);
         return ESP_FAIL;
     }
+    *data = handle->map + file->song_adr;
     return ESP_OK;
 }
 
@@ -123,6 +251,14 @@ esp_err_t tone_partition_file_read(tone_partition_handle_t handle, tone_file_inf
     AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
     AUDIO_NULL_CHECK(TAG, file, return ESP_FAIL);
 
+    if (handle->map) {
+        if ((uint64_t)file->song_adr + offset + read_len > handle->image_len) {
+            ESP_LOGE(TAG, "Tone file read out of range, offset:%"PRIu32", len:%d", offset, read_len);
+            return ESP_FAIL;
+        }
+        memcpy(dst, handle->map + file->song_adr + offset, read_len);
+        return ESP_OK;
+    }
     esp_err_t err = handle->read(handle->partition, file->song_adr + offset, dst, read_len);
     if (ESP_OK != err) {
         ESP_LOGE(TAG, "Tone file read error[0x%x]", err);
@@ -130,26 +266,13 @@ esp_err_t tone_partition_file_read(tone_partition_handle_t handle, tone_file_inf
     return err;
 }
 
-static esp_err_t tone_partition_get_tail(tone_partition_handle_t handle, uint16_t *tail)
-{
-    AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
-
-    if (handle->header.format == TONE_VERSION_1) {
-        tone_file_info_t last_file = { 0 };
-        tone_partition_get_file_info(handle, handle->header.total_num - 1, &last_file);
-        int tail_addr = last_file.song_adr + last_file.song_len + ((4 - last_file.song_len % 4) % 4) + 4;
-        ESP_LOGD(TAG, "addr %"PRIX32", len %"PRIX32", tail %X", last_file.song_adr, last_file.song_len, tail_addr);
-        return handle->read(handle->partition, tail_addr, tail, sizeof(uint16_t));
-    } else {
-        *tail = 0;
-        ESP_LOGE(TAG, "No tail");
-        return ESP_FAIL;
-    }
-}
-
 esp_err_t tone_partition_get_app_desc(tone_partition_handle_t handle, esp_app_desc_t *desc)
 {
     if (handle != NULL && handle->header.format == TONE_VERSION_1) {
+        if (handle->map) {
+            memcpy(desc, handle->map + sizeof(flash_tone_header_t), sizeof(esp_app_desc_t));
+            return ESP_OK;
+        }
         if (ESP_OK == handle->read(handle->partition, sizeof(flash_tone_header_t), desc, sizeof(esp_app_desc_t))) {
             return ESP_OK;
         }
@@ -163,6 +286,7 @@ tone_partition_handle_t tone_partition_init(const char *partition_label, bool us
     AUDIO_NULL_CHECK(TAG, partition_label, return NULL);
     tone_partition_t *tone = audio_calloc(1, sizeof(tone_partition_t));
     AUDIO_NULL_CHECK(TAG, tone, return NULL);
+    tone->use_delegate = use_delegate;
     if (use_delegate) {
         tone->find = partition_find_with_dispatcher;
         tone->read = partition_read_with_dispatcher;
@@ -183,19 +307,24 @@ tone_partition_handle_t tone_partition_init(const char *partition_label, bool us
         ESP_LOGE(TAG, "Not flash tone partition");
         goto error;
     }
-    if (tone->header.format == TONE_VERSION_1) {
-        uint16_t tail = 0;
-        if (ESP_OK != tone_partition_get_tail(tone, &tail) || tail != FLASH_TONE_TAIL) {
-            ESP_LOGE(TAG, "Flash tone init failed at tail check %X", tail);
-            goto error;
-        }
+    if (ESP_OK != tone_partition_load_table(tone)) {
+        goto error;
+    }
+    if (ESP_OK != tone_partition_mmap(tone)) {
+        ESP_LOGW(TAG, "Can not map tone[%s] partition, read it instead", partition_label);
+    }
+    if (tone->header.format == TONE_VERSION_1 && ESP_OK != tone_partition_check_tail(tone)) {
+        goto error;
     }
-    ESP_LOGI(TAG, "tone partition format %"PRIu32", total %"PRIu16, tone->header.format, tone->header.total_num);
+    ESP_LOGI(TAG, "tone partition format %"PRIu32", total %"PRIu16", %s", tone->header.format, tone->header.total_num,
+             tone->map ? "mapped" : "read");
     return (tone_partition_handle_t)tone;
 
 error:
     if (tone) {
-        free(tone);
+        tone_partition_munmap(tone);
+        audio_free(tone->files);
+        audio_free(tone);
     }
     return NULL;
 }
@@ -203,6 +332,8 @@ error:
 esp_err_t tone_partition_deinit(tone_partition_handle_t handle)
 {
     AUDIO_NULL_CHECK(TAG, handle, return ESP_FAIL);
-    free(handle);
+    tone_partition_munmap(handle);
+    audio_free(handle->files);
+    audio_free(handle);
     return ESP_OK;
 }